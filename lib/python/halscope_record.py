@@ -0,0 +1,120 @@
+#    Read files written by halscope-record
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+"""Read the files written by halscope-record.
+
+    rec = halscope_record.open("fault.hsr.gz")
+    print rec.channels, rec.period, rec.trigger
+    for t, sample in rec.samples():
+        ...
+
+A file is a short text header followed by blocks of binary samples,
+each block preceded by its sample count and the number of samples that
+were lost (because the reader fell behind) just before it.  Times
+returned by samples() are in seconds, counted from the trigger sample
+when there is one, and account for lost samples."""
+
+import gzip, struct
+
+__all__ = ['open', 'Recording']
+
+_formats = {'bit': 'B', 'float': 'd', 's32': 'i', 'u32': 'I'}
+
+_open = open
+
+class Recording:
+    def __init__(self, f):
+        self.f = f
+        self.thread = None
+        self.period = 0
+        self.trigger = -1
+        self.channels = []
+        self.types = []
+        line = f.readline().decode()
+        if not line.startswith("halscope-record "):
+            raise ValueError("not a halscope-record file")
+        self.version = int(line.split()[1])
+        while 1:
+            line = f.readline().decode()
+            if not line:
+                raise ValueError("truncated halscope-record header")
+            words = line.split()
+            if words[0] == "data":
+                break
+            elif words[0] == "thread":
+                self.thread = words[1]
+            elif words[0] == "period":
+                self.period = int(words[1])
+            elif words[0] == "trigger":
+                self.trigger = int(words[1])
+            elif words[0] == "channel":
+                self.types.append(words[1])
+                self.channels.append(words[2])
+        self.record = struct.Struct(
+            "=" + "".join(_formats[t] for t in self.types))
+        self.lost = 0
+
+    def blocks(self):
+        """Yield (lost, samples) for each block in the file, where
+        'samples' is a list of tuples with one value per channel"""
+        hdr = struct.Struct("=II")
+        while 1:
+            data = self.f.read(hdr.size)
+            if len(data) < hdr.size:
+                return
+            count, lost = hdr.unpack(data)
+            data = self.f.read(count * self.record.size)
+            count = len(data) // self.record.size
+            self.lost += lost
+            yield lost, [self.record.unpack_from(data, i * self.record.size)
+                            for i in range(count)]
+
+    def samples(self):
+        """Yield (time, sample) for every sample in the file"""
+        dt = self.period * 1e-9
+        n = 0
+        if self.trigger >= 0:
+            n = -self.trigger
+        first = True
+        for lost, block in self.blocks():
+            # samples lost before the first one do not move time zero
+            if not first:
+                n += lost
+            for sample in block:
+                first = False
+                yield n * dt, sample
+                n += 1
+
+    def columns(self):
+        """Return (times, [values of channel 0, values of channel 1, ...])"""
+        times = []
+        values = [[] for c in self.channels]
+        for t, sample in self.samples():
+            times.append(t)
+            for v, s in zip(values, sample):
+                v.append(s)
+        return times, values
+
+    def close(self):
+        self.f.close()
+
+def open(filename):
+    """Open a file written by halscope-record, compressed or not"""
+    if filename.endswith(".gz"):
+        f = gzip.open(filename, "rb")
+    else:
+        f = _open(filename, "rb")
+    return Recording(f)
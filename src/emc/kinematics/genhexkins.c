@@ -103,6 +103,27 @@
   genhexkins.max-iterations - maximum number of iterations spent for
                     a converged solution during current session.
 
+  genhexkins.time-budget - hard limit in nanoseconds on the time spent
+                    in one forward kinematics solution, 0 disables the
+                    limit. If exceeded, iterations stop and the pose
+                    passed in (the previous solution) is returned as is;
+
+  genhexkins.last-time - time in nanoseconds spent for the last
+                    forward kinematics solution;
+
+  genhexkins.max-time - maximum time in nanoseconds spent for a
+                    converged solution during current session;
+
+  genhexkins.budget-overruns - number of solutions abandoned because
+                    the time budget was exceeded.
+
+  Each Newton-Raphson step solves the linear system J * delta = error
+  directly by Gaussian elimination with partial pivoting rather than
+  inverting the Jacobian. When called every servo cycle, the initial
+  value is extrapolated from the last two solutions, so that a platform
+  moving at constant velocity converges in one or two iterations. The
+  feedback and commanded positions each get their own history.
+
  ----------------------------------------------------------------------------*/
 
 #include "rtapi_math.h"
@@ -110,6 +131,7 @@
 #include "genhexkins.h"
 #include "kinematics.h"             /* these decls, KINEMATICS_FORWARD_FLAGS */
 #include "hal.h"
+#include "rtapi.h"
 
 struct haldata {
     hal_float_t basex[NUM_STRUTS];
@@ -129,6 +151,10 @@ struct haldata {
     hal_u32_t *last_iter;
     hal_u32_t *max_iter;
     hal_u32_t iter_limit;
+    hal_u32_t time_budget;
+    hal_u32_t *last_time;
+    hal_u32_t *max_time;
+    hal_u32_t *budget_overruns;
     hal_float_t max_error;
     hal_float_t conv_criterion;
     hal_float_t *tool_offset;
@@ -136,105 +162,60 @@ struct haldata {
 } *haldata;
 
 
-/******************************* MatInvert() ***************************/
+/******************************** MatSolve() ********************************/
 
-/*-----------------------------------------------------------------------------
- This is a function that inverts a 6x6 matrix.
------------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------
+  This function solves the 6x6 linear system J * x = y using Gaussian
+  elimination with partial pivoting. J and y are overwritten. Returns -1
+  if J is singular.
+  ---------------------------------------------------------------------------*/
 
-static int MatInvert(double J[][NUM_STRUTS], double InvJ[][NUM_STRUTS])
+static int MatSolve(double J[][NUM_STRUTS], double y[], double x[])
 {
-  double JAug[NUM_STRUTS][12], m, temp;
-  int j, k, n;
-
-  /* This function determines the inverse of a 6x6 matrix using
-     Gauss-Jordan elimination */
-
-  /* Augment the Identity matrix to the Jacobian matrix */
-
-  for (j=0; j<=5; ++j){
-    for (k=0; k<=5; ++k){     /* Assign J matrix to first 6 columns of AugJ */
-      JAug[j][k] = J[j][k];
-    }
-    for(k=6; k<=11; ++k){    /* Assign I matrix to last six columns of AugJ */
-      if (k-6 == j){
-        JAug[j][k]=1;
-      }
-      else{
-        JAug[j][k]=0;
+  double m, temp;
+  int j, k, n, pivot;
+
+  for (k = 0; k < NUM_STRUTS; ++k) {
+    /* find the largest pivot in column k */
+    pivot = k;
+    for (j = k + 1; j < NUM_STRUTS; ++j) {
+      if (fabs(J[j][k]) > fabs(J[pivot][k])) {
+        pivot = j;
       }
     }
-  }
-
-  /* Perform Gauss elimination */
-  for (k=0; k<=4; ++k){               /* Pivot        */
-    if ((JAug[k][k]< 0.01) && (JAug[k][k] > -0.01)){
-      for (j=k+1;j<=5; ++j){
-        if ((JAug[j][k]>0.01) || (JAug[j][k]<-0.01)){
-          for (n=0; n<=11;++n){
-            temp = JAug[k][n];
-            JAug[k][n] = JAug[j][n];
-            JAug[j][n] = temp;
-          }
-          break;
-        }
-      }
+    if (fabs(J[pivot][k]) < 1e-12) {
+      return -1;
     }
-    for (j=k+1; j<=5; ++j){            /* Pivot */
-      m = -JAug[j][k] / JAug[k][k];
-      for (n=0; n<=11; ++n){
-        JAug[j][n]=JAug[j][n] + m*JAug[k][n];   /* (Row j) + m * (Row k) */
-        if ((JAug[j][n] < 0.000001) && (JAug[j][n] > -0.000001)){
-          JAug[j][n] = 0;
-        }
+    if (pivot != k) {
+      for (n = k; n < NUM_STRUTS; ++n) {
+        temp = J[k][n];
+        J[k][n] = J[pivot][n];
+        J[pivot][n] = temp;
       }
+      temp = y[k];
+      y[k] = y[pivot];
+      y[pivot] = temp;
     }
-  }
-
-  /* Normalization of Diagonal Terms */
-  for (j=0; j<=5; ++j){
-    m=1/JAug[j][j];
-    for(k=0; k<=11; ++k){
-      JAug[j][k] = m * JAug[j][k];
-    }
-  }
-
-  /* Perform Gauss Jordan Steps */
-  for (k=5; k>=0; --k){
-    for(j=k-1; j>=0; --j){
-      m = -JAug[j][k]/JAug[k][k];
-      for (n=0; n<=11; ++n){
-        JAug[j][n] = JAug[j][n] + m * JAug[k][n];
+    /* eliminate column k below the diagonal */
+    for (j = k + 1; j < NUM_STRUTS; ++j) {
+      m = J[j][k] / J[k][k];
+      for (n = k + 1; n < NUM_STRUTS; ++n) {
+        J[j][n] -= m * J[k][n];
       }
+      y[j] -= m * y[k];
     }
   }
 
-  /* Assign last 6 columns of JAug to InvJ */
-  for (j=0; j<=5; ++j){
-    for (k=0; k<=5; ++k){
-      InvJ[j][k] = JAug[j][k+6];
-
+  /* back substitution */
+  for (k = NUM_STRUTS - 1; k >= 0; --k) {
+    temp = y[k];
+    for (n = k + 1; n < NUM_STRUTS; ++n) {
+      temp -= J[k][n] * x[n];
     }
+    x[k] = temp / J[k][k];
   }
 
-  return 0;         /* FIXME-- check divisors for 0 above */
-}
-
-/******************************** MatMult() *********************************/
-
-/*---------------------------------------------------------------------------
-  This function simply multiplies a 6x6 matrix by a 1x6 vector
-  ---------------------------------------------------------------------------*/
-
-static void MatMult(double J[][6], const double x[], double Ans[])
-{
-  int j, k;
-  for (j=0; j<=5; ++j){
-    Ans[j] = 0;
-    for (k=0; k<=5; ++k){
-      Ans[j] = J[j][k]*x[k]+Ans[j];
-    }
-  }
+  return 0;
 }
 
 /* declare arrays for base and platform coordinates */
@@ -246,6 +227,51 @@ static PmCartesian a[NUM_STRUTS];
 static PmCartesian nb1[NUM_STRUTS];
 static PmCartesian na0[NUM_STRUTS];
 
+/* last two forward kinematics solutions, used to predict the next one.
+   Motion calls kinematicsForward for the feedback and for the commanded
+   position, each passing back its own last solution, so there is one
+   history per caller, found by that solution. */
+#define FWD_HISTORIES 2
+static struct fwd_history {
+  EmcPose last, prev;
+  int count;                    /* solutions in last and prev, up to 2 */
+  unsigned long used;           /* when this history was last used */
+} fwd_history[FWD_HISTORIES];
+static unsigned long fwd_calls = 0;
+
+static int pose_equal(const EmcPose *p, const EmcPose *q)
+{
+  return p->tran.x == q->tran.x && p->tran.y == q->tran.y &&
+         p->tran.z == q->tran.z && p->a == q->a && p->b == q->b &&
+         p->c == q->c;
+}
+
+/* the history whose last solution the caller passed back, else an empty
+   one or the one used least recently, cleared */
+static struct fwd_history *find_fwd_history(const EmcPose *pos)
+{
+  struct fwd_history *h, *oldest = &fwd_history[0];
+
+  for (h = fwd_history; h < fwd_history + FWD_HISTORIES; h++) {
+    if (h->count > 0 && pose_equal(pos, &h->last)) {
+      h->used = ++fwd_calls;
+      return h;
+    }
+  }
+  for (h = fwd_history; h < fwd_history + FWD_HISTORIES; h++) {
+    if (h->count == 0) {
+      oldest = h;
+      break;
+    }
+    if (h->used < oldest->used) {
+      oldest = h;
+    }
+  }
+  oldest->count = 0;
+  oldest->used = ++fwd_calls;
+  return oldest;
+}
+
 /************************genhexkins_read_hal_pins**************************/
 
 int genhexkins_read_hal_pins(void) {
@@ -312,7 +338,6 @@ int kinematicsForward(const double * joints,
   PmCartesian InvKinStrutVect,InvKinStrutVectUnit;
   PmCartesian q_trans, RMatrix_a, RMatrix_a_cross_Strut;
 
-  double Jacobian[NUM_STRUTS][NUM_STRUTS];
   double InverseJacobian[NUM_STRUTS][NUM_STRUTS];
   double InvKinStrutLength, StrutLengthDiff[NUM_STRUTS];
   double delta[NUM_STRUTS];
@@ -321,11 +346,16 @@ int kinematicsForward(const double * joints,
 
   PmRotationMatrix RMatrix;
   PmRpy q_RPY;
+  EmcPose seed;
+  struct fwd_history *hist;
 
   int iterate = 1;
+  int predicted = 0;
   int i;
   int iteration = 0;
+  long long int start_time, elapsed;
 
+  start_time = rtapi_get_time();
   genhexkins_read_hal_pins();
 
   /* abort on obvious problems, like joints <= 0 */
@@ -340,22 +370,45 @@ int kinematicsForward(const double * joints,
     return -1;
   }
 
+  seed = *pos;
+  /* if the caller passed back our last solution, extrapolate it by the
+     last step to get a better initial value */
+  hist = find_fwd_history(pos);
+  if (hist->count >= 2) {
+    seed.tran.x += hist->last.tran.x - hist->prev.tran.x;
+    seed.tran.y += hist->last.tran.y - hist->prev.tran.y;
+    seed.tran.z += hist->last.tran.z - hist->prev.tran.z;
+    seed.a += hist->last.a - hist->prev.a;
+    seed.b += hist->last.b - hist->prev.b;
+    seed.c += hist->last.c - hist->prev.c;
+    predicted = 1;
+  }
+
+restart:
   /* assign a,b,c to roll, pitch, yaw angles */
-  q_RPY.r = pos->a * PM_PI / 180.0;
-  q_RPY.p = pos->b * PM_PI / 180.0;
-  q_RPY.y = pos->c * PM_PI / 180.0;
+  q_RPY.r = seed.a * PM_PI / 180.0;
+  q_RPY.p = seed.b * PM_PI / 180.0;
+  q_RPY.y = seed.c * PM_PI / 180.0;
 
-  /* Assign translation values in pos to q_trans */
-  q_trans.x = pos->tran.x;
-  q_trans.y = pos->tran.y;
-  q_trans.z = pos->tran.z;
+  /* Assign translation values in seed to q_trans */
+  q_trans.x = seed.tran.x;
+  q_trans.y = seed.tran.y;
+  q_trans.z = seed.tran.z;
 
   /* Enter Newton-Raphson iterative method   */
   while (iterate) {
     /* check for large error and return error flag if no convergence */
     if ((conv_err > +(haldata->max_error)) ||
     (conv_err < -(haldata->max_error))) {
+      if (predicted) {
+        /* the prediction was bad, start over from the caller's value */
+        predicted = 0;
+        seed = *pos;
+        conv_err = 1.0;
+        goto restart;
+      }
       /* we can't converge */
+      hist->count = 0;
       return -2;
     };
 
@@ -365,9 +418,22 @@ int kinematicsForward(const double * joints,
        convergence criterion and return error flag if it can't */
     if (iteration > haldata->iter_limit) {
       /* we can't converge */
+      hist->count = 0;
       return -5;
     }
 
+    /* check the time budget; if exceeded, leave pos at the pose the
+       caller passed in (its previous solution) and report success, so
+       that motion keeps that pose rather than treating it as a failure */
+    if (haldata->time_budget != 0 && iteration > 1) {
+      elapsed = rtapi_get_time() - start_time;
+      if (elapsed > haldata->time_budget) {
+        *haldata->last_time = elapsed;
+        (*haldata->budget_overruns)++;
+        return 0;
+      }
+    }
+
     /* Convert q_RPY to Rotation Matrix */
     pmRpyMatConvert(&q_RPY, &RMatrix);
 
@@ -404,20 +470,6 @@ int kinematicsForward(const double * joints,
       InverseJacobian[i][5] = RMatrix_a_cross_Strut.z;
     }
 
-    /* invert Inverse Jacobian */
-    MatInvert(InverseJacobian, Jacobian);
-
-    /* multiply Jacobian by LegLengthDiff */
-    MatMult(Jacobian, StrutLengthDiff, delta);
-
-    /* subtract delta from last iterations pos values */
-    q_trans.x -= delta[0];
-    q_trans.y -= delta[1];
-    q_trans.z -= delta[2];
-    q_RPY.r   -= delta[3];
-    q_RPY.p   -= delta[4];
-    q_RPY.y   -= delta[5];
-
     /* determine value of conv_error (used to determine if no convergence) */
     conv_err = 0.0;
     for (i = 0; i < NUM_STRUTS; i++) {
@@ -431,6 +483,21 @@ int kinematicsForward(const double * joints,
     iterate = 1;
       }
     }
+
+    /* solve Inverse Jacobian * delta = LegLengthDiff
+       (overwrites StrutLengthDiff) */
+    if (0 != MatSolve(InverseJacobian, StrutLengthDiff, delta)) {
+      hist->count = 0;
+      return -1;
+    }
+
+    /* subtract delta from last iterations pos values */
+    q_trans.x -= delta[0];
+    q_trans.y -= delta[1];
+    q_trans.z -= delta[2];
+    q_RPY.r   -= delta[3];
+    q_RPY.p   -= delta[4];
+    q_RPY.y   -= delta[5];
   } /* exit Newton-Raphson Iterative loop */
 
   /* assign r,p,y to a,b,c */
@@ -448,6 +515,18 @@ int kinematicsForward(const double * joints,
   if (iteration > *haldata->max_iter){
     *haldata->max_iter = iteration;
   }
+
+  elapsed = rtapi_get_time() - start_time;
+  *haldata->last_time = elapsed;
+  if (elapsed > *haldata->max_time){
+    *haldata->max_time = elapsed;
+  }
+
+  hist->prev = hist->last;
+  hist->last = *pos;
+  if (hist->count < 2) {
+    hist->count++;
+  }
   return 0;
 }
 
@@ -515,7 +594,6 @@ KINEMATICS_TYPE kinematicsType()
 }
 
 
-#include "rtapi.h"      /* RTAPI realtime OS API */
 #include "rtapi_app.h"      /* RTAPI realtime module decls */
 
 EXPORT_SYMBOL(kinematicsType);
@@ -621,6 +699,26 @@ int rtapi_app_main(void)
     goto error;
     haldata->iter_limit = 120;
 
+    if ((res = hal_param_u32_newf(HAL_RW, &haldata->time_budget, comp_id,
+        "genhexkins.time-budget")) < 0)
+    goto error;
+    haldata->time_budget = 0;
+
+    if ((res = hal_pin_u32_newf(HAL_OUT, &haldata->last_time, comp_id,
+        "genhexkins.last-time")) < 0)
+    goto error;
+    *haldata->last_time = 0;
+
+    if ((res = hal_pin_u32_newf(HAL_OUT, &haldata->max_time, comp_id,
+        "genhexkins.max-time")) < 0)
+    goto error;
+    *haldata->max_time = 0;
+
+    if ((res = hal_pin_u32_newf(HAL_OUT, &haldata->budget_overruns, comp_id,
+        "genhexkins.budget-overruns")) < 0)
+    goto error;
+    *haldata->budget_overruns = 0;
+
     if ((res = hal_pin_float_newf(HAL_IN, &haldata->tool_offset, comp_id,
         "genhexkins.tool-offset")) < 0)
     goto error;
@@ -12,6 +12,7 @@
 ********************************************************************/
 
 #include "posemath.h"
+#include "posemath_inline.h"
 #include "tc_types.h"
 #include "tc.h"
 #include "tp_types.h"
@@ -408,6 +409,26 @@ int findIntersectionAngle(PmCartesian const * const u1,
 }
 
 
+/**
+ * Closed-form sine and cosine of the intersection angle.
+ * Since theta = acos(-dot) / 2, the half-angle identities give sin(theta)
+ * and cos(theta) directly from the dot product of the unit vectors, without
+ * evaluating acos, sin or cos. Use this instead of findIntersectionAngle
+ * when only the trig values are needed.
+ */
+int findIntersectionAngleSinCos(PmCartesian const * const u1,
+        PmCartesian const * const u2, double * const sin_theta,
+        double * const cos_theta)
+{
+    double dot = pmCartCartDotV(*u1, *u2);
+    sat_inplace(&dot, 1.0);
+
+    *sin_theta = pmSqrt((1.0 + dot) / 2.0);
+    *cos_theta = pmSqrt((1.0 - dot) / 2.0);
+    return TP_ERR_OK;
+}
+
+
 /** Calculate the minimum of the three values in a PmCartesian. */
 double pmCartMin(PmCartesian const * const in)
 {
@@ -594,6 +615,10 @@ int blendGeom3Init(BlendGeom3 * const geom,
     int res_angle = findIntersectionAngle(&geom->u_tan1,
             &geom->u_tan2,
             &geom->theta_tan);
+    findIntersectionAngleSinCos(&geom->u_tan1,
+            &geom->u_tan2,
+            &geom->sin_tan,
+            &geom->cos_tan);
 
     // Test for intersection angle errors
     if(PM_PI / 2.0 - geom->theta_tan < TP_ANGLE_EPSILON) {
@@ -636,6 +661,17 @@ int blendParamKinematics(BlendGeom3 * const geom,
     // KLUDGE: common operations, but not exactly kinematics
     param->phi = (PM_PI - param->theta * 2.0);
 
+    // Fast path: theta is usually the tangent intersection angle (always for
+    // line-line blends), whose sin / cos are already known in closed form.
+    if (param->theta == geom->theta_tan) {
+        param->sin_theta = geom->sin_tan;
+        param->cos_theta = geom->cos_tan;
+    } else {
+        param->sin_theta = sin(param->theta);
+        param->cos_theta = cos(param->theta);
+    }
+    param->tan_theta = param->sin_theta / param->cos_theta;
+
     double nominal_tolerance;
     tcFindBlendTolerance(prev_tc, tc, &param->tolerance, &nominal_tolerance);
 
@@ -658,16 +694,20 @@ int blendParamKinematics(BlendGeom3 * const geom,
     tp_debug_print("v_planar_max = %f\n", v_planar_max);
 
     // Clip the angle at a reasonable value (less than 90 deg), to prevent div by zero
-    double phi_effective = fmin(param->phi, PM_PI * 0.49);
+    // cos(phi) = cos(pi - 2 theta) = sin^2(theta) - cos^2(theta)
+    double cos_phi_effective = cos(PM_PI * 0.49);
+    if (param->phi < PM_PI * 0.49) {
+        cos_phi_effective = pmSq(param->sin_theta) - pmSq(param->cos_theta);
+    }
 
     // Copy over maximum velocities, clipping velocity to place altitude within base
-    double v_max1 = fmin(prev_tc->maxvel, tc->maxvel / cos(phi_effective));
-    double v_max2 = fmin(tc->maxvel, prev_tc->maxvel / cos(phi_effective));
+    double v_max1 = fmin(prev_tc->maxvel, tc->maxvel / cos_phi_effective);
+    double v_max2 = fmin(tc->maxvel, prev_tc->maxvel / cos_phi_effective);
 
     tp_debug_print("v_max1 = %f, v_max2 = %f\n", v_max1, v_max2);
 
-    // Get "altitude"
-    double v_area = v_max1 * v_max2 / 2.0 * sin(param->phi);
+    // Get "altitude", using sin(phi) = sin(2 theta)
+    double v_area = v_max1 * v_max2 * param->sin_theta * param->cos_theta;
     tp_debug_print("phi = %f\n", param->phi);
     tp_debug_print("v_area = %f\n", v_area);
 
@@ -1118,17 +1158,17 @@ int blendComputeParameters(BlendParameters * const param)
 {
 
     // Find maximum distance h from arc center to intersection point
-    double h_tol = param->tolerance / (1.0 - sin(param->theta));
+    double h_tol = param->tolerance / (1.0 - param->sin_theta);
 
     // Find maximum distance along lines allowed by tolerance
-    double d_tol = cos(param->theta) * h_tol;
+    double d_tol = param->cos_theta * h_tol;
     tp_debug_print(" d_tol = %f\n", d_tol);
 
     // Find minimum distance by blend length constraints
     double d_lengths = fmin(param->L1, param->L2);
     double d_geom = fmin(d_lengths, d_tol);
     // Find radius from the limiting length
-    double R_geom = tan(param->theta) * d_geom;
+    double R_geom = param->tan_theta * d_geom;
 
     // Find maximum velocity allowed by accel and radius
     double v_normal = pmSqrt(param->a_n_max * R_geom);
@@ -1151,7 +1191,7 @@ int blendComputeParameters(BlendParameters * const param)
     double R_blend = fmin(s_blend / param->phi, R_geom);   //Clamp by limiting radius
 
     param->R_plan = fmax(pmSq(param->v_plan) / param->a_n_max, R_blend);
-    param->d_plan = param->R_plan / tan(param->theta);
+    param->d_plan = param->R_plan / param->tan_theta;
 
     tp_debug_print("v_plan = %f\n", param->v_plan);
     tp_debug_print("R_plan = %f\n", param->R_plan);
@@ -1225,11 +1265,10 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
         BlendParameters const * const param)
 {
     // Find center of blend arc along normal vector
-    double center_dist = param->R_plan / sin(param->theta);
+    double center_dist = param->R_plan / param->sin_theta;
     tp_debug_print("center_dist = %f\n", center_dist);
 
-    pmCartScalMult(&geom->normal, center_dist, &points->arc_center);
-    pmCartCartAddEq(&points->arc_center, &geom->P);
+    points->arc_center = pmCartCartScaleAddV(geom->P, center_dist, geom->normal);
     tp_debug_print("arc_center = %f %f %f\n",
             points->arc_center.x,
             points->arc_center.y,
@@ -1237,8 +1276,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
 
     // Start point is d_plan away from intersection P in the
     // negative direction of u1
-    pmCartScalMult(&geom->u1, -param->d_plan, &points->arc_start);
-    pmCartCartAddEq(&points->arc_start, &geom->P);
+    points->arc_start = pmCartCartScaleAddV(geom->P, -param->d_plan, geom->u1);
     tp_debug_print("arc_start = %f %f %f\n",
             points->arc_start.x,
             points->arc_start.y,
@@ -1246,8 +1284,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
 
     // End point is d_plan away from intersection P in the
     // positive direction of u1
-    pmCartScalMult(&geom->u2, param->d_plan, &points->arc_end);
-    pmCartCartAddEq(&points->arc_end, &geom->P);
+    points->arc_end = pmCartCartScaleAddV(geom->P, param->d_plan, geom->u2);
     tp_debug_print("arc_end = %f %f %f\n",
             points->arc_end.x,
             points->arc_end.y,
@@ -45,6 +45,8 @@ typedef struct {
     double radius1;         /* Local approximation of radius */
     double radius2;
     double theta_tan;
+    double sin_tan;         /* sin(theta_tan), found in closed form */
+    double cos_tan;         /* cos(theta_tan), found in closed form */
     double v_max1;          /* maximum velocity in direction u_tan1 */
     double v_max2;          /* maximum velocity in direction u_tan2 */
 
@@ -80,6 +82,9 @@ typedef struct {
     
     double theta;       /* Intersection angle, half of angle between -u1 and u2 */
     double phi;         /* supplement of intersection angle, angle between u1 and u2 */
+    double sin_theta;   /* cached sin, cos and tan of theta */
+    double cos_theta;
+    double tan_theta;
     double a_n_max;     /* max normal acceleration allowed */
 
     double R_plan;      /* planned radius for blend arc */
@@ -139,6 +144,10 @@ int checkTangentAngle(PmCircle const * const circ, SphericalArc const * const ar
 int findIntersectionAngle(PmCartesian const * const u1,
         PmCartesian const * const u2, double * const theta);
 
+int findIntersectionAngleSinCos(PmCartesian const * const u1,
+        PmCartesian const * const u2, double * const sin_theta,
+        double * const cos_theta);
+
 double pmCartMin(PmCartesian const * const in);
 
 int calculateInscribedDiameter(PmCartesian const * const normal,
@@ -12,6 +12,7 @@
  ********************************************************************/
 
 #include "posemath.h"
+#include "posemath_inline.h"
 #include "spherical_arc.h"
 #include "tp_types.h"
 #include "rtapi_math.h"
@@ -93,20 +94,16 @@ int arcPoint(SphericalArc const * const arc, double progress, PmCartesian * cons
     if (net_progress <= 0.0 && arc->line_length > 0) {
         tc_debug_print("net_progress = %f, line_length = %f\n", net_progress, arc->line_length);
         //Get position on line (not actually an angle in this case)
-        pmCartScalMult(&arc->uTan, net_progress, out);
-        pmCartCartAdd(out, &arc->start, out);
+        *out = pmCartCartScaleAddV(arc->start, net_progress, arc->uTan);
     } else {
         double angle_in = net_progress / arc->radius;
         tc_debug_print("angle_in = %f, angle_total = %f\n", angle_in, arc->angle);
         double scale0 = sin(arc->angle - angle_in) / arc->Sangle;
         double scale1 = sin(angle_in) / arc->Sangle;
 
-        PmCartesian interp0,interp1;
-        pmCartScalMult(&arc->rStart, scale0, &interp0);
-        pmCartScalMult(&arc->rEnd, scale1, &interp1);
-
-        pmCartCartAdd(&interp0, &interp1, out);
-        pmCartCartAdd(&arc->center, out, out);
+        PmCartesian interp = pmCartCartAddV(pmCartScalMultV(arc->rStart, scale0),
+                pmCartScalMultV(arc->rEnd, scale1));
+        *out = pmCartCartAddV(arc->center, interp);
     }
     return TP_ERR_OK;
 }
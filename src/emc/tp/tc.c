@@ -269,9 +269,6 @@ int tcGetEndpoint(TC_STRUCT const * const tc, EmcPose * const out) {
 
 int tcGetPosReal(TC_STRUCT const * const tc, int of_point, EmcPose * const pos)
 {
-    PmCartesian xyz;
-    PmCartesian abc;
-    PmCartesian uvw;
     double progress=0.0;
 
     switch (of_point) {
@@ -286,6 +283,20 @@ int tcGetPosReal(TC_STRUCT const * const tc, int of_point, EmcPose * const pos)
             break;
     }
 
+    return tcGetPosAtProgress(tc, progress, pos);
+}
+
+
+/**
+ * Find the position of a segment at an arbitrary progress along its length.
+ * Used by tcGetPosReal, and by the planner to sample a segment before it is
+ * queued.
+ */
+int tcGetPosAtProgress(TC_STRUCT const * const tc, double progress, EmcPose * const pos)
+{
+    PmCartesian xyz;
+    PmCartesian abc;
+    PmCartesian uvw;
 
     // Used for arc-length to angle conversion with spiral segments
     double angle = 0.0;
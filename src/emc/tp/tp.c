@@ -182,6 +182,123 @@ STATIC int tpGetMachineActiveLimit(double * const act_limit, PmCartesian const *
 }
 
 
+/**
+ * Take the joint positions at goalPos from the commanded joint positions.
+ * Valid whenever goalPos is the current position.
+ */
+STATIC void tpSetGoalJointsFromCommand(TP_STRUCT * const tp)
+{
+    int joint_num;
+    for (joint_num = 0; joint_num < EMCMOT_MAX_JOINTS; joint_num++) {
+        tp->goalJoints[joint_num] = emcmotDebug->joints[joint_num].pos_cmd;
+    }
+}
+
+
+/**
+ * Keep the joint positions at the end of a segment just queued.
+ */
+STATIC void tpSetGoalJoints(TP_STRUCT * const tp, double const * const joints)
+{
+    int joint_num;
+    for (joint_num = 0; joint_num < EMCMOT_MAX_JOINTS; joint_num++) {
+        tp->goalJoints[joint_num] = joints[joint_num];
+    }
+}
+
+
+/**
+ * Limit a segment's maximum velocity by the joint velocity limits.
+ * With non-identity kinematics, a constant cartesian feed can demand joint
+ * speeds well above the joint limits (near a singularity, or far from a
+ * rotary axis). Sample the segment through the inverse kinematics, find the
+ * worst-case joint displacement per unit of path length for each joint, and
+ * cap the segment's maxvel so that no joint exceeds its velocity limit.
+ * Only the affected segments slow down; the optimizer sees the reduced maxvel.
+ */
+STATIC int tpClampVelocityByJointLimits(TP_STRUCT const * const tp,
+        TC_STRUCT * const tc,
+        double * const joint_end)
+{
+    int joint_num, k;
+
+    // Until the segment is sampled, its end is the start
+    for (joint_num = 0; joint_num < EMCMOT_MAX_JOINTS; joint_num++) {
+        joint_end[joint_num] = tp->goalJoints[joint_num];
+    }
+
+    if (emcmotConfig->kinType == KINEMATICS_IDENTITY) {
+        // Joint limits are already applied per axis by task
+        return TP_ERR_NO_ACTION;
+    }
+    if (tc->motion_type == TC_RIGIDTAP || tc->target < TP_POS_EPSILON) {
+        return TP_ERR_NO_ACTION;
+    }
+
+    double joint_prev[EMCMOT_MAX_JOINTS];
+    double joint_this[EMCMOT_MAX_JOINTS];
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    EmcPose pos;
+
+    // Seed iterative inverse kinematics with the joints at the segment's
+    // start, the end of the previous one, and each sample with the last
+    for (joint_num = 0; joint_num < emcmotConfig->numJoints; joint_num++) {
+        joint_prev[joint_num] = tp->goalJoints[joint_num];
+    }
+
+    tcGetPosAtProgress(tc, 0.0, &pos);
+    if (kinematicsInverse(&pos, joint_prev, &iflags, &fflags) < 0) {
+        tp_debug_print("kinematicsInverse failed at segment start, not clamping\n");
+        return TP_ERR_FAIL;
+    }
+
+    double ds = tc->target / TP_JOINT_VEL_SAMPLES;
+    double v_joint_max = tc->maxvel;
+
+    for (k = 1; k <= TP_JOINT_VEL_SAMPLES; ++k) {
+        for (joint_num = 0; joint_num < emcmotConfig->numJoints; joint_num++) {
+            joint_this[joint_num] = joint_prev[joint_num];
+        }
+        tcGetPosAtProgress(tc, ds * k, &pos);
+        if (kinematicsInverse(&pos, joint_this, &iflags, &fflags) < 0) {
+            tp_debug_print("kinematicsInverse failed at sample %d, not clamping\n", k);
+            return TP_ERR_FAIL;
+        }
+
+        for (joint_num = 0; joint_num < emcmotConfig->numJoints; joint_num++) {
+            emcmot_joint_t const * const joint = &emcmotDebug->joints[joint_num];
+            if (!GET_JOINT_ACTIVE_FLAG(joint) || joint->vel_limit <= 0.0) {
+                continue;
+            }
+            double dq = fabs(joint_this[joint_num] - joint_prev[joint_num]);
+            if (!isfinite(dq)) {
+                return TP_ERR_FAIL;
+            }
+            // Joint speed ratio is dq / ds, so v_max = vel_limit * ds / dq
+            if (dq * v_joint_max > joint->vel_limit * ds) {
+                v_joint_max = joint->vel_limit * ds / dq;
+            }
+        }
+        for (joint_num = 0; joint_num < emcmotConfig->numJoints; joint_num++) {
+            joint_prev[joint_num] = joint_this[joint_num];
+        }
+    }
+
+    for (joint_num = 0; joint_num < emcmotConfig->numJoints; joint_num++) {
+        joint_end[joint_num] = joint_prev[joint_num];
+    }
+
+    if (v_joint_max < tc->maxvel) {
+        tp_debug_print("joint velocity limits clamp maxvel from %f to %f\n",
+                tc->maxvel, v_joint_max);
+        tc->maxvel = v_joint_max;
+        return TP_ERR_OK;
+    }
+    return TP_ERR_NO_ACTION;
+}
+
+
 /**
  * Get a segment's feed scale based on the current planner state and emcmotStatus.
  * @note depends on emcmotStatus for system information.
@@ -375,6 +492,7 @@ int tpClear(TP_STRUCT * const tp)
     tcqInit(&tp->queue);
     tp->queueSize = 0;
     tp->goalPos = tp->currentPos;
+    tpSetGoalJointsFromCommand(tp);
     tp->nextId = 0;
     tp->execId = 0;
     tp->motionType = 0;
@@ -576,6 +694,7 @@ int tpSetPos(TP_STRUCT * const tp, EmcPose const * const pos)
     }
 
     tp->goalPos = *pos;
+    tpSetGoalJointsFromCommand(tp);
     return TP_ERR_OK;
 }
 
@@ -1901,6 +2020,8 @@ int tpAddLine(TP_STRUCT * const tp, EmcPose end, int canon_motion_type, double v
     }
     tc.nominal_length = tc.target;
     tcClampVelocityByLength(&tc);
+    double goal_joints[EMCMOT_MAX_JOINTS];
+    tpClampVelocityByJointLimits(tp, &tc, goal_joints);
 
     // For linear move, set rotary axis settings 
     tc.indexrotary = indexrotary;
@@ -1917,6 +2038,9 @@ int tpAddLine(TP_STRUCT * const tp, EmcPose end, int canon_motion_type, double v
     tcFlagEarlyStop(prev_tc, &tc);
 
     int retval = tpAddSegmentToQueue(tp, &tc, true);
+    if (retval == TP_ERR_OK) {
+        tpSetGoalJoints(tp, goal_joints);
+    }
     //Run speed optimization (will abort safely if there are no tangent segments)
     tpRunOptimization(tp);
 
@@ -1996,6 +2120,8 @@ int tpAddCircle(TP_STRUCT * const tp,
             vel,
             v_max_actual,
             acc);
+    double goal_joints[EMCMOT_MAX_JOINTS];
+    tpClampVelocityByJointLimits(tp, &tc, goal_joints);
 
     TC_STRUCT *prev_tc;
     prev_tc = tcqLast(&tp->queue);
@@ -2010,6 +2136,9 @@ int tpAddCircle(TP_STRUCT * const tp,
     tcFlagEarlyStop(prev_tc, &tc);
 
     int retval = tpAddSegmentToQueue(tp, &tc, true);
+    if (retval == TP_ERR_OK) {
+        tpSetGoalJoints(tp, goal_joints);
+    }
 
     tpRunOptimization(tp);
     return retval;
@@ -2067,7 +2196,6 @@ STATIC int tpComputeBlendVelocity(TP_STRUCT const * const tp,
     double v_blend_this = fmin(v_reachable_this, t_blend * acc_this);
     double v_blend_next = fmin(v_reachable_next, t_blend * acc_next);
 
-    double theta;
     if (tc->tolerance > 0) {
         /* see diagram blend.fig.  T (blend tolerance) is given, theta
          * is calculated from dot(s1, s2)
@@ -2086,13 +2214,15 @@ STATIC int tpComputeBlendVelocity(TP_STRUCT const * const tp,
         double tblend_vel;
         PmCartesian v1, v2;
 
+        double sin_theta, cos_theta;
+
         tcGetEndAccelUnitVector(tc, &v1);
         tcGetStartAccelUnitVector(nexttc, &v2);
-        findIntersectionAngle(&v1, &v2, &theta);
+        findIntersectionAngleSinCos(&v1, &v2, &sin_theta, &cos_theta);
         /* Minimum value of cos(theta) to prevent numerical instability */
         const double min_cos_theta = cos(PM_PI / 2.0 - TP_MIN_ARC_ANGLE);
-        if (cos(theta) > min_cos_theta) {
-            tblend_vel = 2.0 * pmSqrt(acc_this * tc->tolerance / cos(theta));
+        if (cos_theta > min_cos_theta) {
+            tblend_vel = 2.0 * pmSqrt(acc_this * tc->tolerance / cos_theta);
             v_blend_this = fmin(v_blend_this, tblend_vel);
             v_blend_next = fmin(v_blend_next, tblend_vel);
         }
@@ -2454,6 +2584,7 @@ STATIC void tpHandleEmptyQueue(TP_STRUCT * const tp)
 
     tcqInit(&tp->queue);
     tp->goalPos = tp->currentPos;
+    tpSetGoalJointsFromCommand(tp);
     tp->done = 1;
     tp->depth = tp->activeDepth = 0;
     tp->aborting = 0;
@@ -2534,6 +2665,7 @@ STATIC int tpHandleAbort(TP_STRUCT * const tp, TC_STRUCT * const tc,
             (tc->currentvel == 0.0 && (!nexttc || nexttc->currentvel == 0.0))) {
         tcqInit(&tp->queue);
         tp->goalPos = tp->currentPos;
+        tpSetGoalJointsFromCommand(tp);
         tp->done = 1;
         tp->depth = tp->activeDepth = 0;
         tp->aborting = 0;
@@ -31,6 +31,10 @@
  * the end of the program */
 #define TP_QUEUE_THRESHOLD 3
 
+/* Number of intervals used to sample a segment through the inverse kinematics
+ * when limiting its velocity by the joint velocity limits. */
+#define TP_JOINT_VEL_SAMPLES 8
+
 /* closeness to zero, for determining if a move is pure rotation */
 #define TP_PURE_ROTATION_EPSILON 1e-6
 
@@ -93,6 +97,8 @@ typedef struct {
 
     EmcPose currentPos;
     EmcPose goalPos;
+    double goalJoints[EMCMOT_MAX_JOINTS]; /* joint positions at goalPos, to
+                                             seed the inverse kinematics */
 
     int queueSize;
     double cycleTime;
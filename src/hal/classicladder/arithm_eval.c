@@ -690,3 +690,507 @@ char * VerifySyntaxForMakeCalc(char * StringToVerify)
 	return VerifyErrorDesc;
 }
 
+
+
+/* Compiled expressions */
+/* -------------------- */
+/* The parser above works on the string at each refresh. The functions */
+/* below parse it once (same grammar) to a small stack bytecode, which */
+/* ExecArithmCode( ) runs in the refresh. An expression that does not */
+/* compile keeps being evaluated from its string, exactly as before. */
+
+#define OP_CONST 1
+#define OP_VAR 2	/* Arg=1: indexed, next instruction is the index var */
+#define OP_INDEX 3
+#define OP_NOT 4
+#define OP_POW 5
+#define OP_MUL 6
+#define OP_DIV 7
+#define OP_MOD 8
+#define OP_ADD 9
+#define OP_SUB 10
+#define OP_AND 11
+#define OP_XOR 12
+#define OP_OR 13
+#define OP_ABS 14
+#define OP_MINI 15	/* Arg: number of parameters */
+#define OP_MAXI 16
+#define OP_AVG 17
+#define OP_COMPARE 18	/* Arg and Value: the 2 chars of the operator */
+#define OP_STORE 19	/* Arg=1: indexed, as OP_VAR */
+
+StrArithmExpr * CompExpr;
+
+void CompEmit(char Op, char Arg, int VarType, int Value)
+{
+	StrArithmInstr * pInstr;
+	if ( CompExpr->CodeLength>=ARITHM_CODE_SIZE )
+	{
+		ErrorDesc = "Expression too long to compile";
+		return;
+	}
+	pInstr = &CompExpr->Code[ CompExpr->CodeLength++ ];
+	pInstr->Op = Op;
+	pInstr->Arg = Arg;
+	pInstr->VarType = VarType;
+	pInstr->Value = Value;
+}
+
+/* emit a var (OP_VAR or OP_STORE) and flush it as Variable() does */
+void CompVarOp(char Op)
+{
+	int VarType,VarOffset,IndexVarType,IndexVarOffset;
+	if ( !IdentifyVarIndexedOrNot( Expr, &VarType, &VarOffset, &IndexVarType, &IndexVarOffset ) )
+	{
+		ErrorDesc = "Bad var coding";
+		return;
+	}
+	Expr++;
+	do
+	{
+		Expr++;
+	}
+	while( (*Expr!='@') && (*Expr!='\0') );
+	if ( *Expr=='\0' )
+	{
+		ErrorDesc = "Bad var coding (missing @)";
+		return;
+	}
+	Expr++;
+	if ( IndexVarType!=-1 && IndexVarOffset!=-1 )
+	{
+		CompEmit( Op, 1, VarType, VarOffset );
+		CompEmit( OP_INDEX, 0, IndexVarType, IndexVarOffset );
+	}
+	else
+	{
+		CompEmit( Op, 0, VarType, VarOffset );
+	}
+}
+
+void CompOr(void);
+
+void CompFunction(void)
+{
+	char tcFonc[ 20 ], *pFonc;
+	char Op;
+	int NbrVars = 0;
+
+	pFonc = tcFonc;
+	while((unsigned int)(pFonc-tcFonc)<sizeof(tcFonc)-1 && *Expr>='A' && *Expr<='Z')
+	{
+		*pFonc++ = *Expr;
+		Expr++;
+	}
+	*pFonc = '\0';
+
+	if ( !strcmp(tcFonc, "ABS") )
+	{
+		Expr++; /* ( */
+		CompVarOp( OP_VAR );
+		CompEmit( OP_ABS, 0, 0, 0 );
+		Expr++; /* ) */
+		return;
+	}
+	if ( !strcmp(tcFonc, "MINI") )
+		Op = OP_MINI;
+	else if ( !strcmp(tcFonc, "MAXI") )
+		Op = OP_MAXI;
+	else if ( !strcmp(tcFonc, "MOY") || !strcmp(tcFonc, "AVG") )
+		Op = OP_AVG;
+	else
+	{
+		ErrorDesc = "Unknown function";
+		return;
+	}
+	do
+	{
+		Expr++; /* ( -or- , */
+		CompVarOp( OP_VAR );
+		NbrVars++;
+		if ( ErrorDesc )
+			return;
+	}
+	while( *Expr!=')' && *Expr!='\0' );
+	if ( *Expr=='\0' )
+	{
+		ErrorDesc = "Missing parenthesis";
+		return;
+	}
+	Expr++; /* ) */
+	CompEmit( Op, NbrVars, 0, 0 );
+}
+
+void CompTerm(void)
+{
+	if (*Expr=='(')
+	{
+		Expr++;
+		CompOr();
+		if (*Expr!=')')
+		{
+			ErrorDesc = "Missing parenthesis";
+			return;
+		}
+		Expr++;
+	}
+	else if ( (*Expr>='0' && *Expr<='9') || (*Expr=='$') || (*Expr=='-') )
+		CompEmit( OP_CONST, 0, 0, Constant() );
+	else if (*Expr>='A' && *Expr<='Z')
+		CompFunction();
+	else if (*Expr=='@')
+		CompVarOp( OP_VAR );
+	else if (*Expr=='!')
+	{
+		Expr++;
+		CompTerm();
+		CompEmit( OP_NOT, 0, 0, 0 );
+	}
+	else
+	{
+		ErrorDesc = "Unknown term";
+	}
+}
+
+void CompPow(void)
+{
+	CompTerm();
+	while(*Expr=='^')
+	{
+		if ( ErrorDesc )
+			break;
+		Expr++;
+		CompPow();
+		CompEmit( OP_POW, 0, 0, 0 );
+	}
+}
+
+void CompMulDivMod(void)
+{
+	char Op;
+	CompPow();
+	while( !ErrorDesc )
+	{
+		if (*Expr=='*')
+			Op = OP_MUL;
+		else if (*Expr=='/')
+			Op = OP_DIV;
+		else if (*Expr=='%')
+			Op = OP_MOD;
+		else
+			break;
+		Expr++;
+		CompPow();
+		CompEmit( Op, 0, 0, 0 );
+	}
+}
+
+void CompAddSub(void)
+{
+	char Op;
+	CompMulDivMod();
+	while( !ErrorDesc )
+	{
+		if (*Expr=='+')
+			Op = OP_ADD;
+		else if (*Expr=='-')
+			Op = OP_SUB;
+		else
+			break;
+		Expr++;
+		CompMulDivMod();
+		CompEmit( Op, 0, 0, 0 );
+	}
+}
+
+void CompAnd(void)
+{
+	CompAddSub();
+	while( !ErrorDesc && *Expr=='&' )
+	{
+		Expr++;
+		CompAddSub();
+		CompEmit( OP_AND, 0, 0, 0 );
+	}
+}
+
+void CompXor(void)
+{
+	CompAnd();
+	while( !ErrorDesc && *Expr=='^' )
+	{
+		Expr++;
+		CompAnd();
+		CompEmit( OP_XOR, 0, 0, 0 );
+	}
+}
+
+void CompOr(void)
+{
+	CompXor();
+	while( !ErrorDesc && *Expr=='|' )
+	{
+		Expr++;
+		CompXor();
+		CompEmit( OP_OR, 0, 0, 0 );
+	}
+}
+
+/* common start/end of the compile of an expression, keeping */
+/* the parser quiet and the verify state of the editor untouched */
+int CompUnderVerifyBak;
+char * CompVerifyErrorDescBak;
+void CompBegin(StrArithmExpr * pExpr)
+{
+	pExpr->Compiled = FALSE;
+	pExpr->CodeLength = 0;
+	CompExpr = pExpr;
+	CompUnderVerifyBak = UnderVerify;
+	CompVerifyErrorDescBak = VerifyErrorDesc;
+	UnderVerify = TRUE;
+	ErrorDesc = NULL;
+}
+int CompEnd(void)
+{
+	UnderVerify = CompUnderVerifyBak;
+	VerifyErrorDesc = CompVerifyErrorDescBak;
+	if ( ErrorDesc )
+		return FALSE;
+	CompExpr->Compiled = TRUE;
+	return TRUE;
+}
+
+/* Compile an expression used by a compare element, see EvalCompare() */
+/* return TRUE if compiled */
+int CompileEvalCompare(StrArithmExpr * pExpr)
+{
+	char StrCopy[ARITHM_EXPR_SIZE+1];
+	char * SearchSep = pExpr->Expr;
+	char * SecondExpr;
+	int Pos;
+
+	CompBegin( pExpr );
+	/* null expression ? (evaluated to false) */
+	if (*SearchSep=='\0' || *SearchSep=='#')
+		return CompEnd( );
+
+	while( *SearchSep!='\0' && *SearchSep!='>' && *SearchSep!='<' && *SearchSep!='=' )
+		SearchSep++;
+	if ( *SearchSep=='\0' )
+	{
+		ErrorDesc = "Missing < or > or = or ... to make compare";
+		return CompEnd( );
+	}
+	strcpy( StrCopy, pExpr->Expr );
+	Pos = SearchSep-pExpr->Expr;
+	StrCopy[ Pos ] = '\0';
+	SecondExpr = &StrCopy[ Pos+1 ];
+	/* 2 chars if '>=' or '<=' or '<>' */
+	if ( *SecondExpr=='=' || *SecondExpr=='>' )
+		SecondExpr++;
+
+	Expr = StrCopy;
+	CompOr( );
+	if ( !ErrorDesc )
+	{
+		Expr = SecondExpr;
+		CompOr( );
+	}
+	CompEmit( OP_COMPARE, SearchSep[0], 0, SearchSep[1] );
+	return CompEnd( );
+}
+
+/* Compile an expression used by an operate element, see MakeCalc() */
+/* return TRUE if compiled */
+int CompileMakeCalc(StrArithmExpr * pExpr)
+{
+	StrArithmExpr Target;
+	char * ScanBak;
+	int Found = FALSE;
+
+	CompBegin( pExpr );
+	/* null expression ? (nothing to do) */
+	if (pExpr->Expr[0]=='\0' || pExpr->Expr[0]=='#')
+		return CompEnd( );
+
+	/* the store of the target goes last, after the value */
+	Expr = pExpr->Expr;
+	CompExpr = &Target;
+	Target.CodeLength = 0;
+	CompVarOp( OP_STORE );
+	CompExpr = pExpr;
+	if ( ErrorDesc )
+		return CompEnd( );
+	/* verify if there is the '=' or ':=' */
+	do
+	{
+		ScanBak = Expr;
+		if (*Expr==':')
+			Expr++;
+		if (*Expr=='=')
+		{
+			Found = TRUE;
+			Expr++;
+		}
+		if (*Expr==' ')
+			Expr++;
+	}
+	while( !Found && *Expr!='\0' && Expr!=ScanBak );
+	while( *Expr==' ')
+		Expr++;
+	if ( !Found )
+	{
+		ErrorDesc = "Missing := to make operate";
+		return CompEnd( );
+	}
+	CompOr( );
+	if ( !ErrorDesc )
+	{
+		int Scan;
+		for ( Scan=0; Scan<Target.CodeLength; Scan++ )
+			CompEmit( Target.Code[Scan].Op, Target.Code[Scan].Arg, Target.Code[Scan].VarType, Target.Code[Scan].Value );
+	}
+	return CompEnd( );
+}
+
+int ReadCodeVar(StrArithmInstr * pInstr)
+{
+	int Offset = pInstr->Value;
+	if ( pInstr->Arg )
+		Offset = Offset + ReadVar( pInstr[1].VarType, pInstr[1].Value );
+	return ReadVar( pInstr->VarType, Offset );
+}
+
+/* Run a compiled expression, return the value left on the stack */
+arithmtype ExecArithmCode(StrArithmExpr * pExpr)
+{
+	arithmtype Stack[ARITHM_CODE_SIZE];
+	arithmtype Res;
+	int Top = -1;
+	int Pc,Scan;
+	StrArithmInstr * pInstr;
+
+	for ( Pc=0; Pc<pExpr->CodeLength; Pc++ )
+	{
+		pInstr = &pExpr->Code[ Pc ];
+		switch( pInstr->Op )
+		{
+			case OP_CONST:
+				Stack[ ++Top ] = pInstr->Value;
+				break;
+			case OP_VAR:
+				Stack[ ++Top ] = ReadCodeVar( pInstr );
+				if ( pInstr->Arg )
+					Pc++;
+				break;
+			case OP_NOT:
+				Stack[ Top ] = Stack[ Top ]?0:1;
+				break;
+			case OP_POW:
+				Top--;
+				Stack[ Top ] = pow_int( Stack[ Top ], Stack[ Top+1 ] );
+				break;
+			case OP_MUL:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] * Stack[ Top+1 ];
+				break;
+			case OP_DIV:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] / Stack[ Top+1 ];
+				break;
+			case OP_MOD:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] % Stack[ Top+1 ];
+				break;
+			case OP_ADD:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] + Stack[ Top+1 ];
+				break;
+			case OP_SUB:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] - Stack[ Top+1 ];
+				break;
+			case OP_AND:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] & Stack[ Top+1 ];
+				break;
+			case OP_XOR:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] ^ Stack[ Top+1 ];
+				break;
+			case OP_OR:
+				Top--;
+				Stack[ Top ] = Stack[ Top ] | Stack[ Top+1 ];
+				break;
+			case OP_ABS:
+				if ( Stack[ Top ]<0 )
+					Stack[ Top ] = Stack[ Top ] * -1;
+				break;
+			case OP_MINI:
+			case OP_MAXI:
+			case OP_AVG:
+				Res = pInstr->Op==OP_MINI?0x7FFFFFFF:(pInstr->Op==OP_MAXI?(int)0x80000000:0);
+				for ( Scan=Top-pInstr->Arg+1; Scan<=Top; Scan++ )
+				{
+					if ( pInstr->Op==OP_MINI && Stack[ Scan ]<Res )
+						Res = Stack[ Scan ];
+					else if ( pInstr->Op==OP_MAXI && Stack[ Scan ]>Res )
+						Res = Stack[ Scan ];
+					else if ( pInstr->Op==OP_AVG )
+						Res = Res + Stack[ Scan ];
+				}
+				if ( pInstr->Op==OP_AVG )
+					Res = Res/pInstr->Arg;
+				Top = Top-pInstr->Arg+1;
+				Stack[ Top ] = Res;
+				break;
+			case OP_COMPARE:
+			{
+				char Sep = pInstr->Arg;
+				char SepNext = pInstr->Value;
+				arithmtype EvalFirst = Stack[ Top-1 ];
+				arithmtype EvalSecond = Stack[ Top ];
+				Res = 0;
+				if ( Sep=='>' && EvalFirst>EvalSecond )
+					Res = 1;
+				if ( Sep=='<' && SepNext!='>' && EvalFirst<EvalSecond )
+					Res = 1;
+				if ( Sep=='<' && SepNext=='>' && EvalFirst!=EvalSecond )
+					Res = 1;
+				if ( (Sep=='=' || SepNext=='=') && EvalFirst==EvalSecond )
+					Res = 1;
+				Top--;
+				Stack[ Top ] = Res;
+				break;
+			}
+			case OP_STORE:
+			{
+				int Offset = pInstr->Value;
+				if ( pInstr->Arg )
+				{
+					Offset = Offset + ReadVar( pInstr[1].VarType, pInstr[1].Value );
+					Pc++;
+				}
+				WriteVar( pInstr->VarType, Offset, (int)Stack[ Top-- ] );
+				break;
+			}
+		}
+	}
+	return Top>=0?Stack[ Top ]:0;
+}
+
+/* Refresh of a compare element: compiled if possible */
+int EvalCompareExpr(StrArithmExpr * pExpr)
+{
+	if ( pExpr->Compiled )
+		return ExecArithmCode( pExpr );
+	return EvalCompare( pExpr->Expr );
+}
+/* Refresh of an operate element: compiled if possible */
+void MakeCalcExpr(StrArithmExpr * pExpr)
+{
+	if ( pExpr->Compiled )
+		ExecArithmCode( pExpr );
+	else
+		MakeCalc( pExpr->Expr, FALSE /* verify mode */ );
+}
@@ -24,5 +24,9 @@ arithmtype AddSub(void);
 arithmtype Or(void);
 char * VerifySyntaxForEvalCompare(char * StringToVerify);
 char * VerifySyntaxForMakeCalc(char * StringToVerify);
+int CompileEvalCompare(StrArithmExpr * pExpr);
+int CompileMakeCalc(StrArithmExpr * pExpr);
+int EvalCompareExpr(StrArithmExpr * pExpr);
+void MakeCalcExpr(StrArithmExpr * pExpr);
 
 
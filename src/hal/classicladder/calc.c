@@ -64,6 +64,7 @@ void InitRungs()
 				RungArray[NumRung].Element[x][y].DynamicOutput = 0;
 			}
 		}
+		RungArray[NumRung].Compiled = FALSE;
 	}
 	// the rung used in the default section created per default
 	InfosGene->FirstRung = 0;
@@ -94,8 +95,102 @@ void PrepareRungs()
 				}
 			}
 		}
+		if ( RungArray[NumRung].Used )
+			CompileRung( &RungArray[NumRung] );
 	}
 }
+
+/* Build the straight-line form of a rung, used by RefreshRung() : */
+/* - for each block, the rows of the column on its left that are */
+/*   connected to it (what StateOnLeft() searches at each refresh), */
+/* - the list of the blocks to refresh, without the free ones having */
+/*   a constant input (on the left bar or after free blocks only). */
+/* The arithmetic expressions of the rung are compiled too. */
+/* To be called after each load or edit of the rung. */
+void CompileRung(StrRung * Rung)
+{
+	int x,y,PosY,Row;
+	char StillConnected;
+	unsigned char Rows;
+	StrElement * pElement;
+
+	Rung->Compiled = FALSE;
+	for (x=0;x<RUNG_WIDTH;x++)
+	{
+		for (y=0;y<RUNG_HEIGHT;y++)
+		{
+			if (x==0)
+			{
+				Rung->LeftRows[x][y] = 0;
+				continue;
+			}
+			/* same search as StateOnLeft() */
+			Rows = 1<<y;
+			PosY = y;
+			StillConnected = Rung->Element[x][PosY].ConnectedWithTop;
+			while( (PosY>0) && StillConnected)
+			{
+				PosY--;
+				Rows |= 1<<PosY;
+				if ( !(Rung->Element[x][PosY].ConnectedWithTop) )
+					StillConnected = FALSE;
+			}
+			if (y<RUNG_HEIGHT-1)
+			{
+				PosY = y+1;
+				StillConnected = Rung->Element[x][PosY].ConnectedWithTop;
+				while( (PosY<RUNG_HEIGHT) && StillConnected)
+				{
+					Rows |= 1<<PosY;
+					PosY++;
+					if (PosY<RUNG_HEIGHT)
+					{
+						if ( !(Rung->Element[x][PosY].ConnectedWithTop) )
+							StillConnected = FALSE;
+					}
+				}
+			}
+			Rung->LeftRows[x][y] = Rows;
+		}
+	}
+	Rung->NbrCells = 0;
+	for (x=0;x<RUNG_WIDTH;x++)
+	{
+		for (y=0;y<RUNG_HEIGHT;y++)
+		{
+			pElement = &Rung->Element[x][y];
+			switch( pElement->Type )
+			{
+				case ELE_FREE:
+				case ELE_UNUSABLE:
+					/* nothing writes the output of a free block while */
+					/* running, so an input fed only by them is constant */
+					Rows = Rung->LeftRows[x][y];
+					for (Row=0;x>0 && Row<RUNG_HEIGHT;Row++)
+					{
+						if ( (Rows & (1<<Row)) && Rung->Element[x-1][Row].Type!=ELE_FREE )
+							break;
+					}
+					if ( x==0 || Row==RUNG_HEIGHT )
+					{
+						pElement->DynamicInput = StateOnLeft(x,y,Rung);
+						continue;
+					}
+					break;
+				case ELE_COMPAR:
+					if ( pElement->VarNum>=0 && pElement->VarNum<NBR_ARITHM_EXPR )
+						CompileEvalCompare( &ArithmExpr[ pElement->VarNum ] );
+					break;
+				case ELE_OUTPUT_OPERATE:
+					if ( pElement->VarNum>=0 && pElement->VarNum<NBR_ARITHM_EXPR )
+						CompileMakeCalc( &ArithmExpr[ pElement->VarNum ] );
+					break;
+			}
+			Rung->Cells[ Rung->NbrCells++ ] = x*RUNG_HEIGHT+y;
+		}
+	}
+	Rung->Compiled = TRUE;
+}
 #ifdef OLD_TIMERS_MONOS_SUPPORT
 void InitTimers()
 {
@@ -210,7 +305,10 @@ void InitArithmExpr()
 {
     int NumExpr;
     for (NumExpr=0; NumExpr<NBR_ARITHM_EXPR; NumExpr++)
+    {
         strcpy(ArithmExpr[NumExpr].Expr,"");
+        ArithmExpr[NumExpr].Compiled = FALSE;
+    }
 }
 void InitIOConf( )
 {
@@ -242,6 +340,17 @@ char StateOnLeft(int x,int y,StrRung * TheRung)
     // directly connected to the "left"? if yes, ON !
     if (x==0)
         return 1;
+    /* connected rows already searched by CompileRung() ? */
+    if (TheRung->Compiled)
+    {
+        unsigned char Rows = TheRung->LeftRows[x][y];
+        for (PosY=0; Rows; PosY++, Rows>>=1)
+        {
+            if ( (Rows & 1) && TheRung->Element[x-1][PosY].DynamicOutput )
+                return 1;
+        }
+        return 0;
+    }
     /* Direct on left */
     if (TheRung->Element[x-1][y].DynamicOutput)
         State = 1;
@@ -625,7 +734,7 @@ char CalcTypeCompar(int x,int y,StrRung * UpdateRung)
     char State;
     char StateElement;
 
-    StateElement = EvalCompare(ArithmExpr[UpdateRung->Element[x][y].VarNum].Expr);
+    StateElement = EvalCompareExpr(&ArithmExpr[UpdateRung->Element[x][y].VarNum]);
     UpdateRung->Element[x][y].DynamicState = StateElement;
     if (x==2)
     {
@@ -646,97 +755,120 @@ char CalcTypeOutputOperate(int x,int y,StrRung * UpdateRung)
     char State;
     State = StateOnLeft(x-2,y,UpdateRung);
     if (State)
-        MakeCalc(ArithmExpr[UpdateRung->Element[x][y].VarNum].Expr,FALSE /* verify mode */);
+        MakeCalcExpr(&ArithmExpr[UpdateRung->Element[x][y].VarNum]);
     UpdateRung->Element[x][y].DynamicInput = State;
     UpdateRung->Element[x][y].DynamicState = State;
     return State;
 }
 
 
+/* refresh one block of a rung, return the rung to jump to or -1 */
+int RefreshElement(StrRung * Rung, int x, int y)
+{
+	int JumpToRung = -1;
+	int SectionToCall = -1;
+
+	switch(Rung->Element[x][y].Type)
+	{
+		/* MLD,16/5/2001,V0.2.8 , fixed for drawing */
+		case ELE_FREE:
+		case ELE_UNUSABLE:
+			if (StateOnLeft(x,y,Rung))
+				Rung->Element[x][y].DynamicInput = 1;
+			else
+				Rung->Element[x][y].DynamicInput = 0;
+			break;
+		/* End fix */
+		case ELE_INPUT:
+			CalcTypeInput(x,y,Rung,FALSE,FALSE);
+			break;
+		case ELE_INPUT_NOT:
+			CalcTypeInput(x,y,Rung,TRUE,FALSE);
+			break;
+		case ELE_RISING_INPUT:
+			CalcTypeInput(x,y,Rung,FALSE,TRUE);
+			break;
+		case ELE_FALLING_INPUT:
+			CalcTypeInput(x,y,Rung,TRUE,TRUE);
+			break;
+		case ELE_CONNECTION:
+			CalcTypeConnection(x,y,Rung);
+			break;
+#ifdef OLD_TIMERS_MONOS_SUPPORT
+		case ELE_TIMER:
+			CalcTypeTimer(x,y,Rung);
+			break;
+		case ELE_MONOSTABLE:
+			CalcTypeMonostable(x,y,Rung);
+			break;
+#endif
+		case ELE_COUNTER:
+			CalcTypeCounter(x,y,Rung);
+			break;
+		case ELE_TIMER_IEC:
+			CalcTypeTimerIEC(x,y,Rung);
+			break;
+		case ELE_COMPAR:
+			CalcTypeCompar(x,y,Rung);
+			break;
+		case ELE_OUTPUT:
+			CalcTypeOutput(x,y,Rung,FALSE);
+			break;
+		case ELE_OUTPUT_NOT:
+			CalcTypeOutput(x,y,Rung,TRUE);
+			break;
+		case ELE_OUTPUT_SET:
+			CalcTypeOutputSetReset(x,y,Rung,FALSE);
+			break;
+		case ELE_OUTPUT_RESET:
+			CalcTypeOutputSetReset(x,y,Rung,TRUE);
+			break;
+		case ELE_OUTPUT_JUMP:
+			JumpToRung = CalcTypeOutputJump(x,y,Rung);
+			// we will now abort the refresh of the rung immediately...
+			break;
+		case ELE_OUTPUT_CALL:
+			SectionToCall = CalcTypeOutputCall(x,y,Rung);
+			if ( SectionToCall!=-1 )
+			{
+				StrSection * pSubRoutineSection = &SectionArray[ SectionToCall ];
+				if ( pSubRoutineSection->Used && pSubRoutineSection->SubRoutineNumber>=0 )
+					RefreshASection( pSubRoutineSection ); //recursive call! ;-)
+				else
+					debug_printf("Refresh rungs aborted - call to a sub-routine undefined or programmed as main !!!");
+			}
+			break;
+		case ELE_OUTPUT_OPERATE:
+			CalcTypeOutputOperate(x,y,Rung);
+			break;
+	}
+	return JumpToRung;
+}
+
 int RefreshRung(StrRung * Rung, int * JumpTo)
 {
 	int x = 0, y = 0;
 	int JumpToRung = -1;
-	int SectionToCall = -1;
+	int ScanCell;
+
+	if ( Rung->Compiled )
+	{
+		/* only the blocks listed by CompileRung() */
+		for( ScanCell=0; ScanCell<Rung->NbrCells && JumpToRung==-1; ScanCell++ )
+		{
+			x = Rung->Cells[ ScanCell ]/RUNG_HEIGHT;
+			y = Rung->Cells[ ScanCell ]%RUNG_HEIGHT;
+			JumpToRung = RefreshElement( Rung, x, y );
+		}
+		*JumpTo = JumpToRung;
+		return TRUE;
+	}
 
 	do
 	{
 		do
 		{
-			switch(Rung->Element[x][y].Type)
-			{
-				/* MLD,16/5/2001,V0.2.8 , fixed for drawing */
-				case ELE_FREE:
-				case ELE_UNUSABLE:
-					if (StateOnLeft(x,y,Rung))
-						Rung->Element[x][y].DynamicInput = 1;
-					else
-						Rung->Element[x][y].DynamicInput = 0;
-					break;
-				/* End fix */
-				case ELE_INPUT:
-					CalcTypeInput(x,y,Rung,FALSE,FALSE);
-					break;
-				case ELE_INPUT_NOT:
-					CalcTypeInput(x,y,Rung,TRUE,FALSE);
-					break;
-				case ELE_RISING_INPUT:
-					CalcTypeInput(x,y,Rung,FALSE,TRUE);
-					break;
-				case ELE_FALLING_INPUT:
-					CalcTypeInput(x,y,Rung,TRUE,TRUE);
-					break;
-				case ELE_CONNECTION:
-					CalcTypeConnection(x,y,Rung);
-					break;
-#ifdef OLD_TIMERS_MONOS_SUPPORT
-				case ELE_TIMER:
-					CalcTypeTimer(x,y,Rung);
-					break;
-				case ELE_MONOSTABLE:
-					CalcTypeMonostable(x,y,Rung);
-					break;
-#endif
-				case ELE_COUNTER:
-					CalcTypeCounter(x,y,Rung);
-					break;
-				case ELE_TIMER_IEC:
-					CalcTypeTimerIEC(x,y,Rung);
-					break;
-				case ELE_COMPAR:
-					CalcTypeCompar(x,y,Rung);
-					break;
-				case ELE_OUTPUT:
-					CalcTypeOutput(x,y,Rung,FALSE);
-					break;
-				case ELE_OUTPUT_NOT:
-					CalcTypeOutput(x,y,Rung,TRUE);
-					break;
-				case ELE_OUTPUT_SET:
-					CalcTypeOutputSetReset(x,y,Rung,FALSE);
-					break;
-				case ELE_OUTPUT_RESET:
-					CalcTypeOutputSetReset(x,y,Rung,TRUE);
-					break;
-				case ELE_OUTPUT_JUMP:
-					JumpToRung = CalcTypeOutputJump(x,y,Rung);
-					// we will now abort the refresh of the rung immediately...
-					break;
-				case ELE_OUTPUT_CALL:
-					SectionToCall = CalcTypeOutputCall(x,y,Rung);
-					if ( SectionToCall!=-1 )
-					{
-						StrSection * pSubRoutineSection = &SectionArray[ SectionToCall ];
-						if ( pSubRoutineSection->Used && pSubRoutineSection->SubRoutineNumber>=0 )
-							RefreshASection( pSubRoutineSection ); //recursive call! ;-)
-						else
-							debug_printf("Refresh rungs aborted - call to a sub-routine undefined or programmed as main !!!");
-					}
-					break;
-				case ELE_OUTPUT_OPERATE:
-					CalcTypeOutputOperate(x,y,Rung);
-					break;
-			}
+			JumpToRung = RefreshElement( Rung, x, y );
 			y++;
 		}while( y<RUNG_HEIGHT && JumpToRung==-1 );
 		y = 0;
@@ -16,6 +16,8 @@
 
 void InitRungs(void);
 void PrepareRungs(void);
+void CompileRung(StrRung * Rung);
+char StateOnLeft(int x,int y,StrRung * TheRung);
 void InitTimers(void);
 void PrepareTimers(void);
 void InitMonostables(void);
@@ -223,6 +223,11 @@ typedef struct StrRung
 	char Label[LGT_LABEL];
 	char Comment[LGT_COMMENT];
 	StrElement Element[RUNG_WIDTH][RUNG_HEIGHT];
+	/* straight-line form of the rung, set by CompileRung() */
+	char Compiled;
+	short NbrCells;
+	unsigned char Cells[RUNG_WIDTH*RUNG_HEIGHT]; /* x*RUNG_HEIGHT+y, in refresh order */
+	unsigned char LeftRows[RUNG_WIDTH][RUNG_HEIGHT]; /* bit n: row n of column x-1 feeds x,y */
 }StrRung;
 
 #ifdef OLD_TIMERS_MONOS_SUPPORT
@@ -279,9 +284,25 @@ typedef struct StrTimerIEC
 	int ValueToReachOneBaseUnit;
 }StrTimerIEC;
 
+/* one instruction of a compiled arithmetic expression (see arithm_eval.c) */
+typedef struct StrArithmInstr
+{
+	char Op;
+	char Arg;	/* comparison or number of function parameters */
+	short VarType;
+	int Value;	/* constant or variable offset */
+}StrArithmInstr;
+/* an expression has no more instructions than characters, */
+/* plus the final compare or store */
+#define ARITHM_CODE_SIZE (ARITHM_EXPR_SIZE+2)
+
 typedef struct StrArithmExpr
 {
 	char Expr[ARITHM_EXPR_SIZE];
+	/* bytecode of Expr, set by CompileArithmExpr() */
+	char Compiled;
+	short CodeLength;
+	StrArithmInstr Code[ARITHM_CODE_SIZE];
 }StrArithmExpr;
 
 #define DEVICE_TYPE_DIRECT_ACCESS 0	/* used inb( ) and outb( ) calls */
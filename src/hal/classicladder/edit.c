@@ -846,8 +846,11 @@ void ApplyRungEdited()
 	int PrevNew;
 	int NextNew;
 	save_label_comment_edited();
+	/* interpreted until compiled again below */
+	EditDatas.Rung.Compiled = FALSE;
 	CopyRungToRung(&EditDatas.Rung,&RungArray[EditDatas.NumRung]);
 	ApplyNewArithmExpr();
+	CompileRung(&RungArray[EditDatas.NumRung]);
 
 	/* if we have added or inserted, we will have to */
 	/* modify the links between rungs */
@@ -20,7 +20,7 @@
 
     Invoking:
 
-    halsampler [-c chan_num] [-n num_samples] [-t]
+    halsampler [-c chan_num] [-n num_samples] [-t] [-b] [filename]
 
     'chan_num', if present, specifies the sampler channel to use.
     The default is channel zero.
@@ -32,6 +32,11 @@
     '-t' tells sampler to print the sample number at the start
     of each line.
 
+    '-b' writes binary records instead of text, see streamer.h for
+    the format.  A named file is then written through mmap(), or
+    compressed with gzip if its name ends in '.gz'.  This keeps up
+    with much higher sample rates and channel counts than text.
+
 */
 
 /** This program is free software; you can redistribute it and/or
@@ -69,6 +74,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
 
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"                /* HAL public API decls */
@@ -104,18 +111,134 @@ static void quit(int sig)
 
 #define BUF_SIZE 4000
 
+/* records taken from the stream per wakeup */
+#define BATCH 1024
+
+/* a binary output file grows, and is mapped, this much at a time */
+#define MAP_CHUNK (16 << 20)
+
+static int out_fd = 1;
+static FILE *out_pipe;
+static char *map;		/* mapped window of the output file */
+static size_t map_used;		/* bytes of the window filled */
+static off_t map_offset;	/* file offset of the window */
+
+/* write 'len' bytes of binary output */
+static int out_write(const void *data, size_t len)
+{
+    const char *src = data;
+    size_t n;
+    ssize_t res;
+
+    if (out_pipe) {
+	return fwrite(data, 1, len, out_pipe) == len ? 0 : -1;
+    }
+    while (len > 0) {
+	if (map) {
+	    if (map_used == MAP_CHUNK) {
+		munmap(map, MAP_CHUNK);
+		map_offset += MAP_CHUNK;
+		map_used = 0;
+		if (ftruncate(out_fd, map_offset + MAP_CHUNK) < 0) {
+		    return -1;
+		}
+		map = mmap(NULL, MAP_CHUNK, PROT_READ | PROT_WRITE,
+		    MAP_SHARED, out_fd, map_offset);
+		if (map == MAP_FAILED) {
+		    map = NULL;
+		    return -1;
+		}
+	    }
+	    n = MAP_CHUNK - map_used;
+	    if (n > len) {
+		n = len;
+	    }
+	    memcpy(map + map_used, src, n);
+	    map_used += n;
+	} else {
+	    res = write(out_fd, src, len);
+	    if (res < 0) {
+		if (errno == EINTR) {
+		    continue;
+		}
+		return -1;
+	    }
+	    n = res;
+	}
+	src += n;
+	len -= n;
+    }
+    return 0;
+}
+
+/* set up binary output to 'name', or to stdout if it is NULL */
+static int out_open(const char *name)
+{
+    size_t len;
+    struct stat st;
+
+    if (name == NULL) {
+	return 0;
+    }
+    len = strlen(name);
+    if (len > 3 && strcmp(name + len - 3, ".gz") == 0) {
+	/* the name reaches the shell through the environment so that
+	   it needs no quoting */
+	setenv("HALSAMPLER_FILE", name, 1);
+	out_pipe = popen("gzip -c > \"$HALSAMPLER_FILE\"", "w");
+	return out_pipe ? 0 : -1;
+    }
+    out_fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (out_fd < 0) {
+	return -1;
+    }
+    if (fstat(out_fd, &st) == 0 && S_ISREG(st.st_mode)
+	&& ftruncate(out_fd, MAP_CHUNK) == 0) {
+	map = mmap(NULL, MAP_CHUNK, PROT_READ | PROT_WRITE, MAP_SHARED,
+	    out_fd, 0);
+	if (map == MAP_FAILED) {
+	    /* fall back to write() */
+	    map = NULL;
+	    if (ftruncate(out_fd, 0) < 0) {
+		return -1;
+	    }
+	}
+    }
+    return 0;
+}
+
+static void out_close(void)
+{
+    if (out_pipe) {
+	pclose(out_pipe);
+	out_pipe = NULL;
+    } else if (map) {
+	munmap(map, MAP_CHUNK);
+	map = NULL;
+	/* drop the unused end of the last chunk */
+	if (ftruncate(out_fd, map_offset + map_used) < 0) {
+	    perror("ftruncate");
+	}
+	close(out_fd);
+    }
+}
+
 int main(int argc, char **argv)
 {
-    int n, channel, tag;
+    int n, i, channel, tag, binary;
     long int samples;
     unsigned this_sample, last_sample=0;
-    char *cp, *cp2;
+    char *cp, *cp2, *filename;
     hal_stream_t stream;
+    union hal_stream_data *buf = NULL, *rec;
+    stream_file_header_t hdr;
 
     /* set return code to "fail", clear it later if all goes well */
     exitval = 1;
     channel = 0;
     tag = 0;
+    binary = 0;
+    filename = NULL;
     samples = -1;  /* -1 means run forever */
     /* FIXME - if I wasn't so lazy I'd learn how to use getopt() here */
     for ( n = 1 ; n < argc ; n++ ) {
@@ -147,6 +270,9 @@ int main(int argc, char **argv)
 	case 't':
 	    tag = 1;
 	    break;
+	case 'b':
+	    binary = 1;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -159,10 +285,13 @@ int main(int argc, char **argv)
 	    fprintf(stderr, "ERROR: At most one filename may be specified\n");
 	    exit(1);
 	}
-	// make stdout be the named file
-	fd = open(argv[n], O_WRONLY | O_CREAT, 0666);
-	close(1);
-	dup2(fd, 1);
+	filename = argv[n];
+	if(!binary) {
+	    // make stdout be the named file
+	    fd = open(argv[n], O_WRONLY | O_CREAT, 0666);
+	    close(1);
+	    dup2(fd, 1);
+	}
     }
     /* register signal handlers - if the process is killed
        we need to call hal_exit() to free the shared memory */
@@ -189,50 +318,88 @@ int main(int argc, char **argv)
 	goto out;
     }
     int num_pins = hal_stream_element_count(&stream);
-    while ( samples != 0 ) {
-	union hal_stream_data buf[num_pins];
-	hal_stream_wait_readable(&stream, &stop);
-	if(stop) break;
-	int res = hal_stream_read(&stream, buf, &this_sample);
-	if (res < 0) {
-	    errno = -res;
-	    perror("hal_stream_read");
+    int stride = num_pins + 1;
+    buf = malloc(sizeof(union hal_stream_data) * stride * BATCH);
+    if (!buf) {
+	fprintf(stderr, "ERROR: out of memory\n");
+	goto out;
+    }
+    if ( binary ) {
+	if (out_open(filename) < 0) {
+	    perror(filename);
 	    goto out;
 	}
-	++last_sample;
-	if ( this_sample != last_sample ) {
-	    printf ( "overrun\n");
-	    last_sample = this_sample;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, STREAM_FILE_MAGIC, sizeof(hdr.magic));
+	hdr.byte_order = STREAM_FILE_BYTE_ORDER;
+	hdr.num_pins = num_pins;
+	hdr.record_size = sizeof(union hal_stream_data) * stride;
+	for ( n = 0 ; n < num_pins; n++ ) {
+	    hdr.type[n] = hal_stream_element_type(&stream, n);
 	}
-	if ( tag ) {
-	    printf ( "%d ", this_sample-1 );
+	if (out_write(&hdr, sizeof(hdr)) < 0) {
+	    perror("write");
+	    goto out;
 	}
-	for ( n = 0 ; n < num_pins; n++ ) {
-	    switch ( hal_stream_element_type(&stream, n) ) {
-	    case HAL_FLOAT:
-		printf ( "%f ", buf[n].f);
-		break;
-	    case HAL_BIT:
-		if ( buf[n].b ) {
-		    printf ( "1 " );
+    }
+    while ( samples != 0 ) {
+	int count = BATCH;
+	hal_stream_wait_readable(&stream, &stop);
+	if(stop) break;
+	/* take everything that is waiting, up to BATCH records */
+	if ( samples > 0 && samples < count ) {
+	    count = samples;
+	}
+	count = hal_stream_read_many(&stream, buf, count);
+	for ( i = 0 ; i < count ; i++ ) {
+	    rec = buf + i * stride;
+	    this_sample = rec[num_pins].u;
+	    ++last_sample;
+	    if ( this_sample != last_sample ) {
+		if ( binary ) {
+		    fprintf(stderr, "halsampler: overrun\n");
 		} else {
-		    printf ( "0 " );
+		    printf ( "overrun\n");
 		}
-		break;
-	    case HAL_U32:
-		printf ( "%lu ", (unsigned long)buf[n].u);
-		break;
-	    case HAL_S32:
-		printf ( "%ld ", (long)buf[n].s);
-		break;
-	    default:
-		/* better not happen */
-		goto out;
+		last_sample = this_sample;
+	    }
+	    if ( binary ) {
+		continue;
 	    }
+	    if ( tag ) {
+		printf ( "%d ", this_sample-1 );
+	    }
+	    for ( n = 0 ; n < num_pins; n++ ) {
+		switch ( hal_stream_element_type(&stream, n) ) {
+		case HAL_FLOAT:
+		    printf ( "%f ", rec[n].f);
+		    break;
+		case HAL_BIT:
+		    if ( rec[n].b ) {
+			printf ( "1 " );
+		    } else {
+			printf ( "0 " );
+		    }
+		    break;
+		case HAL_U32:
+		    printf ( "%lu ", (unsigned long)rec[n].u);
+		    break;
+		case HAL_S32:
+		    printf ( "%ld ", (long)rec[n].s);
+		    break;
+		default:
+		    /* better not happen */
+		    goto out;
+		}
+	    }
+	    printf ( "\n" );
+	}
+	if ( binary && out_write(buf, hdr.record_size * count) < 0 ) {
+	    perror("write");
+	    goto out;
 	}
-	printf ( "\n" );
 	if ( samples > 0 ) {
-	    samples--;
+	    samples -= count;
 	}
     }
     /* run was succesfull */
@@ -240,6 +407,10 @@ int main(int argc, char **argv)
 
 out:
     ignore_sig = 1;
+    if ( binary ) {
+	out_close();
+    }
+    free(buf);
     hal_stream_detach(&stream);
     if ( comp_id >= 0 ) {
 	hal_exit(comp_id);
@@ -17,6 +17,24 @@
 #define STREAMER_SHMEM_KEY 	0x48535430
 #define SAMPLER_SHMEM_KEY	0x48534130
 
+/* binary sample files, written by 'halsampler -b' and read by
+   'halstreamer -b'.  The header is followed by records in the layout
+   of the stream: one union hal_stream_data per pin, then one holding
+   the sample number (.u).  Everything is in the writer's byte order,
+   which 'byte_order' lets a reader check. */
+
+#define STREAM_FILE_MAGIC	"HALSTRM1"
+#define STREAM_FILE_BYTE_ORDER	0x01020304
+
+typedef struct {
+    char magic[8];		/* STREAM_FILE_MAGIC, not terminated */
+    uint32_t byte_order;	/* STREAM_FILE_BYTE_ORDER */
+    uint32_t num_pins;		/* values per record */
+    uint32_t record_size;	/* bytes per record */
+    uint32_t reserved;
+    uint8_t type[24];		/* hal_type_t of each value */
+} stream_file_header_t;
+
 /* this struct lives in HAL shared memory */
 
 typedef union {
@@ -27,6 +27,11 @@
     from stdin, it will almost always either need to have stdin 
     redirected from a file, or have data piped into it from some
     other program.
+
+    With '-b', the input is a binary file as written by 'halsampler -b'
+    (see streamer.h).  A named file is read through mmap(), or through
+    gzip if its name ends in '.gz', and records go to the stream many
+    at a time.  Its header must match the types of the stream.
 */
 
 /** This program is free software; you can redistribute it and/or
@@ -64,6 +69,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"                /* HAL public API decls */
@@ -99,10 +105,93 @@ static void quit(int sig)
 
 #define BUF_SIZE 4000
 
+/* records read from a binary file per write to the stream */
+#define BATCH 1024
+
+/* play back a binary file, mapped at 'map' or read from 'in' */
+static int stream_binary(hal_stream_t *stream, FILE *in,
+    const char *map, size_t map_len)
+{
+    stream_file_header_t hdr;
+    union hal_stream_data *buf = NULL;
+    const char *data;
+    size_t count, done, pos = sizeof(hdr);
+    int n, num_pins = hal_stream_element_count(stream);
+    int stride = num_pins + 1;
+    int res = -1;
+
+    if (map) {
+	if (map_len < sizeof(hdr)) {
+	    fprintf(stderr, "ERROR: file too short\n");
+	    return -1;
+	}
+	memcpy(&hdr, map, sizeof(hdr));
+    } else if (fread(&hdr, sizeof(hdr), 1, in) != 1) {
+	fprintf(stderr, "ERROR: file too short\n");
+	return -1;
+    }
+    if (memcmp(hdr.magic, STREAM_FILE_MAGIC, sizeof(hdr.magic)) != 0
+	|| hdr.byte_order != STREAM_FILE_BYTE_ORDER) {
+	fprintf(stderr, "ERROR: not a binary sampler file, "
+	    "or written on a different architecture\n");
+	return -1;
+    }
+    if (hdr.num_pins != (uint32_t) num_pins
+	|| hdr.record_size != sizeof(union hal_stream_data) * stride) {
+	fprintf(stderr, "ERROR: file has %u values per record, "
+	    "stream has %d\n", hdr.num_pins, num_pins);
+	return -1;
+    }
+    for (n = 0; n < num_pins; n++) {
+	if (hdr.type[n] != hal_stream_element_type(stream, n)) {
+	    fprintf(stderr, "ERROR: type of value %d does not match\n", n);
+	    return -1;
+	}
+    }
+    if (!map) {
+	buf = malloc(hdr.record_size * BATCH);
+	if (!buf) {
+	    fprintf(stderr, "ERROR: out of memory\n");
+	    return -1;
+	}
+    }
+    while (!stop) {
+	/* get the next batch of records */
+	if (map) {
+	    count = (map_len - pos) / hdr.record_size;
+	    if (count > BATCH) {
+		count = BATCH;
+	    }
+	    data = map + pos;
+	    pos += count * hdr.record_size;
+	} else {
+	    count = fread(buf, hdr.record_size, BATCH, in);
+	    data = (const char *) buf;
+	}
+	if (count == 0) {
+	    res = 0;
+	    break;
+	}
+	/* and push all of them into the stream */
+	done = 0;
+	while (done < count) {
+	    hal_stream_wait_writable(stream, &stop);
+	    if (stop) {
+		break;
+	    }
+	    done += hal_stream_write_many(stream,
+		(union hal_stream_data *) (data + done * hdr.record_size),
+		count - done);
+	}
+    }
+    free(buf);
+    return res;
+}
+
 int main(int argc, char **argv)
 {
-    int n, channel, line=0;
-    char *cp, *cp2;
+    int n, channel, line=0, binary=0;
+    char *cp, *cp2, *filename=NULL;
     hal_stream_t stream;
     char buf[BUF_SIZE];
 	const char *errmsg;
@@ -126,6 +215,9 @@ int main(int argc, char **argv)
 		exit(1);
 	    }
 	    break;
+	case 'b':
+	    binary = 1;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -138,10 +230,13 @@ int main(int argc, char **argv)
 	    fprintf(stderr, "ERROR: At most one filename may be specified\n");
 	    exit(1);
 	}
-	// make stdin be the named file
-	fd = open(argv[n], O_RDONLY);
-	close(0);
-	dup2(fd, 0);
+	filename = argv[n];
+	if(!binary) {
+	    // make stdin be the named file
+	    fd = open(argv[n], O_RDONLY);
+	    close(0);
+	    dup2(fd, 0);
+	}
     }
     /* register signal handlers - if the process is killed
        we need to call hal_exit() to free the shared memory */
@@ -169,6 +264,48 @@ int main(int argc, char **argv)
 	goto out;
     }
     int num_pins = hal_stream_element_count(&stream);
+    if ( binary ) {
+	FILE *in = stdin;
+	char *map = NULL;
+	struct stat st;
+	size_t len;
+	int fd = -1;
+	if ( filename && (len = strlen(filename)) > 3
+		&& strcmp(filename + len - 3, ".gz") == 0 ) {
+	    /* the name reaches the shell through the environment so
+	       that it needs no quoting */
+	    setenv("HALSTREAMER_FILE", filename, 1);
+	    in = popen("gzip -dc < \"$HALSTREAMER_FILE\"", "r");
+	} else if ( filename ) {
+	    fd = open(filename, O_RDONLY);
+	    if ( fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+		    && st.st_size > 0 ) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if ( map == MAP_FAILED ) {
+		    map = NULL;
+		} else {
+		    madvise(map, st.st_size, MADV_SEQUENTIAL);
+		}
+	    }
+	    in = fd >= 0 && !map ? fdopen(fd, "r") : NULL;
+	}
+	if ( !map && !in ) {
+	    perror(filename);
+	    goto out;
+	}
+	if ( stream_binary(&stream, in, map, map ? st.st_size : 0) == 0 ) {
+	    exitval = 0;
+	}
+	if ( map ) {
+	    munmap(map, st.st_size);
+	    close(fd);
+	} else if ( in != stdin && filename && fd < 0 ) {
+	    pclose(in);
+	} else if ( in != stdin ) {
+	    fclose(in);
+	}
+	goto out;
+    }
     while ( fgets(buf, BUF_SIZE, stdin) ) {
 	/* skip comment lines */
 	if ( buf[0] == '#' ) {
@@ -131,7 +131,7 @@ int hm2_tram_add_bspi_frame(char *name, int chan, rtapi_u32 **wbuff, rtapi_u32 *
         return -1;
     }
     if (wbuff != NULL) {
-        r = hm2_register_tram_write_region(hm2,hm2->bspi.instance[i].addr[chan], sizeof(rtapi_u32),wbuff);
+        r = hm2_register_tram_strobe_region(hm2,hm2->bspi.instance[i].addr[chan], sizeof(rtapi_u32),wbuff);
         if (r < 0) {
             HM2_ERR("Failed to add TRAM write entry for %s.\n", name);
             return -1;
@@ -35,6 +35,7 @@
 #include "hal.h"
 
 #include "hal/drivers/mesa-hostmot2/hostmot2.h"
+#include "hal/drivers/mesa-hostmot2/hostmot2-wrap.h"
 
 
 
@@ -114,17 +115,33 @@ static void hm2_encoder_update_control_register(hostmot2_t *hm2) {
 }
 
 
+//
+// Called once per read, before any instance is processed; it used to be
+// called again for each instance.  A second call in the same read does
+// not change what the instances see: they read none of the pins set
+// here, read_control_reg is not changed, and prev_control, which they
+// do read, is only changed through hm2_encoder_force_write(), which a
+// second call cannot reach because last_error_enable is kept per
+// instance.  (It was one flag for all the instances, so a mix of
+// enabled and disabled quadrature error checking forced a write of the
+// control registers from every call.)  The only output that moves is
+// the first .quadrature-error after checking is enabled, which the
+// second call set from a register read before the enable was written;
+// now the next read sets it.
+//
+
 static void hm2_encoder_read_control_register(hostmot2_t *hm2) {
     int i;
-    static int last_error_enable = 0;
+    int force_write = 0;
 
     for (i = 0; i < hm2->encoder.num_instances; i ++) {
         hm2_encoder_instance_t *e = &hm2->encoder.instance[i];
 
         if (*e->hal.pin.quadrature_error_enable) {
-            if (!last_error_enable) {
-                hm2_encoder_force_write(hm2);
-                last_error_enable = 1;
+            if (!e->last_error_enable) {
+                // the error bit means nothing until the enable is written
+                force_write = 1;
+                e->last_error_enable = 1;
             } else {
                 int state = (hm2->encoder.read_control_reg[i] & HM2_ENCODER_CONTROL_MASK) & HM2_ENCODER_QUADRATURE_ERROR;
                 if ((*e->hal.pin.quadrature_error == 0) && state) {
@@ -134,13 +151,17 @@ static void hm2_encoder_read_control_register(hostmot2_t *hm2) {
             }
         } else {
             *e->hal.pin.quadrature_error = 0;
-            last_error_enable = 0;
+            e->last_error_enable = 0;
         }
 
         *e->hal.pin.input_a = hm2->encoder.read_control_reg[i] & HM2_ENCODER_INPUT_A;
         *e->hal.pin.input_b = hm2->encoder.read_control_reg[i] & HM2_ENCODER_INPUT_B;
         *e->hal.pin.input_idx = hm2->encoder.read_control_reg[i] & HM2_ENCODER_INPUT_INDEX;
     }
+
+    if (force_write) {
+        hm2_encoder_force_write(hm2);
+    }
 }
 
 
@@ -338,6 +359,14 @@ int hm2_encoder_parse_md(hostmot2_t *hm2, int md_index) {
         goto fail0;
     }
 
+    hm2->encoder.prev_reg_count = (rtapi_u16 *)hal_malloc(hm2->encoder.num_instances * sizeof(rtapi_u16));
+    hm2->encoder.reg_count_diff = (rtapi_s32 *)hal_malloc(hm2->encoder.num_instances * sizeof(rtapi_s32));
+    if (hm2->encoder.prev_reg_count == NULL || hm2->encoder.reg_count_diff == NULL) {
+        HM2_ERR("out of memory!\n");
+        r = -ENOMEM;
+        goto fail0;
+    }
+
     hm2->encoder.stride = md->register_stride;
     hm2->encoder.clock_frequency = md->clock_freq;
     hm2->encoder.version = md->version;
@@ -693,7 +722,7 @@ void hm2_encoder_tram_init(hostmot2_t *hm2) {
 
         hm2->encoder.instance[i].zero_offset = count;
 
-        hm2->encoder.instance[i].prev_reg_count = count;
+        hm2->encoder.prev_reg_count[i] = count;
 
         hm2->encoder.instance[i].state = HM2_ENCODER_STOPPED;
 
@@ -715,8 +744,9 @@ void hm2_encoder_tram_init(hostmot2_t *hm2) {
  *     .prev_reg_count
  *     (maybe) .index_enabled and .zero_offset
  *
- * This function expects the TRAM read to have just finished, so that
- * counter_reg[i] is up-to-date.
+ * This function expects the TRAM read to have just finished, and
+ * hm2_encoder_process_tram_read() to have worked out reg_count_diff[i]
+ * from counter_reg[i].
  *
  * May read the Latch register (if searching for the Index pulse).
  *
@@ -742,11 +772,7 @@ static void hm2_encoder_instance_update_rawcounts_and_handle_index(hostmot2_t *h
 
     reg_count = hm2_encoder_get_reg_count(hm2, instance);
 
-    reg_count_diff = (rtapi_s32)reg_count - (rtapi_s32)e->prev_reg_count;
-    if (reg_count_diff > 32768) reg_count_diff -= 65536;
-    if (reg_count_diff < -32768) reg_count_diff += 65536;
-
-    *e->hal.pin.rawcounts += reg_count_diff;
+    *e->hal.pin.rawcounts += hm2->encoder.reg_count_diff[instance];
 
 
     //
@@ -765,9 +791,7 @@ static void hm2_encoder_instance_update_rawcounts_and_handle_index(hostmot2_t *h
 
             latched_count = (latch_ctrl >> 16) & 0xffff;
 
-            reg_count_diff = (rtapi_s32)latched_count - (rtapi_s32)e->prev_reg_count;
-            if (reg_count_diff > 32768) reg_count_diff -= 65536;
-            if (reg_count_diff < -32768) reg_count_diff += 65536;
+            reg_count_diff = hm2_encoder_count_diff(latched_count, hm2->encoder.prev_reg_count[instance]);
 
             e->zero_offset = prev_rawcounts + reg_count_diff;
             *e->hal.pin.index_enable = 0;
@@ -782,16 +806,14 @@ static void hm2_encoder_instance_update_rawcounts_and_handle_index(hostmot2_t *h
 
             latched_count = (latch_ctrl >> 16) & 0xffff;
 
-            reg_count_diff = (rtapi_s32)latched_count - (rtapi_s32)e->prev_reg_count;
-            if (reg_count_diff > 32768) reg_count_diff -= 65536;
-            if (reg_count_diff < -32768) reg_count_diff += 65536;
+            reg_count_diff = hm2_encoder_count_diff(latched_count, hm2->encoder.prev_reg_count[instance]);
 
             *(e->hal.pin.rawlatch) = prev_rawcounts + reg_count_diff;
             // *e->hal.pin.latch_enable = 0;
         }
     }
 
-    e->prev_reg_count = reg_count;
+    hm2->encoder.prev_reg_count[instance] = reg_count;
 }
 
 
@@ -875,16 +897,11 @@ static void hm2_encoder_instance_process_tram_read(hostmot2_t *hm2, int instance
         e->hal.param.scale = 1.0;
     }
 
-    hm2_encoder_read_control_register(hm2);
-
     switch (e->state) {
 
         case HM2_ENCODER_STOPPED: {
-            rtapi_u16 reg_count;  // the count currently in the register
-
-            // get current count from the FPGA (already read)
-            reg_count = hm2_encoder_get_reg_count(hm2, instance);
-            if (reg_count == e->prev_reg_count
+            // see if the count in the register (already read) changed
+            if (hm2->encoder.reg_count_diff[instance] == 0
 			&& !(e->prev_control & (HM2_ENCODER_LATCH_ON_INDEX | HM2_ENCODER_LATCH_ON_PROBE))) {
                 // still not moving, but .reset can change the position
                 hm2_encoder_instance_update_position(hm2, instance);
@@ -911,7 +928,6 @@ static void hm2_encoder_instance_process_tram_read(hostmot2_t *hm2, int instance
 
 
         case HM2_ENCODER_MOVING: {
-            rtapi_u16 reg_count;  // the count currently in the register
             rtapi_u16 time_of_interest;  // terrible variable name, sorry
 
             rtapi_s32 dT_clocks;
@@ -920,9 +936,8 @@ static void hm2_encoder_instance_process_tram_read(hostmot2_t *hm2, int instance
             rtapi_s32 dS_counts;
             double dS_pos_units;
 
-            // get current count from the FPGA (already read)
-            reg_count = hm2_encoder_get_reg_count(hm2, instance);
-            if (reg_count == e->prev_reg_count) {
+            // see if the count in the register (already read) changed
+            if (hm2->encoder.reg_count_diff[instance] == 0) {
                 double vel;
 
                 //
@@ -1039,12 +1054,22 @@ static void hm2_encoder_instance_process_tram_read(hostmot2_t *hm2, int instance
 
 
 void hm2_encoder_process_tram_read(hostmot2_t *hm2, long l_period_ns) {
-    int i;
+    rtapi_u32 *counter_reg = hm2->encoder.counter_reg;
+    rtapi_u16 *prev_reg_count = hm2->encoder.prev_reg_count;
+    rtapi_s32 *reg_count_diff = hm2->encoder.reg_count_diff;
+    int i, n = hm2->encoder.num_instances;
 
-    if (hm2->encoder.num_instances <= 0) return;
+    if (n <= 0) return;
+
+    hm2_encoder_read_control_register(hm2);
+
+    // the change in counts of all the instances at once
+    for (i = 0; i < n; i ++) {
+        reg_count_diff[i] = hm2_encoder_count_diff(counter_reg[i] & 0xffff, prev_reg_count[i]);
+    }
 
     // process each encoder instance independently
-    for (i = 0; i < hm2->encoder.num_instances; i ++) {
+    for (i = 0; i < n; i ++) {
         hm2_encoder_instance_process_tram_read(hm2, i);
     }
 }
@@ -28,6 +28,7 @@
 #include <ifaddrs.h>
 #include <unistd.h>
 #include <spawn.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -94,6 +95,9 @@ RTAPI_MP_ARRAY_STRING(config, MAX_ETH_BOARDS, "config string for the AnyIO board
 int debug = 0;
 RTAPI_MP_INT(debug, "Developer/debug use only!  Enable debug logging.");
 
+static int busy_poll = 0;
+RTAPI_MP_INT(busy_poll, "Busy-poll the network device for up to this many microseconds while waiting for a reply (0: sleep instead)");
+
 static int boards_count = 0;
 
 int comm_active = 0;
@@ -318,6 +322,7 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
     board->server_addr.sin_family = AF_INET;
     board->server_addr.sin_port = htons(LBP16_UDP_PORT);
     board->server_addr.sin_addr.s_addr = inet_addr(board_ip);
+    board->loopback = (ntohl(board->server_addr.sin_addr.s_addr) >> 24) == IN_LOOPBACKNET;
 
     board->local_addr.sin_family      = AF_INET;
     board->local_addr.sin_addr.s_addr = INADDR_ANY;
@@ -328,7 +333,9 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
         return -errno;
     }
 
-    if(!use_iptables()) {
+    if(board->loopback) {
+        LL_PRINT("%s: loopback address, expecting hm2_eth_emu\n", board_ip);
+    } else if(!use_iptables()) {
         LL_PRINT(\
 "WARNING: Unable to restrict other access to the hm2-eth device.\n"
 "This means that other software using the same network interface can violate\n"
@@ -352,6 +359,23 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
         return -errno;
     }
 
+    if(busy_poll > 0) {
+        ret = setsockopt(board->sockfd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll));
+        if(ret < 0) {
+            LL_PRINT("WARNING: %s: can't busy-poll: %s\n", board_ip, strerror(errno));
+        } else {
+            board->busy_poll = true;
+        }
+    }
+
+    // without timestamps, reply-time and receive-delay just stay 0
+    int on = 1;
+    if(setsockopt(board->sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0) {
+        LL_PRINT("WARNING: %s: no receive timestamps: %s\n", board_ip, strerror(errno));
+    }
+    board->rx_msg.msg_iov = &board->rx_iov;
+    board->rx_msg.msg_iovlen = 1;
+
     memset(&board->req, 0, sizeof(board->req));
     struct sockaddr_in *sin;
 
@@ -367,14 +391,24 @@ static int init_board(hm2_eth_t *board, const char *board_ip) {
         return ret;
     }
 
-    ret = ioctl(board->sockfd, SIOCSARP, &board->req);
-    if(ret < 0) {
-        perror("ioctl SIOCSARP");
+    // the loopback interface has no ARP, and must not be firewalled.
+    // hm2_eth_emu behind a veth pair reports a locally administered
+    // address, which is not the one of its interface: leave it to ARP.
+    if(board->loopback) {
         board->req.arp_flags &= ~ATF_PERM;
-        return -errno;
+    } else if(board->req.arp_ha.sa_data[0] & 0x02) {
+        LL_PRINT("%s: locally administered address, expecting hm2_eth_emu\n", board_ip);
+        board->req.arp_flags &= ~ATF_PERM;
+    } else {
+        ret = ioctl(board->sockfd, SIOCSARP, &board->req);
+        if(ret < 0) {
+            perror("ioctl SIOCSARP");
+            board->req.arp_flags &= ~ATF_PERM;
+            return -errno;
+        }
     }
 
-    if(use_iptables())
+    if(!board->loopback && use_iptables())
     {
         ret = install_iptables_board(board->sockfd);
         if(ret < 0) return ret;
@@ -404,10 +438,43 @@ static int eth_socket_send(int sockfd, const void *buffer, int len, int flags) {
     return send(sockfd, buffer, len, flags);
 }
 
+// send two buffers as a single packet
+static int eth_socket_send2(int sockfd, const void *buffer1, int len1, const void *buffer2, int len2, int flags) {
+    struct iovec iov[2] = { { (void *) buffer1, len1 }, { (void *) buffer2, len2 } };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    return sendmsg(sockfd, &msg, flags);
+}
+
 static int eth_socket_recv(int sockfd, void *buffer, int len, int flags) {
     return recv(sockfd, buffer, len, flags);
 }
 
+// receive a packet, and in *stamp the time it reached the kernel, or zero
+static int eth_socket_recv_stamped(hm2_eth_t *board, void *buffer, int len, int flags, struct timespec *stamp) {
+    struct cmsghdr *cmsg;
+    int result;
+
+    board->rx_iov.iov_base = buffer;
+    board->rx_iov.iov_len = len;
+    board->rx_msg.msg_control = board->rx_control;
+    board->rx_msg.msg_controllen = sizeof(board->rx_control);
+    stamp->tv_sec = stamp->tv_nsec = 0;
+    result = recvmsg(board->sockfd, &board->rx_msg, flags);
+    if(result < 0) return result;
+    for(cmsg = CMSG_FIRSTHDR(&board->rx_msg); cmsg; cmsg = CMSG_NXTHDR(&board->rx_msg, cmsg)) {
+        if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+            memcpy(stamp, CMSG_DATA(cmsg), sizeof(*stamp));
+    }
+    return result;
+}
+
+static hal_s32_t ns_between(const struct timespec *from, const struct timespec *to) {
+    long long ns = (to->tv_sec - from->tv_sec) * 1000000000LL + (to->tv_nsec - from->tv_nsec);
+    if(ns > 0x7fffffff) return 0x7fffffff;
+    if(ns < -0x7fffffff) return -0x7fffffff;
+    return ns;
+}
+
 static int eth_socket_recv_loop(int sockfd, void *buffer, int len, int flags, long timeout) {
     long long end = rtapi_get_clocks() + timeout;
     int result;
@@ -467,6 +534,22 @@ static int hm2_eth_read(hm2_lowlevel_io_t *this, rtapi_u32 addr, void *buffer, i
     return 1;  // success
 }
 
+// send writes that were held back to go out with a read request
+static int hm2_eth_send_held_writes(hm2_eth_t *board) {
+    int send;
+
+    if(!board->write_held) return 1;
+    board->write_held = false;
+    send = eth_socket_send(board->sockfd, (void*) &board->write_packet, board->write_packet_size, 0);
+    board->write_packet_ptr = board->write_packet;
+    board->write_packet_size = 0;
+    if(send < 0) {
+        LL_PRINT("ERROR: sending packet: %s\n", strerror(errno));
+        return 0;
+    }
+    return 1;
+}
+
 static int hm2_eth_send_queued_reads(hm2_lowlevel_io_t *this) {
     hm2_eth_t *board = this->private;
     int send;
@@ -484,25 +567,73 @@ static int hm2_eth_send_queued_reads(hm2_lowlevel_io_t *this) {
     // write then read back space 4 scratch register at 0010 to verify we got the right receive packet
     LBP16_INIT_PACKET4(*(lbp16_cmd_addr*)(board->read_packet_ptr), CMD_WRITE_TIMER_ADDR16_INCR(2), 0x10);
     board->read_packet_ptr += sizeof(lbp16_cmd_addr);
+    board->read_cnt_offset = board->read_packet_ptr - board->read_packet;
     *(uint32_t*)board->read_packet_ptr = board->read_cnt;
     board->read_packet_ptr += sizeof(uint32_t);
 
     LBP16_INIT_PACKET4(*(lbp16_cmd_addr*)(board->read_packet_ptr), CMD_READ_TIMER_ADDR16_INCR(4), 0x10);
     board->read_packet_ptr += sizeof(lbp16_cmd_addr);
+    board->confirm_from = board->queue_buff_size;
     board->queue_reads[board->queue_reads_count].buffer = &board->confirm_read_cnt;
     board->queue_reads[board->queue_reads_count].size = 8;
     board->queue_reads[board->queue_reads_count].from = board->queue_buff_size;
     board->queue_reads_count++;
     board->queue_buff_size += 8;
 
+    // the writes held back by hm2_eth_send_queued_writes go in front of
+    // the reads, so the board still does them first
+    if(board->write_held && board->write_packet_size + (board->read_packet_ptr - board->read_packet) <= sizeof(board->read_packet)) {
+        send = eth_socket_send2(board->sockfd, board->write_packet, board->write_packet_size,
+            board->read_packet, board->read_packet_ptr - board->read_packet, 0);
+        board->write_held = false;
+        board->write_packet_ptr = board->write_packet;
+        board->write_packet_size = 0;
+    } else {
+        if(!hm2_eth_send_held_writes(board)) return 0;
+        send = eth_socket_send(board->sockfd, (void*) &board->read_packet, board->read_packet_ptr - board->read_packet, 0);
+    }
+    if(send < 0) {
+        LL_PRINT("ERROR: sending packet: %s\n", strerror(errno));
+        return 0;
+    }
+    clock_gettime(CLOCK_REALTIME, &board->read_sent);
+    return 1;
+}
+
+// send the queued reads again under a new read number, so that a late
+// reply to the first request is told apart and skipped
+static int hm2_eth_resend_queued_reads(hm2_eth_t *board) {
+    int send;
+
+    board->read_cnt++;
+    memcpy(board->read_packet + board->read_cnt_offset, &board->read_cnt, sizeof(board->read_cnt));
     send = eth_socket_send(board->sockfd, (void*) &board->read_packet, board->read_packet_ptr - board->read_packet, 0);
     if(send < 0) {
         LL_PRINT("ERROR: sending packet: %s\n", strerror(errno));
         return 0;
     }
+    clock_gettime(CLOCK_REALTIME, &board->read_sent);
     return 1;
 }
 
+// check, without waiting, whether the reply to the outstanding read request
+// has arrived, dropping late replies to earlier requests on the way
+static bool hm2_eth_reply_ready(hm2_eth_t *board) {
+    rtapi_u8 tmp_buffer[board->queue_buff_size];
+    uint32_t confirm;
+    int recv;
+
+    while(1) {
+        recv = eth_socket_recv(board->sockfd, (void*) &tmp_buffer, board->queue_buff_size, MSG_DONTWAIT | MSG_PEEK);
+        if(recv < 0) return false;
+        if(recv == board->queue_buff_size) {
+            memcpy(&confirm, &tmp_buffer[board->confirm_from], sizeof(confirm));
+            if(confirm == board->read_cnt) return true;
+        }
+        eth_socket_recv(board->sockfd, (void*) &tmp_buffer, board->queue_buff_size, MSG_DONTWAIT);
+    }
+}
+
 static bool record_soft_error(hm2_eth_t *board) {
     if(!board->hal) return 1; // still early in hm2_eth_probe
     board->llio.needs_soft_reset = 1;
@@ -534,6 +665,7 @@ static int hm2_eth_receive_queued_reads(hm2_lowlevel_io_t *this) {
     hm2_eth_t *board = this->private;
     int recv, i = 0;
     rtapi_u8 tmp_buffer[board->queue_buff_size];
+    struct timespec stamp;
     long long t1, t2;
     t1 = rtapi_get_time();
     
@@ -545,7 +677,10 @@ static int hm2_eth_receive_queued_reads(hm2_lowlevel_io_t *this) {
         board->comm_error_counter = 0;
     }
 
-    long read_timeout = board->hal ? board->hal->read_timeout : 800000;
+    // the reads made while the board registers come before the first
+    // .read_request, so there is no period and no read_time yet
+    bool running = board->hal && board->llio.period;
+    long read_timeout = running ? board->hal->read_timeout : 800000;
     if(read_timeout <= 0)
         read_timeout = 80;
     if(read_timeout < 100)
@@ -553,13 +688,29 @@ static int hm2_eth_receive_queued_reads(hm2_lowlevel_io_t *this) {
     if(read_timeout < 100000)
         read_timeout = 100000;
  
-    if(!board->hal) this->read_time = t1;
+    if(!running) this->read_time = t1;
+
+    // the request was sent by .write in the previous cycle.  Normally the
+    // reply is already here; if it is not, or the thread was held up so
+    // long that the data in it is too old to use, read synchronously
+    if(this->read_pipelined && board->hal) {
+        long long staleness = t1 - this->read_time;
+        *board->hal->read_staleness = staleness > 0x7fffffff ? 0x7fffffff : staleness;
+        if(staleness > this->period + this->period / 2 || !hm2_eth_reply_ready(board)) {
+            (*board->hal->read_fallbacks)++;
+            if(!hm2_eth_resend_queued_reads(board)) return 0;
+            this->read_time = t1;
+        }
+    }
+
     unsigned long long read_deadline = this->read_time + read_timeout;
     do {
 do_recv_packet:
         errno = 0;
-        recv = eth_socket_recv(board->sockfd, (void*) &tmp_buffer, board->queue_buff_size, MSG_DONTWAIT);
-        if(recv < 0) rtapi_delay(READ_PCK_DELAY_NS);
+        // with busy_poll, a recv that blocks (for at most RECV_TIMEOUT_US)
+        // polls the NIC itself rather than waiting for its interrupt
+        recv = eth_socket_recv_stamped(board, (void*) &tmp_buffer, board->queue_buff_size, board->busy_poll ? 0 : MSG_DONTWAIT, &stamp);
+        if(recv < 0 && !board->busy_poll) rtapi_delay(READ_PCK_DELAY_NS);
         t2 = rtapi_get_time();
         i++;
     } while (recv != board->queue_buff_size && t2 < read_deadline);
@@ -580,6 +731,15 @@ do_recv_packet:
     if(board->confirm_read_cnt != board->read_cnt && t2 < read_deadline)
         goto do_recv_packet;
 
+    // only the reply to this read tells how long the board took, not a
+    // stale one skipped above
+    if(board->hal && stamp.tv_sec && board->confirm_read_cnt == board->read_cnt) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        *board->hal->reply_time = ns_between(&board->read_sent, &stamp);
+        *board->hal->receive_delay = ns_between(&stamp, &now);
+    }
+
     board->read_packet_ptr = board->read_packet;
     board->queue_reads_count = 0;
     board->queue_buff_size = 0;
@@ -644,6 +804,8 @@ static int hm2_eth_send_queued_writes(hm2_lowlevel_io_t *this) {
     long long t0, t1;
     hm2_eth_t *board = this->private;
 
+    if(!hm2_eth_send_held_writes(board)) return 0;
+
     board->write_cnt++;
     // XXX this is missing a check for exceeding the maximum packet size!
     lbp16_cmd_addr *packet = (lbp16_cmd_addr *) board->write_packet_ptr;
@@ -652,7 +814,16 @@ static int hm2_eth_send_queued_writes(hm2_lowlevel_io_t *this) {
     memcpy(board->write_packet_ptr, &board->write_cnt, 4);
     board->write_packet_ptr += 4;
     board->write_packet_size += (sizeof(*packet) + 4);
-    
+
+    if(board->hal) this->pipeline_reads = board->hal->read_pipeline;
+
+    // when .write goes on to send the next cycle's read request, the
+    // writes are held back to be sent in the same packet
+    if(this->pipeline_reads && board->hal->combine_packets && !this->read_requested && !*this->io_error) {
+        board->write_held = true;
+        return 1;
+    }
+
     t0 = rtapi_get_time();
     send = eth_socket_send(board->sockfd, (void*) &board->write_packet, board->write_packet_size, 0);
     if(send < 0) {
@@ -888,6 +1059,54 @@ static int hm2_eth_items(hm2_eth_t *board) {
         return r;
     *board->hal->packet_error_exceeded = 0;
 
+    if((r = hal_param_bit_newf(HAL_RW,
+            &board->hal->read_pipeline,
+            board->llio.comp_id,
+            "%s.read-pipeline",
+            board->llio.name)) < 0)
+        return r;
+    board->hal->read_pipeline = 0;
+
+    if((r = hal_pin_s32_newf(HAL_OUT,
+            &board->hal->read_staleness,
+            board->llio.comp_id,
+            "%s.read-staleness",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->read_staleness = 0;
+
+    if((r = hal_pin_u32_newf(HAL_OUT,
+            &board->hal->read_fallbacks,
+            board->llio.comp_id,
+            "%s.read-fallbacks",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->read_fallbacks = 0;
+
+    if((r = hal_param_bit_newf(HAL_RW,
+            &board->hal->combine_packets,
+            board->llio.comp_id,
+            "%s.combine-packets",
+            board->llio.name)) < 0)
+        return r;
+    board->hal->combine_packets = 0;
+
+    if((r = hal_pin_s32_newf(HAL_OUT,
+            &board->hal->reply_time,
+            board->llio.comp_id,
+            "%s.reply-time",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->reply_time = 0;
+
+    if((r = hal_pin_s32_newf(HAL_OUT,
+            &board->hal->receive_delay,
+            board->llio.comp_id,
+            "%s.receive-delay",
+            board->llio.name)) < 0)
+        return r;
+    *board->hal->receive_delay = 0;
+
     return 0;
 }
 
@@ -932,6 +1151,10 @@ int rtapi_app_main(void) {
 
     for(i = 0; i<num_boards; i++) {
         char ifbuf[64]; // more than enough for eth0
+        if(boards[i].loopback) {
+            boards[i].read_cnt = boards[i].write_cnt = 0;
+            continue;
+        }
         char *ifptr = fetch_ifname(boards[i].sockfd, ifbuf, sizeof(ifbuf));
         if(!ifptr) {
             LL_PRINT("failed to retrieve interface name for board");
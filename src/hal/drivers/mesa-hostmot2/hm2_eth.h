@@ -41,9 +41,12 @@ typedef struct {
     int sockfd;
     struct sockaddr_in local_addr;
     struct sockaddr_in server_addr;
+    bool loopback;  // talking to hm2_eth_emu on this machine
 
     rtapi_u8 read_packet[1400];
     rtapi_u8 *read_packet_ptr;
+    int read_cnt_offset;    // where read_cnt is in read_packet
+    int confirm_from;       // where confirm_read_cnt is in the reply
     hm2_read_queue_entry_t queue_reads[MAX_ETH_READS];
     int queue_reads_count;
     int queue_buff_size;
@@ -51,11 +54,19 @@ typedef struct {
     rtapi_u8 write_packet[1400];
     rtapi_u8 *write_packet_ptr;
     int write_packet_size;
+    bool write_held;        // write_packet waits to go out with the reads
     uint32_t read_cnt, write_cnt;
     // these two fields must be kept together, they're read by a single
     // read-request
     uint32_t confirm_read_cnt, confirm_write_cnt;
 
+    bool busy_poll;         // wait for replies in recv, busy-polling the NIC
+    struct timespec read_sent;  // CLOCK_REALTIME, for reply-time
+    // set up once, for receiving replies with their kernel timestamp
+    struct msghdr rx_msg;
+    struct iovec rx_iov;
+    char rx_control[CMSG_SPACE(sizeof(struct timespec))];
+
     int comm_error_counter;
     uint16_t old_rxudpcount, rxudpcount;
     struct arpreq req;
@@ -68,6 +79,12 @@ typedef struct {
         hal_bit_t *packet_error;
         hal_s32_t *packet_error_level;
         hal_bit_t *packet_error_exceeded;
+        hal_bit_t read_pipeline;
+        hal_s32_t *read_staleness;
+        hal_u32_t *read_fallbacks;
+        hal_bit_t combine_packets;
+        hal_s32_t *reply_time;
+        hal_s32_t *receive_delay;
     } *hal;
 } hm2_eth_t;
 
@@ -129,6 +129,14 @@ struct hm2_lowlevel_io_struct {
     // TRUE if it is useful to split reads into a request and response part
     bool split_read;
 
+    // the llio sets this to TRUE to have .write send the next cycle's read
+    // request as soon as the writes are out, so that the round trip happens
+    // while the thread is idle and .read only has to pick up the reply
+    bool pipeline_reads;
+
+    // TRUE while the outstanding read request is one sent by .write
+    bool read_pipelined;
+
     // this gets set to TRUE when the llio driver detects an io_error, and
     // by the hm2 watchdog (if present) when it detects a watchdog bite
     // needs_soft_reset is like needs_reset except that no message is logged
@@ -0,0 +1,52 @@
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+
+//
+// Wrap-around arithmetic of the encoder counters and the stepgen
+// accumulators.  These have no branches, so that the loops over all the
+// instances in hm2_encoder_process_tram_read() and
+// hm2_stepgen_process_tram_read() vectorize.  tests/hm2-wrap checks them
+// against the code they replaced.
+//
+
+#ifndef HOSTMOT2_WRAP_H
+#define HOSTMOT2_WRAP_H
+
+#include <rtapi_stdint.h>
+
+
+// The change from 'prev' to 'count' of a 16-bit counter that moved less
+// than half way round.
+static inline rtapi_s32 hm2_encoder_count_diff(rtapi_u16 count, rtapi_u16 prev) {
+    rtapi_s32 diff = (rtapi_s32)count - (rtapi_s32)prev;
+    diff -= (diff > 32768) * 65536;
+    diff += (diff < -32768) * 65536;
+    return diff;
+}
+
+
+// The change from 'prev' to 'acc' of a 16.16 stepgen accumulator: its
+// 32-bit wrapped difference, less one when it wrapped upwards and plus
+// one when it wrapped downwards (the wrap has always been taken as
+// UINT32_MAX rather than 2^32).
+static inline rtapi_s32 hm2_stepgen_acc_delta(rtapi_u32 acc, rtapi_u32 prev) {
+    rtapi_s32 wrapped = (rtapi_s32)(acc - prev);
+    return wrapped
+        + ((acc > prev) & (wrapped < 0))
+        - ((acc < prev) & (wrapped >= 0));
+}
+
+#endif
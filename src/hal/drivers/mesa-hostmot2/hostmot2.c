@@ -81,6 +81,10 @@ static void hm2_read_request(void *void_hm2, long period) {
     // if there are comm problems, wait for the user to fix it
     if ((*hm2->llio->io_error) != 0) return;
 
+    // a pipelined request sent by .write is already outstanding
+    if (hm2->llio->read_requested) return;
+    hm2->llio->read_pipelined = false;
+
     hm2_tram_read(hm2);
     if ((*hm2->llio->io_error) != 0) return;
     hm2_raw_queue_read(hm2);
@@ -149,6 +153,11 @@ static void hm2_write(void *void_hm2, long period) {
 
     hm2_raw_write(hm2);
     hm2_finish_write(hm2);
+
+    if (hm2->llio->pipeline_reads) {
+        hm2_read_request(void_hm2, period);
+        hm2->llio->read_pipelined = hm2->llio->read_requested;
+    }
 }
 
 
@@ -1419,6 +1428,25 @@ int hm2_register(hm2_lowlevel_io_t *llio, char *config_string) {
         goto fail1;
     }
 
+    hm2->tram_write_refresh = (hal_u32_t *)hal_malloc(sizeof(hal_u32_t));
+    if (hm2->tram_write_refresh == NULL) {
+        HM2_ERR("out of memory!\n");
+        r = -ENOMEM;
+        goto fail1;
+    }
+    *hm2->tram_write_refresh = 0;
+
+    {
+        char name[HAL_NAME_LEN + 1];
+        rtapi_snprintf(name, sizeof(name), "%s.tram_write_refresh", hm2->llio->name);
+        r = hal_param_u32_new(name, HAL_RW, hm2->tram_write_refresh, hm2->llio->comp_id);
+        if (r < 0) {
+            HM2_ERR("error adding param '%s', aborting\n", name);
+            r = -EINVAL;
+            goto fail1;
+        }
+    }
+
 
     //
     // At this point, all register buffers have been allocated.
@@ -1693,5 +1721,6 @@ void hm2_force_write(hostmot2_t *hm2) {
     hm2_sserial_force_write(hm2);
     hm2_bspi_force_write(hm2);
     hm2_dpll_force_write(hm2);
+    hm2_tram_force_write(hm2);
 }
 
@@ -298,12 +298,12 @@ typedef struct {
 
     rtapi_s32 zero_offset;  // *hal.pin.counts == (*hal.pin.rawcounts - zero_offset)
 
-    rtapi_u16 prev_reg_count;  // from this and the current count in the register we compute a change-in-counts, which we add to rawcounts
-
     rtapi_s32 prev_dS_counts;  // last time the function ran, it saw this many counts from the time before *that*
 
     rtapi_u32 prev_control;
 
+    int last_error_enable;  // quadrature_error_enable has been written to the control register
+
     // these two are the datapoint last time we moved (only valid if state == HM2_ENCODER_MOVING)
     rtapi_s32 prev_event_rawcounts;
     rtapi_u16 prev_event_reg_timestamp;
@@ -360,6 +360,12 @@ typedef struct {
     rtapi_u32 filter_rate_addr;
 
     rtapi_u32 dpll_timer_num_addr;
+
+    // per-instance count state, kept in arrays so that the change in
+    // counts of all the instances is worked out in one loop that the
+    // compiler can vectorize
+    rtapi_u16 *prev_reg_count;  // from this and the current count in the register we compute a change-in-counts, which we add to rawcounts
+    rtapi_s32 *reg_count_diff;  // that change-in-counts, for this cycle
 } hm2_encoder_t;
 
 //
@@ -702,12 +708,6 @@ typedef struct {
     // computing the feedforward velocity
     hal_float_t old_position_cmd;
 
-    rtapi_u32 prev_accumulator;
-
-    // this is a 48.16 signed fixed-point representation of the current
-    // stepgen position (16 bits of sub-step resolution)
-    rtapi_s64 subcounts;
-
     rtapi_u32 written_steplen;
     rtapi_u32 written_stepspace;
     rtapi_u32 written_dirsetup;
@@ -744,6 +744,15 @@ typedef struct {
     rtapi_u32 accumulator_addr;
     rtapi_u32 *accumulator_reg;
 
+    // per-instance feedback state, kept in arrays so that the
+    // accumulators of all the instances are processed in one loop that
+    // the compiler can vectorize
+    rtapi_u32 *prev_accumulator;
+
+    // this is a 48.16 signed fixed-point representation of the current
+    // stepgen position (16 bits of sub-step resolution)
+    rtapi_s64 *subcounts;
+
     rtapi_u32 mode_addr;
     rtapi_u32 *mode_reg;
 
@@ -991,6 +1000,7 @@ typedef struct {
     rtapi_u16 addr;
     rtapi_u16 size;
     rtapi_u32 **buffer;
+    bool strobe;  // every write does something (FIFO, command, watchdog reset)
     struct rtapi_list_head list;
 } hm2_tram_entry_t;
 
@@ -1047,6 +1057,13 @@ typedef struct {
     rtapi_u32 *tram_write_buffer;
     rtapi_u16 tram_write_size;
 
+    // what was last written from tram_write_buffer, so that registers
+    // that did not change can be left out of the write
+    rtapi_u32 *tram_write_shadow;
+    bool tram_write_shadow_valid;
+    rtapi_u32 tram_write_cycles;
+    hal_u32_t *tram_write_refresh;
+
     // the hostmot2 "Functions"
     hm2_encoder_t encoder;
     hm2_absenc_t absenc;
@@ -1113,12 +1130,14 @@ int hm2_get_pktuart(hostmot2_t **hm2, char *name);
 
 int hm2_register_tram_read_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer);
 int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer);
+int hm2_register_tram_strobe_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer);
 int hm2_allocate_tram_regions(hostmot2_t *hm2);
 int hm2_tram_read(hostmot2_t *hm2);
 int hm2_finish_read(hostmot2_t *hm2);
 int hm2_queue_read(hostmot2_t *hm2);
 int hm2_tram_write(hostmot2_t *hm2);
 int hm2_finish_write(hostmot2_t *hm2);
+void hm2_tram_force_write(hostmot2_t *hm2);
 void hm2_tram_cleanup(hostmot2_t *hm2);
 
 
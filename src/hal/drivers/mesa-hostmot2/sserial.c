@@ -37,6 +37,9 @@ int setbits(hm2_sserial_remote_t *chan, rtapi_u64 *val, int start, int len);
 int hm2_sserial_get_bytes(hostmot2_t *hm2, hm2_sserial_remote_t *chan, void *buffer, int addr, int size);
 int hm2_sserial_read_globals(hostmot2_t *hm2,hm2_sserial_remote_t *chan);
 int hm2_sserial_create_params(hostmot2_t *hm2, hm2_sserial_remote_t *chan);
+int hm2_sserial_nvram_mode(hostmot2_t *hm2, hm2_sserial_remote_t *chan, int on);
+int hm2_sserial_read_nvram_word(hostmot2_t *hm2, hm2_sserial_remote_t *chan,
+                                int addr, int length, void *data);
 int getlocal32(hostmot2_t *hm2, hm2_sserial_instance_t *inst, int addr);
 int getlocal8(hostmot2_t *hm2, hm2_sserial_instance_t *inst, int addr);
 int check_set_baudrate(hostmot2_t *hm2, hm2_sserial_instance_t *inst);
@@ -395,9 +398,9 @@ int hm2_sserial_setup_channel(hostmot2_t *hm2, hm2_sserial_instance_t *inst, int
         
     }
     // Nothing happens without a "Do It" command
-    r = hm2_register_tram_write_region(hm2, inst->command_reg_addr,
-                                       sizeof(rtapi_u32),
-                                       &inst->command_reg_write);
+    r = hm2_register_tram_strobe_region(hm2, inst->command_reg_addr,
+                                        sizeof(rtapi_u32),
+                                        &inst->command_reg_write);
     if (r < 0) {
         HM2_ERR("error registering tram write region for sserial "
                 "command register (%d)\n", index);
@@ -444,7 +447,9 @@ int hm2_sserial_setup_remotes(hostmot2_t *hm2,
             + inst->index * md->instance_stride + c * sizeof(rtapi_u32);
             HM2_DBG("reg_2_addr = %x\n", chan->reg_2_addr);
             
-            // Get the board ID and name before it is over-written by DoIts
+            // Get the board ID and name before it is over-written by DoIts.
+            // This has to be done for every remote before any of them is
+            // set up, as config reads are shared between channels.
             hm2->llio->read(hm2->llio, chan->reg_0_addr, 
                             &buff, sizeof(rtapi_u32));
             chan->serialnumber = buff;
@@ -467,33 +472,62 @@ int hm2_sserial_setup_remotes(hostmot2_t *hm2,
             
             HM2_DBG("BoardName %s\n", chan->name);
             
-            
-            if (hm2_sserial_read_globals(hm2, chan) < 0) {
-                HM2_ERR("Failed to read/setup the globals on %s\n", 
-                        chan->name);
-                return -EINVAL;
-            }
-            
-            if (hm2_sserial_read_configs(hm2, chan) < 0) {
-                HM2_ERR("Failed to read/setup the config data on %s\n", 
-                        chan->name);
-                return -EINVAL;
-            } 
-            
-            if ( hm2_sserial_create_pins(hm2, chan) < 0) {
-                HM2_ERR("Failed to create the pins on %s\n", 
-                        chan->name);
-                return -EINVAL;
+            // With only one remote there is nothing to share. Without the
+            // cache the remote simply reads its own bytes.
+            if (inst->num_remotes > 1) {
+                chan->rom_cache = rtapi_kzalloc(HM2_SSERIAL_ROM_CACHE_SIZE
+                                                + HM2_SSERIAL_ROM_CACHE_SIZE / 8,
+                                                RTAPI_GFP_KERNEL);
             }
+        }
+    }
+    
+    hm2->sserial.setup_inst = inst;
+    for (r = 0 ; r < inst->num_remotes ; r++) {
+        hm2_sserial_remote_t *chan = &inst->remotes[r];
+        
+        if (hm2_sserial_read_globals(hm2, chan) < 0) {
+            HM2_ERR("Failed to read/setup the globals on %s\n", 
+                    chan->name);
+            goto fail0;
+        }
+        
+        if (hm2_sserial_read_configs(hm2, chan) < 0) {
+            HM2_ERR("Failed to read/setup the config data on %s\n", 
+                    chan->name);
+            goto fail0;
+        } 
+        
+        // Finished with the config ROM, stop reading it for this remote
+        if (chan->rom_cache != NULL) {
+            rtapi_kfree(chan->rom_cache);
+            chan->rom_cache = NULL;
+        }
+        
+        if ( hm2_sserial_create_pins(hm2, chan) < 0) {
+            HM2_ERR("Failed to create the pins on %s\n", 
+                    chan->name);
+            goto fail0;
+        }
 
-            if ( hm2_sserial_register_tram(hm2, chan) < 0) {
-                HM2_ERR("Failed to register TRAM for %s\n",
-                        chan->name);
-                return -EINVAL;
-            }
+        if ( hm2_sserial_register_tram(hm2, chan) < 0) {
+            HM2_ERR("Failed to register TRAM for %s\n",
+                    chan->name);
+            goto fail0;
         }
     }
+    hm2->sserial.setup_inst = NULL;
     return 0;           
+
+fail0:
+    hm2->sserial.setup_inst = NULL;
+    for (r = 0 ; r < inst->num_remotes ; r++) {
+        if (inst->remotes[r].rom_cache != NULL) {
+            rtapi_kfree(inst->remotes[r].rom_cache);
+            inst->remotes[r].rom_cache = NULL;
+        }
+    }
+    return -EINVAL;
 }
 void config_8i20(hostmot2_t *hm2, hm2_sserial_remote_t *chan){
     rtapi_u32 buff;
@@ -659,23 +693,30 @@ int hm2_sserial_read_globals(hostmot2_t *hm2, hm2_sserial_remote_t *chan){
     return 0;
 }
 
-int hm2_sserial_read_nvram_word(hostmot2_t *hm2, 
-                                hm2_sserial_remote_t *chan, 
-                                int addr,
-                                int length,
-                                void *data){
+int hm2_sserial_nvram_mode(hostmot2_t *hm2, 
+                           hm2_sserial_remote_t *chan,
+                           int on){
     rtapi_u32 buff;
-//    return 0; //// This needs to disappear eventually, obviously
     buff = 0xEC000000;
     hm2->llio->write(hm2->llio, chan->reg_cs_addr, &buff, sizeof(rtapi_u32));
-    buff = 0x01;
+    buff = on ? 0x01 : 0x00;
     hm2->llio->write(hm2->llio, chan->reg_0_addr, &buff, sizeof(rtapi_u32));
     buff = 0x1000 | (1 << chan->index);
     hm2->llio->write(hm2->llio, chan->command_reg_addr, &buff, sizeof(rtapi_u32));
     if (0 > hm2_sserial_waitfor(hm2, chan->command_reg_addr, 0xFFFFFFFF, 1012)){
-        HM2_ERR("Timeout in sserial_read_nvram_word(2)\n");
-        goto fail0;
+        HM2_ERR("Timeout in sserial_nvram_mode(%s)\n", on ? "on" : "off");
+        return -EINVAL;
     }
+    return 0;
+}
+
+int hm2_sserial_read_nvram_word(hostmot2_t *hm2, 
+                                hm2_sserial_remote_t *chan, 
+                                int addr,
+                                int length,
+                                void *data){
+    // The remote must already be in NVRAM mode, see hm2_sserial_nvram_mode
+    rtapi_u32 buff;
     switch (length){
         case 1:
             buff = 0x44000000 + addr; break;
@@ -691,28 +732,18 @@ int hm2_sserial_read_nvram_word(hostmot2_t *hm2,
     buff = 0x1000 | (1 << chan->index);
     hm2->llio->write(hm2->llio, chan->command_reg_addr, &buff, sizeof(rtapi_u32));
     if (0 > hm2_sserial_waitfor(hm2, chan->command_reg_addr, 0xFFFFFFFF, 1013)){
-        HM2_ERR("Timeout in sserial_read_nvram_word(4)\n");
-        goto fail0;
-    }
-    hm2->llio->read(hm2->llio, chan->reg_0_addr, data, sizeof(rtapi_u32));
-    
-fail0: // attempt to set back to normal access
-    buff = 0xEC000000;
-    hm2->llio->write(hm2->llio, chan->reg_cs_addr, &buff, sizeof(rtapi_u32));
-    buff = 0x00;
-    hm2->llio->write(hm2->llio, chan->reg_0_addr, &buff, sizeof(rtapi_u32));
-    buff = 0x1000 | (1 << chan->index);
-    hm2->llio->write(hm2->llio, chan->command_reg_addr, &buff, sizeof(rtapi_u32));
-    if (0 > hm2_sserial_waitfor(hm2, chan->command_reg_addr, 0xFFFFFFFF, 1014)){
-        HM2_ERR("Timeout in sserial_read_nvram_word(6)\n");
+        HM2_ERR("Timeout in sserial_read_nvram_word\n");
         return -EINVAL;
     }
+    hm2->llio->read(hm2->llio, chan->reg_0_addr, data, sizeof(rtapi_u32));
     return 0;
 }    
     
 
 int hm2_sserial_create_params(hostmot2_t *hm2, hm2_sserial_remote_t *chan){
     int i, r;
+    int num_nvram = 0;
+    int err = 0;
     hm2_sserial_data_t global;
     
     chan->params = hal_malloc(chan->num_globals * sizeof(hm2_sserial_params_t));
@@ -751,12 +782,7 @@ int hm2_sserial_create_params(hostmot2_t *hm2, hm2_sserial_remote_t *chan){
                                        chan->name, 
                                        global.NameString);
                 if (r < 0) {HM2_ERR("Out of memory\n") ; return -ENOMEM;}
-                r = hm2_sserial_read_nvram_word(hm2, 
-                                                chan,
-                                                global.ParmAddr,
-                                                global.DataLength/8,
-                                                (void*)&(chan->params[i].u32_param));
-                if (r < 0) {HM2_ERR("SSerial Parameter read error\n") ; return -EINVAL;}
+                num_nvram++;
                 break;
             case 0x05:
                 r = hal_param_s32_newf(HAL_RO, 
@@ -766,17 +792,36 @@ int hm2_sserial_create_params(hostmot2_t *hm2, hm2_sserial_remote_t *chan){
                                        chan->name, 
                                        chan->globals[i].NameString);
                 if (r < 0) {HM2_ERR("Out of memory\n") ; return -ENOMEM;}
-                r = hm2_sserial_read_nvram_word(hm2, 
-                                                chan,
-                                                global.ParmAddr,
-                                                global.DataLength/8,
-                                                (void*)&(chan->params[i].s32_param));
-                if (r < 0) {HM2_ERR("SSerial Parameter read error\n") ; return -EINVAL;}
+                num_nvram++;
                 break;
                 
         }
     }
-    return 0;
+    
+    if (num_nvram == 0) return 0;
+    
+    // Read all the non-volatile values in one go, rather than switching
+    // NVRAM access on and off again for each of them.
+    if (hm2_sserial_nvram_mode(hm2, chan, 1) < 0) {
+        err = -EINVAL;
+        goto fail0;
+    }
+    for (i = 0 ; i < chan->num_globals ; i++){
+        global = chan->globals[i];
+        if (global.DataType != 0x04 && global.DataType != 0x05) continue;
+        r = hm2_sserial_read_nvram_word(hm2, 
+                                        chan,
+                                        global.ParmAddr,
+                                        global.DataLength/8,
+                                        (global.DataType == 0x04)
+                                        ? (void*)&(chan->params[i].u32_param)
+                                        : (void*)&(chan->params[i].s32_param));
+        if (r < 0) {HM2_ERR("SSerial Parameter read error\n") ; err = -EINVAL; break;}
+    }
+    
+fail0: // attempt to set back to normal access, even after an error
+    if (hm2_sserial_nvram_mode(hm2, chan, 0) < 0) return -EINVAL;
+    return err;
 }
     
     
@@ -1576,8 +1621,87 @@ void hm2_sserial_print_module(hostmot2_t *hm2) {
     HM2_PRINT("\n");
 }
 
+static int rom_cached(hm2_sserial_remote_t *chan, int addr){
+    return chan->rom_cache != NULL
+        && addr >= 0 && addr < HM2_SSERIAL_ROM_CACHE_SIZE
+        && (chan->rom_cache[HM2_SSERIAL_ROM_CACHE_SIZE + addr / 8] & (1 << (addr % 8)));
+}
+
+static int hm2_sserial_get_rom_byte(hostmot2_t *hm2, hm2_sserial_remote_t *chan,
+                                    int addr, rtapi_u32 *byte){
+    // Remotes of the same type walk the same tables in their config ROM,
+    // and a DoIt takes as long for all the channels as for one. So while
+    // the remotes are being set up, every one that has not read this byte
+    // yet reads it now too, and later finds it in its cache.
+    hm2_sserial_instance_t *inst;
+    hm2_sserial_remote_t *rem;
+    rtapi_u32 data, mask;
+    int r, num;
+    
+    if (rom_cached(chan, addr)){
+        *byte = chan->rom_cache[addr];
+        return 0;
+    }
+    
+    inst = hm2->sserial.setup_inst;
+    if (chan->rom_cache == NULL || inst == NULL){
+        rem = chan;
+        num = 1;
+    } else {
+        rem = inst->remotes;
+        num = inst->num_remotes;
+    }
+    
+    data = 0x4C000000 | addr;
+    mask = 0;
+    for (r = 0 ; r < num ; r++){
+        if (&rem[r] == chan
+            || (rem[r].rom_cache != NULL
+                && addr >= 0 && addr < HM2_SSERIAL_ROM_CACHE_SIZE
+                && ! rom_cached(&rem[r], addr))){
+            hm2->llio->write(hm2->llio, rem[r].reg_cs_addr, &data, sizeof(rtapi_u32));
+            mask |= 1 << rem[r].index;
+        }
+    }
+    for (r = 0 ; r < num ; r++){
+        if (! (mask & (1 << rem[r].index))) continue;
+        if (0 > hm2_sserial_waitfor(hm2, rem[r].reg_cs_addr, 0x0000FF00, 24)){
+            if (&rem[r] == chan){
+                HM2_ERR("Timeout trying to read config data in sserial_get_bytes\n");
+                return -EINVAL;
+            }
+            // leave the other remote to read its own bytes
+            mask &= ~(1 << rem[r].index);
+            rtapi_kfree(rem[r].rom_cache);
+            rem[r].rom_cache = NULL;
+        }
+    }
+    data = 0x1000 | mask;
+    hm2->llio->write(hm2->llio, chan->command_reg_addr, &data, sizeof(rtapi_u32));
+    
+    if (0 > hm2_sserial_waitfor(hm2, chan->command_reg_addr, 0xFFFFFFFF, 25)){
+        HM2_ERR("Timeout during do-it in sserial_get_bytes\n");
+        return -EINVAL;
+    }
+    
+    for (r = 0 ; r < num ; r++){
+        if (! (mask & (1 << rem[r].index))) continue;
+        hm2->llio->read(hm2->llio, rem[r].reg_0_addr, &data, sizeof(rtapi_u32));
+        data &= 0x000000FF;
+        if (&rem[r] == chan){
+            *byte = data;
+        }
+        if (rem[r].rom_cache != NULL
+            && addr >= 0 && addr < HM2_SSERIAL_ROM_CACHE_SIZE){
+            rem[r].rom_cache[addr] = data;
+            rem[r].rom_cache[HM2_SSERIAL_ROM_CACHE_SIZE + addr / 8] |= 1 << (addr % 8);
+        }
+    }
+    return 0;
+}
+
 int hm2_sserial_get_bytes(hostmot2_t *hm2, hm2_sserial_remote_t *chan, void *buffer, int addr, int size ){
-    // Gets the bytes one at a time. This could be done more efficiently. 
+    // Gets the bytes one at a time, shared with the other remotes during setup
     char *ptr;
     rtapi_u32 data;
     int string = size;
@@ -1585,23 +1709,9 @@ int hm2_sserial_get_bytes(hostmot2_t *hm2, hm2_sserial_remote_t *chan, void *buf
     
     ptr = (char*)buffer;
     while(0 != size){
-        data = 0x4C000000 | addr++;
-        hm2->llio->write(hm2->llio, chan->reg_cs_addr, &data, sizeof(rtapi_u32));
-        
-        if (0 > hm2_sserial_waitfor(hm2, chan->reg_cs_addr, 0x0000FF00, 24)){
-            HM2_ERR("Timeout trying to read config data in sserial_get_bytes\n");
-            return -EINVAL;
-        }
-        data = 0x1000 | (1 << chan->index);
-        hm2->llio->write(hm2->llio, chan->command_reg_addr, &data, sizeof(rtapi_u32));
-        
-        if (0 > hm2_sserial_waitfor(hm2, chan->command_reg_addr, 0xFFFFFFFF, 25)){
-            HM2_ERR("Timeout during do-it in sserial_get_bytes\n");
+        if (hm2_sserial_get_rom_byte(hm2, chan, addr++, &data) < 0){
             return -EINVAL;
         }
-        
-        hm2->llio->read(hm2->llio, chan->reg_0_addr, &data, sizeof(rtapi_u32));
-        data &= 0x000000FF;
         size--;
         if (size < 0) { // string data
             if (data == 0 || size < (-HM2_SSERIAL_MAX_STRING_LENGTH)){
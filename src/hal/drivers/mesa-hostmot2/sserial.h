@@ -24,6 +24,7 @@
 #define HM2_SSERIAL_TYPE_8I20               0x30324938  // '8i20' as 4 ascii
 #define HM2_SSERIAL_TYPE_7I64               0x34364937  // More to be added later.
 #define HM2_SSERIAL_MAX_STRING_LENGTH       48
+#define HM2_SSERIAL_ROM_CACHE_SIZE          0x1000 // config bytes cached at setup
 
 //Commands etc
 #define LBPNONVOL_flag      0xCC000000
@@ -226,6 +227,7 @@ typedef struct {
     int myinst;
     char name[29];
     char raw_name[5];
+    rtapi_u8 *rom_cache; // config bytes then a valid bitmap, only during setup
 }hm2_sserial_remote_t;
 
 typedef struct {
@@ -258,6 +260,7 @@ typedef struct {
     int baudrate;
     int num_instances; // number of active instances
     hm2_sserial_instance_t *instance ;
+    hm2_sserial_instance_t *setup_inst; // remotes sharing config reads
 } hm2_sserial_t;
 
 #endif
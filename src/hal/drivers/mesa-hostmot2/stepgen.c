@@ -26,6 +26,7 @@
 #include "hal.h"
 
 #include "hal/drivers/mesa-hostmot2/hostmot2.h"
+#include "hal/drivers/mesa-hostmot2/hostmot2-wrap.h"
 
 
 #define f_period_s ((double)(l_period_ns * 1e-9))
@@ -38,11 +39,21 @@
 // 
 
 void hm2_stepgen_process_tram_read(hostmot2_t *hm2, long l_period_ns) {
-    int i;
-    for (i = 0; i < hm2->stepgen.num_instances; i ++) {
-        rtapi_u32 acc = hm2->stepgen.accumulator_reg[i];
-        rtapi_s64 acc_delta;
+    rtapi_u32 *acc = hm2->stepgen.accumulator_reg;
+    rtapi_u32 *prev_acc = hm2->stepgen.prev_accumulator;
+    rtapi_s64 *subcounts = hm2->stepgen.subcounts;
+    int i, n = hm2->stepgen.num_instances;
+
+    // The HM2 Accumulator Register is a 16.16 bit fixed-point
+    // representation of the current stepper position.
+    // The fractional part gives accurate velocity at low speeds, and
+    // sub-step position feedback (like sw stepgen).
+    for (i = 0; i < n; i ++) {
+        subcounts[i] += hm2_stepgen_acc_delta(acc[i], prev_acc[i]);
+        prev_acc[i] = acc[i];
+    }
 
+    for (i = 0; i < n; i ++) {
         // those tricky users are always trying to get us to divide by zero
         if (fabs(hm2->stepgen.instance[i].hal.param.position_scale) < 1e-6) {
             if (hm2->stepgen.instance[i].hal.param.position_scale >= 0.0) {
@@ -54,27 +65,12 @@ void hm2_stepgen_process_tram_read(hostmot2_t *hm2, long l_period_ns) {
             }
         }
 
-        // The HM2 Accumulator Register is a 16.16 bit fixed-point
-        // representation of the current stepper position.
-        // The fractional part gives accurate velocity at low speeds, and
-        // sub-step position feedback (like sw stepgen).
-        acc_delta = (rtapi_s64)acc - (rtapi_s64)hm2->stepgen.instance[i].prev_accumulator;
-        if (acc_delta > INT32_MAX) {
-            acc_delta -= UINT32_MAX;
-        } else if (acc_delta < INT32_MIN) {
-            acc_delta += UINT32_MAX;
-        }
-
-        hm2->stepgen.instance[i].subcounts += acc_delta;
-
-        *(hm2->stepgen.instance[i].hal.pin.counts) = hm2->stepgen.instance[i].subcounts >> 16;
+        *(hm2->stepgen.instance[i].hal.pin.counts) = subcounts[i] >> 16;
 
         // note that it's important to use "subcounts/65536.0" instead of just
         // "counts" when computing position_fb, because position_fb needs sub-count
         // precision
-        *(hm2->stepgen.instance[i].hal.pin.position_fb) = ((double)hm2->stepgen.instance[i].subcounts / 65536.0) / hm2->stepgen.instance[i].hal.param.position_scale;
-
-        hm2->stepgen.instance[i].prev_accumulator = acc;
+        *(hm2->stepgen.instance[i].hal.pin.position_fb) = ((double)subcounts[i] / 65536.0) / hm2->stepgen.instance[i].hal.param.position_scale;
     }
 }
 
@@ -550,7 +546,7 @@ void hm2_stepgen_tram_init(hostmot2_t *hm2) {
     int i;
 
     for (i = 0; i < hm2->stepgen.num_instances; i ++) {
-        hm2->stepgen.instance[i].prev_accumulator = hm2->stepgen.accumulator_reg[i];
+        hm2->stepgen.prev_accumulator[i] = hm2->stepgen.accumulator_reg[i];
         hm2->stepgen.instance[i].old_position_cmd = *hm2->stepgen.instance[i].hal.pin.position_cmd;
     }
 }
@@ -657,6 +653,14 @@ int hm2_stepgen_parse_md(hostmot2_t *hm2, int md_index) {
         goto fail0;
     }
 
+    hm2->stepgen.prev_accumulator = (rtapi_u32 *)hal_malloc(hm2->stepgen.num_instances * sizeof(rtapi_u32));
+    hm2->stepgen.subcounts = (rtapi_s64 *)hal_malloc(hm2->stepgen.num_instances * sizeof(rtapi_s64));
+    if (hm2->stepgen.prev_accumulator == NULL || hm2->stepgen.subcounts == NULL) {
+        HM2_ERR("out of memory!\n");
+        r = -ENOMEM;
+        goto fail0;
+    }
+
     hm2->stepgen.clock_frequency = md->clock_freq;
     hm2->stepgen.version = md->version;
 
@@ -965,7 +969,7 @@ int hm2_stepgen_parse_md(hostmot2_t *hm2, int md_index) {
             hm2->stepgen.instance[i].hal.param.maxvel = 0.0;
             hm2->stepgen.instance[i].hal.param.maxaccel = 1.0;
 
-            hm2->stepgen.instance[i].subcounts = 0;
+            hm2->stepgen.subcounts[i] = 0;
 
             // start out the slowest possible, let the user speed up if they want
             hm2->stepgen.instance[i].hal.param.steplen   = (double)0x3FFF * ((double)1e9 / (double)hm2->stepgen.clock_frequency);
@@ -986,7 +990,7 @@ int hm2_stepgen_parse_md(hostmot2_t *hm2, int md_index) {
             hm2->stepgen.instance[i].hal.param.table[2] = 0;
             hm2->stepgen.instance[i].hal.param.table[3] = 0;
 
-            hm2->stepgen.instance[i].prev_accumulator = 0;
+            hm2->stepgen.prev_accumulator[i] = 0;
         }
     }
 
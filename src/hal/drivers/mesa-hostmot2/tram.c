@@ -62,7 +62,7 @@ int hm2_register_tram_read_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 siz
 }
 
 
-int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer) {
+static int register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer, bool strobe) {
     hm2_tram_entry_t *tram_entry;
 
     tram_entry = rtapi_kmalloc(sizeof(hm2_tram_entry_t), RTAPI_GFP_KERNEL);
@@ -74,6 +74,7 @@ int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 si
     tram_entry->addr = addr;
     tram_entry->size = size;
     tram_entry->buffer = buffer;
+    tram_entry->strobe = strobe;
 
     rtapi_list_add_tail(&tram_entry->list, &hm2->tram_write_entries);
 
@@ -81,6 +82,22 @@ int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 si
 }
 
 
+//
+// Registers written through a write region are only written when they
+// change (see hm2_tram_write() below).  Registers where every write has
+// an effect, even of an unchanged value, must be registered with
+// hm2_register_tram_strobe_region() instead.
+//
+
+int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer) {
+    return register_tram_write_region(hm2, addr, size, buffer, false);
+}
+
+int hm2_register_tram_strobe_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer) {
+    return register_tram_write_region(hm2, addr, size, buffer, true);
+}
+
+
 int hm2_allocate_tram_regions(hostmot2_t *hm2) {
     struct rtapi_list_head *ptr;
     rtapi_u16 offset;
@@ -122,6 +139,13 @@ int hm2_allocate_tram_regions(hostmot2_t *hm2) {
     if(hm2->tram_write_size>old_tram_write_size)
         memset(hm2->tram_write_buffer+old_tram_write_size, 0, hm2->tram_write_size-old_tram_write_size);
 
+    hm2->tram_write_shadow = (rtapi_u32 *)rtapi_krealloc(hm2->tram_write_shadow, hm2->tram_write_size, RTAPI_GFP_KERNEL);
+    if (hm2->tram_write_shadow == NULL) {
+        HM2_ERR("Error while (re)allocating Translation RAM write shadow (%d bytes)\n", hm2->tram_write_size);
+        return -ENOMEM;
+    }
+    hm2->tram_write_shadow_valid = false;
+
     HM2_DBG("buffer address %p\n", &hm2->tram_write_buffer);
     HM2_DBG("Translation RAM read buffer:\n");
     offset = 0;
@@ -186,7 +210,16 @@ int hm2_finish_read(hostmot2_t *hm2) {
 
 
 static rtapi_u32 tram_write_iteration = 0;
-int hm2_tram_write(hostmot2_t *hm2) {
+
+//
+// Unchanged registers separated by no more than this many words are
+// written along with the changed ones around them, rather than starting
+// a new burst (on ethernet, each burst costs a word of command).
+//
+
+#define TRAM_WRITE_MERGE_GAP 1
+
+static int tram_write_all(hostmot2_t *hm2) {
     struct rtapi_list_head *ptr;
 
     rtapi_list_for_each(ptr, &hm2->tram_write_entries) {
@@ -197,11 +230,90 @@ int hm2_tram_write(hostmot2_t *hm2) {
             return -EIO;
         }
     }
+    return 0;
+}
+
+// write only the registers that differ from the shadow copy (and all
+// strobe registers), in as few bursts as possible
+static int tram_write_changed(hostmot2_t *hm2) {
+    struct rtapi_list_head *ptr;
+    rtapi_u32 *burst = NULL;    // first word of the burst being collected
+    rtapi_u16 burst_addr = 0;
+    int burst_words = 0;
+
+    rtapi_list_for_each(ptr, &hm2->tram_write_entries) {
+        hm2_tram_entry_t *tram_entry = rtapi_list_entry(ptr, hm2_tram_entry_t, list);
+        rtapi_u32 *buffer = *tram_entry->buffer;
+        rtapi_u32 *shadow = hm2->tram_write_shadow + (buffer - hm2->tram_write_buffer);
+        int i, words = tram_entry->size / sizeof(rtapi_u32);
+
+        for (i = 0; i < words; i ++) {
+            rtapi_u16 addr = tram_entry->addr + i * sizeof(rtapi_u32);
+
+            if (!tram_entry->strobe && buffer[i] == shadow[i]) continue;
+
+            // the words in between are only known to be registers if
+            // they are next to each other both here and on the board
+            if (burst != NULL) {
+                int gap = &buffer[i] - (burst + burst_words);
+                if (gap >= 0 && gap <= TRAM_WRITE_MERGE_GAP
+                        && addr == burst_addr + (burst_words + gap) * sizeof(rtapi_u32)) {
+                    burst_words += gap + 1;
+                    continue;
+                }
+            }
+
+            if (burst != NULL && !hm2->llio->queue_write(hm2->llio, burst_addr, burst, burst_words * sizeof(rtapi_u32))) {
+                HM2_ERR("TRAM write error! (addr=0x%04x, size=%d, iter=%u)\n", burst_addr, (int)(burst_words * sizeof(rtapi_u32)), tram_write_iteration);
+                return -EIO;
+            }
+            burst = &buffer[i];
+            burst_addr = addr;
+            burst_words = 1;
+        }
+    }
+
+    if (burst != NULL && !hm2->llio->queue_write(hm2->llio, burst_addr, burst, burst_words * sizeof(rtapi_u32))) {
+        HM2_ERR("TRAM write error! (addr=0x%04x, size=%d, iter=%u)\n", burst_addr, (int)(burst_words * sizeof(rtapi_u32)), tram_write_iteration);
+        return -EIO;
+    }
+    return 0;
+}
+
+//
+// With the tram_write_refresh parameter at 0, every write region is
+// written every cycle.  Otherwise only the registers that changed since
+// the last cycle are, and everything is written again every
+// tram_write_refresh cycles and after hm2_tram_force_write(), in case
+// the board missed a write or was reset.
+//
+
+int hm2_tram_write(hostmot2_t *hm2) {
+    rtapi_u32 refresh = hm2->tram_write_refresh ? *hm2->tram_write_refresh : 0;
+    int r;
+
+    if (refresh == 0 || !hm2->tram_write_shadow_valid || ++hm2->tram_write_cycles >= refresh) {
+        r = tram_write_all(hm2);
+        hm2->tram_write_cycles = 0;
+    } else {
+        r = tram_write_changed(hm2);
+    }
+    if (r < 0) {
+        hm2->tram_write_shadow_valid = false;
+        return r;
+    }
+
+    memcpy(hm2->tram_write_shadow, hm2->tram_write_buffer, hm2->tram_write_size);
+    hm2->tram_write_shadow_valid = true;
     tram_write_iteration ++;
 
     return 0;
 }
 
+void hm2_tram_force_write(hostmot2_t *hm2) {
+    hm2->tram_write_shadow_valid = false;
+}
+
 int hm2_finish_write(hostmot2_t *hm2) {
     if (!hm2->llio->send_queued_writes) return 0;
     if (!hm2->llio->send_queued_writes(hm2->llio)) {
@@ -231,5 +343,6 @@ void hm2_tram_cleanup(hostmot2_t *hm2) {
     // free the tram buffers
     if (hm2->tram_read_buffer != NULL) rtapi_kfree(hm2->tram_read_buffer);
     if (hm2->tram_write_buffer != NULL) rtapi_kfree(hm2->tram_write_buffer);
+    if (hm2->tram_write_shadow != NULL) rtapi_kfree(hm2->tram_write_shadow);
 }
 
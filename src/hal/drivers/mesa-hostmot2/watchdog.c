@@ -114,7 +114,7 @@ int hm2_watchdog_parse_md(hostmot2_t *hm2, int md_index) {
         goto fail0;
     }
 
-    r = hm2_register_tram_write_region(hm2, hm2->watchdog.reset_addr, sizeof(rtapi_u32), &hm2->watchdog.reset_reg);
+    r = hm2_register_tram_strobe_region(hm2, hm2->watchdog.reset_addr, sizeof(rtapi_u32), &hm2->watchdog.reset_reg);
     if (r < 0) {
         HM2_ERR("error registering tram write region for watchdog (%d)!\n", r);
         goto fail0;
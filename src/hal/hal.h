@@ -777,6 +777,17 @@ extern bool hal_stream_writable(hal_stream_t *stream);
 extern void hal_stream_wait_writable(hal_stream_t *stream, sig_atomic_t *stop);
 #endif
 
+/** hal_stream_read_many() and hal_stream_write_many() move up to 'count'
+    records at once, with one update of the fifo pointers.  A record is
+    hal_stream_element_count()+1 elements: the values, then the sample
+    number (ignored by write_many, which numbers the records itself).
+    They return the number of records moved, which is less than 'count'
+    when the fifo runs empty or full; this is not counted as an underrun
+    or overrun.
+*/
+extern int hal_stream_read_many(hal_stream_t *stream, union hal_stream_data *buf, int count);
+extern int hal_stream_write_many(hal_stream_t *stream, union hal_stream_data *buf, int count);
+
 RTAPI_END_DECLS
 
 #endif /* HAL_H */
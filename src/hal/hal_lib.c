@@ -66,11 +66,18 @@
 MODULE_AUTHOR("John Kasunich");
 MODULE_DESCRIPTION("Hardware Abstraction Layer for EMC");
 MODULE_LICENSE("GPL");
+static int hal_size = HAL_SIZE;
+RTAPI_MP_INT(hal_size, "size of HAL shared memory, in bytes");
+static int parallel_cpus[HAL_MAX_HELPERS] =
+    {[0 ... HAL_MAX_HELPERS - 1] = -1 };
+RTAPI_MP_ARRAY_INT(parallel_cpus, HAL_MAX_HELPERS,
+    "processors for the helper tasks of parallel threads");
 #endif /* RTAPI */
 
 #if defined(ULAPI)
 #include <sys/types.h>		/* pid_t */
 #include <unistd.h>		/* getpid() */
+#include <stdlib.h>		/* getenv() */
 #include <time.h>
 #endif
 
@@ -88,9 +95,10 @@ static int lib_mem_id = 0;	/* RTAPI shmem ID for library module */
 
 /** init_hal_data() initializes the entire HAL data structure, only
     if the structure has not already been initialized.  (The init
-    is done by the first HAL component to be loaded.
+    is done by the first HAL component to be loaded.  'size' is the
+    size of the shared memory block.
 */
-static int init_hal_data(void);
+static int init_hal_data(long size);
 
 /** The 'shmalloc_xx()' functions allocate blocks of shared memory.
     Each function allocates a block that is 'size' bytes long.
@@ -115,6 +123,21 @@ static int init_hal_data(void);
 static void *shmalloc_up(long int size);
 static void *shmalloc_dn(long int size);
 
+/** 'malloc_owner()' returns the component that a hal_malloc() made now
+    belongs to: the one component of this process (or the realtime
+    one) that is not ready yet, or NULL if there is no such single
+    component.  'block_alloc()' gets a block of at least 'size' bytes
+    for 'owner', from the free lists if possible, and 'free_blocks()'
+    releases all blocks of a component.  'block_release()' puts one
+    block, that no component owns, back on the free lists.  They assume
+    the caller holds the mutex.
+*/
+static hal_comp_t *malloc_owner(void);
+static void *block_alloc(hal_comp_t * owner, long int size);
+static void free_blocks(hal_comp_t * comp);
+static void block_release(hal_block_t * b);
+static hal_block_t *block_reuse(long int size);
+
 /** The alloc_xxx_struct() functions allocate a structure of the
     appropriate type and return a pointer to it, or 0 if they fail.
     They attempt to re-use freed structs first, if none are
@@ -151,12 +174,68 @@ static void free_funct_entry_struct(hal_funct_entry_t * funct_entry);
 static void free_thread_struct(hal_thread_t * thread);
 #endif /* RTAPI */
 
+/** 'drop_schedules()' makes every thread run its functions in order
+    until the next halpr_schedule_threads(), and waits for parallel runs
+    that already started to finish.  Called before functions are added
+    to or removed from threads, or pins are linked or unlinked.
+    'reschedule_threads()' is called after such a change: if the threads
+    are running, it works out new schedules at once, so that parallel
+    threads do not run in order until the next start.
+*/
+static void drop_schedules(void);
+static void reschedule_threads(void);
+
+/* for busy waits on other processors */
+#if defined(__i386__) || defined(__x86_64__)
+#define spin_pause() __asm__ __volatile__("pause" ::: "memory")
+#else
+#define spin_pause() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/** The hash_xxx() functions maintain the name indexes in hal_data.
+    HASH_BUCKET() returns the head of the bucket that 'name' hashes
+    to in 'table', which must be one of the hash arrays in hal_data.
+    'hash_insert()' adds the object at offset 'ptr' to the head of
+    a bucket, and 'hash_remove()' unlinks it again.  'link_off' is
+    the byte offset of the object's 'hash_next' field.  Like the
+    alloc/free functions, these assume the caller holds the mutex.
+*/
+static unsigned int hash_name(const char *name);
+static void hash_insert(int *bucket, int ptr, int *hash_next);
+static void hash_remove(int *bucket, int ptr, long link_off);
+
+#define HASH_BUCKET(table, name) \
+    (&(table)[hash_name(name) & (sizeof(table) / sizeof((table)[0]) - 1)])
+#define HASH_LINK_OFF(obj) ((long)((char *)&(obj)->hash_next - (char *)(obj)))
+
+/** Pins, signals and params begin with these links.  'list_insert()'
+    puts the object at offset 'ptr' into the sorted 'list', using the
+    search tree at 'root' to find its place instead of walking the
+    list, and 'tree_remove()' takes it out of the tree again (the
+    caller unlinks it from the list).  'name_off' is the byte offset
+    of the object's name.  The caller must already have checked for
+    duplicates, and must hold the mutex.
+*/
+typedef struct {
+    int next_ptr;
+    int hash_next;
+    int tree_left;
+    int tree_right;
+} hal_links_t;
+
+static void list_insert(int *list, int *root, int ptr, long name_off);
+static void tree_remove(int *root, int ptr, long name_off);
+
+#define NAME_OFF(obj) ((long)((char *)(obj)->name - (char *)(obj)))
+
 #ifdef RTAPI
 /** 'thread_task()' is a function that is invoked as a realtime task.
     It implements a thread, by running down the thread's function list
     and calling each function in turn.
 */
 static void thread_task(void *arg);
+static void helper_task(void *arg);
+static void start_helpers(hal_thread_t * thread);
 #endif /* RTAPI */
 
 /***********************************************************************
@@ -165,6 +244,16 @@ static void thread_task(void *arg);
 
 static int ref_cnt = 0;
 
+#ifdef ULAPI
+unsigned long hal_shmem_request_size(void)
+{
+    const char *env = getenv("HAL_SIZE");
+    long size = env ? strtol(env, NULL, 0) : 0;
+
+    return size > HAL_SIZE ? size : HAL_SIZE;
+}
+#endif
+
 int hal_init(const char *name)
 {
     int comp_id;
@@ -198,7 +287,8 @@ int hal_init(const char *name)
 	}
 
 	/* get HAL shared memory block from RTAPI */
-	lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id, HAL_SIZE);
+	lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id,
+	    hal_shmem_request_size());
 	if (lib_mem_id < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"HAL: ERROR: could not open shared memory\n");
@@ -217,7 +307,7 @@ int hal_init(const char *name)
         hal_shmem_base = (char *) mem;
         hal_data = (hal_data_t *) mem;
 	/* perform a global init if needed */
-	retval = init_hal_data();
+	retval = init_hal_data(hal_shmem_request_size());
 	if ( retval ) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"HAL: ERROR: could not init shared memory\n");
@@ -274,6 +364,8 @@ int hal_init(const char *name)
     /* insert new structure at head of list */
     comp->next_ptr = hal_data->comp_list_ptr;
     hal_data->comp_list_ptr = SHMOFF(comp);
+    hash_insert(HASH_BUCKET(hal_data->comp_hash, comp->name), SHMOFF(comp),
+	&(comp->hash_next));
     /* done with list, release mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     /* done */
@@ -370,6 +462,7 @@ int hal_exit(int comp_id)
 void *hal_malloc(long int size)
 {
     void *retval;
+    hal_comp_t *owner;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -378,8 +471,13 @@ void *hal_malloc(long int size)
     }
     /* get the mutex */
     rtapi_mutex_get(&(hal_data->mutex));
-    /* allocate memory */
-    retval = shmalloc_up(size);
+    /* allocate memory, recyclable if we know who it belongs to */
+    owner = malloc_owner();
+    if (owner != 0) {
+	retval = block_alloc(owner, size);
+    } else {
+	retval = shmalloc_up(size);
+    }
     /* release the mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     /* check return value */
@@ -605,8 +703,7 @@ int hal_pin_s32_newf(hal_pin_dir_t dir,
 int hal_pin_new(const char *name, hal_type_t type, hal_pin_dir_t dir,
     void **data_ptr_addr, int comp_id)
 {
-    int *prev, next, cmp;
-    hal_pin_t *new, *ptr;
+    hal_pin_t *new;
     hal_comp_t *comp;
 
     if (hal_data == 0) {
@@ -669,6 +766,13 @@ int hal_pin_new(const char *name, hal_type_t type, hal_pin_dir_t dir,
 	    "HAL: ERROR: pin_new called after hal_ready\n");
 	return -EINVAL;
     }
+    /* check for an existing pin with the same name */
+    if (halpr_find_pin_by_name(name) != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: duplicate variable '%s'\n", name);
+	return -EINVAL;
+    }
     /* allocate a new variable structure */
     new = alloc_pin_struct();
     if (new == 0) {
@@ -688,44 +792,19 @@ int hal_pin_new(const char *name, hal_type_t type, hal_pin_dir_t dir,
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
     /* make 'data_ptr' point to dummy signal */
     *data_ptr_addr = comp->shmem_base + SHMOFF(&(new->dummysig));
-    /* search list for 'name' and insert new structure */
-    prev = &(hal_data->pin_list_ptr);
-    next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	ptr = SHMPTR(next);
-	cmp = strcmp(ptr->name, new->name);
-	if (cmp > 0) {
-	    /* found the right place for it, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	if (cmp == 0) {
-	    /* name already in list, can't insert */
-	    free_pin_struct(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    rtapi_print_msg(RTAPI_MSG_ERR,
-		"HAL: ERROR: duplicate variable '%s'\n", name);
-	    return -EINVAL;
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(ptr->next_ptr);
-	next = *prev;
-    }
+    /* insert new structure in the list and the index */
+    list_insert(&(hal_data->pin_list_ptr), &(hal_data->pin_tree_root),
+	SHMOFF(new), NAME_OFF(new));
+    hash_insert(HASH_BUCKET(hal_data->pin_hash, new->name), SHMOFF(new),
+	&(new->hash_next));
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
 }
 
 int hal_pin_alias(const char *pin_name, const char *alias)
 {
-    int *prev, next, cmp;
-    hal_pin_t *pin, *ptr;
+    int *prev, next;
+    hal_pin_t *pin;
     hal_oldname_t *oldname;
 
     if (hal_data == 0) {
@@ -770,42 +849,35 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 	return -EINVAL;
     }
     free_oldname_struct(oldname);
-    /* find the pin and unlink it from pin list */
+    /* find the pin */
+    pin = halpr_find_pin_by_name(pin_name);
+    if (pin == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: pin '%s' not found\n", pin_name);
+	return -EINVAL;
+    }
+    /* unlink it from the pin list and the index */
     prev = &(hal_data->pin_list_ptr);
     next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, not found */
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    rtapi_print_msg(RTAPI_MSG_ERR,
-		"HAL: ERROR: pin '%s' not found\n", pin_name);
-	    return -EINVAL;
-	}
-	pin = SHMPTR(next);
-	if ( strcmp(pin->name, pin_name) == 0 ) {
-	    /* found it, unlink from list */
-	    *prev = pin->next_ptr;
-	    break;
-	}
-	if (pin->oldname != 0 ) {
-	    oldname = SHMPTR(pin->oldname);
-	    if (strcmp(oldname->name, pin_name) == 0) {
-		/* found it, unlink from list */
-		*prev = pin->next_ptr;
-		break;
-	    }
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(pin->next_ptr);
+    while (next != SHMOFF(pin)) {
+	prev = &(((hal_pin_t *) SHMPTR(next))->next_ptr);
 	next = *prev;
     }
+    *prev = pin->next_ptr;
+    tree_remove(&(hal_data->pin_tree_root), SHMOFF(pin), NAME_OFF(pin));
+    hash_remove(HASH_BUCKET(hal_data->pin_hash, pin->name), SHMOFF(pin),
+	HASH_LINK_OFF(pin));
     if ( alias != NULL ) {
 	/* adding a new alias */
 	if ( pin->oldname == 0 ) {
 	    /* save old name (only if not already saved) */
 	    oldname = halpr_alloc_oldname_struct();
 	    pin->oldname = SHMOFF(oldname);
+	    oldname->owner_ptr = SHMOFF(pin);
 	    rtapi_snprintf(oldname->name, sizeof(oldname->name), "%s", pin->name);
+	    hash_insert(HASH_BUCKET(hal_data->pin_alias_hash, oldname->name),
+		SHMOFF(oldname), &(oldname->hash_next));
 	}
 	/* change pin's name to 'alias' */
 	rtapi_snprintf(pin->name, sizeof(pin->name), "%s", alias);
@@ -816,33 +888,18 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 	    oldname = SHMPTR(pin->oldname);
 	    rtapi_snprintf(pin->name, sizeof(pin->name), "%s", oldname->name);
 	    pin->oldname = 0;
+	    hash_remove(HASH_BUCKET(hal_data->pin_alias_hash, oldname->name),
+		SHMOFF(oldname), HASH_LINK_OFF(oldname));
 	    free_oldname_struct(oldname);
 	}
     }
-    /* insert pin back into list in proper place */
-    prev = &(hal_data->pin_list_ptr);
-    next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, insert here */
-	    pin->next_ptr = next;
-	    *prev = SHMOFF(pin);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	ptr = SHMPTR(next);
-	cmp = strcmp(ptr->name, pin->name);
-	if (cmp > 0) {
-	    /* found the right place for it, insert here */
-	    pin->next_ptr = next;
-	    *prev = SHMOFF(pin);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(ptr->next_ptr);
-	next = *prev;
-    }
+    /* insert pin back into list in proper place, and into the index */
+    list_insert(&(hal_data->pin_list_ptr), &(hal_data->pin_tree_root),
+	SHMOFF(pin), NAME_OFF(pin));
+    hash_insert(HASH_BUCKET(hal_data->pin_hash, pin->name), SHMOFF(pin),
+	&(pin->hash_next));
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
 }
 
 /***********************************************************************
@@ -851,10 +908,7 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 
 int hal_signal_new(const char *name, hal_type_t type)
 {
-
-    int *prev, next, cmp;
-    hal_sig_t *new, *ptr;
-    void *data_addr;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -876,9 +930,18 @@ int hal_signal_new(const char *name, hal_type_t type)
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: creating signal '%s'\n", name);
     /* get mutex before accessing shared data */
     rtapi_mutex_get(&(hal_data->mutex));
+    retval = halpr_signal_new(name, type);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_signal_new(const char *name, hal_type_t type)
+{
+    hal_sig_t *new;
+    void *data_addr;
+
     /* check for an existing signal with the same name */
     if (halpr_find_sig_by_name(name) != 0) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: duplicate signal '%s'\n", name);
 	return -EINVAL;
@@ -898,7 +961,6 @@ int hal_signal_new(const char *name, hal_type_t type)
 	data_addr = shmalloc_up(sizeof(hal_float_t));
 	break;
     default:
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: illegal signal type %d'\n", type);
 	return -EINVAL;
@@ -908,7 +970,6 @@ int hal_signal_new(const char *name, hal_type_t type)
     new = alloc_sig_struct();
     if ((new == 0) || (data_addr == 0)) {
 	/* alloc failed */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: insufficient memory for signal '%s'\n", name);
 	return -ENOMEM;
@@ -937,30 +998,12 @@ int hal_signal_new(const char *name, hal_type_t type)
     new->writers = 0;
     new->bidirs = 0;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
-    /* search list for 'name' and insert new structure */
-    prev = &(hal_data->sig_list_ptr);
-    next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	ptr = SHMPTR(next);
-	cmp = strcmp(ptr->name, new->name);
-	if (cmp > 0) {
-	    /* found the right place for it, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(ptr->next_ptr);
-	next = *prev;
-    }
+    /* insert new structure in the list and the index */
+    list_insert(&(hal_data->sig_list_ptr), &(hal_data->sig_tree_root),
+	SHMOFF(new), NAME_OFF(new));
+    hash_insert(HASH_BUCKET(hal_data->sig_hash, new->name), SHMOFF(new),
+	&(new->hash_next));
+    return 0;
 }
 
 int hal_signal_delete(const char *name)
@@ -1012,8 +1055,7 @@ int hal_link(const char *pin_name, const char *sig_name)
 {
     hal_pin_t *pin;
     hal_sig_t *sig;
-    hal_comp_t *comp;
-    void **data_ptr_addr, *data_addr;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1058,46 +1100,51 @@ int hal_link(const char *pin_name, const char *sig_name)
 	    "HAL: ERROR: signal '%s' not found\n", sig_name);
 	return -EINVAL;
     }
+    retval = halpr_link(pin, sig);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_link(hal_pin_t * pin, hal_sig_t * sig)
+{
+    hal_comp_t *comp;
+    void **data_ptr_addr, *data_addr;
+
     /* found both pin and signal, are they already connected? */
     if (SHMPTR(pin->signal) == sig) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_WARN,
-	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin_name, sig_name);
+	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin->name, sig->name);
 	return 0;
     }
     /* is the pin connected to something else? */
     if(pin->signal) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	sig = SHMPTR(pin->signal);
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: pin '%s' is linked to '%s', cannot link to '%s'\n",
-	    pin_name, sig->name, sig_name);
+	    pin->name, ((hal_sig_t *) SHMPTR(pin->signal))->name, sig->name);
 	return -EINVAL;
     }
     /* check types */
     if (pin->type != sig->type) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin_name, sig_name);
+	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin->name, sig->name);
 	return -EINVAL;
     }
     /* linking output pin to sig that already has output or I/O pins? */
     if ((pin->dir == HAL_OUT) && ((sig->writers > 0) || (sig->bidirs > 0 ))) {
 	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig_name);
+	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig->name);
 	return -EINVAL;
     }
     /* linking bidir pin to sig that already has output pin? */
     if ((pin->dir == HAL_IO) && (sig->writers > 0)) {
 	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output pin\n", sig_name);
+	    "HAL: ERROR: signal '%s' already has output pin\n", sig->name);
 	return -EINVAL;
     }
     /* everything is OK, make the new link */
+    drop_schedules();
     data_ptr_addr = SHMPTR(pin->data_ptr_addr);
     comp = SHMPTR(pin->owner_ptr);
     data_addr = comp->shmem_base + sig->data_ptr;
@@ -1148,8 +1195,7 @@ int hal_link(const char *pin_name, const char *sig_name)
     }
     /* and update the pin */
     pin->signal = SHMOFF(sig);
-    /* done, release the mutex and return */
-    rtapi_mutex_give(&(hal_data->mutex));
+    reschedule_threads();
     return 0;
 }
 
@@ -1287,8 +1333,7 @@ int hal_param_s32_newf(hal_param_dir_t dir, hal_s32_t * data_addr,
 int hal_param_new(const char *name, hal_type_t type, hal_param_dir_t dir, void *data_addr,
     int comp_id)
 {
-    int *prev, next, cmp;
-    hal_param_t *new, *ptr;
+    hal_param_t *new;
     hal_comp_t *comp;
 
     if (hal_data == 0) {
@@ -1346,6 +1391,13 @@ int hal_param_new(const char *name, hal_type_t type, hal_param_dir_t dir, void *
 	    "HAL: ERROR: param_new called after hal_ready\n");
 	return -EINVAL;
     }
+    /* check for an existing parameter with the same name */
+    if (halpr_find_param_by_name(name) != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: duplicate parameter '%s'\n", name);
+	return -EINVAL;
+    }
     /* allocate a new parameter structure */
     new = alloc_param_struct();
     if (new == 0) {
@@ -1361,38 +1413,13 @@ int hal_param_new(const char *name, hal_type_t type, hal_param_dir_t dir, void *
     new->type = type;
     new->dir = dir;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
-    /* search list for 'name' and insert new structure */
-    prev = &(hal_data->param_list_ptr);
-    next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	ptr = SHMPTR(next);
-	cmp = strcmp(ptr->name, new->name);
-	if (cmp > 0) {
-	    /* found the right place for it, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	if (cmp == 0) {
-	    /* name already in list, can't insert */
-	    free_param_struct(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    rtapi_print_msg(RTAPI_MSG_ERR,
-		"HAL: ERROR: duplicate parameter '%s'\n", name);
-	    return -EINVAL;
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(ptr->next_ptr);
-	next = *prev;
-    }
+    /* insert new structure in the list and the index */
+    list_insert(&(hal_data->param_list_ptr), &(hal_data->param_tree_root),
+	SHMOFF(new), NAME_OFF(new));
+    hash_insert(HASH_BUCKET(hal_data->param_hash, new->name), SHMOFF(new),
+	&(new->hash_next));
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
 }
 
 /* wrapper functs for typed params - these call the generic funct below */
@@ -1495,8 +1522,8 @@ int hal_param_set(const char *name, hal_type_t type, void *value_addr)
 
 int hal_param_alias(const char *param_name, const char *alias)
 {
-    int *prev, next, cmp;
-    hal_param_t *param, *ptr;
+    int *prev, next;
+    hal_param_t *param;
     hal_oldname_t *oldname;
 
     if (hal_data == 0) {
@@ -1541,42 +1568,35 @@ int hal_param_alias(const char *param_name, const char *alias)
 	return -EINVAL;
     }
     free_oldname_struct(oldname);
-    /* find the param and unlink it from pin list */
+    /* find the param */
+    param = halpr_find_param_by_name(param_name);
+    if (param == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: param '%s' not found\n", param_name);
+	return -EINVAL;
+    }
+    /* unlink it from the param list and the index */
     prev = &(hal_data->param_list_ptr);
     next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, not found */
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    rtapi_print_msg(RTAPI_MSG_ERR,
-		"HAL: ERROR: param '%s' not found\n", param_name);
-	    return -EINVAL;
-	}
-	param = SHMPTR(next);
-	if ( strcmp(param->name, param_name) == 0 ) {
-	    /* found it, unlink from list */
-	    *prev = param->next_ptr;
-	    break;
-	}
-	if (param->oldname != 0 ) {
-	    oldname = SHMPTR(param->oldname);
-	    if (strcmp(oldname->name, param_name) == 0) {
-		/* found it, unlink from list */
-		*prev = param->next_ptr;
-		break;
-	    }
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(param->next_ptr);
+    while (next != SHMOFF(param)) {
+	prev = &(((hal_param_t *) SHMPTR(next))->next_ptr);
 	next = *prev;
     }
+    *prev = param->next_ptr;
+    tree_remove(&(hal_data->param_tree_root), SHMOFF(param), NAME_OFF(param));
+    hash_remove(HASH_BUCKET(hal_data->param_hash, param->name),
+	SHMOFF(param), HASH_LINK_OFF(param));
     if ( alias != NULL ) {
 	/* adding a new alias */
 	if ( param->oldname == 0 ) {
 	    /* save old name (only if not already saved) */
 	    oldname = halpr_alloc_oldname_struct();
 	    param->oldname = SHMOFF(oldname);
+	    oldname->owner_ptr = SHMOFF(param);
 	    rtapi_snprintf(oldname->name, sizeof(oldname->name), "%s", param->name);
+	    hash_insert(HASH_BUCKET(hal_data->param_alias_hash, oldname->name),
+		SHMOFF(oldname), &(oldname->hash_next));
 	}
 	/* change param's name to 'alias' */
 	rtapi_snprintf(param->name, sizeof(param->name), "%s", alias);
@@ -1587,33 +1607,18 @@ int hal_param_alias(const char *param_name, const char *alias)
 	    oldname = SHMPTR(param->oldname);
 	    rtapi_snprintf(param->name, sizeof(param->name), "%s", oldname->name);
 	    param->oldname = 0;
+	    hash_remove(HASH_BUCKET(hal_data->param_alias_hash, oldname->name),
+		SHMOFF(oldname), HASH_LINK_OFF(oldname));
 	    free_oldname_struct(oldname);
 	}
     }
-    /* insert param back into list in proper place */
-    prev = &(hal_data->param_list_ptr);
-    next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, insert here */
-	    param->next_ptr = next;
-	    *prev = SHMOFF(param);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	ptr = SHMPTR(next);
-	cmp = strcmp(ptr->name, param->name);
-	if (cmp > 0) {
-	    /* found the right place for it, insert here */
-	    param->next_ptr = next;
-	    *prev = SHMOFF(param);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
-	/* didn't find it yet, look at next one */
-	prev = &(ptr->next_ptr);
-	next = *prev;
-    }
+    /* insert param back into list in proper place, and into the index */
+    list_insert(&(hal_data->param_list_ptr), &(hal_data->param_tree_root),
+	SHMOFF(param), NAME_OFF(param));
+    hash_insert(HASH_BUCKET(hal_data->param_hash, param->name),
+	SHMOFF(param), &(param->hash_next));
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
 }
 
 /***********************************************************************
@@ -1885,6 +1890,7 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
 	    "HAL_LIB: could not start task for thread %s: %d\n", name, retval);
 	return -EINVAL;
     }
+    start_helpers(new);
     /* insert new structure at head of list */
     new->next_ptr = hal_data->thread_list_ptr;
     hal_data->thread_list_ptr = SHMOFF(new);
@@ -1913,6 +1919,19 @@ int hal_create_thread(const char *name, unsigned long period_nsec, int uses_fp)
         return -EINVAL;
     }
     *(new->runtime) = 0;
+
+    /* like tmax, these are for debugging and tuning only, so failing
+       to create them does not fail the thread */
+    rtapi_snprintf(buf, sizeof(buf), "%s.histogram", new->name);
+    hal_param_bit_new(buf, HAL_RW, &(new->hist_enable), new->comp_id);
+    rtapi_snprintf(buf, sizeof(buf), "%s.misses", new->name);
+    hal_param_u32_new(buf, HAL_RW, &(new->misses), new->comp_id);
+    if (new->helpers > 0) {
+	rtapi_snprintf(buf, sizeof(buf), "%s.parallel", new->name);
+	hal_param_bit_new(buf, HAL_RW, &(new->parallel), new->comp_id);
+	rtapi_snprintf(buf, sizeof(buf), "%s.stages", new->name);
+	hal_param_s32_new(buf, HAL_RO, &(new->stages), new->comp_id);
+    }
     hal_ready(new->comp_id);
 
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: thread created\n");
@@ -1974,9 +1993,7 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 {
     hal_thread_t *thread;
     hal_funct_t *funct;
-    hal_list_t *list_root, *list_entry;
-    int n;
-    hal_funct_entry_t *funct_entry;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1995,13 +2012,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	funct_name, thread_name);
     /* get mutex before accessing data structures */
     rtapi_mutex_get(&(hal_data->mutex));
-    /* make sure position is valid */
-    if (position == 0) {
-	/* zero is not allowed */
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: bad position: 0\n");
-	return -EINVAL;
-    }
     /* make sure we were given a function name */
     if (funct_name == 0) {
 	/* no name supplied */
@@ -2025,13 +2035,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: function '%s' not found\n", funct_name);
 	return -EINVAL;
     }
-    /* found the function, is it available? */
-    if ((funct->users > 0) && (funct->reentrant == 0)) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: function '%s' may only be added to one thread\n", funct_name);
-	return -EINVAL;
-    }
     /* search thread list for thread_name */
     thread = halpr_find_thread_by_name(thread_name);
     if (thread == 0) {
@@ -2041,25 +2044,47 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: thread '%s' not found\n", thread_name);
 	return -EINVAL;
     }
-    /* ok, we have thread and function, are they compatible? */
-    if ((funct->uses_fp) && (!thread->uses_fp)) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: function '%s' needs FP\n", funct_name);
-	return -EINVAL;
-    }
-    /* find insertion point */
-    list_root = &(thread->funct_list);
-    list_entry = list_root;
-    n = 0;
-    if (position > 0) {
-	/* insertion is relative to start of list */
+    retval = halpr_add_funct_to_thread(funct, thread, position);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_add_funct_to_thread(hal_funct_t * funct, hal_thread_t * thread,
+    int position)
+{
+    hal_list_t *list_root, *list_entry;
+    int n;
+    hal_funct_entry_t *funct_entry;
+
+    /* make sure position is valid */
+    if (position == 0) {
+	/* zero is not allowed */
+	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: bad position: 0\n");
+	return -EINVAL;
+    }
+    /* found the function, is it available? */
+    if ((funct->users > 0) && (funct->reentrant == 0)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: function '%s' may only be added to one thread\n", funct->name);
+	return -EINVAL;
+    }
+    /* ok, we have thread and function, are they compatible? */
+    if ((funct->uses_fp) && (!thread->uses_fp)) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: function '%s' needs FP\n", funct->name);
+	return -EINVAL;
+    }
+    /* find insertion point */
+    list_root = &(thread->funct_list);
+    list_entry = list_root;
+    n = 0;
+    if (position > 0) {
+	/* insertion is relative to start of list */
 	while (++n < position) {
 	    /* move further into list */
 	    list_entry = list_next(list_entry);
 	    if (list_entry == list_root) {
 		/* reached end of list */
-		rtapi_mutex_give(&(hal_data->mutex));
 		rtapi_print_msg(RTAPI_MSG_ERR,
 		    "HAL: ERROR: position '%d' is too high\n", position);
 		return -EINVAL;
@@ -2072,7 +2097,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    list_entry = list_prev(list_entry);
 	    if (list_entry == list_root) {
 		/* reached end of list */
-		rtapi_mutex_give(&(hal_data->mutex));
 		rtapi_print_msg(RTAPI_MSG_ERR,
 		    "HAL: ERROR: position '%d' is too low\n", position);
 		return -EINVAL;
@@ -2085,7 +2109,6 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     funct_entry = alloc_funct_entry_struct();
     if (funct_entry == 0) {
 	/* alloc failed */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: insufficient memory for thread->function link\n");
 	return -ENOMEM;
@@ -2095,10 +2118,11 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     funct_entry->arg = funct->arg;
     funct_entry->funct = funct->funct;
     /* add the entry to the list */
+    drop_schedules();
     list_add_after((hal_list_t *) funct_entry, list_entry);
     /* update the function usage count */
     funct->users++;
-    rtapi_mutex_give(&(hal_data->mutex));
+    reschedule_threads();
     return 0;
 }
 
@@ -2180,6 +2204,7 @@ int hal_del_funct_from_thread(const char *funct_name, const char *thread_name)
 	funct_entry = (hal_funct_entry_t *) list_entry;
 	if (SHMPTR(funct_entry->funct_ptr) == funct) {
 	    /* this funct entry points to our funct, unlink */
+	    drop_schedules();
 	    list_remove_entry(list_entry);
 	    /* and delete it */
 	    free_funct_entry_struct(funct_entry);
@@ -2209,6 +2234,13 @@ int hal_start_threads(void)
 
 
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: starting threads\n");
+    rtapi_mutex_get(&(hal_data->mutex));
+    if (hal_data->threads_running == 0) {
+	/* lay signal data out in the order the threads will use it */
+	halpr_compact_signals();
+    }
+    halpr_schedule_threads();
+    rtapi_mutex_give(&(hal_data->mutex));
     hal_data->threads_running = 1;
     return 0;
 }
@@ -2237,6 +2269,388 @@ int hal_stop_threads(void)
 *                    PRIVATE FUNCTION CODE                             *
 ************************************************************************/
 
+/* size of the data of a signal of type 'type', as allocated by
+   halpr_signal_new() */
+static long sig_data_size(hal_type_t type)
+{
+    switch (type) {
+    case HAL_BIT:
+	return sizeof(hal_bit_t);
+    case HAL_S32:
+	return sizeof(hal_s32_t);
+    case HAL_U32:
+	return sizeof(hal_u32_t);
+    case HAL_FLOAT:
+	return sizeof(hal_float_t);
+    default:
+	return sizeof(hal_data_u);
+    }
+}
+
+/* gives 'sig' the next slot in 'block', with the same alignment as
+   shmalloc_up(), unless it already has one.  If 'move' is zero, it
+   only checks that the signal is already in that slot. */
+static int place_sig(hal_sig_t * sig, char *block, long *used, int move)
+{
+    long size = sig_data_size(sig->type);
+    long off = (char *) SHMPTR(sig->data_ptr) - block;
+    long slot = *used;
+
+    if (off >= 0 && off < *used) {
+	/* already placed */
+	return 0;
+    }
+    if (size >= 8) {
+	slot = (slot + 7) & (~7);
+    } else if (size >= 4) {
+	slot = (slot + 3) & (~3);
+    }
+    if (!move) {
+	if (off != slot) {
+	    return -1;
+	}
+    } else {
+	memcpy(block + slot, SHMPTR(sig->data_ptr), size);
+	sig->data_ptr = SHMOFF(block + slot);
+    }
+    *used = slot + size;
+    return 0;
+}
+
+/* places every signal in 'block' in the order described at
+   halpr_compact_signals(); returns -1 if 'move' is zero and some
+   signal is not where it would be placed */
+static int place_all_sigs(char *block, long *used, int move)
+{
+    hal_thread_t *thread;
+    hal_list_t *list_root, *list_entry;
+    hal_funct_t *funct;
+    hal_comp_t *comp;
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    int next;
+
+    *used = 0;
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	thread = SHMPTR(next);
+	list_root = &(thread->funct_list);
+	list_entry = list_next(list_root);
+	while (list_entry != list_root) {
+	    funct = SHMPTR(((hal_funct_entry_t *) list_entry)->funct_ptr);
+	    comp = SHMPTR(funct->owner_ptr);
+	    pin = 0;
+	    while ((pin = halpr_find_pin_by_owner(comp, pin)) != 0) {
+		if (pin->signal != 0
+		    && place_sig(SHMPTR(pin->signal), block, used, move) < 0) {
+		    return -1;
+		}
+	    }
+	    list_entry = list_next(list_entry);
+	}
+	next = thread->next_ptr;
+    }
+    /* then everything that no thread uses */
+    next = hal_data->sig_list_ptr;
+    while (next != 0) {
+	sig = SHMPTR(next);
+	if (place_sig(sig, block, used, move) < 0) {
+	    return -1;
+	}
+	next = sig->next_ptr;
+    }
+    return 0;
+}
+
+/* nonzero if pin 'name' belongs to the instance named by the first
+   'scope' characters of 'instance', or 'scope' is 0 */
+static int in_scope(const char *name, const char *instance, int scope)
+{
+    return scope == 0
+	|| (strncmp(name, instance, scope) == 0 && name[scope] == '.');
+}
+
+/* the 'scope' of a function: the length of its whole name if pins of
+   its component are named after it ("and2.0" with "and2.0.in0"), of
+   the part before the last '.' if they are named after that
+   ("pid.0.do-pid-calcs" with "pid.0.command"), else 0 */
+static int funct_scope(hal_funct_t * funct)
+{
+    hal_pin_t *pin;
+    int next, len, dot, n;
+
+    len = strlen(funct->name);
+    dot = 0;
+    for (n = 0; n < len; n++) {
+	if (funct->name[n] == '.') {
+	    dot = n;
+	}
+    }
+    n = 0;
+    next = hal_data->pin_list_ptr;
+    while (next != 0) {
+	pin = SHMPTR(next);
+	/* the function's own '.time' pin says nothing about its scope */
+	if (pin->owner_ptr == funct->owner_ptr
+	    && pin->data_ptr_addr != SHMOFF(&(funct->runtime))) {
+	    if (in_scope(pin->name, funct->name, len)) {
+		return len;
+	    }
+	    if (dot > 0 && in_scope(pin->name, funct->name, dot)) {
+		n = dot;
+	    }
+	}
+	next = pin->next_ptr;
+    }
+    return n;
+}
+
+static void sched_mark(hal_u32_t * mask, int sig)
+{
+    unsigned int h;
+
+    h = ((unsigned int) sig * 2654435761u) >> 24;
+    mask[h >> 5] |= 1u << (h & 31);
+}
+
+static int sched_overlap(const hal_u32_t * a, const hal_u32_t * b)
+{
+    int n;
+
+    for (n = 0; n < HAL_SCHED_WORDS; n++) {
+	if (a[n] & b[n]) {
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+/* nonzero if 'a' and 'b' may not run at the same time */
+static int entries_conflict(hal_funct_entry_t * a, hal_funct_entry_t * b)
+{
+    hal_funct_t *fa, *fb;
+    hal_funct_entry_t *t;
+    int len;
+
+    fa = SHMPTR(a->funct_ptr);
+    fb = SHMPTR(b->funct_ptr);
+    if (fa->owner_ptr == fb->owner_ptr) {
+	/* same component: only different instances are independent */
+	if (a->scope == 0 || b->scope == 0) {
+	    return 1;
+	}
+	if (a->scope > b->scope) {
+	    t = a; a = b; b = t;
+	    fa = SHMPTR(a->funct_ptr);
+	    fb = SHMPTR(b->funct_ptr);
+	}
+	len = a->scope;
+	if (strncmp(fa->name, fb->name, len) == 0
+	    && (b->scope == len || fb->name[len] == '.')) {
+	    return 1;
+	}
+    }
+    return sched_overlap(a->writes, b->reads)
+	|| sched_overlap(a->writes, b->writes)
+	|| sched_overlap(a->reads, b->writes);
+}
+
+static void schedule_thread(hal_thread_t * thread)
+{
+    hal_list_t *root, *l, *m;
+    hal_funct_entry_t *e, *f;
+    hal_funct_t *funct;
+    hal_pin_t *pin;
+    int next, head, *prev, stage, stages, n;
+
+    /* a run that read the old head either sees it dropped, or has
+       set its stage before we look at it and must be let finish */
+    __sync_synchronize();
+    while (thread->sched_stage >= 0) {
+	spin_pause();
+    }
+    root = &(thread->funct_list);
+    /* find the signals each function reads and writes */
+    for (l = list_next(root); l != root; l = list_next(l)) {
+	e = (hal_funct_entry_t *) l;
+	funct = SHMPTR(e->funct_ptr);
+	e->scope = funct_scope(funct);
+	for (n = 0; n < HAL_SCHED_WORDS; n++) {
+	    e->reads[n] = 0;
+	    e->writes[n] = 0;
+	}
+	next = hal_data->pin_list_ptr;
+	while (next != 0) {
+	    pin = SHMPTR(next);
+	    next = pin->next_ptr;
+	    if (pin->signal == 0 || pin->owner_ptr != funct->owner_ptr
+		|| !in_scope(pin->name, funct->name, e->scope)) {
+		continue;
+	    }
+	    if (pin->dir & HAL_IN) {
+		sched_mark(e->reads, pin->signal);
+	    }
+	    if (pin->dir & HAL_OUT) {
+		sched_mark(e->writes, pin->signal);
+	    }
+	}
+    }
+    /* each function runs after the earlier ones it conflicts with */
+    stages = 0;
+    for (l = list_next(root); l != root; l = list_next(l)) {
+	e = (hal_funct_entry_t *) l;
+	e->stage = 0;
+	for (m = list_next(root); m != l; m = list_next(m)) {
+	    f = (hal_funct_entry_t *) m;
+	    if (f->stage >= e->stage && entries_conflict(f, e)) {
+		e->stage = f->stage + 1;
+	    }
+	}
+	if (e->stage >= stages) {
+	    stages = e->stage + 1;
+	}
+    }
+    /* chain them stage by stage, in list order within a stage */
+    head = 0;
+    prev = &head;
+    for (stage = 0; stage < stages; stage++) {
+	for (l = list_next(root); l != root; l = list_next(l)) {
+	    e = (hal_funct_entry_t *) l;
+	    if (e->stage == stage) {
+		*prev = SHMOFF(e);
+		prev = &(e->sched_next);
+	    }
+	}
+    }
+    *prev = 0;
+    thread->stages = stages;
+    __sync_synchronize();
+    thread->sched_head = head;
+}
+
+void halpr_schedule_threads(void)
+{
+    hal_thread_t *thread;
+    int next;
+
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	thread = SHMPTR(next);
+	if (thread->helpers > 0 && thread->sched_head == 0) {
+	    schedule_thread(thread);
+	}
+	next = thread->next_ptr;
+    }
+}
+
+static void drop_schedules(void)
+{
+    hal_thread_t *thread;
+    int next;
+
+    next = hal_data->thread_list_ptr;
+    while (next != 0) {
+	thread = SHMPTR(next);
+	thread->sched_head = 0;
+	/* see schedule_thread() */
+	__sync_synchronize();
+	while (thread->sched_stage >= 0) {
+	    spin_pause();
+	}
+	next = thread->next_ptr;
+    }
+}
+
+static void reschedule_threads(void)
+{
+    if (hal_data->threads_running > 0) {
+	halpr_schedule_threads();
+    }
+}
+
+int halpr_compact_signals(void)
+{
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    hal_comp_t *comp;
+    hal_block_t *b;
+    void **data_ptr_addr;
+    char *block;
+    long size, used;
+    int next;
+
+    /* already compacted, and nothing changed since? */
+    if (hal_data->sig_block_ptr != 0
+	&& place_all_sigs(SHMPTR(hal_data->sig_block_ptr), &used, 0) == 0) {
+	return 0;
+    }
+    /* size the new block, allowing for worst case alignment */
+    size = 0;
+    next = hal_data->sig_list_ptr;
+    while (next != 0) {
+	sig = SHMPTR(next);
+	size += 2 * sig_data_size(sig->type) - 1;
+	next = sig->next_ptr;
+    }
+    if (size == 0) {
+	return 0;
+    }
+    if (size > hal_data->shmem_avail / 2) {
+	rtapi_print_msg(RTAPI_MSG_DBG,
+	    "HAL: not enough free memory to compact signals\n");
+	return -ENOMEM;
+    }
+    /* the block has a header like hal_malloc() blocks, so that it can
+       go on the free lists when it is replaced */
+    size = (size + 7) & (~7);
+    b = block_reuse(size);
+    if (b == 0) {
+	b = shmalloc_up(sizeof(hal_block_t) + size);
+	if (b == 0) {
+	    return -ENOMEM;
+	}
+	b->size = size;
+    }
+    block = (char *) (b + 1);
+    /* copy the values over, then point the pins at them */
+    place_all_sigs(block, &used, 1);
+    next = hal_data->pin_list_ptr;
+    while (next != 0) {
+	pin = SHMPTR(next);
+	if (pin->signal != 0) {
+	    sig = SHMPTR(pin->signal);
+	    comp = SHMPTR(pin->owner_ptr);
+	    data_ptr_addr = SHMPTR(pin->data_ptr_addr);
+	    *data_ptr_addr = comp->shmem_base + sig->data_ptr;
+	}
+	next = pin->next_ptr;
+    }
+    if (hal_data->sig_block_ptr != 0) {
+	/* no signal is left in the old block */
+	block_release((hal_block_t *) SHMPTR(hal_data->sig_block_ptr) - 1);
+    }
+    hal_data->sig_block_ptr = SHMOFF(block);
+    hal_data->sig_generation++;
+    rtapi_print_msg(RTAPI_MSG_DBG,
+	"HAL: compacted signal data into %ld bytes\n", used);
+    return 0;
+}
+
+int halpr_set_insmod_args(hal_comp_t * comp, const char *args)
+{
+    char *cp;
+
+    /* the string belongs to the component, and is recycled with its
+       other memory when it exits */
+    cp = block_alloc(comp, strlen(args) + 1);
+    if (cp == 0) {
+	return -ENOMEM;
+    }
+    strcpy(cp, args);
+    comp->insmod_args = SHMOFF(cp);
+    return 0;
+}
+
 hal_list_t *list_prev(hal_list_t * entry)
 {
     /* this function is only needed because of memory mapping */
@@ -2314,8 +2728,8 @@ hal_comp_t *halpr_find_comp_by_name(const char *name)
     int next;
     hal_comp_t *comp;
 
-    /* search component list for 'name' */
-    next = hal_data->comp_list_ptr;
+    /* search the component index for 'name' */
+    next = *HASH_BUCKET(hal_data->comp_hash, name);
     while (next != 0) {
 	comp = SHMPTR(next);
 	if (strcmp(comp->name, name) == 0) {
@@ -2323,9 +2737,9 @@ hal_comp_t *halpr_find_comp_by_name(const char *name)
 	    return comp;
 	}
 	/* didn't find it yet, look at next one */
-	next = comp->next_ptr;
+	next = comp->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2335,25 +2749,28 @@ hal_pin_t *halpr_find_pin_by_name(const char *name)
     hal_pin_t *pin;
     hal_oldname_t *oldname;
 
-    /* search pin list for 'name' */
-    next = hal_data->pin_list_ptr;
+    /* search the pin index for 'name' */
+    next = *HASH_BUCKET(hal_data->pin_hash, name);
     while (next != 0) {
 	pin = SHMPTR(next);
 	if (strcmp(pin->name, name) == 0) {
 	    /* found a match */
 	    return pin;
 	}
-	if (pin->oldname != 0 ) {
-	    oldname = SHMPTR(pin->oldname);
-	    if (strcmp(oldname->name, name) == 0) {
-		/* found a match */
-		return pin;
-	    }
-	}
 	/* didn't find it yet, look at next one */
-	next = pin->next_ptr;
+	next = pin->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* not found, it might be the original name of an aliased pin */
+    next = *HASH_BUCKET(hal_data->pin_alias_hash, name);
+    while (next != 0) {
+	oldname = SHMPTR(next);
+	if (strcmp(oldname->name, name) == 0) {
+	    /* found a match */
+	    return SHMPTR(oldname->owner_ptr);
+	}
+	next = oldname->hash_next;
+    }
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2362,8 +2779,8 @@ hal_sig_t *halpr_find_sig_by_name(const char *name)
     int next;
     hal_sig_t *sig;
 
-    /* search signal list for 'name' */
-    next = hal_data->sig_list_ptr;
+    /* search the signal index for 'name' */
+    next = *HASH_BUCKET(hal_data->sig_hash, name);
     while (next != 0) {
 	sig = SHMPTR(next);
 	if (strcmp(sig->name, name) == 0) {
@@ -2371,9 +2788,9 @@ hal_sig_t *halpr_find_sig_by_name(const char *name)
 	    return sig;
 	}
 	/* didn't find it yet, look at next one */
-	next = sig->next_ptr;
+	next = sig->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2383,25 +2800,28 @@ hal_param_t *halpr_find_param_by_name(const char *name)
     hal_param_t *param;
     hal_oldname_t *oldname;
 
-    /* search parameter list for 'name' */
-    next = hal_data->param_list_ptr;
+    /* search the parameter index for 'name' */
+    next = *HASH_BUCKET(hal_data->param_hash, name);
     while (next != 0) {
 	param = SHMPTR(next);
 	if (strcmp(param->name, name) == 0) {
 	    /* found a match */
 	    return param;
 	}
-	if (param->oldname != 0 ) {
-	    oldname = SHMPTR(param->oldname);
-	    if (strcmp(oldname->name, name) == 0) {
-		/* found a match */
-		return param;
-	    }
-	}
 	/* didn't find it yet, look at next one */
-	next = param->next_ptr;
+	next = param->hash_next;
     }
-    /* if loop terminates, we reached end of list with no match */
+    /* not found, it might be the original name of an aliased param */
+    next = *HASH_BUCKET(hal_data->param_alias_hash, name);
+    while (next != 0) {
+	oldname = SHMPTR(next);
+	if (strcmp(oldname->name, name) == 0) {
+	    /* found a match */
+	    return SHMPTR(oldname->owner_ptr);
+	}
+	next = oldname->hash_next;
+    }
+    /* if loop terminates, we reached end of bucket with no match */
     return 0;
 }
 
@@ -2645,7 +3065,10 @@ int rtapi_app_main(void)
 	return -EINVAL;
     }
     /* get HAL shared memory block from RTAPI */
-    lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id, HAL_SIZE);
+    if (hal_size < HAL_SIZE) {
+	hal_size = HAL_SIZE;
+    }
+    lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id, hal_size);
     if (lib_mem_id < 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL_LIB: ERROR: could not open shared memory\n");
@@ -2664,7 +3087,7 @@ int rtapi_app_main(void)
     hal_shmem_base = (char *) mem;
     hal_data = (hal_data_t *) mem;
     /* perform a global init if needed */
-    retval = init_hal_data();
+    retval = init_hal_data(hal_size);
     if ( retval ) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL_LIB: ERROR: could not init shared memory\n");
@@ -2713,50 +3136,249 @@ void rtapi_app_exit(void)
 
 /* this is the task function that implements threads in realtime */
 
+static void clear_histograms(hal_thread_t * thread)
+{
+    hal_funct_entry_t *funct_root, *funct_entry;
+    hal_funct_t *funct;
+
+    memset(&(thread->hist), 0, sizeof(hal_hist_t));
+    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
+    funct_entry = SHMPTR(funct_root->links.next);
+    while (funct_entry != funct_root) {
+	funct = SHMPTR(funct_entry->funct_ptr);
+	memset(&(funct->hist), 0, sizeof(hal_hist_t));
+	funct_entry = SHMPTR(funct_entry->links.next);
+    }
+}
+
+/* updates the run time data of the function of 'funct_entry' */
+static void funct_stats(hal_funct_entry_t * funct_entry, long long int cycles,
+    int hist)
+{
+    hal_funct_t *funct;
+
+    /* point to function structure */
+    funct = SHMPTR(funct_entry->funct_ptr);
+    /* update execution time data */
+    *(funct->runtime) = (hal_s32_t) cycles;
+    if ( *(funct->runtime) > funct->maxtime) {
+	funct->maxtime = *(funct->runtime);
+	funct->maxtime_increased = 1;
+    } else {
+	funct->maxtime_increased = 0;
+    }
+    if (hist) {
+	funct->hist.count[hal_hist_bucket(*(funct->runtime))]++;
+    }
+}
+
+/* takes entries of 'stage' of parallel run 'gen' from the thread's
+   schedule and runs them, until there are none left to take */
+static void run_stage(hal_thread_t * thread, int gen, int stage, int hist)
+{
+    hal_funct_entry_t *funct_entry;
+    long long int start_time;
+    int next;
+
+    while (1) {
+	/* announce a possible run before looking, so that the thread
+	   does not finish the stage between the two */
+	__sync_fetch_and_add(&(thread->sched_busy), 1);
+	/* a helper late from the last run must not take entries of a
+	   later stage of this one */
+	if (thread->sched_gen != gen) {
+	    break;
+	}
+	next = thread->sched_pending;
+	if (next == 0) {
+	    break;
+	}
+	funct_entry = SHMPTR(next);
+	if (funct_entry->stage != stage) {
+	    break;
+	}
+	if (__sync_bool_compare_and_swap(&(thread->sched_pending), next,
+		funct_entry->sched_next)) {
+	    start_time = rtapi_get_clocks();
+	    funct_entry->funct(funct_entry->arg, thread->period);
+	    funct_stats(funct_entry, rtapi_get_clocks() - start_time, hist);
+	}
+	__sync_fetch_and_sub(&(thread->sched_busy), 1);
+    }
+    __sync_fetch_and_sub(&(thread->sched_busy), 1);
+}
+
+/* runs the functions of a thread stage by stage, with its helpers.
+   Returns 0, having run nothing, if the schedule was dropped. */
+static int run_parallel(hal_thread_t * thread, int head, int hist)
+{
+    int gen, stage;
+
+    /* claim the schedule, see schedule_thread() */
+    thread->sched_stage = 0;
+    __sync_synchronize();
+    if (thread->sched_head != head) {
+	thread->sched_stage = -1;
+	return 0;
+    }
+    thread->sched_pending = head;
+    /* full barrier, the helpers may start now */
+    gen = __sync_add_and_fetch(&(thread->sched_gen), 1);
+    for (stage = 0; thread->sched_pending != 0; stage++) {
+	if (stage > 0) {
+	    __sync_synchronize();
+	    thread->sched_stage = stage;
+	}
+	run_stage(thread, gen, stage, hist);
+	/* wait for helpers that are still running entries of the stage */
+	while (thread->sched_busy != 0) {
+	    spin_pause();
+	}
+    }
+    thread->sched_stage = -1;
+    __sync_synchronize();
+    return 1;
+}
+
 static void thread_task(void *arg)
 {
     hal_thread_t *thread;
-    hal_funct_t *funct;
     hal_funct_entry_t *funct_root, *funct_entry;
     long long int start_time, end_time;
-    long long int thread_start_time;
+    long long int thread_start_time, start_ns, end_ns;
+    int hist, head;
 
     thread = arg;
     while (1) {
+	/* The period starts one period after the last one did.  A task
+	   can't wake up before its period starts, so an earlier wakeup
+	   means the estimate was late; starting from the first wakeup,
+	   the estimate never runs ahead of the real schedule. */
+	start_ns = rtapi_get_time();
+	if (thread->release == 0 || start_ns < thread->release) {
+	    thread->release = start_ns;
+	}
 	if (hal_data->threads_running > 0) {
 	    /* point at first function on function list */
 	    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
 	    funct_entry = SHMPTR(funct_root->links.next);
+	    /* start histograms from scratch each time they are enabled */
+	    hist = thread->hist_enable;
+	    if (hist && !thread->hist_active) {
+		clear_histograms(thread);
+	    }
+	    thread->hist_active = hist;
 	    /* execution time logging */
 	    start_time = rtapi_get_clocks();
 	    end_time = start_time;
 	    thread_start_time = start_time;
-	    /* run thru function list */
-	    while (funct_entry != funct_root) {
-		/* call the function */
-		funct_entry->funct(funct_entry->arg, thread->period);
-		/* capture execution time */
+	    head = thread->sched_head;
+	    if (thread->parallel && thread->helpers > 0 && head != 0
+		&& run_parallel(thread, head, hist)) {
 		end_time = rtapi_get_clocks();
-		/* point to function structure */
-		funct = SHMPTR(funct_entry->funct_ptr);
-		/* update execution time data */
-		*(funct->runtime) = (hal_s32_t)(end_time - start_time);
-		if ( *(funct->runtime) > funct->maxtime) {
-		    funct->maxtime = *(funct->runtime);
-		    funct->maxtime_increased = 1;
-		} else {
-		    funct->maxtime_increased = 0;
+	    } else {
+		/* run thru function list */
+		while (funct_entry != funct_root) {
+		    /* call the function */
+		    funct_entry->funct(funct_entry->arg, thread->period);
+		    /* capture execution time */
+		    end_time = rtapi_get_clocks();
+		    funct_stats(funct_entry, end_time - start_time, hist);
+		    /* point to next next entry in list */
+		    funct_entry = SHMPTR(funct_entry->links.next);
+		    /* prepare to measure time for next funct */
+		    start_time = end_time;
 		}
-		/* point to next next entry in list */
-		funct_entry = SHMPTR(funct_entry->links.next);
-		/* prepare to measure time for next funct */
-		start_time = end_time;
 	    }
 	    /* update thread execution time */
 	    *(thread->runtime) = (hal_s32_t)(end_time - thread_start_time);
 	    if ( *(thread->runtime) > thread->maxtime) {
 	        thread->maxtime = *(thread->runtime);
 	    }
+	    if (hist) {
+		thread->hist.count[hal_hist_bucket(*(thread->runtime))]++;
+	    }
+	    /* The deadline is the start of the next period.  Waking up
+	       late counts as well as running long, and every deadline
+	       that passed counts, also those of periods the RTOS skipped
+	       or that have to catch up with this one. */
+	    end_ns = rtapi_get_time();
+	    while (end_ns - thread->release > thread->period) {
+		thread->misses++;
+		thread->last_miss = end_ns;
+		thread->release += thread->period;
+	    }
+	}
+	/* wait until next period */
+	thread->release += thread->period;
+	rtapi_wait();
+    }
+}
+
+/* creates and starts the helper tasks of a new thread, one on each
+   processor in 'parallel_cpus', waking up with the thread.  Without
+   helpers, or if the RTOS can't pin them, the 'parallel' param is not
+   created and the thread runs its functions in order. */
+static void start_helpers(hal_thread_t * thread)
+{
+    int n, retval, task_id;
+
+    for (n = 0; n < HAL_MAX_HELPERS && parallel_cpus[n] >= 0; n++) {
+	task_id = rtapi_task_new(helper_task, thread, thread->priority,
+	    lib_module_id, HAL_STACKSIZE, thread->uses_fp);
+	if (task_id < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL_LIB: could not create helper for thread %s\n",
+		thread->name);
+	    return;
+	}
+	retval = rtapi_task_set_cpu(task_id, parallel_cpus[n]);
+	if (retval == 0) {
+	    /* wake up at the same times as the thread */
+	    retval = rtapi_task_follow(task_id, thread->task_id);
+	}
+	if (retval == 0) {
+	    retval = rtapi_task_start(task_id, thread->period);
+	}
+	if (retval < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL_LIB: could not start helper for thread %s on cpu %d: %d\n",
+		thread->name, parallel_cpus[n], retval);
+	    rtapi_task_delete(task_id);
+	    return;
+	}
+	thread->helper_task_id[thread->helpers++] = task_id;
+    }
+}
+
+/* this is the task function of the helpers of a parallel thread.  It
+   wakes with the thread each period, waits up to half a period for
+   the thread to start, then takes entries until the thread is done. */
+static void helper_task(void *arg)
+{
+    hal_thread_t *thread;
+    long long int wake_ns;
+    int gen, last_gen, stage;
+
+    thread = arg;
+    last_gen = thread->sched_gen;
+    while (1) {
+	if (hal_data->threads_running > 0 && thread->parallel) {
+	    wake_ns = rtapi_get_time();
+	    while ((gen = thread->sched_gen) == last_gen) {
+		if (rtapi_get_time() - wake_ns > thread->period / 2) {
+		    break;
+		}
+		spin_pause();
+	    }
+	    if (gen != last_gen) {
+		last_gen = gen;
+		while ((stage = thread->sched_stage) >= 0
+		    && thread->sched_gen == gen) {
+		    run_stage(thread, gen, stage, thread->hist_active);
+		    spin_pause();
+		}
+	    }
 	}
 	/* wait until next period */
 	rtapi_wait();
@@ -2768,7 +3390,7 @@ static void thread_task(void *arg)
    a description of what they do.
 */
 
-static int init_hal_data(void)
+static int init_hal_data(long size)
 {
     /* has the block already been initialized? */
     if (hal_data->version != 0) {
@@ -2789,6 +3411,8 @@ static int init_hal_data(void)
     hal_data->comp_list_ptr = 0;
     hal_data->pin_list_ptr = 0;
     hal_data->sig_list_ptr = 0;
+    hal_data->sig_block_ptr = 0;
+    hal_data->sig_generation = 0;
     hal_data->param_list_ptr = 0;
     hal_data->funct_list_ptr = 0;
     hal_data->thread_list_ptr = 0;
@@ -2807,8 +3431,20 @@ static int init_hal_data(void)
     hal_data->exact_base_period = 0;
     /* set up for shmalloc_xx() */
     hal_data->shmem_bot = sizeof(hal_data_t);
-    hal_data->shmem_top = HAL_SIZE;
+    hal_data->shmem_size = size;
+    hal_data->shmem_top = size;
     hal_data->lock = HAL_LOCK_NONE;
+    /* empty name indexes */
+    hal_data->pin_tree_root = 0;
+    hal_data->sig_tree_root = 0;
+    hal_data->param_tree_root = 0;
+    memset(hal_data->comp_hash, 0, sizeof(hal_data->comp_hash));
+    memset(hal_data->pin_hash, 0, sizeof(hal_data->pin_hash));
+    memset(hal_data->sig_hash, 0, sizeof(hal_data->sig_hash));
+    memset(hal_data->param_hash, 0, sizeof(hal_data->param_hash));
+    memset(hal_data->pin_alias_hash, 0, sizeof(hal_data->pin_alias_hash));
+    memset(hal_data->param_alias_hash, 0, sizeof(hal_data->param_alias_hash));
+    memset(hal_data->malloc_free, 0, sizeof(hal_data->malloc_free));
     /* done, release mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     return 0;
@@ -2843,6 +3479,140 @@ static void *shmalloc_up(long int size)
     return retval;
 }
 
+static hal_comp_t *malloc_owner(void)
+{
+    hal_comp_t *comp, *owner = 0;
+    int next;
+
+    next = hal_data->comp_list_ptr;
+    while (next != 0) {
+	comp = SHMPTR(next);
+#ifdef RTAPI
+	if (!comp->ready && comp->type == 1) {
+#else /* ULAPI */
+	if (!comp->ready && comp->type == 0 && comp->pid == getpid()) {
+#endif
+	    if (owner != 0) {
+		/* more than one, can't tell which */
+		return 0;
+	    }
+	    owner = comp;
+	}
+	next = comp->next_ptr;
+    }
+    return owner;
+}
+
+/* size class of a block: blocks of class 'n' hold at least 8 << n bytes */
+static int block_class(long int size)
+{
+    int n = 0;
+
+    while (size >= 16 && n < HAL_MALLOC_CLASSES - 1) {
+	size >>= 1;
+	n++;
+    }
+    return n;
+}
+
+/* takes a block of at least 'size' bytes from the free lists */
+static hal_block_t *block_reuse(long int size)
+{
+    hal_block_t *b, *rest;
+    int n, *prev;
+
+    for (n = block_class(size); n < HAL_MALLOC_CLASSES; n++) {
+	/* blocks in the first class may be too small, later ones are not */
+	prev = &(hal_data->malloc_free[n]);
+	while (*prev != 0) {
+	    b = SHMPTR(*prev);
+	    if (b->size >= size) {
+		*prev = b->next_ptr;
+		/* give back a large enough remainder */
+		if (b->size - size >= (long) sizeof(hal_block_t) + 64) {
+		    rest = (hal_block_t *) ((char *) (b + 1) + size);
+		    rest->size = b->size - size - sizeof(hal_block_t);
+		    b->size = size;
+		    rest->next_ptr = hal_data->malloc_free[block_class(rest->size)];
+		    hal_data->malloc_free[block_class(rest->size)] = SHMOFF(rest);
+		}
+		return b;
+	    }
+	    prev = &(b->next_ptr);
+	}
+    }
+    return 0;
+}
+
+static void *block_alloc(hal_comp_t * owner, long int size)
+{
+    hal_block_t *b;
+
+    /* keep blocks (and the headers that follow them) 8 byte aligned */
+    size = (size + 7) & (~7);
+    b = block_reuse(size);
+    if (b != 0) {
+	/* fresh shmem is zeroed, and some components count on that */
+	memset(b + 1, 0, b->size);
+    } else {
+	b = shmalloc_up(sizeof(hal_block_t) + size);
+	if (b == 0) {
+	    return 0;
+	}
+	b->size = size;
+    }
+    b->next_ptr = owner->mem_ptr;
+    owner->mem_ptr = SHMOFF(b);
+    return b + 1;
+}
+
+/* unlinks the free block that ends at the bottom of free shmem, if any */
+static hal_block_t *block_below_free_shmem(void)
+{
+    hal_block_t *b;
+    int n, *prev;
+
+    for (n = 0; n < HAL_MALLOC_CLASSES; n++) {
+	prev = &(hal_data->malloc_free[n]);
+	while (*prev != 0) {
+	    b = SHMPTR(*prev);
+	    if (SHMOFF((char *) (b + 1) + b->size) == hal_data->shmem_bot) {
+		*prev = b->next_ptr;
+		return b;
+	    }
+	    prev = &(b->next_ptr);
+	}
+    }
+    return 0;
+}
+
+static void block_release(hal_block_t * b)
+{
+    int n;
+
+    n = block_class(b->size);
+    b->next_ptr = hal_data->malloc_free[n];
+    hal_data->malloc_free[n] = SHMOFF(b);
+    /* blocks at the end of the used area go back to the free area,
+       which is expected to be zeroed */
+    while ((b = block_below_free_shmem()) != 0) {
+	hal_data->shmem_bot = SHMOFF(b);
+	memset(b, 0, sizeof(hal_block_t) + b->size);
+	hal_data->shmem_avail = hal_data->shmem_top - hal_data->shmem_bot;
+    }
+}
+
+static void free_blocks(hal_comp_t * comp)
+{
+    hal_block_t *b;
+
+    while (comp->mem_ptr != 0) {
+	b = SHMPTR(comp->mem_ptr);
+	comp->mem_ptr = b->next_ptr;
+	block_release(b);
+    }
+}
+
 static void *shmalloc_dn(long int size)
 {
     long int tmp_top;
@@ -2891,10 +3661,12 @@ hal_comp_t *halpr_alloc_comp_struct(void)
     if (p) {
 	/* make sure it's empty */
 	p->next_ptr = 0;
+	p->hash_next = 0;
 	p->comp_id = 0;
 	p->mem_id = 0;
 	p->type = 0;
 	p->shmem_base = 0;
+	p->mem_ptr = 0;
 	p->name[0] = '\0';
     }
     return p;
@@ -2918,6 +3690,9 @@ static hal_pin_t *alloc_pin_struct(void)
     if (p) {
 	/* make sure it's empty */
 	p->next_ptr = 0;
+	p->hash_next = 0;
+	p->tree_left = 0;
+	p->tree_right = 0;
 	p->data_ptr_addr = 0;
 	p->owner_ptr = 0;
 	p->type = 0;
@@ -2947,6 +3722,9 @@ static hal_sig_t *alloc_sig_struct(void)
     if (p) {
 	/* make sure it's empty */
 	p->next_ptr = 0;
+	p->hash_next = 0;
+	p->tree_left = 0;
+	p->tree_right = 0;
 	p->data_ptr = 0;
 	p->type = 0;
 	p->readers = 0;
@@ -2975,6 +3753,9 @@ static hal_param_t *alloc_param_struct(void)
     if (p) {
 	/* make sure it's empty */
 	p->next_ptr = 0;
+	p->hash_next = 0;
+	p->tree_left = 0;
+	p->tree_right = 0;
 	p->data_ptr = 0;
 	p->owner_ptr = 0;
 	p->type = 0;
@@ -3001,6 +3782,8 @@ static hal_oldname_t *halpr_alloc_oldname_struct(void)
     if (p) {
 	/* make sure it's empty */
 	p->next_ptr = 0;
+	p->hash_next = 0;
+	p->owner_ptr = 0;
 	p->name[0] = '\0';
     }
     return p;
@@ -3031,6 +3814,7 @@ static hal_funct_t *alloc_funct_struct(void)
 	p->users = 0;
 	p->arg = 0;
 	p->funct = 0;
+	memset(&(p->hist), 0, sizeof(hal_hist_t));
 	p->name[0] = '\0';
     }
     return p;
@@ -3060,6 +3844,8 @@ static hal_funct_entry_t *alloc_funct_entry_struct(void)
 	p->funct_ptr = 0;
 	p->arg = 0;
 	p->funct = 0;
+	p->sched_next = 0;
+	p->stage = 0;
     }
     return p;
 }
@@ -3087,6 +3873,20 @@ static hal_thread_t *alloc_thread_struct(void)
 	p->period = 0;
 	p->priority = 0;
 	p->task_id = 0;
+	p->hist_enable = 0;
+	p->hist_active = 0;
+	p->misses = 0;
+	p->last_miss = 0;
+	p->release = 0;
+	memset(&(p->hist), 0, sizeof(hal_hist_t));
+	p->parallel = 0;
+	p->stages = 0;
+	p->helpers = 0;
+	p->sched_head = 0;
+	p->sched_pending = 0;
+	p->sched_stage = -1;
+	p->sched_busy = 0;
+	p->sched_gen = 0;
 	list_init_entry(&(p->funct_list));
 	p->name[0] = '\0';
     }
@@ -3094,6 +3894,160 @@ static hal_thread_t *alloc_thread_struct(void)
 }
 #endif /* RTAPI */
 
+/* FNV-1a, it is cheap and spreads the long, similar names typical
+   of HAL ("hm2_5i25.0.gpio.012.in") well over the buckets. */
+static unsigned int hash_name(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*name != '\0') {
+	hash ^= (unsigned char) *name++;
+	hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void hash_insert(int *bucket, int ptr, int *hash_next)
+{
+    *hash_next = *bucket;
+    *bucket = ptr;
+}
+
+static void hash_remove(int *bucket, int ptr, long link_off)
+{
+    int *link;
+
+    link = bucket;
+    while (*link != 0) {
+	if (*link == ptr) {
+	    /* found it, unlink from the chain */
+	    *link = *(int *) (hal_shmem_base + ptr + link_off);
+	    *(int *) (hal_shmem_base + ptr + link_off) = 0;
+	    return;
+	}
+	link = (int *) (hal_shmem_base + *link + link_off);
+    }
+}
+
+#define LINKS(ptr) ((hal_links_t *) (hal_shmem_base + (ptr)))
+#define NAME(ptr, name_off) (hal_shmem_base + (ptr) + (name_off))
+
+/* treap priority, a hash of the object's offset in shmem */
+static unsigned int tree_prio(int ptr)
+{
+    unsigned int x = (unsigned int) ptr;
+
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static void tree_rotate_right(int *link)
+{
+    int top = *link;
+    int left = LINKS(top)->tree_left;
+
+    LINKS(top)->tree_left = LINKS(left)->tree_right;
+    LINKS(left)->tree_right = top;
+    *link = left;
+}
+
+static void tree_rotate_left(int *link)
+{
+    int top = *link;
+    int right = LINKS(top)->tree_right;
+
+    LINKS(top)->tree_right = LINKS(right)->tree_left;
+    LINKS(right)->tree_left = top;
+    *link = right;
+}
+
+static void tree_insert(int *link, int ptr, long name_off)
+{
+    hal_links_t *node;
+
+    if (*link == 0) {
+	*link = ptr;
+	return;
+    }
+    node = LINKS(*link);
+    if (strcmp(NAME(ptr, name_off), NAME(*link, name_off)) < 0) {
+	tree_insert(&(node->tree_left), ptr, name_off);
+	if (tree_prio(node->tree_left) > tree_prio(*link)) {
+	    tree_rotate_right(link);
+	}
+    } else {
+	tree_insert(&(node->tree_right), ptr, name_off);
+	if (tree_prio(node->tree_right) > tree_prio(*link)) {
+	    tree_rotate_left(link);
+	}
+    }
+}
+
+static void tree_remove(int *root, int ptr, long name_off)
+{
+    int *link;
+    hal_links_t *node;
+
+    /* find the link that points to 'ptr' */
+    link = root;
+    while (*link != 0 && *link != ptr) {
+	if (strcmp(NAME(ptr, name_off), NAME(*link, name_off)) < 0) {
+	    link = &(LINKS(*link)->tree_left);
+	} else {
+	    link = &(LINKS(*link)->tree_right);
+	}
+    }
+    if (*link == 0) {
+	/* not in the tree */
+	return;
+    }
+    /* rotate it down until it is a leaf, then cut it off */
+    node = LINKS(ptr);
+    while (node->tree_left != 0 || node->tree_right != 0) {
+	if (node->tree_right == 0 || (node->tree_left != 0 &&
+		tree_prio(node->tree_left) > tree_prio(node->tree_right))) {
+	    tree_rotate_right(link);
+	    link = &(LINKS(*link)->tree_right);
+	} else {
+	    tree_rotate_left(link);
+	    link = &(LINKS(*link)->tree_left);
+	}
+    }
+    *link = 0;
+}
+
+static void list_insert(int *list, int *root, int ptr, long name_off)
+{
+    int next, prev;
+
+    /* the list predecessor is the last node where the search went right */
+    prev = 0;
+    next = *root;
+    while (next != 0) {
+	if (strcmp(NAME(ptr, name_off), NAME(next, name_off)) < 0) {
+	    next = LINKS(next)->tree_left;
+	} else {
+	    prev = next;
+	    next = LINKS(next)->tree_right;
+	}
+    }
+    if (prev == 0) {
+	/* goes at the head of the list */
+	LINKS(ptr)->next_ptr = *list;
+	*list = ptr;
+    } else {
+	LINKS(ptr)->next_ptr = LINKS(prev)->next_ptr;
+	LINKS(prev)->next_ptr = ptr;
+    }
+    LINKS(ptr)->tree_left = 0;
+    LINKS(ptr)->tree_right = 0;
+    tree_insert(root, ptr, name_off);
+}
+
 static void free_comp_struct(hal_comp_t * comp)
 {
     int *prev, next;
@@ -3155,7 +4109,11 @@ static void free_comp_struct(hal_comp_t * comp)
 	}
 	next = *prev;
     }
+    /* nothing refers to its memory any more */
+    free_blocks(comp);
     /* now we can delete the component itself */
+    hash_remove(HASH_BUCKET(hal_data->comp_hash, comp->name), SHMOFF(comp),
+	HASH_LINK_OFF(comp));
     /* clear contents of struct */
     comp->comp_id = 0;
     comp->mem_id = 0;
@@ -3177,6 +4135,7 @@ static void unlink_pin(hal_pin_t * pin)
     /* is this pin linked to a signal? */
     if (pin->signal != 0) {
 	/* yes, need to unlink it */
+	drop_schedules();
 	sig = SHMPTR(pin->signal);
 	/* make pin's 'data_ptr' point to its dummy signal */
 	data_ptr_addr = SHMPTR(pin->data_ptr_addr);
@@ -3219,15 +4178,27 @@ static void unlink_pin(hal_pin_t * pin)
 	}
 	/* mark pin as unlinked */
 	pin->signal = 0;
+	reschedule_threads();
     }
 }
 
 static void free_pin_struct(hal_pin_t * pin)
 {
+    hal_oldname_t *oldname;
 
     unlink_pin(pin);
+    /* remove it from the name index */
+    hash_remove(HASH_BUCKET(hal_data->pin_hash, pin->name), SHMOFF(pin),
+	HASH_LINK_OFF(pin));
+    tree_remove(&(hal_data->pin_tree_root), SHMOFF(pin), NAME_OFF(pin));
     /* clear contents of struct */
-    if ( pin->oldname != 0 ) free_oldname_struct(SHMPTR(pin->oldname));
+    if ( pin->oldname != 0 ) {
+	oldname = SHMPTR(pin->oldname);
+	hash_remove(HASH_BUCKET(hal_data->pin_alias_hash, oldname->name),
+	    SHMOFF(oldname), HASH_LINK_OFF(oldname));
+	free_oldname_struct(oldname);
+	pin->oldname = 0;
+    }
     pin->data_ptr_addr = 0;
     pin->owner_ptr = 0;
     pin->type = 0;
@@ -3252,6 +4223,10 @@ static void free_sig_struct(hal_sig_t * sig)
 	/* check for another pin linked to the signal */
 	pin = halpr_find_pin_by_sig(sig, pin);
     }
+    /* remove it from the name index */
+    hash_remove(HASH_BUCKET(hal_data->sig_hash, sig->name), SHMOFF(sig),
+	HASH_LINK_OFF(sig));
+    tree_remove(&(hal_data->sig_tree_root), SHMOFF(sig), NAME_OFF(sig));
     /* clear contents of struct */
     sig->data_ptr = 0;
     sig->type = 0;
@@ -3266,8 +4241,20 @@ static void free_sig_struct(hal_sig_t * sig)
 
 static void free_param_struct(hal_param_t * p)
 {
+    hal_oldname_t *oldname;
+
+    /* remove it from the name index */
+    hash_remove(HASH_BUCKET(hal_data->param_hash, p->name), SHMOFF(p),
+	HASH_LINK_OFF(p));
+    tree_remove(&(hal_data->param_tree_root), SHMOFF(p), NAME_OFF(p));
     /* clear contents of struct */
-    if ( p->oldname != 0 ) free_oldname_struct(SHMPTR(p->oldname));
+    if ( p->oldname != 0 ) {
+	oldname = SHMPTR(p->oldname);
+	hash_remove(HASH_BUCKET(hal_data->param_alias_hash, oldname->name),
+	    SHMOFF(oldname), HASH_LINK_OFF(oldname));
+	free_oldname_struct(oldname);
+	p->oldname = 0;
+    }
     p->data_ptr = 0;
     p->owner_ptr = 0;
     p->type = 0;
@@ -3280,6 +4267,8 @@ static void free_param_struct(hal_param_t * p)
 static void free_oldname_struct(hal_oldname_t * oldname)
 {
     /* clear contents of struct */
+    oldname->hash_next = 0;
+    oldname->owner_ptr = 0;
     oldname->name[0] = '\0';
     /* add it to free list */
     oldname->next_ptr = hal_data->oldname_free_ptr;
@@ -3316,6 +4305,7 @@ static void free_funct_struct(hal_funct_t * funct)
 		/* test it */
 		if (SHMPTR(funct_entry->funct_ptr) == funct) {
 		    /* this funct entry points to our funct, unlink */
+		    drop_schedules();
 		    list_entry = list_remove_entry(list_entry);
 		    /* and delete it */
 		    free_funct_entry_struct(funct_entry);
@@ -3347,6 +4337,7 @@ static void free_funct_entry_struct(hal_funct_entry_t * funct_entry)
 {
     hal_funct_t *funct;
 
+    drop_schedules();
     if (funct_entry->funct_ptr > 0) {
 	/* entry points to a function, update the function struct */
 	funct = SHMPTR(funct_entry->funct_ptr);
@@ -3358,6 +4349,7 @@ static void free_funct_entry_struct(hal_funct_entry_t * funct_entry)
     funct_entry->funct = 0;
     /* add it to free list */
     list_add_after((hal_list_t *) funct_entry, &(hal_data->funct_entry_free));
+    reschedule_threads();
 }
 
 #ifdef RTAPI
@@ -3377,6 +4369,15 @@ static void free_thread_struct(hal_thread_t * thread)
     /* and stop the task associated with this thread */
     rtapi_task_pause(thread->task_id);
     rtapi_task_delete(thread->task_id);
+    /* and its helpers */
+    while (thread->helpers > 0) {
+	thread->helpers--;
+	rtapi_task_pause(thread->helper_task_id[thread->helpers]);
+	rtapi_task_delete(thread->helper_task_id[thread->helpers]);
+    }
+    thread->parallel = 0;
+    thread->sched_head = 0;
+    thread->sched_stage = -1;
     /* clear contents of struct */
     thread->uses_fp = 0;
     thread->period = 0;
@@ -3540,7 +4541,7 @@ int hal_stream_depth(hal_stream_t *stream) {
     int out = stream->fifo->out;
     int in = stream->fifo->in;
     int result = in - out;
-    if(result < 0) result += stream->fifo->depth - 1;
+    if(result < 0) result += stream->fifo->depth;
     return result;
 }
 
@@ -3617,6 +4618,53 @@ int hal_stream_read(hal_stream_t *stream, union hal_stream_data *buf, unsigned *
     return 0;
 }
 
+int hal_stream_read_many(hal_stream_t *stream, union hal_stream_data *buf, int count) {
+    int out = hal_stream_atomic_load_out(stream),
+        in = hal_stream_atomic_load_in(stream);
+    int depth = stream->fifo->depth;
+    int stride = stream->fifo->num_pins + 1;
+    int avail = in - out, n, done = 0;
+    if(avail < 0) avail += depth;
+    if(count > avail) count = avail;
+    /* at most two copies, before and after the wrap */
+    while(done < count) {
+        n = count - done;
+        if(n > depth - out) n = depth - out;
+        memcpy(buf + done * stride, &stream->fifo->data[out * stride],
+            sizeof(union hal_stream_data) * stride * n);
+        done += n;
+        out += n;
+        if(out >= depth) out = 0;
+    }
+    if(count) hal_stream_atomic_store_out(stream, out);
+    return count;
+}
+
+int hal_stream_write_many(hal_stream_t *stream, union hal_stream_data *buf, int count) {
+    int in = hal_stream_atomic_load_in(stream),
+        out = hal_stream_atomic_load_out(stream);
+    int depth = stream->fifo->depth;
+    int num_pins = stream->fifo->num_pins;
+    int stride = num_pins + 1;
+    int room = out - in - 1, n, i, done = 0;
+    if(room < 0) room += depth;
+    if(count > room) count = room;
+    while(done < count) {
+        n = count - done;
+        if(n > depth - in) n = depth - in;
+        union hal_stream_data *dptr = &stream->fifo->data[in * stride];
+        memcpy(dptr, buf + done * stride,
+            sizeof(union hal_stream_data) * stride * n);
+        for(i = 0; i < n; i++)
+            dptr[i * stride + num_pins].s = ++stream->fifo->this_sample;
+        done += n;
+        in += n;
+        if(in >= depth) in = 0;
+    }
+    if(count) hal_stream_atomic_store_in(stream, in);
+    return count;
+}
+
 int hal_stream_attach(hal_stream_t *stream, int comp_id, int key, const char *typestring) {
     int i;
 
@@ -3760,6 +4808,7 @@ EXPORT_SYMBOL(hal_start_threads);
 EXPORT_SYMBOL(hal_stop_threads);
 
 EXPORT_SYMBOL(hal_shmem_base);
+EXPORT_SYMBOL(hal_data);
 EXPORT_SYMBOL(halpr_find_comp_by_name);
 EXPORT_SYMBOL(halpr_find_pin_by_name);
 EXPORT_SYMBOL(halpr_find_sig_by_name);
@@ -3773,6 +4822,7 @@ EXPORT_SYMBOL(halpr_find_param_by_owner);
 EXPORT_SYMBOL(halpr_find_funct_by_owner);
 
 EXPORT_SYMBOL(halpr_find_pin_by_sig);
+EXPORT_SYMBOL(halpr_set_insmod_args);
 
 EXPORT_SYMBOL(hal_pin_alias);
 EXPORT_SYMBOL(hal_param_alias);
@@ -3784,6 +4834,8 @@ EXPORT_SYMBOL_GPL(hal_stream_depth);
 EXPORT_SYMBOL_GPL(hal_stream_maxdepth);
 EXPORT_SYMBOL_GPL(hal_stream_write);
 EXPORT_SYMBOL_GPL(hal_stream_read);
+EXPORT_SYMBOL_GPL(hal_stream_write_many);
+EXPORT_SYMBOL_GPL(hal_stream_read_many);
 EXPORT_SYMBOL_GPL(hal_stream_attach);
 EXPORT_SYMBOL_GPL(hal_stream_detach);
 EXPORT_SYMBOL_GPL(hal_stream_element_count);
@@ -108,7 +108,7 @@ RTAPI_BEGIN_DECLS
 /* offset 0 is reserved for a null-ish pointer, so SHMCHK(hal_shmem_base) is
    false by design */
 #define SHMCHK(ptr)  ( ((char *)(ptr)) > (hal_shmem_base) && \
-                       ((char *)(ptr)) < (hal_shmem_base + HAL_SIZE) )
+                       ((char *)(ptr)) < (hal_shmem_base + hal_data->shmem_size) )
 
 /** The good news is that none of this linked list complexity is
     visible to the components that use this API.  Complexity here
@@ -151,9 +151,42 @@ typedef struct {
 */
 typedef struct {
     int next_ptr;		/* next struct (used for free list only) */
+    int hash_next;		/* next oldname in alias hash bucket */
+    int owner_ptr;		/* pin or param that carries this name */
     char name[HAL_NAME_LEN + 1];	/* the original name */
 } hal_oldname_t;
 
+/* Name lookups (halpr_find_xxx_by_name) go through hash tables in
+   the master data structure instead of walking the sorted lists.
+   Each table is an array of bucket heads (shmem offsets, 0 = empty),
+   and objects are chained through their 'hash_next' field.  Aliased
+   pins and params are indexed under their current name, and their
+   'oldname' struct is indexed separately in the alias tables.  The
+   sizes must be powers of two.
+   The pin, signal and param lists are also threaded by a search tree
+   (a treap, linked through 'tree_left' and 'tree_right') so that new
+   objects can be put in their sorted place without walking the list.
+   These structs must start with the same four link fields.
+*/
+#define HAL_HASH_SIZE       512	/* buckets for pins, signals, params */
+#define HAL_COMP_HASH_SIZE  64	/* buckets for components */
+#define HAL_ALIAS_HASH_SIZE 64	/* buckets for pin/param old names */
+
+/* Memory that a component gets from hal_malloc() while it is being
+   set up (after hal_init(), before hal_ready()) starts with this
+   header.  The component keeps a list of its blocks, and hal_exit()
+   puts them on free lists, one per power of two size class, where
+   the next hal_malloc() looks first.  So loading and unloading a
+   component over and over does not use up the shared memory.
+   Memory allocated at other times is never freed, as before.
+*/
+typedef struct {
+    int next_ptr;		/* next block of the owner, or free block */
+    int size;			/* usable size, following the header */
+} hal_block_t;
+
+#define HAL_MALLOC_CLASSES  24	/* free lists for 8 bytes up to 64 MB */
+
 /* Master HAL data structure
    There is a single instance of this structure in the machine.
    It resides at the base of the HAL shared memory block, where it
@@ -172,11 +205,14 @@ typedef struct {
 			        /* prefix of name for new instance */
     char constructor_arg[HAL_NAME_LEN+1];
 			        /* prefix of name for new instance */
+    int shmem_size;		/* size of the shmem block */
     int shmem_bot;		/* bottom of free shmem (first free byte) */
     int shmem_top;		/* top of free shmem (1 past last free) */
     int comp_list_ptr;		/* root of linked list of components */
     int pin_list_ptr;		/* root of linked list of pins */
     int sig_list_ptr;		/* root of linked list of signals */
+    int sig_block_ptr;		/* signal data laid out by compaction */
+    int sig_generation;		/* incremented when signal data moves */
     int param_list_ptr;		/* root of linked list of parameters */
     int funct_list_ptr;		/* root of linked list of functions */
     int thread_list_ptr;	/* root of linked list of threads */
@@ -193,6 +229,16 @@ typedef struct {
     int exact_base_period;      /* if set, pretend that rtapi satisfied our
 				   period request exactly */
     unsigned char lock;         /* hal locking, can be one of the HAL_LOCK_* types */
+    int pin_tree_root;		/* root of pin search tree */
+    int sig_tree_root;		/* root of signal search tree */
+    int param_tree_root;	/* root of parameter search tree */
+    int comp_hash[HAL_COMP_HASH_SIZE];	/* component name index */
+    int pin_hash[HAL_HASH_SIZE];	/* pin name index */
+    int sig_hash[HAL_HASH_SIZE];	/* signal name index */
+    int param_hash[HAL_HASH_SIZE];	/* parameter name index */
+    int pin_alias_hash[HAL_ALIAS_HASH_SIZE];	/* pin old name index */
+    int param_alias_hash[HAL_ALIAS_HASH_SIZE];	/* param old name index */
+    int malloc_free[HAL_MALLOC_CLASSES];	/* freed hal_malloc() blocks */
 } hal_data_t;
 
 /** HAL 'component' data structure.
@@ -202,6 +248,7 @@ typedef struct {
 */
 typedef struct {
     int next_ptr;		/* next component in the list */
+    int hash_next;		/* next component in hash bucket */
     int comp_id;		/* component ID (RTAPI module id) */
     int mem_id;			/* RTAPI shmem ID used by this comp */
     int type;			/* 1 if realtime, 0 if not */
@@ -211,6 +258,7 @@ typedef struct {
     char name[HAL_NAME_LEN + 1];	/* component name */
     constructor make;
     int insmod_args;		/* args passed to insmod when loaded */
+    int mem_ptr;		/* blocks this comp got from hal_malloc() */
 } hal_comp_t;
 
 /** HAL 'pin' data structure.
@@ -218,6 +266,9 @@ typedef struct {
 */
 typedef struct {
     int next_ptr;		/* next pin in linked list */
+    int hash_next;		/* next pin in hash bucket */
+    int tree_left;		/* search tree links */
+    int tree_right;
     int data_ptr_addr;		/* address of pin data pointer */
     int owner_ptr;		/* component that owns this pin */
     int signal;			/* signal to which pin is linked */
@@ -233,6 +284,9 @@ typedef struct {
 */
 typedef struct {
     int next_ptr;		/* next signal in linked list */
+    int hash_next;		/* next signal in hash bucket */
+    int tree_left;		/* search tree links */
+    int tree_right;
     int data_ptr;		/* offset of signal value */
     hal_type_t type;		/* data type */
     int readers;		/* number of input pins linked */
@@ -246,6 +300,9 @@ typedef struct {
 */
 typedef struct {
     int next_ptr;		/* next parameter in linked list */
+    int hash_next;		/* next parameter in hash bucket */
+    int tree_left;		/* search tree links */
+    int tree_right;
     int data_ptr;		/* offset of parameter value */
     int owner_ptr;		/* component that owns this signal */
     int oldname;		/* old name if aliased, else zero */
@@ -270,6 +327,30 @@ typedef struct {
     that identify the functions connected to that thread.
 */
 
+/** Execution time histogram, with log2 sized buckets: bucket 0 counts
+    runs of 0 or 1 CPU cycles, bucket 'n' counts runs of 2^n up to
+    2^(n+1)-1 cycles.  It is only written by the thread that runs the
+    function, readers may see one run half counted.
+*/
+#define HAL_HIST_BUCKETS 32
+
+typedef struct {
+    hal_u32_t count[HAL_HIST_BUCKETS];
+} hal_hist_t;
+
+static inline int hal_hist_bucket(hal_u32_t cycles)
+{
+    int n = 0;
+
+    /* floor(log2(cycles)), in five steps */
+    if (cycles >> 16) { cycles >>= 16; n += 16; }
+    if (cycles >> 8) { cycles >>= 8; n += 8; }
+    if (cycles >> 4) { cycles >>= 4; n += 4; }
+    if (cycles >> 2) { cycles >>= 2; n += 2; }
+    if (cycles >> 1) { n += 1; }
+    return n;
+}
+
 typedef struct {
     int next_ptr;		/* next function in linked list */
     int uses_fp;		/* floating point flag */
@@ -281,14 +362,35 @@ typedef struct {
     hal_s32_t* runtime;	/* (pin) duration of last run, in CPU cycles */
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
     hal_bit_t maxtime_increased;	/* on last call, maxtime increased */
+    hal_hist_t hist;		/* run times, if the thread collects them */
     char name[HAL_NAME_LEN + 1];	/* function name */
 } hal_funct_t;
 
+/* Parallel threads: a thread whose 'parallel' param is set shares its
+   functions with helper tasks on other processors.  When threads are
+   started, each function entry gets a 'stage': one more than the
+   highest stage of any earlier entry it conflicts with.  Two entries
+   conflict if one writes a signal the other uses, which is found from
+   the pins of the function's instance, or if they belong to the same
+   instance of a component.  Signals are hashed into 'reads' and
+   'writes' bit masks, so unrelated signals can look alike; that only
+   costs parallelism.  The entries of each stage are then chained in
+   order through 'sched_next', and the thread and its helpers take them
+   from the chain one at a time, finishing each stage before the next.
+*/
+#define HAL_MAX_HELPERS 8	/* helper tasks per thread */
+#define HAL_SCHED_WORDS 8	/* 256 bit signal masks */
+
 typedef struct {
     hal_list_t links;		/* linked list data */
     void *arg;			/* argument for function */
     void (*funct) (void *, long);	/* ptr to function code */
     int funct_ptr;		/* pointer to function */
+    int sched_next;		/* next entry in stage order */
+    int stage;			/* stage of a parallel thread */
+    int scope;			/* length of the instance name, or 0 */
+    hal_u32_t reads[HAL_SCHED_WORDS];	/* signals the function reads */
+    hal_u32_t writes[HAL_SCHED_WORDS];	/* signals the function writes */
 } hal_funct_entry_t;
 
 #define HAL_STACKSIZE 16384	/* realtime task stacksize */
@@ -301,6 +403,21 @@ typedef struct {
     int task_id;		/* ID of the task that runs this thread */
     hal_s32_t* runtime;	/* (pin) duration of last run, in CPU cycles */
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
+    hal_bit_t hist_enable;	/* (param) collect run time histograms */
+    hal_bit_t hist_active;	/* histograms were cleared and are in use */
+    hal_u32_t misses;		/* (param) deadlines missed, see thread_task() */
+    long long int last_miss;	/* rtapi_get_time() at end of last miss */
+    long long int release;	/* rtapi_get_time() of this period's start */
+    hal_hist_t hist;		/* run times of the whole thread */
+    hal_bit_t parallel;		/* (param) use helpers, if there are any */
+    hal_s32_t stages;		/* (param) stages of the parallel schedule */
+    int helpers;		/* number of helper tasks */
+    int helper_task_id[HAL_MAX_HELPERS];	/* their task IDs */
+    int sched_head;		/* first entry in stage order, 0 if none */
+    volatile int sched_pending;	/* next entry to be taken */
+    volatile int sched_stage;	/* stage being run, -1 if none */
+    volatile int sched_busy;	/* tasks that may be running an entry */
+    volatile int sched_gen;	/* counts parallel runs of the thread */
     hal_list_t funct_list;	/* list of functions to run */
     char name[HAL_NAME_LEN + 1];	/* thread name */
     int comp_id;
@@ -329,8 +446,23 @@ typedef struct {
 */
 
 #define HAL_KEY   0x48414C32	/* key used to open HAL shared memory */
-#define HAL_VER   0x0000000D	/* version code */
+#define HAL_VER   0x00000013	/* version code */
+
+/* HAL_SIZE is the default, and smallest, size of the shmem block.  The
+   one that creates the block can ask for more: the realtime hal_lib
+   with its 'hal_size' parameter, a user space program with the
+   HAL_SIZE environment variable.  The size actually used is stored in
+   hal_data->shmem_size. */
 #define HAL_SIZE  (75*4096)
+
+#ifdef ULAPI
+/** 'hal_shmem_request_size()' returns the size a user space program
+    asks for when it opens the shmem block: HAL_SIZE, or the HAL_SIZE
+    environment variable if that is larger.  It must match the size the
+    block was created with if that is larger than the default.
+*/
+extern unsigned long hal_shmem_request_size(void);
+#endif
 #define HAL_PSEUDO_COMP_PREFIX "__" /* prefix to identify a pseudo component */
 
 /* These pointers are set by hal_init() to point to the shmem block
@@ -385,8 +517,8 @@ void list_add_after(hal_list_t * entry, hal_list_t * prev);
 void list_add_before(hal_list_t * entry, hal_list_t * next);
 hal_list_t *list_remove_entry(hal_list_t * entry);
 
-/** The 'find_xxx_by_name()' functions search the appropriate list for
-    an object that matches 'name'.  They return a pointer to the object,
+/** The 'find_xxx_by_name()' functions search the appropriate hash
+    index for an object that matches 'name'.  They return a pointer to the object,
     or NULL if no matching object is found.
 */
 extern hal_comp_t *halpr_find_comp_by_name(const char *name);
@@ -427,6 +559,51 @@ extern hal_funct_t *halpr_find_funct_by_owner(hal_comp_t * owner,
 */
 extern hal_pin_t *halpr_find_pin_by_sig(hal_sig_t * sig, hal_pin_t * start);
 
+/** 'halpr_set_insmod_args()' copies 'args', the arguments a module was
+    loaded with, into shared memory owned by 'comp', and points
+    comp->insmod_args at the copy.  Returns 0, or -ENOMEM.  The caller
+    must hold the mutex.
+*/
+extern int halpr_set_insmod_args(hal_comp_t * comp, const char *args);
+
+/** The following are the lock-free cores of hal_signal_new(), hal_link()
+    and hal_add_funct_to_thread().  The caller must hold the HAL mutex and
+    must already have checked HAL_LOCK_CONFIG.  They let a caller apply a
+    whole batch of configuration changes under a single acquisition of the
+    mutex, so that no other HAL user sees the batch half applied.
+*/
+extern int halpr_signal_new(const char *name, hal_type_t type);
+extern int halpr_link(hal_pin_t * pin, hal_sig_t * sig);
+extern int halpr_add_funct_to_thread(hal_funct_t * funct,
+    hal_thread_t * thread, int position);
+
+/** 'halpr_compact_signals()' moves the data of all signals into one
+    new block, in the order the functions of each thread will touch
+    them: for each thread, for each function in it, the signals linked
+    to pins of the function's component.  Signals no thread touches go
+    last.  It then points every linked pin at the new location.  It
+    does nothing if the data is already laid out that way, or if the
+    block would take more than half of the free shared memory.  The
+    previous block goes back on the free lists of hal_malloc(), and
+    'sig_generation' in hal_data is incremented, so that code which
+    keeps the location of signal data (like halscope) knows to look it
+    up again.  Values written to a signal while it is moved may be lost,
+    so it should only be called while the threads are stopped.  The
+    caller must hold the mutex.  Called by hal_start_threads().
+*/
+extern int halpr_compact_signals(void);
+
+/** 'halpr_schedule_threads()' works out the stages of the functions of
+    every thread that has helper tasks and no current schedule.  Adding
+    or removing a function, or linking or unlinking a pin, drops the
+    schedules; while the threads are running they are worked out again
+    at once, otherwise the threads run their functions in order until
+    the next call.  Only pin connections are looked at, see the 'parallel'
+    thread parameter in the HAL manual.  The caller must hold the mutex.
+    Called by hal_start_threads().
+*/
+extern void halpr_schedule_threads(void);
+
 #define HAL_STREAM_MAGIC_NUM		0x4649464F
 struct hal_stream_shm {
     unsigned int magic;
@@ -177,6 +177,7 @@ struct pyhalitem {
 };
 
 static PyObject * pyhal_pin_new(halitem * pin, const char *name);
+static halitem *resolve_item(struct halobject *self, PyObject *o);
 
 typedef std::map<std::string, struct halitem> itemmap;
 
@@ -186,6 +187,7 @@ typedef struct halobject {
     char *name;
     char *prefix;
     itemmap *items;
+    PyObject *handles;
 } halobject;
 
 PyObject *pyhal_error_type = NULL;
@@ -208,6 +210,8 @@ static int pyhal_init(PyObject *_self, PyObject *args, PyObject *kw) {
     if(!PyArg_ParseTuple(args, "s|s:hal.component", &name, &prefix)) return -1;
 
     self->items = new itemmap();
+    self->handles = PyDict_New();
+    if(!self->handles) return -1;
 
     self->hal_id = hal_init(name);
     if(self->hal_id <= 0) {
@@ -242,6 +246,8 @@ static void pyhal_exit_impl(halobject *self) {
 
     delete self->items;
     self->items = 0;
+
+    Py_CLEAR(self->handles);
 }
 
 static void pyhal_delete(PyObject *_self) {
@@ -250,61 +256,85 @@ static void pyhal_delete(PyObject *_self) {
     self->ob_type->tp_free(self);
 }
 
-static int pyhal_write_common(halitem *pin, PyObject *value) {
-    if(!pin) return -1;
+static int pyhal_convert(halitem *pin, PyObject *value, paramunion *u) {
+    switch(pin->type) {
+        case HAL_BIT:
+            u->b = PyObject_IsTrue(value);
+            return 0;
+        case HAL_FLOAT: {
+            double tmp;
+            if(!from_python(value, &tmp)) return -1;
+            u->f = tmp;
+            return 0;
+        }
+        case HAL_U32: {
+            uint32_t tmp;
+            if(!from_python(value, &tmp)) return -1;
+            u->u32 = tmp;
+            return 0;
+        }
+        case HAL_S32: {
+            int32_t tmp;
+            if(!from_python(value, &tmp)) return -1;
+            u->s32 = tmp;
+            return 0;
+        }
+        default:
+            PyErr_Format(pyhal_error_type, "Invalid pin type %d", pin->type);
+            return -1;
+    }
+}
 
+static int pyhal_convert_double(halitem *pin, double value, paramunion *u) {
+    switch(pin->type) {
+        case HAL_BIT:
+            u->b = value != 0;
+            return 0;
+        case HAL_FLOAT:
+            u->f = value;
+            return 0;
+        case HAL_U32:
+            if(!(value > -1 && value < 4294967296.)) break;
+            u->u32 = (uint32_t)value;
+            return 0;
+        case HAL_S32:
+            if(!(value > -2147483649. && value < 2147483648.)) break;
+            u->s32 = (int32_t)value;
+            return 0;
+        default:
+            PyErr_Format(pyhal_error_type, "Invalid pin type %d", pin->type);
+            return -1;
+    }
+    PyErr_Format(PyExc_OverflowError, "Value %g out of range", value);
+    return -1;
+}
+
+static void pyhal_store(halitem *pin, const paramunion *u) {
     if(pin->is_pin) {
         switch(pin->type) {
-            case HAL_BIT:
-                *pin->u->pin.b = PyObject_IsTrue(value);
-                break;
-            case HAL_FLOAT: {
-                double tmp;
-                if(!from_python(value, &tmp)) return -1;
-                *pin->u->pin.f = tmp;
-                break;
-            }
-            case HAL_U32: {
-                uint32_t tmp;
-                if(!from_python(value, &tmp)) return -1;
-                *pin->u->pin.u32 = tmp;
-                break;
-            }
-            case HAL_S32: {
-                int32_t tmp;
-                if(!from_python(value, &tmp)) return -1;
-                *pin->u->pin.s32 = tmp;
-                break;
-            }
-            default:
-                PyErr_Format(pyhal_error_type, "Invalid pin type %d", pin->type);
+            case HAL_BIT: *pin->u->pin.b = u->b; break;
+            case HAL_FLOAT: *pin->u->pin.f = u->f; break;
+            case HAL_U32: *pin->u->pin.u32 = u->u32; break;
+            case HAL_S32: *pin->u->pin.s32 = u->s32; break;
+            default: break;
         }
     } else {
         switch(pin->type) {
-            case HAL_BIT:
-                pin->u->param.b = PyObject_IsTrue(value);
-                break;
-            case HAL_FLOAT: {
-                double tmp;
-                if(!from_python(value, &tmp)) return -1;
-                pin->u->param.f = tmp;
-                break;
-            }
-            case HAL_U32: {
-                uint32_t tmp;
-                if(!from_python(value, &tmp)) return -1;
-                pin->u->param.u32 = tmp;
-                break;
-            }
-            case HAL_S32:
-                int32_t tmp;
-                if(!from_python(value, &tmp)) return -1;
-                pin->u->param.s32 = tmp;
-                break;
-            default:
-                PyErr_Format(pyhal_error_type, "Invalid pin type %d", pin->type);
+            case HAL_BIT: pin->u->param.b = u->b; break;
+            case HAL_FLOAT: pin->u->param.f = u->f; break;
+            case HAL_U32: pin->u->param.u32 = u->u32; break;
+            case HAL_S32: pin->u->param.s32 = u->s32; break;
+            default: break;
         }
     }
+}
+
+static int pyhal_write_common(halitem *pin, PyObject *value) {
+    paramunion u;
+
+    if(!pin) return -1;
+    if(pyhal_convert(pin, value, &u) < 0) return -1;
+    pyhal_store(pin, &u);
     return 0;
 }
 
@@ -331,6 +361,26 @@ static PyObject *pyhal_read_common(halitem *item) {
     return NULL;
 }
 
+static double pyhal_read_double(halitem *item) {
+    if(item->is_pin) {
+        switch(item->type) {
+            case HAL_BIT: return *(item->u->pin.b);
+            case HAL_U32: return *(item->u->pin.u32);
+            case HAL_S32: return *(item->u->pin.s32);
+            case HAL_FLOAT: return *(item->u->pin.f);
+            default: return 0;
+        }
+    } else {
+        switch(item->type) {
+            case HAL_BIT: return item->u->param.b;
+            case HAL_U32: return item->u->param.u32;
+            case HAL_S32: return item->u->param.s32;
+            case HAL_FLOAT: return item->u->param.f;
+            default: return 0;
+        }
+    }
+}
+
 static halitem *find_item(halobject *self, char *name) {
     if(!name) return NULL;
 
@@ -344,6 +394,26 @@ static halitem *find_item(halobject *self, char *name) {
     return &(i->second);
 }
 
+/* Every pin and param also has an item object in 'handles', keyed by
+   name.  A dict lookup with a string key uses the hash cached in the
+   string, which is much cheaper than building a std::string for 'items'.
+   The map is still used for the error message on a miss. */
+static halitem *find_item_cached(halobject *self, PyObject *key) {
+    PyObject *item = PyDict_GetItem(self->handles, key);
+    if(item) return &((pyhalitem *)item)->pin;
+    return find_item(self, PyString_AsString(key));
+}
+
+static PyObject *pyhal_add_handle(halobject *self, halitem *item, char *name) {
+    PyObject *result = pyhal_pin_new(item, name);
+    if(!result) return NULL;
+    if(PyDict_SetItemString(self->handles, name, result) < 0) {
+        Py_DECREF(result);
+        return NULL;
+    }
+    return result;
+}
+
 static PyObject * pyhal_create_param(halobject *self, char *name, hal_type_t type, hal_param_dir_t dir) {
     char param_name[HAL_NAME_LEN+1];
     int res;
@@ -370,7 +440,7 @@ static PyObject * pyhal_create_param(halobject *self, char *name, hal_type_t typ
 
     (*self->items)[name] = param;
 
-    return pyhal_pin_new(&param, name);
+    return pyhal_add_handle(self, &param, name);
 }
 
 
@@ -403,7 +473,7 @@ static PyObject * pyhal_create_pin(halobject *self, char *name, hal_type_t type,
 
     (*self->items)[name] = pin;
 
-    return pyhal_pin_new(&pin, name);
+    return pyhal_add_handle(self, &pin, name);
 }
 
 static PyObject *pyhal_new_param(PyObject *_self, PyObject *o) {
@@ -483,13 +553,24 @@ static PyObject *pyhal_getattro(PyObject *_self, PyObject *attro)  {
     if(result) return result;
 
     PyErr_Clear();
-    return pyhal_read_common(find_item(self, PyString_AsString(attro)));
+    return pyhal_read_common(find_item_cached(self, attro));
 }
 
 static int pyhal_setattro(PyObject *_self, PyObject *attro, PyObject *v) {
     halobject *self = (halobject *)_self;
     EXCEPTION_IF_NOT_LIVE(-1);
-    return pyhal_write_common(find_item(self, PyString_AsString(attro)), v);
+    return pyhal_write_common(find_item_cached(self, attro), v);
+}
+
+static PyObject *pyhal_subscript(PyObject *_self, PyObject *key) {
+    halobject *self = (halobject *)_self;
+    EXCEPTION_IF_NOT_LIVE(NULL);
+
+    // h['pin'] is the common case, so look for an item before trying
+    // attributes
+    PyObject *item = PyDict_GetItem(self->handles, key);
+    if(item) return pyhal_read_common(&((pyhalitem *)item)->pin);
+    return pyhal_getattro(_self, key);
 }
 
 static Py_ssize_t pyhal_len(PyObject *_self) {
@@ -528,6 +609,118 @@ static PyObject *pyhal_set_prefix(PyObject *_self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject *pyhal_get_many(PyObject *_self, PyObject *args) {
+    PyObject *items, *buf = NULL, *seq, *result;
+    halobject *self = (halobject *)_self;
+    if(!PyArg_ParseTuple(args, "O|O:get_many", &items, &buf)) return NULL;
+    EXCEPTION_IF_NOT_LIVE(NULL);
+
+    seq = PySequence_Fast(items, "get_many: items must be a sequence");
+    if(!seq) return NULL;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyObject **o = PySequence_Fast_ITEMS(seq);
+
+    if(buf) {
+        // fill a buffer of doubles, e.g. array.array('d')
+        void *ptr;
+        Py_ssize_t len;
+        result = NULL;
+        if(PyObject_AsWriteBuffer(buf, &ptr, &len) < 0) goto out;
+        if(len < n * (Py_ssize_t)sizeof(double)) {
+            PyErr_Format(PyExc_ValueError,
+                "get_many: buffer holds %d values, %d needed",
+                (int)(len / sizeof(double)), (int)n);
+            goto out;
+        }
+        for(Py_ssize_t i = 0; i < n; i++) {
+            halitem *item = resolve_item(self, o[i]);
+            if(!item) goto out;
+            double d = pyhal_read_double(item);
+            memcpy((char *)ptr + i * sizeof(double), &d, sizeof(double));
+        }
+        Py_INCREF(buf);
+        result = buf;
+    } else {
+        result = PyList_New(n);
+        if(!result) goto out;
+        for(Py_ssize_t i = 0; i < n; i++) {
+            halitem *item = resolve_item(self, o[i]);
+            PyObject *v = item ? pyhal_read_common(item) : NULL;
+            if(!v) {
+                Py_CLEAR(result);
+                goto out;
+            }
+            PyList_SET_ITEM(result, i, v);
+        }
+    }
+out:
+    Py_DECREF(seq);
+    return result;
+}
+
+// All the values are converted before any is stored, so a bad value
+// leaves every item unchanged.
+static PyObject *pyhal_set_many(PyObject *_self, PyObject *args) {
+    PyObject *items, *values, *seq, *vseq = NULL, *result = NULL;
+    halobject *self = (halobject *)_self;
+    if(!PyArg_ParseTuple(args, "OO:set_many", &items, &values)) return NULL;
+    EXCEPTION_IF_NOT_LIVE(NULL);
+
+    seq = PySequence_Fast(items, "set_many: items must be a sequence");
+    if(!seq) return NULL;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyObject **o = PySequence_Fast_ITEMS(seq);
+    halitem **resolved = new halitem*[n];
+    paramunion *converted = new paramunion[n];
+    const void *ptr = NULL;
+    Py_ssize_t len;
+
+    if(PyList_Check(values) || PyTuple_Check(values)) {
+        vseq = PySequence_Fast(values, "");
+        if(PySequence_Fast_GET_SIZE(vseq) != n) {
+            PyErr_Format(PyExc_ValueError,
+                "set_many: %d items but %d values",
+                (int)n, (int)PySequence_Fast_GET_SIZE(vseq));
+            goto out;
+        }
+    } else {
+        // a buffer of doubles, e.g. array.array('d')
+        if(PyObject_AsReadBuffer(values, &ptr, &len) < 0) goto out;
+        if(len != n * (Py_ssize_t)sizeof(double)) {
+            PyErr_Format(PyExc_ValueError,
+                "set_many: %d items but buffer holds %d values",
+                (int)n, (int)(len / sizeof(double)));
+            goto out;
+        }
+    }
+
+    for(Py_ssize_t i = 0; i < n; i++) {
+        resolved[i] = resolve_item(self, o[i]);
+        if(!resolved[i]) goto out;
+        if(vseq) {
+            if(pyhal_convert(resolved[i],
+                    PySequence_Fast_GET_ITEM(vseq, i), &converted[i]) < 0)
+                goto out;
+        } else {
+            double d;
+            memcpy(&d, (const char *)ptr + i * sizeof(double), sizeof(double));
+            if(pyhal_convert_double(resolved[i], d, &converted[i]) < 0)
+                goto out;
+        }
+    }
+    for(Py_ssize_t i = 0; i < n; i++)
+        pyhal_store(resolved[i], &converted[i]);
+
+    Py_INCREF(Py_None);
+    result = Py_None;
+out:
+    delete [] resolved;
+    delete [] converted;
+    Py_XDECREF(vseq);
+    Py_DECREF(seq);
+    return result;
+}
+
 static PyMethodDef hal_methods[] = {
     {"setprefix", pyhal_set_prefix, METH_VARARGS,
         "Set the prefix for newly created pins and parameters"},
@@ -543,12 +736,18 @@ static PyMethodDef hal_methods[] = {
         "Call hal_exit"},
     {"ready", pyhal_ready, METH_NOARGS,
         "Call hal_ready"},
+    {"get_many", pyhal_get_many, METH_VARARGS,
+        "Read a sequence of items (names or item objects).  Returns a list,\n"
+        "or fills the optional buffer of doubles and returns it"},
+    {"set_many", pyhal_set_many, METH_VARARGS,
+        "Write a sequence of items (names or item objects) from a list of\n"
+        "values or a buffer of doubles"},
     {NULL},
 };
 
 static PyMappingMethods halobject_map = {
     pyhal_len,
-    pyhal_getattro,
+    pyhal_subscript,
     pyhal_setattro
 };
 
@@ -757,6 +956,26 @@ static PyObject * pyhal_pin_new(halitem * pin, const char * name) {
     return (PyObject *) pypin;
 }
 
+// an item given to get_many or set_many: a name, an item object, or a
+// hal.Pin or hal.Param wrapping an item object
+static halitem *resolve_item(halobject *self, PyObject *o) {
+    if(PyObject_TypeCheck(o, &halpin_type))
+        return &((pyhalitem *)o)->pin;
+    if(PyString_Check(o) || PyUnicode_Check(o))
+        return find_item_cached(self, o);
+
+    PyObject *item = PyObject_GetAttrString(o, "_item");
+    halitem *result = NULL;
+    if(item && PyObject_TypeCheck(item, &halpin_type))
+        // 'o' keeps the item object alive
+        result = &((pyhalitem *)item)->pin;
+    else
+        PyErr_Format(PyExc_TypeError, "Expected item or name, not %s",
+                o->ob_type->tp_name);
+    Py_XDECREF(item);
+    return result;
+}
+
 PyObject *pin_has_writer(PyObject *self, PyObject *args) {
     char *name;
     if(!PyArg_ParseTuple(args, "s", &name)) return NULL;
@@ -969,6 +1188,63 @@ PyObject *set_p(PyObject *self, PyObject *args) {
     return PyBool_FromLong(retval != 0);
 }
 
+static PyObject *hist_to_list(hal_hist_t *hist) {
+    PyObject *result = PyList_New(HAL_HIST_BUCKETS);
+    if(!result) return NULL;
+    for(int i=0; i<HAL_HIST_BUCKETS; i++)
+        PyList_SET_ITEM(result, i, PyLong_FromUnsignedLong(hist->count[i]));
+    return result;
+}
+
+PyObject *funct_stats(PyObject *self, PyObject *args) {
+    char *name;
+    PyObject *result;
+    if(!PyArg_ParseTuple(args, "s", &name)) return NULL;
+    if(!SHMPTR(0)) {
+	PyErr_Format(PyExc_RuntimeError,
+		"Cannot call before creating component");
+	return NULL;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    hal_funct_t *funct = halpr_find_funct_by_name(name);
+    if(!funct) {
+        rtapi_mutex_give(&(hal_data->mutex));
+        PyErr_Format(PyExc_RuntimeError, "function not found");
+        return NULL;
+    }
+    result = Py_BuildValue("{s:N,s:l}",
+        "histogram", hist_to_list(&funct->hist),
+        "tmax", (long)funct->maxtime);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return result;
+}
+
+PyObject *thread_stats(PyObject *self, PyObject *args) {
+    char *name;
+    PyObject *result;
+    if(!PyArg_ParseTuple(args, "s", &name)) return NULL;
+    if(!SHMPTR(0)) {
+	PyErr_Format(PyExc_RuntimeError,
+		"Cannot call before creating component");
+	return NULL;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    hal_thread_t *thread = halpr_find_thread_by_name(name);
+    if(!thread) {
+        rtapi_mutex_give(&(hal_data->mutex));
+        PyErr_Format(PyExc_RuntimeError, "thread not found");
+        return NULL;
+    }
+    result = Py_BuildValue("{s:N,s:l,s:l,s:k,s:L}",
+        "histogram", hist_to_list(&thread->hist),
+        "period", thread->period,
+        "tmax", (long)thread->maxtime,
+        "misses", (unsigned long)thread->misses,
+        "last_miss", thread->last_miss);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return result;
+}
+
 struct shmobject {
     PyObject_HEAD
     halobject *comp;
@@ -1364,6 +1640,10 @@ PyMethodDef module_methods[] = {
 	"connect pin to signal"},
     {"set_p", set_p, METH_VARARGS,
 	"set pin value"},
+    {"funct_stats", funct_stats, METH_VARARGS,
+	"Return the run time histogram and tmax of a function"},
+    {"thread_stats", thread_stats, METH_VARARGS,
+	"Return the run time histogram, tmax and deadline misses of a thread"},
     {NULL},
 };
 
@@ -454,6 +454,21 @@ int halcmd_parse_cmd(char *tokens[])
     }
 
     hal_flag = 1;
+    /* queued 'loadrt's must be done before anything that may use them,
+       and a queued run of net/setp/addf before anything else */
+    if (tokens[0] && tokens[0][0] != '\0') {
+        retval = 0;
+        if (strcmp(tokens[0], "loadrt") != 0) {
+            retval = halcmd_flush_loadrt();
+        }
+        if (retval == 0 && !halcmd_is_bulk_cmd(tokens)) {
+            retval = halcmd_flush_bulk();
+        }
+        if (retval != 0) {
+            hal_flag = 0;
+            return retval;
+        }
+    }
     retval = parse_cmd1(tokens);
     hal_flag = 0;
     return retval;
@@ -43,6 +43,9 @@
 #include "../hal_priv.h"	/* private HAL decls */
 #include "halcmd_commands.h"
 #include <rtapi_mutex.h>
+#if defined(RTAPI_USPACE)
+#include "rtapi_taskstats.h"
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -55,6 +58,13 @@
 #include <errno.h>
 #include <time.h>
 #include <fnmatch.h>
+#include <search.h>
+#if defined(RTAPI_USPACE)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
 
 
 static int unloadrt_comp(char *mod_name);
@@ -67,6 +77,10 @@ static void print_script_sig_info(int type, char **patterns);
 static void print_param_info(int type, char **patterns);
 static void print_funct_info(char **patterns);
 static void print_thread_info(char **patterns);
+static void print_hist(hal_hist_t *hist);
+#if defined(RTAPI_USPACE)
+static void print_task_stats(rtapi_taskstats_t *ts, int task_id);
+#endif
 static void print_comp_names(char **patterns);
 static void print_pin_names(char **patterns);
 static void print_sig_names(char **patterns);
@@ -92,6 +106,8 @@ static void save_nets(FILE *dst, int arrows);
 static void save_params(FILE *dst);
 static void save_threads(FILE *dst);
 static void print_help_commands(void);
+enum bulk_op { BULK_NET, BULK_LINKPS, BULK_SETP, BULK_SETS, BULK_ADDF };
+static int bulk_queue(int op, char *first, char *second, char *rest[]);
 
 static int tmatch(int req_type, int type) {
     return req_type == -1 || type == req_type;
@@ -212,6 +228,9 @@ int do_linkps_cmd(char *pin, char *sig)
 {
     int retval;
 
+    if (halcmd_bulk_config) {
+        return bulk_queue(BULK_LINKPS, pin, sig, NULL);
+    }
     retval = hal_link(pin, sig);
     if (retval == 0) {
 	/* print success message */
@@ -312,6 +331,9 @@ int do_addf_cmd(char *func, char *thread, char **opt) {
     int position = -1;
     int retval;
 
+    if (halcmd_bulk_config) {
+        return bulk_queue(BULK_ADDF, func, thread, opt);
+    }
     if(position_str && *position_str) position = atoi(position_str);
 
     retval = hal_add_funct_to_thread(func, thread, position);
@@ -459,6 +481,9 @@ int do_net_cmd(char *signal, char *pins[]) {
     hal_sig_t *sig;
     int i, retval;
 
+    if (halcmd_bulk_config) {
+        return bulk_queue(BULK_NET, signal, NULL, pins);
+    }
     rtapi_mutex_get(&(hal_data->mutex));
     /* see if signal already exists */
     sig = halpr_find_sig_by_name(signal);
@@ -696,6 +721,9 @@ int do_setp_cmd(char *name, char *value)
     hal_type_t type;
     void *d_ptr;
 
+    if (halcmd_bulk_config) {
+        return bulk_queue(BULK_SETP, name, value, NULL);
+    }
     halcmd_info("setting parameter '%s' to '%s'\n", name, value);
     /* get mutex before accessing shared data */
     rtapi_mutex_get(&(hal_data->mutex));
@@ -838,6 +866,9 @@ int do_sets_cmd(char *name, char *value)
     hal_type_t type;
     void *d_ptr;
 
+    if (halcmd_bulk_config) {
+        return bulk_queue(BULK_SETS, name, value, NULL);
+    }
     rtapi_print_msg(RTAPI_MSG_DBG, "setting signal '%s'\n", name);
     /* get mutex before accessing shared data */
     rtapi_mutex_get(&(hal_data->mutex));
@@ -1046,7 +1077,7 @@ int do_status_cmd(char *type)
 	print_mem_status();
     } else if (strcmp(type, "lock") == 0) {
 	print_lock_status();
-    } else if (strcmp(type, "mem") == 0) {
+    } else if (strcmp(type, "mem") == 0 || strcmp(type, "memory") == 0) {
 	print_mem_status();
     } else {
 	halcmd_error("Unknown 'status' type '%s'\n", type);
@@ -1055,13 +1086,11 @@ int do_status_cmd(char *type)
     return 0;
 }
 
-int do_loadrt_cmd(char *mod_name, char *args[])
+/* loadrt_exec() runs the helper program that loads one module */
+static int loadrt_exec(char *mod_name, char *args[])
 {
-    char arg_string[MAX_CMD_LEN+1];
     int m=0, n=0, retval;
-    hal_comp_t *comp;
     char *argv[MAX_TOK+3];
-    char *cp1;
 #if defined(RTAPI_USPACE)
     argv[m++] = "-Wn";
     argv[m++] = mod_name;
@@ -1123,15 +1152,26 @@ int do_loadrt_cmd(char *mod_name, char *args[])
 
     retval = hal_systemv(argv);
 #endif
+    return retval;
+}
 
-    if ( retval != 0 ) {
-	halcmd_error("insmod for %s failed, returned %d\n"
+/* loadrt_failed() reports a module that could not be loaded */
+static void loadrt_failed(char *mod_name, int retval)
+{
+    halcmd_error("insmod for %s failed, returned %d\n"
 #if !defined(RTAPI_USPACE)
-            "See the output of 'dmesg' for more information.\n"
+        "See the output of 'dmesg' for more information.\n"
 #endif
         , mod_name, retval );
-	return -1;
-    }
+}
+
+/* loadrt_finish() records the args of a newly loaded module */
+static int loadrt_finish(char *mod_name, char *args[])
+{
+    char arg_string[MAX_CMD_LEN+1];
+    int n;
+    hal_comp_t *comp;
+
     /* make the args that were passed to the module into a single string */
     n = 0;
     arg_string[0] = '\0';
@@ -1139,14 +1179,6 @@ int do_loadrt_cmd(char *mod_name, char *args[])
 	strncat(arg_string, args[n++], MAX_CMD_LEN);
 	strncat(arg_string, " ", MAX_CMD_LEN);
     }
-    /* allocate HAL shmem for the string */
-    cp1 = hal_malloc(strlen(arg_string)+1);
-    if ( cp1 == NULL ) {
-	halcmd_error("failed to allocate memory for module args\n");
-	return -1;
-    }
-    /* copy string to shmem */
-    strcpy (cp1, arg_string);
     /* get mutex before accessing shared data */
     rtapi_mutex_get(&(hal_data->mutex));
     /* search component list for the newly loaded component */
@@ -1156,14 +1188,836 @@ int do_loadrt_cmd(char *mod_name, char *args[])
 	halcmd_error("module '%s' not loaded\n", mod_name);
 	return -EINVAL;
     }
-    /* link args to comp struct */
-    comp->insmod_args = SHMOFF(cp1);
+    /* copy the string to shmem, and link it to the comp struct */
+    if (halpr_set_insmod_args(comp, arg_string) != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	halcmd_error("failed to allocate memory for module args\n");
+	return -1;
+    }
     rtapi_mutex_give(&(hal_data->mutex));
     /* print success message */
     halcmd_info("Realtime module '%s' loaded\n", mod_name);
     return 0;
 }
 
+int halcmd_batch_loadrt = 0;
+
+#if defined(RTAPI_USPACE)
+/* When 'halcmd_batch_loadrt' is set (halcmd -f reading a file),
+   consecutive 'loadrt' commands are not run one at a time.  They are
+   queued here, and halcmd_flush_loadrt() (called before any other
+   command and at the end of the file) sends the whole queue to the
+   running rtapi_app master in a single request over its socket, so a
+   config with many 'loadrt' lines forks once instead of once per
+   line.  The master stops at the first module that fails and replies
+   with the status of each command it ran.
+*/
+#define MAX_LOADRT_BATCH 64
+
+struct loadrt_request {
+    int linenumber;		/* line to blame for errors */
+    char *argv[MAX_TOK+2];	/* module name, args, NULL */
+};
+
+static struct loadrt_request loadrt_batch[MAX_LOADRT_BATCH];
+static int loadrt_batch_count = 0;
+
+/* connect to the rtapi_app master, returns -1 if none is running */
+static int loadrt_connect_master(void)
+{
+    struct sockaddr_un addr;
+    const char *path = getenv("RTAPI_FIFO_PATH");
+    int fd, r;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path) {
+        r = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    } else if (getenv("HOME")) {
+        r = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/.rtapi_fifo",
+            getenv("HOME"));
+    } else {
+        return -1;
+    }
+    if (r < 0 || r >= (int)sizeof(addr.sun_path)) {
+        return -1;
+    }
+    fd = socket(PF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* the master's wire format: a count or length is decimal followed by a
+   space, a string is its length followed by its bytes, and a request
+   is the number of strings followed by the strings */
+static int loadrt_put_number(char *buf, int pos, int size, int num)
+{
+    int r = snprintf(buf + pos, size - pos, "%d ", num);
+    if (r < 0 || r >= size - pos) return -1;
+    return pos + r;
+}
+
+static int loadrt_put_string(char *buf, int pos, int size, const char *str)
+{
+    int len = strlen(str);
+    pos = loadrt_put_number(buf, pos, size, len);
+    if (pos < 0 || len >= size - pos) return -1;
+    memcpy(buf + pos, str, len);
+    return pos + len;
+}
+
+static int loadrt_get_number(int fd, int *num)
+{
+    int r = 0, neg = 1;
+    char ch;
+
+    while (1) {
+        if (read(fd, &ch, 1) != 1) return -1;
+        if (ch == '-') neg = -1;
+        else if (ch == ' ') break;
+        else r = 10 * r + ch - '0';
+    }
+    *num = r * neg;
+    return 0;
+}
+
+/* send requests 'first' and up as one "batch" request, returns the
+   number of statuses received or -1 if the master could not be reached */
+static int loadrt_send_batch(int fd, int first, int *results)
+{
+    static char buf[MAX_LOADRT_BATCH * (MAX_CMD_LEN + 64)];
+    int i, n, nstrings, pos, count;
+    struct loadrt_request *req;
+
+    /* one "batch" tag, then per command a count, "load" and its argv */
+    nstrings = 1;
+    for (i = first; i < loadrt_batch_count; i++) {
+        req = &loadrt_batch[i];
+        for (n = 0; req->argv[n]; n++) ;
+        nstrings += 2 + n;
+    }
+    pos = loadrt_put_number(buf, 0, sizeof(buf), nstrings);
+    if (pos >= 0) pos = loadrt_put_string(buf, pos, sizeof(buf), "batch");
+    for (i = first; i < loadrt_batch_count && pos >= 0; i++) {
+        char count_str[16];
+        req = &loadrt_batch[i];
+        for (n = 0; req->argv[n]; n++) ;
+        snprintf(count_str, sizeof(count_str), "%d", n + 1);
+        pos = loadrt_put_string(buf, pos, sizeof(buf), count_str);
+        if (pos >= 0) pos = loadrt_put_string(buf, pos, sizeof(buf), "load");
+        for (n = 0; req->argv[n] && pos >= 0; n++) {
+            pos = loadrt_put_string(buf, pos, sizeof(buf), req->argv[n]);
+        }
+    }
+    if (pos < 0) {
+        halcmd_error("loadrt batch request too long\n");
+        return -1;
+    }
+    if (write(fd, buf, pos) != pos) {
+        return -1;
+    }
+    if (loadrt_get_number(fd, &count) < 0 || count < 0 ||
+            count > loadrt_batch_count - first) {
+        return -1;
+    }
+    for (i = 0; i < count; i++) {
+        if (loadrt_get_number(fd, &results[i]) < 0) return -1;
+    }
+    return count;
+}
+
+static int loadrt_queue(char *mod_name, char *args[])
+{
+    struct loadrt_request *req;
+    int n;
+
+    if (loadrt_batch_count == MAX_LOADRT_BATCH) {
+        int retval = halcmd_flush_loadrt();
+        if (retval != 0) return retval;
+    }
+    req = &loadrt_batch[loadrt_batch_count++];
+    req->linenumber = halcmd_get_linenumber();
+    req->argv[0] = strdup(mod_name);
+    for (n = 0; args[n] && args[n][0] != '\0' && n < MAX_TOK; n++) {
+        req->argv[n+1] = strdup(args[n]);
+    }
+    req->argv[n+1] = NULL;
+    return 0;
+}
+#endif
+
+int halcmd_flush_loadrt(void)
+{
+#if defined(RTAPI_USPACE)
+    int results[MAX_LOADRT_BATCH];
+    int i, j, n, fd, retval = 0;
+    int linenumber = halcmd_get_linenumber();
+    struct loadrt_request *req;
+
+    i = 0;
+    while (i < loadrt_batch_count && retval == 0) {
+        fd = loadrt_connect_master();
+        if (fd < 0) {
+            /* no master yet, loading the first module starts one */
+            req = &loadrt_batch[i++];
+            halcmd_set_linenumber(req->linenumber);
+            retval = loadrt_exec(req->argv[0], req->argv + 1);
+            if (retval != 0) {
+                loadrt_failed(req->argv[0], retval);
+                retval = -1;
+            } else {
+                retval = loadrt_finish(req->argv[0], req->argv + 1);
+            }
+            continue;
+        }
+        n = loadrt_send_batch(fd, i, results);
+        close(fd);
+        if (n < 0) {
+            halcmd_set_linenumber(loadrt_batch[i].linenumber);
+            halcmd_error("lost connection to rtapi_app while loading modules\n");
+            retval = -1;
+            break;
+        }
+        for (j = 0; j < n && retval == 0; j++) {
+            req = &loadrt_batch[i++];
+            halcmd_set_linenumber(req->linenumber);
+            if (results[j] != 0) {
+                loadrt_failed(req->argv[0], results[j]);
+                retval = -1;
+            } else {
+                retval = loadrt_finish(req->argv[0], req->argv + 1);
+            }
+        }
+    }
+    /* discard the queue, after an error the rest is not loaded */
+    for (i = 0; i < loadrt_batch_count; i++) {
+        for (n = 0; loadrt_batch[i].argv[n]; n++) {
+            free(loadrt_batch[i].argv[n]);
+        }
+    }
+    loadrt_batch_count = 0;
+    halcmd_set_linenumber(linenumber);
+    return retval;
+#else
+    return 0;
+#endif
+}
+
+int do_loadrt_cmd(char *mod_name, char *args[])
+{
+    int retval;
+
+#if defined(RTAPI_USPACE)
+    if (halcmd_batch_loadrt) {
+        return loadrt_queue(mod_name, args);
+    }
+#endif
+    retval = loadrt_exec(mod_name, args);
+    if ( retval != 0 ) {
+	loadrt_failed(mod_name, retval);
+	return -1;
+    }
+    return loadrt_finish(mod_name, args);
+}
+
+int halcmd_bulk_config = 0;
+
+/* When 'halcmd_bulk_config' is set (halcmd -f reading a file), runs of
+   'net', 'linkps', 'linksp', 'setp', 'sets' and 'addf' commands are
+   queued here instead of being executed one at a time.
+   halcmd_flush_bulk() (called before any other command and at the end
+   of the file) takes the HAL mutex once, checks every queued command
+   against a shadow copy of the signal, link and thread state, and
+   reports every error it finds.  Only if there were none is the whole
+   run applied, still under the same mutex acquisition, so a typo on
+   one line no longer leaves the configuration half connected.
+*/
+struct bulk_request {
+    int op;			/* one of BULK_xxx */
+    int linenumber;		/* line to blame for errors */
+    char *filename;		/* file to blame for errors */
+    char *argv[MAX_TOK+3];	/* command arguments, NULL */
+};
+
+static struct bulk_request *bulk_requests;
+static int bulk_count, bulk_size;
+
+/* shadow of a signal, as it will be once the commands checked so far
+   have been applied */
+struct bulk_sig {
+    const char *name;
+    int exists;			/* exists now or is created by a 'net' */
+    int type;			/* -1 if not known yet */
+    int writers, bidirs;
+    const char *writer_name, *bidir_name;
+};
+
+/* shadow of a pin (signal it is linked to), a function (number of
+   threads it is in) or a thread (number of functions it runs) */
+struct bulk_obj {
+    void *obj;
+    struct bulk_sig *sig;
+    int count;
+};
+
+static void *bulk_sigs, *bulk_objs;
+
+static int bulk_sig_cmp(const void *a, const void *b)
+{
+    return strcmp(((const struct bulk_sig *) a)->name,
+	((const struct bulk_sig *) b)->name);
+}
+
+static int bulk_obj_cmp(const void *a, const void *b)
+{
+    const char *x = ((const struct bulk_obj *) a)->obj;
+    const char *y = ((const struct bulk_obj *) b)->obj;
+    return (x > y) - (x < y);
+}
+
+/* looks up the shadow of signal 'name', creating it from the real
+   signal if needed.  If there is no such signal, returns NULL unless
+   'create' is set, in which case it returns a shadow that does not
+   exist yet. */
+static struct bulk_sig *bulk_find_sig(const char *name, int create)
+{
+    struct bulk_sig key, *s, **node;
+    hal_sig_t *sig;
+    hal_pin_t *pin;
+    int next;
+
+    key.name = name;
+    node = tfind(&key, &bulk_sigs, bulk_sig_cmp);
+    if (node) {
+	return *node;
+    }
+    sig = halpr_find_sig_by_name(name);
+    if (sig == 0 && !create) {
+	return NULL;
+    }
+    s = calloc(1, sizeof(struct bulk_sig));
+    if (s == NULL) {
+	return NULL;
+    }
+    s->type = -1;
+    s->name = name;
+    if (sig) {
+	s->name = sig->name;
+	s->exists = 1;
+	s->type = sig->type;
+	s->writers = sig->writers;
+	s->bidirs = sig->bidirs;
+    }
+    if (s->writers || s->bidirs) {
+	for (next = hal_data->pin_list_ptr; next; next = pin->next_ptr) {
+	    pin = SHMPTR(next);
+	    if (SHMPTR(pin->signal) == sig && pin->dir == HAL_OUT)
+		s->writer_name = pin->name;
+	    if (SHMPTR(pin->signal) == sig && pin->dir == HAL_IO)
+		s->bidir_name = s->writer_name = pin->name;
+	}
+    }
+    if (tsearch(s, &bulk_sigs, bulk_sig_cmp) == NULL) {
+	free(s);
+	return NULL;
+    }
+    return s;
+}
+
+/* looks up the shadow of a pin, function or thread; 'count' and 'sig'
+   are only filled in by the caller when '*is_new' is set */
+static struct bulk_obj *bulk_find_obj(void *obj, int *is_new)
+{
+    struct bulk_obj key, *o, **node;
+
+    key.obj = obj;
+    *is_new = 0;
+    node = tfind(&key, &bulk_objs, bulk_obj_cmp);
+    if (node) {
+	return *node;
+    }
+    o = calloc(1, sizeof(struct bulk_obj));
+    if (o == NULL) {
+	return NULL;
+    }
+    o->obj = obj;
+    if (tsearch(o, &bulk_objs, bulk_obj_cmp) == NULL) {
+	free(o);
+	return NULL;
+    }
+    *is_new = 1;
+    return o;
+}
+
+static struct bulk_obj *bulk_find_pin(hal_pin_t *pin)
+{
+    struct bulk_obj *o;
+    int is_new;
+
+    o = bulk_find_obj(pin, &is_new);
+    if (o && is_new && pin->signal) {
+	hal_sig_t *sig = SHMPTR(pin->signal);
+	o->sig = bulk_find_sig(sig->name, 0);
+    }
+    return o;
+}
+
+static struct bulk_obj *bulk_find_funct(hal_funct_t *funct)
+{
+    struct bulk_obj *o;
+    int is_new;
+
+    o = bulk_find_obj(funct, &is_new);
+    if (o && is_new) {
+	o->count = funct->users;
+    }
+    return o;
+}
+
+static struct bulk_obj *bulk_find_thread(hal_thread_t *thread)
+{
+    struct bulk_obj *o;
+    hal_list_t *list_root, *list_entry;
+    int is_new;
+
+    o = bulk_find_obj(thread, &is_new);
+    if (o && is_new) {
+	list_root = &(thread->funct_list);
+	list_entry = list_next(list_root);
+	while (list_entry != list_root) {
+	    o->count++;
+	    list_entry = list_next(list_entry);
+	}
+    }
+    return o;
+}
+
+/* checks adding 'pin' to the shadow signal 'tmp'; updates 'tmp' */
+static int bulk_check_link(const char *signal, struct bulk_sig *tmp,
+    hal_pin_t *pin)
+{
+    if (tmp->type == -1) {
+	tmp->type = pin->type;
+    }
+    if (tmp->type != pin->type) {
+	halcmd_error(
+	    "Signal '%s' of type '%s' cannot add pin '%s' of type '%s'\n",
+	    signal, data_type2(tmp->type), pin->name, data_type2(pin->type));
+	return -EINVAL;
+    }
+    if ((pin->dir == HAL_OUT && (tmp->writers || tmp->bidirs))
+	|| (pin->dir == HAL_IO && tmp->writers)) {
+	halcmd_error(
+	    "Signal '%s' can not add %s pin '%s', "
+	    "it already has %s pin '%s'\n",
+	    signal, pin_data_dir(pin->dir), pin->name,
+	    tmp->bidir_name ? pin_data_dir(HAL_IO) : pin_data_dir(HAL_OUT),
+	    tmp->bidir_name ? tmp->bidir_name : tmp->writer_name);
+	return -EINVAL;
+    }
+    if (pin->dir == HAL_OUT) {
+	tmp->writer_name = pin->name;
+	tmp->writers++;
+    }
+    if (pin->dir == HAL_IO) {
+	tmp->bidir_name = pin->name;
+	tmp->bidirs++;
+    }
+    return 0;
+}
+
+static int bulk_check_net(char *signal, char *pins[])
+{
+    struct bulk_sig *s, tmp;
+    struct bulk_obj *p;
+    hal_pin_t *pin;
+    int i, pincnt = 0;
+
+    if (halpr_find_pin_by_name(signal)) {
+	halcmd_error(
+	    "Signal name '%s' must not be the same as a pin.  "
+	    "Did you omit the signal name?\n", signal);
+	return -ENOENT;
+    }
+    s = bulk_find_sig(signal, 1);
+    if (s == NULL) {
+	return -ENOMEM;
+    }
+    tmp = *s;
+    for (i = 0; pins[i] && *pins[i]; i++) {
+	pin = halpr_find_pin_by_name(pins[i]);
+	if (!pin) {
+	    halcmd_error("Pin '%s' does not exist\n", pins[i]);
+	    return -ENOENT;
+	}
+	p = bulk_find_pin(pin);
+	if (p == NULL) {
+	    return -ENOMEM;
+	}
+	pincnt++;
+	if (p->sig == s) {
+	    /* already on this signal */
+	    continue;
+	} else if (p->sig) {
+	    halcmd_error("Pin '%s' was already linked to signal '%s'\n",
+		pin->name, p->sig->name);
+	    return -EINVAL;
+	}
+	if (bulk_check_link(signal, &tmp, pin) < 0) {
+	    return -EINVAL;
+	}
+    }
+    if (pincnt == 0) {
+	halcmd_error("'net' requires at least one pin, none given\n");
+	return -EINVAL;
+    }
+    /* the whole command is OK, record its effect */
+    *s = tmp;
+    s->exists = 1;
+    for (i = 0; pins[i] && *pins[i]; i++) {
+	p = bulk_find_pin(halpr_find_pin_by_name(pins[i]));
+	p->sig = s;
+    }
+    return 0;
+}
+
+static int bulk_check_linkps(char *pin_name, char *signal)
+{
+    struct bulk_sig *s, tmp;
+    struct bulk_obj *p;
+    hal_pin_t *pin;
+
+    pin = halpr_find_pin_by_name(pin_name);
+    if (pin == 0) {
+	halcmd_error("pin '%s' not found\n", pin_name);
+	return -EINVAL;
+    }
+    s = bulk_find_sig(signal, 0);
+    if (s == NULL || !s->exists) {
+	halcmd_error("signal '%s' not found\n", signal);
+	return -EINVAL;
+    }
+    p = bulk_find_pin(pin);
+    if (p == NULL) {
+	return -ENOMEM;
+    }
+    if (p->sig == s) {
+	return 0;
+    }
+    if (p->sig) {
+	halcmd_error("pin '%s' is linked to '%s', cannot link to '%s'\n",
+	    pin->name, p->sig->name, signal);
+	return -EINVAL;
+    }
+    tmp = *s;
+    if (bulk_check_link(signal, &tmp, pin) < 0) {
+	return -EINVAL;
+    }
+    *s = tmp;
+    p->sig = s;
+    return 0;
+}
+
+static int bulk_check_setp(char *name, char *value)
+{
+    hal_param_t *param;
+    hal_pin_t *pin;
+    struct bulk_obj *p;
+    hal_data_u scratch;
+
+    param = halpr_find_param_by_name(name);
+    if (param) {
+	if (param->dir == HAL_RO) {
+	    halcmd_error("param '%s' is not writable\n", name);
+	    return -EINVAL;
+	}
+	return set_common(param->type, &scratch, value);
+    }
+    pin = halpr_find_pin_by_name(name);
+    if (pin == 0) {
+	halcmd_error("parameter or pin '%s' not found\n", name);
+	return -EINVAL;
+    }
+    if (pin->dir == HAL_OUT) {
+	halcmd_error("pin '%s' is not writable\n", name);
+	return -EINVAL;
+    }
+    p = bulk_find_pin(pin);
+    if (p == NULL) {
+	return -ENOMEM;
+    }
+    if (p->sig) {
+	halcmd_error("pin '%s' is connected to a signal\n", name);
+	return -EINVAL;
+    }
+    return set_common(pin->type, &scratch, value);
+}
+
+static int bulk_check_sets(char *name, char *value)
+{
+    struct bulk_sig *s;
+    hal_data_u scratch;
+
+    s = bulk_find_sig(name, 0);
+    if (s == NULL || !s->exists) {
+	halcmd_error("signal '%s' not found\n", name);
+	return -EINVAL;
+    }
+    if (s->writers > 0) {
+	halcmd_error("signal '%s' already has writer(s)\n", name);
+	return -EINVAL;
+    }
+    return set_common(s->type, &scratch, value);
+}
+
+static int bulk_position(char *position_str)
+{
+    if (position_str && *position_str) return atoi(position_str);
+    return -1;
+}
+
+static int bulk_check_addf(char *func, char *thread_name, char *position_str)
+{
+    hal_funct_t *funct;
+    hal_thread_t *thread;
+    struct bulk_obj *f, *t;
+    int position = bulk_position(position_str);
+
+    funct = halpr_find_funct_by_name(func);
+    if (funct == 0) {
+	halcmd_error("function '%s' not found\n", func);
+	return -EINVAL;
+    }
+    thread = halpr_find_thread_by_name(thread_name);
+    if (thread == 0) {
+	halcmd_error("thread '%s' not found\n", thread_name);
+	return -EINVAL;
+    }
+    f = bulk_find_funct(funct);
+    t = bulk_find_thread(thread);
+    if (f == NULL || t == NULL) {
+	return -ENOMEM;
+    }
+    if (f->count > 0 && funct->reentrant == 0) {
+	halcmd_error("function '%s' may only be added to one thread\n", func);
+	return -EINVAL;
+    }
+    if (funct->uses_fp && !thread->uses_fp) {
+	halcmd_error("function '%s' needs FP\n", func);
+	return -EINVAL;
+    }
+    if (position == 0) {
+	halcmd_error("bad position: 0\n");
+	return -EINVAL;
+    }
+    /* 'position' counts from 1 at the start, or -1 at the end */
+    if ((position > 0 ? position : -position) - 1 > t->count) {
+	halcmd_error("position '%d' is too %s\n", position,
+	    position > 0 ? "high" : "low");
+	return -EINVAL;
+    }
+    f->count++;
+    t->count++;
+    return 0;
+}
+
+static int bulk_check(struct bulk_request *req)
+{
+    char **argv = req->argv;
+
+    if (req->op != BULK_SETP && req->op != BULK_SETS
+	&& (hal_data->lock & HAL_LOCK_CONFIG)) {
+	halcmd_error("HAL is locked, configuration changes are not allowed\n");
+	return -EPERM;
+    }
+    switch (req->op) {
+    case BULK_NET:
+	return bulk_check_net(argv[0], argv + 1);
+    case BULK_LINKPS:
+	return bulk_check_linkps(argv[0], argv[1]);
+    case BULK_SETP:
+	return bulk_check_setp(argv[0], argv[1]);
+    case BULK_SETS:
+	return bulk_check_sets(argv[0], argv[1]);
+    case BULK_ADDF:
+	return bulk_check_addf(argv[0], argv[1], argv[2]);
+    }
+    return -EINVAL;
+}
+
+static int bulk_apply_link(hal_pin_t *pin, hal_sig_t *sig)
+{
+    int retval = halpr_link(pin, sig);
+
+    if (retval == 0) {
+	halcmd_info("Pin '%s' linked to signal '%s'\n", pin->name, sig->name);
+    } else {
+	halcmd_error("link failed\n");
+    }
+    return retval;
+}
+
+/* applies a request that bulk_check() accepted; only an allocation
+   failure can make this fail */
+static int bulk_apply(struct bulk_request *req)
+{
+    char **argv = req->argv;
+    hal_param_t *param;
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    int i, retval = 0;
+
+    switch (req->op) {
+    case BULK_NET:
+	sig = halpr_find_sig_by_name(argv[0]);
+	if (sig == 0) {
+	    pin = halpr_find_pin_by_name(argv[1]);
+	    retval = halpr_signal_new(argv[0], pin->type);
+	    if (retval < 0) {
+		halcmd_error("net failed\n");
+		return retval;
+	    }
+	    sig = halpr_find_sig_by_name(argv[0]);
+	}
+	for (i = 1; retval == 0 && argv[i]; i++) {
+	    retval = bulk_apply_link(halpr_find_pin_by_name(argv[i]), sig);
+	}
+	return retval;
+    case BULK_LINKPS:
+	return bulk_apply_link(halpr_find_pin_by_name(argv[0]),
+	    halpr_find_sig_by_name(argv[1]));
+    case BULK_SETP:
+	param = halpr_find_param_by_name(argv[0]);
+	if (param) {
+	    set_common(param->type, SHMPTR(param->data_ptr), argv[1]);
+	    halcmd_info("Parameter '%s' set to %s\n", argv[0], argv[1]);
+	} else {
+	    pin = halpr_find_pin_by_name(argv[0]);
+	    set_common(pin->type, (void *) &pin->dummysig, argv[1]);
+	    halcmd_info("Pin '%s' set to %s\n", argv[0], argv[1]);
+	}
+	return 0;
+    case BULK_SETS:
+	sig = halpr_find_sig_by_name(argv[0]);
+	set_common(sig->type, SHMPTR(sig->data_ptr), argv[1]);
+	halcmd_info("Signal '%s' set to %s\n", argv[0], argv[1]);
+	return 0;
+    case BULK_ADDF:
+	retval = halpr_add_funct_to_thread(halpr_find_funct_by_name(argv[0]),
+	    halpr_find_thread_by_name(argv[1]), bulk_position(argv[2]));
+	if (retval == 0) {
+	    halcmd_info("Function '%s' added to thread '%s'\n",
+		argv[0], argv[1]);
+	} else {
+	    halcmd_error("addf failed\n");
+	}
+	return retval;
+    }
+    return -EINVAL;
+}
+
+static int bulk_queue(int op, char *first, char *second, char *rest[])
+{
+    struct bulk_request *req;
+    int n = 0;
+
+    if (bulk_count == bulk_size) {
+	int size = bulk_size ? 2 * bulk_size : 256;
+	req = realloc(bulk_requests, size * sizeof(struct bulk_request));
+	if (req == NULL) {
+	    halcmd_error("out of memory queueing command\n");
+	    return -ENOMEM;
+	}
+	bulk_requests = req;
+	bulk_size = size;
+    }
+    req = &bulk_requests[bulk_count++];
+    req->op = op;
+    req->linenumber = halcmd_get_linenumber();
+    req->filename = strdup(halcmd_get_filename());
+    req->argv[n++] = strdup(first);
+    if (second) {
+	req->argv[n++] = strdup(second);
+    }
+    while (rest && rest[0] && rest[0][0] != '\0' && n < MAX_TOK + 2) {
+	req->argv[n++] = strdup(*rest++);
+    }
+    req->argv[n] = NULL;
+    return 0;
+}
+
+int halcmd_is_bulk_cmd(char *tokens[])
+{
+    static const char *cmds[] =
+	{ "net", "linkps", "linksp", "setp", "sets", "addf", NULL };
+    int i;
+
+    if (!halcmd_bulk_config) return 0;
+    /* 'pin/param = value' is a setp */
+    if (tokens[1] && !strcmp(tokens[1], "=")) return 1;
+    for (i = 0; cmds[i]; i++) {
+	if (!strcmp(tokens[0], cmds[i])) return 1;
+    }
+    return 0;
+}
+
+int halcmd_flush_bulk(void)
+{
+    char *filename_save;
+    int linenumber = halcmd_get_linenumber();
+    int i, n, errors = 0, retval = 0;
+    struct bulk_request *req;
+
+    if (bulk_count == 0) {
+	return 0;
+    }
+    filename_save = strdup(halcmd_get_filename());
+    rtapi_mutex_get(&(hal_data->mutex));
+    /* check everything first, reporting all errors */
+    for (i = 0; i < bulk_count; i++) {
+	req = &bulk_requests[i];
+	halcmd_set_filename(req->filename);
+	halcmd_set_linenumber(req->linenumber);
+	if (bulk_check(req) < 0) {
+	    errors++;
+	}
+    }
+    tdestroy(bulk_sigs, free);
+    tdestroy(bulk_objs, free);
+    bulk_sigs = bulk_objs = NULL;
+    if (errors) {
+	halcmd_error("%d error%s, none of the %d commands since line %d "
+	    "were applied\n", errors, errors > 1 ? "s" : "", bulk_count,
+	    bulk_requests[0].linenumber);
+	retval = -EINVAL;
+    }
+    /* then apply it all, without giving up the mutex in between */
+    for (i = 0; i < bulk_count && retval == 0; i++) {
+	req = &bulk_requests[i];
+	halcmd_set_filename(req->filename);
+	halcmd_set_linenumber(req->linenumber);
+	retval = bulk_apply(req);
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    for (i = 0; i < bulk_count; i++) {
+	free(bulk_requests[i].filename);
+	for (n = 0; bulk_requests[i].argv[n]; n++) {
+	    free(bulk_requests[i].argv[n]);
+	}
+    }
+    bulk_count = 0;
+    halcmd_set_filename(filename_save);
+    halcmd_set_linenumber(linenumber);
+    free(filename_save);
+    return retval;
+}
+
 int do_delsig_cmd(char *mod_name)
 {
     int next, retval, retval1, n;
@@ -1854,6 +2708,34 @@ static void print_param_aliases(char **patterns)
     halcmd_output("\n");
 }
 
+/* true if a thread that runs 'funct' is keeping histograms, so that
+   the histogram of 'funct' is current.  Call with the HAL mutex held. */
+static int funct_hist_active(hal_funct_t *funct)
+{
+    int next_thread;
+    hal_thread_t *tptr;
+    hal_list_t *list_root, *list_entry;
+    hal_funct_entry_t *fentry;
+
+    next_thread = hal_data->thread_list_ptr;
+    while (next_thread != 0) {
+	tptr = SHMPTR(next_thread);
+	if (tptr->hist_active) {
+	    list_root = &(tptr->funct_list);
+	    list_entry = list_next(list_root);
+	    while (list_entry != list_root) {
+		fentry = (hal_funct_entry_t *) list_entry;
+		if (SHMPTR(fentry->funct_ptr) == funct) {
+		    return 1;
+		}
+		list_entry = list_next(list_entry);
+	    }
+	}
+	next_thread = tptr->next_ptr;
+    }
+    return 0;
+}
+
 static void print_funct_info(char **patterns)
 {
     int next;
@@ -1876,6 +2758,9 @@ static void print_funct_info(char **patterns)
 		    (long)fptr->funct,
 		    (long)fptr->arg, (fptr->uses_fp ? "YES" : "NO"),
 		    fptr->users, fptr->name);
+		if (funct_hist_active(fptr)) {
+		    print_hist(&(fptr->hist));
+		}
 	    } else {
 		halcmd_output("%s %08lx %08lx %s %3d %s\n",
 		    comp->name,
@@ -1897,8 +2782,19 @@ static void print_thread_info(char **patterns)
     hal_list_t *list_root, *list_entry;
     hal_funct_entry_t *fentry;
     hal_funct_t *funct;
+#if defined(RTAPI_USPACE)
+    rtapi_taskstats_t *ts = NULL;
+#endif
 
     if (scriptmode == 0) {
+#if defined(RTAPI_USPACE)
+	/* rtapi_app only creates the segment while tasks are running */
+	int id = shmget(RTAPI_TASKSTATS_KEY, 0, 0);
+	if (id >= 0) {
+	    ts = shmat(id, NULL, SHM_RDONLY);
+	    if (ts == (void *) -1) ts = NULL;
+	}
+#endif
 	halcmd_output("Realtime Threads:\n");
 	halcmd_output("     Period  FP     Name               (     Time, Max-Time )\n");
     }
@@ -1935,6 +2831,20 @@ static void print_thread_info(char **patterns)
                 rtapi_print_msg(RTAPI_MSG_ERR,
                      "unexpected: cannot find time pin for %s thread",tptr->name);
             }
+	    if (scriptmode == 0) {
+		if (tptr->misses) {
+		    halcmd_output("%34s %u deadline misses, last at %lld ns\n",
+			"", (unsigned) tptr->misses, tptr->last_miss);
+		}
+#if defined(RTAPI_USPACE)
+		if (ts) {
+		    print_task_stats(ts, tptr->task_id);
+		}
+#endif
+		if (tptr->hist_active) {
+		    print_hist(&(tptr->hist));
+		}
+	    }
 
 
 	    list_root = &(tptr->funct_list);
@@ -1948,6 +2858,9 @@ static void print_thread_info(char **patterns)
 		   thread period, FP flag, name, then all functs separated by spaces  */
 		if (scriptmode == 0) {
 		    halcmd_output("                 %2d %s\n", n, funct->name);
+		    if (tptr->hist_active) {
+			print_hist(&(funct->hist));
+		    }
 		} else {
 		    halcmd_output(" %s", funct->name);
 		}
@@ -1961,9 +2874,72 @@ static void print_thread_info(char **patterns)
 	next_thread = tptr->next_ptr;
     }
     rtapi_mutex_give(&(hal_data->mutex));
+#if defined(RTAPI_USPACE)
+    if (ts) {
+	shmdt(ts);
+    }
+#endif
     halcmd_output("\n");
 }
 
+#if defined(RTAPI_USPACE)
+/* prints one line summarizing the wakeup statistics that rtapi_app
+   keeps for a task, if it has woken up at all: how late it woke up
+   and how long it ran, in ns, as for print_hist */
+static void print_task_stats(rtapi_taskstats_t *ts, int task_id)
+{
+    int i, l50, l99, e50, e99;
+
+    for (i = 0; i < RTAPI_TASKSTATS_TASKS; i++) {
+	rtapi_task_stats_t s = ts->task[i];
+
+	if (!s.active || s.id != task_id) {
+	    continue;
+	}
+	l50 = rtapi_taskstats_percentile(s.late, .5);
+	l99 = rtapi_taskstats_percentile(s.late, .99);
+	e50 = rtapi_taskstats_percentile(s.exec, .5);
+	e99 = rtapi_taskstats_percentile(s.exec, .99);
+	if (l50 < 0 || e50 < 0) {
+	    return;
+	}
+	halcmd_output("%34s %llu wakeups, late ns: 50%% < %llu, 99%% < %llu, "
+	    "max %lld\n", "", s.wakeups, 2ULL << l50, 2ULL << l99, s.late_max);
+	halcmd_output("%34s run ns: 50%% < %llu, 99%% < %llu, max %lld, "
+	    "%llu overruns\n", "", 2ULL << e50, 2ULL << e99, s.exec_max,
+	    s.overruns);
+	return;
+    }
+}
+#endif
+
+/* prints one line summarizing a run time histogram, if it has any
+   runs: the upper bounds of the buckets that hold the median, the 99th
+   percentile and the longest run */
+static void print_hist(hal_hist_t *hist)
+{
+    unsigned long long total = 0, sum = 0;
+    int n, p50 = -1, p99 = -1, max = 0;
+
+    if (scriptmode != 0) {
+	return;
+    }
+    for (n = 0; n < HAL_HIST_BUCKETS; n++) {
+	total += hist->count[n];
+    }
+    if (total == 0) {
+	return;
+    }
+    for (n = 0; n < HAL_HIST_BUCKETS; n++) {
+	sum += hist->count[n];
+	if (p50 < 0 && 2 * sum >= total) p50 = n;
+	if (p99 < 0 && 100 * sum >= 99 * total) p99 = n;
+	if (hist->count[n]) max = n;
+    }
+    halcmd_output("%34s %llu runs, cycles: 50%% < %llu, 99%% < %llu, max < %llu\n",
+	"", total, 2ULL << p50, 2ULL << p99, 2ULL << max);
+}
+
 static void print_comp_names(char **patterns)
 {
     int next;
@@ -2108,26 +3084,71 @@ static int count_list(int list_root)
     return n;
 }
 
+/* prints the number of active and recycled objects of one type, and
+   how much memory they take */
+static void print_mem_line(const char *what, int active, int recycled,
+    long size)
+{
+    halcmd_output("  active/recycled %-12s %6d/%-6d %8ld/%-8ld bytes\n",
+	what, active, recycled, active * size, recycled * size);
+}
+
 static void print_mem_status()
 {
-    int active, recycled, next;
+    int active, recycled, next, n, blocks;
+    long size, owned, freed;
     hal_pin_t *pin;
     hal_param_t *param;
+    hal_comp_t *comp;
+    hal_block_t *b;
 
+    size = hal_data->shmem_size;
     halcmd_output("HAL memory status\n");
-    halcmd_output("  used/total shared memory:   %ld/%d\n", (long)(HAL_SIZE - hal_data->shmem_avail), HAL_SIZE);
+    halcmd_output("  used/total shared memory:   %ld/%ld\n",
+	size - (long)hal_data->shmem_avail, size);
+    halcmd_output("  hal_malloc/structs/free:    %ld/%ld/%ld\n",
+	(long)hal_data->shmem_bot, size - hal_data->shmem_top,
+	(long)hal_data->shmem_avail);
+    // component memory, and what the free lists hold
+    rtapi_mutex_get(&(hal_data->mutex));
+    owned = 0;
+    next = hal_data->comp_list_ptr;
+    while (next != 0) {
+	comp = SHMPTR(next);
+	for (n = comp->mem_ptr; n != 0; n = b->next_ptr) {
+	    b = SHMPTR(n);
+	    owned += b->size + sizeof(hal_block_t);
+	}
+	next = comp->next_ptr;
+    }
+    freed = 0;
+    blocks = 0;
+    for (n = 0; n < HAL_MALLOC_CLASSES; n++) {
+	for (next = hal_data->malloc_free[n]; next != 0; next = b->next_ptr) {
+	    b = SHMPTR(next);
+	    freed += b->size + sizeof(hal_block_t);
+	    blocks++;
+	}
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    halcmd_output("  component memory:           %ld bytes, %ld recycled in %d blocks\n",
+	owned, freed, blocks);
+    if (hal_data->shmem_avail + freed > 0) {
+	halcmd_output("  fragmentation:              %ld%% of free memory is in recycled blocks\n",
+	    100 * freed / (hal_data->shmem_avail + freed));
+    }
     // count components
     active = count_list(hal_data->comp_list_ptr);
     recycled = count_list(hal_data->comp_free_ptr);
-    halcmd_output("  active/recycled components: %d/%d\n", active, recycled);
+    print_mem_line("components:", active, recycled, sizeof(hal_comp_t));
     // count pins
     active = count_list(hal_data->pin_list_ptr);
     recycled = count_list(hal_data->pin_free_ptr);
-    halcmd_output("  active/recycled pins:       %d/%d\n", active, recycled);
+    print_mem_line("pins:", active, recycled, sizeof(hal_pin_t));
     // count parameters
     active = count_list(hal_data->param_list_ptr);
     recycled = count_list(hal_data->param_free_ptr);
-    halcmd_output("  active/recycled parameters: %d/%d\n", active, recycled);
+    print_mem_line("parameters:", active, recycled, sizeof(hal_param_t));
     // count aliases
     rtapi_mutex_get(&(hal_data->mutex));
     next = hal_data->pin_list_ptr;
@@ -2145,19 +3166,19 @@ static void print_mem_status()
     }
     rtapi_mutex_give(&(hal_data->mutex));
     recycled = count_list(hal_data->oldname_free_ptr);
-    halcmd_output("  active/recycled aliases:    %d/%d\n", active, recycled);
+    print_mem_line("aliases:", active, recycled, sizeof(hal_oldname_t));
     // count signals
     active = count_list(hal_data->sig_list_ptr);
     recycled = count_list(hal_data->sig_free_ptr);
-    halcmd_output("  active/recycled signals:    %d/%d\n", active, recycled);
+    print_mem_line("signals:", active, recycled, sizeof(hal_sig_t));
     // count functions
     active = count_list(hal_data->funct_list_ptr);
     recycled = count_list(hal_data->funct_free_ptr);
-    halcmd_output("  active/recycled functions:  %d/%d\n", active, recycled);
+    print_mem_line("functions:", active, recycled, sizeof(hal_funct_t));
     // count threads
     active = count_list(hal_data->thread_list_ptr);
     recycled = count_list(hal_data->thread_free_ptr);
-    halcmd_output("  active/recycled threads:    %d/%d\n", active, recycled);
+    print_mem_line("threads:", active, recycled, sizeof(hal_thread_t));
 }
 
 /* Switch function for pin/sig/param type for the print_*_list functions */
@@ -90,6 +90,16 @@ int hal_systemv(char *const argv[]);
 
 extern int scriptmode, comp_id;
 
+/* nonzero to queue 'loadrt' commands until halcmd_flush_loadrt() */
+extern int halcmd_batch_loadrt;
+extern int halcmd_flush_loadrt(void);
+
+/* nonzero to queue net/link/setp/sets/addf runs until halcmd_flush_bulk(),
+   which checks the whole run and then applies all or none of it */
+extern int halcmd_bulk_config;
+extern int halcmd_is_bulk_cmd(char *tokens[]);
+extern int halcmd_flush_bulk(void);
+
 RTAPI_END_DECLS
 
 #endif
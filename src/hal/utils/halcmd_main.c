@@ -232,6 +232,14 @@ int main(int argc, char **argv)
     if ( halcmd_startup(0) != 0 ) return 1;
 
     errorcount = 0;
+    /* loadrt's read from a file (but not typed at a prompt) can be
+       sent to rtapi_app in batches, and runs of net/setp/addf checked
+       and applied as a whole, unless we must keep going after errors,
+       which needs each result before the next command */
+    if (srcfile && !isatty(fileno(srcfile)) && !keep_going) {
+        halcmd_batch_loadrt = 1;
+        halcmd_bulk_config = 1;
+    }
     /* HAL init is OK, let's process the command(s) */
     if (srcfile == NULL) {
 #ifndef NO_INI
@@ -282,6 +290,12 @@ int main(int argc, char **argv)
 		break;
 	    }
 	}
+	/* do anything still queued at the end of the file */
+	if ( errorcount == 0 && !halcmd_done ) {
+	    if ( halcmd_flush_loadrt() != 0 || halcmd_flush_bulk() != 0 ) {
+		errorcount++;
+	    }
+	}
     }
     /* all done */
     halcmd_shutdown();
@@ -309,7 +323,7 @@ static int release_HAL_mutex(void)
         return -EINVAL;
     }
     /* get HAL shared memory block from RTAPI */
-    mem_id = rtapi_shmem_new(HAL_KEY, comp_id, HAL_SIZE);
+    mem_id = rtapi_shmem_new(HAL_KEY, comp_id, hal_shmem_request_size());
     if (mem_id < 0) {
         rtapi_print_msg(RTAPI_MSG_ERR,
             "ERROR: could not open shared memory\n");
@@ -250,6 +250,16 @@ def to_c(name):
     name = name.replace("#", "").replace(".", "_").replace("-", "_")
     return re.sub("_+", "_", name)
 
+# with 'option vector', each item is an array with one element per
+# instance, so an array item becomes a pointer to its per-instance arrays
+def vec_member(name, array):
+    if isinstance(array, tuple): array = array[0]
+    if array: return "(*%s)[%s]" % (name, array)
+    return "(*%s)" % name
+
+def vec_funct_name(name):
+    return to_hal(removeprefix(comp_name, "hal_") + "." + name)
+
 def prologue(f):
     print >> f, "/* Autogenerated by %s on %s -- do not edit */" % (
         sys.argv[0], time.asctime())
@@ -311,52 +321,102 @@ static int comp_id;
             else: print >>f, ";"
             print >>f, "%s(%s, %s);" % (decl, name, q(doc))
             
+    vector = options.get("vector")
+    if vector:
+        inst = "__comp_vec->%s[__comp_i]"
+    else:
+        inst = "inst->%s"
+
     print >>f
-    print >>f, "struct __comp_state {"
-    print >>f, "    struct __comp_state *_next;"
-    if has_personality:
+    if vector:
+        members = []
+        print >>f, "struct __comp_vec {"
+        print >>f, "    int count, size;"
+        if has_personality:
+            print >>f, "    int (*_personality);"
+            members.append("_personality")
+        for name, type, array, dir, value, personality in pins:
+            print >>f, "    hal_%s_t *%s;" % (type, vec_member(to_c(name), array))
+            members.append(to_c(name))
+        for name, type, array, dir, value, personality in params:
+            print >>f, "    hal_%s_t %s;" % (type, vec_member(to_c(name), array))
+            members.append(to_c(name))
+        for type, name, array, value in variables:
+            print >>f, "    %s %s%s;" % (type, "*" * name.count("*"),
+                vec_member(name.replace("*", ""), array))
+            members.append(name.replace("*", ""))
+        print >>f, "};"
+        print >>f, "static struct __comp_vec *__comp_vec;"
+        print >>f
+        print >>f, "static int __comp_vec_alloc(int size) {"
+        print >>f, "    if(size < 1) size = 1;"
+        print >>f, "    __comp_vec = hal_malloc(sizeof(struct __comp_vec));"
+        print >>f, "    if(!__comp_vec) return -ENOMEM;"
+        print >>f, "    memset(__comp_vec, 0, sizeof(struct __comp_vec));"
+        print >>f, "    __comp_vec->size = size;"
+        for m in members:
+            print >>f, "    __comp_vec->%s = hal_malloc(size * sizeof(*__comp_vec->%s));" % (m, m)
+            print >>f, "    if(!__comp_vec->%s) return -ENOMEM;" % m
+            print >>f, "    memset((void *)__comp_vec->%s, 0, size * sizeof(*__comp_vec->%s));" % (m, m)
+        print >>f, "    return 0;"
+        print >>f, "}"
+    else:
+        print >>f, "struct __comp_state {"
+        print >>f, "    struct __comp_state *_next;"
+    if has_personality and not vector:
         print >>f, "    int _personality;"
 
     for name, type, array, dir, value, personality in pins:
+        names[name] = 1
+        if vector: continue
         if array:
             if isinstance(array, tuple): array = array[0]
             print >>f, "    hal_%s_t *%s[%s];" % (type, to_c(name), array)
         else:
             print >>f, "    hal_%s_t *%s;" % (type, to_c(name))
-        names[name] = 1
 
     for name, type, array, dir, value, personality in params:
+        names[name] = 1
+        if vector: continue
         if array:
             if isinstance(array, tuple): array = array[0]
             print >>f, "    hal_%s_t %s[%s];" % (type, to_c(name), array)
         else:
             print >>f, "    hal_%s_t %s;" % (type, to_c(name))
-        names[name] = 1
 
-    for type, name, array, value in variables:
-        if array:
-            print >>f, "    %s %s[%d];\n" % (type, name, array)
-        else:
-            print >>f, "    %s %s;\n" % (type, name)
-    if has_data:
-        print >>f, "    void *_data;"
+    if not vector:
+        for type, name, array, value in variables:
+            if array:
+                print >>f, "    %s %s[%d];\n" % (type, name, array)
+            else:
+                print >>f, "    %s %s;\n" % (type, name)
+        if has_data:
+            print >>f, "    void *_data;"
 
-    print >>f, "};"
+        print >>f, "};"
 
     if options.get("userspace"):
         print >>f, "#include <stdlib.h>"
 
-    print >>f, "struct __comp_state *__comp_first_inst=0, *__comp_last_inst=0;"
+    if not vector:
+        print >>f, "struct __comp_state *__comp_first_inst=0, *__comp_last_inst=0;"
     
     print >>f
     for name, fp in functions:
         if names.has_key(name):
             Error("Duplicate item name: %s" % name)
-        print >>f, "static void %s(struct __comp_state *__comp_inst, long period);" % to_c(name)
+        if vector:
+            print >>f, "static inline void %s(int __comp_i, long period);" % to_c(name)
+            print >>f, "static void __comp_vec_%s(void *__comp_arg, long period);" % to_c(name)
+        else:
+            print >>f, "static void %s(struct __comp_state *__comp_inst, long period);" % to_c(name)
         names[name] = 1
 
-    print >>f, "static int __comp_get_data_size(void);"
-    if options.get("extra_setup"):
+    if not vector:
+        print >>f, "static int __comp_get_data_size(void);"
+    if options.get("extra_setup") and vector:
+        print >>f, "static int extra_setup(int __comp_i, char *prefix, long extra_arg);"
+    elif options.get("extra_setup"):
         print >>f, "static int extra_setup(struct __comp_state *__comp_inst, char *prefix, long extra_arg);"
     if options.get("extra_cleanup"):
         print >>f, "static void extra_cleanup(void);"
@@ -376,44 +436,51 @@ static int comp_id;
         print >>f, "static int export(char *prefix, long extra_arg, long personality) {"
     else:
         print >>f, "static int export(char *prefix, long extra_arg) {"
-    if len(functions) > 0:
+    if len(functions) > 0 and not vector:
         print >>f, "    char buf[HAL_NAME_LEN + 1];"
     print >>f, "    int r = 0;"
     if has_array:
         print >>f, "    int j = 0;"
-    print >>f, "    int sz = sizeof(struct __comp_state) + __comp_get_data_size();"
-    print >>f, "    struct __comp_state *inst = hal_malloc(sz);"
-    print >>f, "    memset(inst, 0, sz);"
+    if vector:
+        print >>f, "    int __comp_i = __comp_vec->count;"
+        print >>f, "    if(__comp_i >= __comp_vec->size) return -ENOSPC;"
+    else:
+        print >>f, "    int sz = sizeof(struct __comp_state) + __comp_get_data_size();"
+        print >>f, "    struct __comp_state *inst = hal_malloc(sz);"
+        print >>f, "    memset(inst, 0, sz);"
     if has_data:
         print >>f, "    inst->_data = (char*)inst + sizeof(struct __comp_state);"
     if has_personality:
-        print >>f, "    inst->_personality = personality;"
+        print >>f, "    %s = personality;" % (inst % "_personality")
     if options.get("extra_setup"):
-        print >>f, "    r = extra_setup(inst, prefix, extra_arg);"
+        if vector:
+            print >>f, "    r = extra_setup(__comp_i, prefix, extra_arg);"
+        else:
+            print >>f, "    r = extra_setup(inst, prefix, extra_arg);"
 	print >>f, "    if(r != 0) return r;"
         # the extra_setup() function may have changed the personality
         if has_personality:
-            print >>f, "    personality = inst->_personality;"
+            print >>f, "    personality = %s;" % (inst % "_personality")
     for name, type, array, dir, value, personality in pins:
         if personality:
             print >>f, "if(%s) {" % personality
         if array:
             if isinstance(array, tuple): array = array[1]
             print >>f, "    for(j=0; j < (%s); j++) {" % array
-            print >>f, "        r = hal_pin_%s_newf(%s, &(inst->%s[j]), comp_id," % (
-                type, dirmap[dir], to_c(name))
+            print >>f, "        r = hal_pin_%s_newf(%s, &(%s[j]), comp_id," % (
+                type, dirmap[dir], inst % to_c(name))
             print >>f, "            \"%%s%s\", prefix, j);" % to_hal("." + name)
             print >>f, "        if(r != 0) return r;"
             if value is not None:
-                print >>f, "    *(inst->%s[j]) = %s;" % (to_c(name), value)
+                print >>f, "    *(%s[j]) = %s;" % (inst % to_c(name), value)
             print >>f, "    }"
         else:
-            print >>f, "    r = hal_pin_%s_newf(%s, &(inst->%s), comp_id," % (
-                type, dirmap[dir], to_c(name))
+            print >>f, "    r = hal_pin_%s_newf(%s, &(%s), comp_id," % (
+                type, dirmap[dir], inst % to_c(name))
             print >>f, "        \"%%s%s\", prefix);" % to_hal("." + name)
             print >>f, "    if(r != 0) return r;"
             if value is not None:
-                print >>f, "    *(inst->%s) = %s;" % (to_c(name), value)
+                print >>f, "    *(%s) = %s;" % (inst % to_c(name), value)
         if personality:
             print >>f, "}"
 
@@ -423,19 +490,19 @@ static int comp_id;
         if array:
             if isinstance(array, tuple): array = array[1]
             print >>f, "    for(j=0; j < %s; j++) {" % array
-            print >>f, "        r = hal_param_%s_newf(%s, &(inst->%s[j]), comp_id," % (
-                type, dirmap[dir], to_c(name))
+            print >>f, "        r = hal_param_%s_newf(%s, &(%s[j]), comp_id," % (
+                type, dirmap[dir], inst % to_c(name))
             print >>f, "            \"%%s%s\", prefix, j);" % to_hal("." + name)
             print >>f, "        if(r != 0) return r;"
             if value is not None:
-                print >>f, "    inst->%s[j] = %s;" % (to_c(name), value)
+                print >>f, "    %s[j] = %s;" % (inst % to_c(name), value)
             print >>f, "    }"
         else:
-            print >>f, "    r = hal_param_%s_newf(%s, &(inst->%s), comp_id," % (
-                type, dirmap[dir], to_c(name))
+            print >>f, "    r = hal_param_%s_newf(%s, &(%s), comp_id," % (
+                type, dirmap[dir], inst % to_c(name))
             print >>f, "        \"%%s%s\", prefix);" % to_hal("." + name)
             if value is not None:
-                print >>f, "    inst->%s = %s;" % (to_c(name), value)
+                print >>f, "    %s = %s;" % (inst % to_c(name), value)
             print >>f, "    if(r != 0) return r;"
         if personality:
             print >>f, "}"
@@ -444,20 +511,23 @@ static int comp_id;
         if value is None: continue
         if array:
             print >>f, "    for(j=0; j < %s; j++) {" % array
-            print >>f, "        inst->%s[j] = %s;" % (name, value)
+            print >>f, "        %s[j] = %s;" % (inst % name.replace("*", ""), value)
             print >>f, "    }"
         else:
-            print >>f, "    inst->%s = %s;" % (name, value)
+            print >>f, "    %s = %s;" % (inst % name.replace("*", ""), value)
 
-    for name, fp in functions:
-        print >>f, "    rtapi_snprintf(buf, sizeof(buf), \"%%s%s\", prefix);"\
-            % to_hal("." + name)
-        print >>f, "    r = hal_export_funct(buf, (void(*)(void *inst, long))%s, inst, %s, 0, comp_id);" % (
-            to_c(name), int(fp))
-        print >>f, "    if(r != 0) return r;"
-    print >>f, "    if(__comp_last_inst) __comp_last_inst->_next = inst;"
-    print >>f, "    __comp_last_inst = inst;"
-    print >>f, "    if(!__comp_first_inst) __comp_first_inst = inst;"
+    if vector:
+        print >>f, "    __comp_vec->count++;"
+    else:
+        for name, fp in functions:
+            print >>f, "    rtapi_snprintf(buf, sizeof(buf), \"%%s%s\", prefix);"\
+                % to_hal("." + name)
+            print >>f, "    r = hal_export_funct(buf, (void(*)(void *inst, long))%s, inst, %s, 0, comp_id);" % (
+                to_c(name), int(fp))
+            print >>f, "    if(r != 0) return r;"
+        print >>f, "    if(__comp_last_inst) __comp_last_inst->_next = inst;"
+        print >>f, "    __comp_last_inst = inst;"
+        print >>f, "    if(!__comp_first_inst) __comp_first_inst = inst;"
     print >>f, "    return 0;"
     print >>f, "}"
 
@@ -492,6 +562,8 @@ static int comp_id;
 
         print >>f, "    comp_id = hal_init(\"%s\");" % comp_name
         print >>f, "    if(comp_id < 0) return comp_id;"
+        if vector and options.get("count_function"):
+            vec_alloc(f, "count")
 
         if options.get("singleton"):
             if has_personality:
@@ -518,6 +590,9 @@ static int comp_id;
             print >>f, "        return -EINVAL;"
             print >>f, "    }"
             print >>f, "    if(!count && !names[0]) count = default_count;"
+            if vector:
+                # with names=, there can be as many instances as names
+                vec_alloc(f, "count ? count : (int)(sizeof(names)/sizeof(names[0]))")
             print >>f, "    if(count) {"
             print >>f, "        for(i=0; i<count; i++) {"
             print >>f, "            char buf[HAL_NAME_LEN + 1];"
@@ -546,6 +621,10 @@ static int comp_id;
             print >>f, "       }"
             print >>f, "    }"
 
+        if vector:
+            for name, fp in functions:
+                print >>f, "    if(r == 0) r = hal_export_funct(\"%s\", __comp_vec_%s, __comp_vec, %s, 0, comp_id);" % (
+                    vec_funct_name(name), to_c(name), int(fp))
         if options.get("constructable") and not options.get("singleton"):
             print >>f, "    hal_set_constructor(comp_id, export_1);"
         print >>f, "    if(r) {"
@@ -636,10 +715,20 @@ int __comp_parse_names(int *argc, char **argv) {
 
     print >>f
     if not options.get("no_convenience_defines"):
+        if vector:
+            inst = "__comp_vec->%s[__comp_i]"
+        else:
+            inst = "__comp_inst->%s"
         print >>f, "#undef FUNCTION"
-        print >>f, "#define FUNCTION(name) static void name(struct __comp_state *__comp_inst, long period)"
+        if vector:
+            print >>f, "#define FUNCTION(name) static inline void name(int __comp_i, long period)"
+        else:
+            print >>f, "#define FUNCTION(name) static void name(struct __comp_state *__comp_inst, long period)"
         print >>f, "#undef EXTRA_SETUP"
-        print >>f, "#define EXTRA_SETUP() static int extra_setup(struct __comp_state *__comp_inst, char *prefix, long extra_arg)"
+        if vector:
+            print >>f, "#define EXTRA_SETUP() static int extra_setup(int __comp_i, char *prefix, long extra_arg)"
+        else:
+            print >>f, "#define EXTRA_SETUP() static int extra_setup(struct __comp_state *__comp_inst, char *prefix, long extra_arg)"
         print >>f, "#undef EXTRA_CLEANUP"
         print >>f, "#define EXTRA_CLEANUP() static void extra_cleanup(void)"
         print >>f, "#undef fperiod"
@@ -648,32 +737,32 @@ int __comp_parse_names(int *argc, char **argv) {
             print >>f, "#undef %s" % to_c(name)
             if array:
                 if dir == 'in':
-                    print >>f, "#define %s(i) (0+*(__comp_inst->%s[i]))" % (to_c(name), to_c(name))
+                    print >>f, "#define %s(i) (0+*(%s[i]))" % (to_c(name), inst % to_c(name))
                 else:
-                    print >>f, "#define %s(i) (*(__comp_inst->%s[i]))" % (to_c(name), to_c(name))
+                    print >>f, "#define %s(i) (*(%s[i]))" % (to_c(name), inst % to_c(name))
             else:
                 if dir == 'in':
-                    print >>f, "#define %s (0+*__comp_inst->%s)" % (to_c(name), to_c(name))
+                    print >>f, "#define %s (0+*%s)" % (to_c(name), inst % to_c(name))
                 else:
-                    print >>f, "#define %s (*__comp_inst->%s)" % (to_c(name), to_c(name))
+                    print >>f, "#define %s (*%s)" % (to_c(name), inst % to_c(name))
         for name, type, array, dir, value, personality in params:
             print >>f, "#undef %s" % to_c(name)
             if array:
-                print >>f, "#define %s(i) (__comp_inst->%s[i])" % (to_c(name), to_c(name))
+                print >>f, "#define %s(i) (%s[i])" % (to_c(name), inst % to_c(name))
             else:
-                print >>f, "#define %s (__comp_inst->%s)" % (to_c(name), to_c(name))
+                print >>f, "#define %s (%s)" % (to_c(name), inst % to_c(name))
 
         for type, name, array, value in variables:
             name = name.replace("*", "")
             print >>f, "#undef %s" % name
-            print >>f, "#define %s (__comp_inst->%s)" % (name, name)
+            print >>f, "#define %s (%s)" % (name, inst % name)
 
         if has_data:
             print >>f, "#undef data"
             print >>f, "#define data (*(%s*)(__comp_inst->_data))" % options['data']
         if has_personality:
             print >>f, "#undef personality"
-            print >>f, "#define personality (__comp_inst->_personality)"
+            print >>f, "#define personality (%s)" % (inst % "_personality")
 
         if options.get("userspace"):
             print >>f, "#undef FOR_ALL_INSTS"
@@ -681,12 +770,27 @@ int __comp_parse_names(int *argc, char **argv) {
     print >>f
     print >>f
 
+def vec_alloc(f, size):
+    print >>f, "    r = __comp_vec_alloc(%s);" % size
+    print >>f, "    if(r != 0) {"
+    print >>f, "        hal_exit(comp_id);"
+    print >>f, "        return r;"
+    print >>f, "    }"
+
 def epilogue(f):
     data = options.get('data')
     print >>f
+    if options.get("vector"):
+        for name, fp in functions:
+            print >>f, "static void __comp_vec_%s(void *__comp_arg, long period) {" % to_c(name)
+            print >>f, "    int __comp_i, __comp_n = __comp_vec->count;"
+            print >>f, "    for(__comp_i = 0; __comp_i < __comp_n; __comp_i++) {"
+            print >>f, "        %s(__comp_i, period);" % to_c(name)
+            print >>f, "    }"
+            print >>f, "}"
     if data:
         print >>f, "static int __comp_get_data_size(void) { return sizeof(%s); }" % data
-    else:
+    elif not options.get("vector"):
         print >>f, "static int __comp_get_data_size(void) { return 0; }"
 
 INSTALL, COMPILE, PREPROCESS, DOCUMENT, INSTALLDOC, VIEWDOC, MODINC = range(7)
@@ -866,7 +970,10 @@ def document(filename, outfilename):
         print >>f, ".SH FUNCTIONS"
         for _, name, fp, doc in finddocs('funct'):
             print >>f, ".TP"
-            print >>f, "\\fB%s\\fR" % to_hal_man(name),
+            if options.get("vector"):
+                print >>f, "\\fB%s\\fR" % vec_funct_name(name),
+            else:
+                print >>f, "\\fB%s\\fR" % to_hal_man(name),
             if fp:
                 print >>f, "(requires a floating-point thread)"
             else:
@@ -965,6 +1072,12 @@ def process(filename, mode, outfilename):
         if options.get("userspace"):
             if functions:
                 raise SystemExit, "Userspace components may not have functions"
+        if options.get("vector"):
+            for o in "userspace", "singleton", "constructable", "data":
+                if options.get(o):
+                    raise SystemExit, "Option vector may not be used with option %s" % o
+            if not options.get("rtapi_app", 1):
+                raise SystemExit, "Option vector may not be used with option rtapi_app no"
         if not pins:
             raise SystemExit, "Component must have at least one pin"
         prologue(f)
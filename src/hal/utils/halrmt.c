@@ -592,7 +592,7 @@ static int release_HAL_mutex(void)
         return -EINVAL;
     }
     /* get HAL shared memory block from RTAPI */
-    mem_id = rtapi_shmem_new(HAL_KEY, comp_id, HAL_SIZE);
+    mem_id = rtapi_shmem_new(HAL_KEY, comp_id, hal_shmem_request_size());
     if (mem_id < 0) {
         rtapi_print_msg(RTAPI_MSG_ERR,
             "ERROR: could not open shared memory\n");
@@ -1129,7 +1129,6 @@ static int doLoadRt(char *mod_name, char *args[], connectionRecType *context)
     char arg_string[MAX_CMD_LEN+1];
     int n=0, retval=0;
     hal_comp_t *comp;
-    char *cp1;
     const char *nakStr = "SET LOADRT NAK";
 
 #if defined(RTAPI_USPACE)
@@ -1215,15 +1214,6 @@ static int doLoadRt(char *mod_name, char *args[], connectionRecType *context)
 	strncat(arg_string, args[n++], MAX_CMD_LEN);
 	strncat(arg_string, " ", MAX_CMD_LEN);
     }
-    /* allocate HAL shmem for the string */
-    cp1 = hal_malloc(strlen(arg_string)+1);
-    if ( cp1 == NULL ) {
-      sprintf(errorStr, "failed to allocate memory for module args");
-      sockWriteError(nakStr, context);
-	return -1;
-    }
-    /* copy string to shmem */
-    strcpy (cp1, arg_string);
     /* get mutex before accessing shared data */
     rtapi_mutex_get(&(hal_data->mutex));
     /* search component list for the newly loaded component */
@@ -1234,8 +1224,13 @@ static int doLoadRt(char *mod_name, char *args[], connectionRecType *context)
         sockWriteError(nakStr, context);
 	return -EINVAL;
     }
-    /* link args to comp struct */
-    comp->insmod_args = SHMOFF(cp1);
+    /* copy the string to shmem, and link it to the comp struct */
+    if (halpr_set_insmod_args(comp, arg_string) != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+      sprintf(errorStr, "failed to allocate memory for module args");
+      sockWriteError(nakStr, context);
+	return -1;
+    }
     rtapi_mutex_give(&(hal_data->mutex));
     /* print success message */
 //    halcmd_info("Realtime module '%s' loaded\n", mod_name);
@@ -0,0 +1,997 @@
+/** This file, 'hm2_eth_emu.c', is 'hm2_eth_emu', a userspace stand-in
+    for a Mesa ethernet AnyIO board (7i76E, 7i80, 7i92).  It answers
+    the LBP16 commands that hm2_eth sends over UDP, so the ethernet
+    path of the hostmot2 driver can be run without hardware, and it
+    can also act as a client that measures the round trip of one
+    servo cycle's worth of traffic against an emulated or real board.
+
+    Invoking:
+
+    hm2_eth_emu [-a addr] [-b board] [-L usec] [-J usec] [-l percent]
+                [-s seed] [-i image] [-S seconds]
+
+    hm2_eth_emu -B [-P] [-C] [-a addr] [-p usec] [-n cycles] [-r bytes]
+                [-w bytes] [-A hm2addr] [-t usec]
+
+    The emulated board listens on 'addr' (default 127.0.0.1), port
+    27181.  Any 127.x.y.z address can be used, one per emulated board,
+    and hm2_eth can then be loaded with board_ip=127.x.y.z.  To put
+    the board behind a real network interface, run the emulator in
+    its own network namespace at the far end of a veth pair.
+
+    The HostMot2 register file behaves as plain memory.  It starts
+    out with an IDROM describing LEDs, a watchdog, IO ports, two
+    encoders and up to five stepgens (or, with '-i', a 64 KiB register
+    image), which is enough for hostmot2 to load and run.  Only the
+    watchdog does more: it bites when it is not reset in time.
+
+    Each request is delayed by the '-L' latency plus a uniformly
+    distributed extra delay of up to '-J' microseconds, and with
+    '-l', that percentage of requests or of their replies is lost.
+    Requests are answered in the order they were received, like a
+    single ethernet link.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111 USA
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>		/* getopt() */
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "rtapi.h"		/* rtapi_u8 and friends */
+#include "../drivers/mesa-hostmot2/hostmot2.h"	/* HM2_* register map */
+#include "../drivers/mesa-hostmot2/lbp16.h"	/* LBP16 commands */
+
+/***********************************************************************
+*                         LOCAL VARIABLES                              *
+************************************************************************/
+
+#define SPACE_SIZE 65536
+#define MAX_PACKET 1500		/* larger than any hm2_eth packet */
+#define MAX_PENDING 256
+#define SPIN_NS 20000		/* shorter waits than this are spun */
+
+/* the spaces hm2_eth uses */
+#define SPACE_HM2 0
+#define SPACE_EEPROM 2
+#define SPACE_TIMER 4
+#define SPACE_STATUS 6
+#define SPACE_INFO 7
+
+/* byte offsets in the status space (lbp_status_area) */
+#define STATUS_PARSE_ERRORS 0x02
+#define STATUS_RX_PACKETS 0x08
+#define STATUS_RX_UDP 0x0A
+#define STATUS_TX_PACKETS 0x0E
+#define STATUS_TX_UDP 0x10
+
+/* hm2_eth writes its write counter here once per servo cycle */
+#define TIMER_WRITE_COUNT 0x14
+
+/* the watchdog registers, see init_hm2() */
+#define WD_TIMER 0x0c00
+#define WD_STATUS 0x0d00
+#define WD_RESET 0x0e00
+
+struct board {
+    const char *name;		/* as reported in the board info space */
+    int ports, width;
+};
+
+static const struct board boards[] = {
+    { "7I92", 2, 17 },
+    { "7I76E-16", 3, 17 },
+    { "7I80DB-16", 4, 17 },
+    { "7I80DB-25", 4, 17 },
+    { "7I80HD-16", 3, 24 },
+    { "7I80HD-25", 3, 24 },
+};
+
+static rtapi_u8 space[LBP16_MEM_SPACE_COUNT][SPACE_SIZE];
+static unsigned int space_addr[LBP16_MEM_SPACE_COUNT];
+
+struct pending {
+    long long due;
+    int len;
+    int drop_reply;
+    struct sockaddr_in from;
+    rtapi_u8 data[MAX_PACKET];
+};
+
+/* requests waiting out their latency, oldest at 'pending_tail' */
+static struct pending pending[MAX_PENDING];
+static int pending_head, pending_tail;
+
+static long long latency, jitter;	/* ns */
+static double loss;		/* fraction of packets */
+static uint64_t rng_state = 0x2545f4914f6cdd1dULL;
+
+static unsigned long rx_packets, tx_packets, dropped, overflows;
+static unsigned long parse_errors, cycles;
+static int wd_armed;		/* the watchdog timer was written */
+static long long wd_petted;	/* when the watchdog was last reset */
+
+/* benchmark: busy-poll time, and kernel-to-benchmark delay of replies */
+static int busy_poll;		/* us */
+static long long rx_delay_sum, rx_delay_max;
+static long rx_delay_count;
+
+static sig_atomic_t stop;
+
+/***********************************************************************
+*                         LOCAL FUNCTIONS                              *
+************************************************************************/
+
+static void quit(int sig)
+{
+    stop = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"Usage: hm2_eth_emu [-a addr] [-b board] [-L usec] [-J usec]\n"
+	"           [-l percent] [-s seed] [-i image] [-S seconds]\n"
+	"       hm2_eth_emu -B [-P] [-C] [-a addr] [-p usec] [-n cycles] [-r bytes]\n"
+	"           [-w bytes] [-A hm2addr] [-t usec] [-U usec]\n");
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void ns_to_timespec(long long ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / 1000000000LL;
+    ts->tv_nsec = ns % 1000000000LL;
+}
+
+/* xorshift64*, so that runs with the same '-s' seed are repeatable */
+static double random_fraction(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return ((rng_state * 0x2545f4914f6cdd1dULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* LBP16 data is little endian */
+static void put16(int sp, unsigned int addr, unsigned int val)
+{
+    space[sp][addr & 0xffff] = val;
+    space[sp][(addr + 1) & 0xffff] = val >> 8;
+}
+
+static void put32(int sp, unsigned int addr, uint32_t val)
+{
+    put16(sp, addr, val & 0xffff);
+    put16(sp, addr + 2, val >> 16);
+}
+
+static uint32_t get32(int sp, unsigned int addr)
+{
+    int i;
+    uint32_t val = 0;
+    for (i = 3; i >= 0; i--)
+	val = (val << 8) | space[sp][(addr + i) & 0xffff];
+    return val;
+}
+
+static void count16(int sp, unsigned int addr)
+{
+    put16(sp, addr, space[sp][addr] + (space[sp][addr + 1] << 8) + 1);
+}
+
+/***********************************************************************
+*                         THE EMULATED BOARD                           *
+************************************************************************/
+
+static void put_md(unsigned int *addr, int gtag, int version, int clock,
+    int instances, int base, int regs, int multiple)
+{
+    /* register stride 0 (0x100) and instance stride 0 (4) */
+    put32(SPACE_HM2, *addr, gtag | (version << 8) | (clock << 16)
+	| (instances << 24));
+    put32(SPACE_HM2, *addr + 4, base | (regs << 16));
+    put32(SPACE_HM2, *addr + 8, multiple);
+    *addr += 12;
+}
+
+static void put_pd(int pin, int sec_pin, int sec_tag, int sec_unit)
+{
+    put32(SPACE_HM2, 0x600 + 4 * pin, sec_pin | (sec_tag << 8)
+	| (sec_unit << 16) | (HM2_GTAG_IOPORT << 24));
+}
+
+/* build the register file of a board with the usual modules, laid out
+   the way hostmot2 firmwares are */
+static void init_hm2(const struct board *b)
+{
+    unsigned int md = 0x440;
+    int io_width = b->ports * b->width;
+    int nstep = (io_width - 6) / 2;
+    int i;
+
+    if (nstep > 5)
+	nstep = 5;
+
+    put32(SPACE_HM2, HM2_ADDR_IOCOOKIE, HM2_IOCOOKIE);
+    memcpy(&space[SPACE_HM2][HM2_ADDR_CONFIGNAME], "HOSTMOT2", 8);
+    put32(SPACE_HM2, HM2_ADDR_IDROM_OFFSET, 0x400);
+
+    put32(SPACE_HM2, 0x400, 3);		/* IDROM type */
+    put32(SPACE_HM2, 0x404, 0x40);	/* offset to module descriptors */
+    put32(SPACE_HM2, 0x408, 0x200);	/* offset to pin descriptors */
+    memcpy(&space[SPACE_HM2][0x40c], "MESA", 4);
+    memcpy(&space[SPACE_HM2][0x410], b->name, 4);
+    put32(SPACE_HM2, 0x414, 9);		/* FPGA size */
+    put32(SPACE_HM2, 0x418, 144);	/* FPGA pins */
+    put32(SPACE_HM2, 0x41c, b->ports);
+    put32(SPACE_HM2, 0x420, io_width);
+    put32(SPACE_HM2, 0x424, b->width);
+    put32(SPACE_HM2, 0x428, 100000000);	/* ClockLow */
+    put32(SPACE_HM2, 0x42c, 200000000);	/* ClockHigh */
+    put32(SPACE_HM2, 0x430, 4);		/* instance stride 0 */
+    put32(SPACE_HM2, 0x434, 0x40);	/* instance stride 1 */
+    put32(SPACE_HM2, 0x438, 0x100);	/* register stride 0 */
+    put32(SPACE_HM2, 0x43c, 4);		/* register stride 1 */
+
+    put_md(&md, HM2_GTAG_LED, 0, 1, 1, 0x0200, 1, 0x0000);
+    put_md(&md, HM2_GTAG_WATCHDOG, 0, 1, 1, 0x0c00, 3, 0x0000);
+    put_md(&md, HM2_GTAG_IOPORT, 0, 1, b->ports, 0x1000, 5, 0x001f);
+    put_md(&md, HM2_GTAG_ENCODER, 2, 1, 2, 0x3000, 5, 0x0003);
+    put_md(&md, HM2_GTAG_STEPGEN, 2, 2, nstep, 0x2000, 10, 0x01ff);
+
+    for (i = 0; i < io_width; i++)
+	put_pd(i, 0, 0, 0);
+    for (i = 0; i < 2; i++) {
+	put_pd(3 * i + 0, 1, HM2_GTAG_ENCODER, i);	/* A */
+	put_pd(3 * i + 1, 2, HM2_GTAG_ENCODER, i);	/* B */
+	put_pd(3 * i + 2, 3, HM2_GTAG_ENCODER, i);	/* Index */
+    }
+    for (i = 0; i < nstep; i++) {
+	put_pd(6 + 2 * i, 0x81, HM2_GTAG_STEPGEN, i);	/* Step */
+	put_pd(7 + 2 * i, 0x82, HM2_GTAG_STEPGEN, i);	/* Direction */
+    }
+}
+
+static void init_board(const struct board *b, struct in_addr ip)
+{
+    uint32_t host = ntohl(ip.s_addr);
+    /* Mesa's OUI with the locally administered bit set, which no real
+       board has and tells hm2_eth not to pin it in the ARP table, then
+       the low bytes of the board's address */
+    rtapi_u8 mac[6] = { 0x02, 0x60, 0x1b, host >> 16, host >> 8, host };
+    int i;
+
+    init_hm2(b);
+
+    /* the eeprom stores the MAC address backwards */
+    for (i = 0; i < 6; i++)
+	space[SPACE_EEPROM][2 + i] = mac[5 - i];
+    strncpy((char *) &space[SPACE_EEPROM][0x10], b->name, 16);
+    put16(SPACE_EEPROM, 0x20, host & 0xffff);
+    put16(SPACE_EEPROM, 0x22, host >> 16);
+
+    strncpy((char *) &space[SPACE_INFO][0], b->name, 16);
+    put16(SPACE_INFO, 16, 3);		/* LBP16 version */
+    put16(SPACE_INFO, 18, 0);		/* firmware version */
+}
+
+static int load_image(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    size_t n;
+
+    if (!f) {
+	perror(filename);
+	return -1;
+    }
+    memset(space[SPACE_HM2], 0, SPACE_SIZE);
+    n = fread(space[SPACE_HM2], 1, SPACE_SIZE, f);
+    fclose(f);
+    if (n < 0x200) {
+	fprintf(stderr, "%s: too short for a HostMot2 register file\n",
+	    filename);
+	return -1;
+    }
+    return 0;
+}
+
+/* The watchdog bites, setting bit 0 of its status register, when its
+   reset register was not written within the timeout.  Unlike on a real
+   board, the outputs are left alone. */
+static void watchdog(long long now)
+{
+    uint32_t timer = get32(SPACE_HM2, WD_TIMER);
+
+    /* bit 31 disables it; the timeout counts ClockLow (100 MHz) */
+    if (!wd_armed || (timer & 0x80000000))
+	return;
+    if (now - wd_petted > (timer + 1LL) * 10)
+	put32(SPACE_HM2, WD_STATUS, get32(SPACE_HM2, WD_STATUS) | 1);
+}
+
+/* a write of 'val' to byte 'addr' of the HostMot2 space: writing the
+   timer or 0x5a to the top byte of the reset register pets the dog */
+static void watchdog_write(unsigned int addr, rtapi_u8 val, long long now)
+{
+    if (addr == WD_TIMER + 3) {
+	wd_armed = 1;
+	wd_petted = now;
+    } else if (addr == WD_RESET + 3 && val == 0x5a) {
+	wd_petted = now;
+    }
+}
+
+/* Run the commands in one LBP16 packet, and return the length of the
+   reply, which holds the data of every read in order.  Like the real
+   board, a packet that reads nothing gets no reply.  Writes to the
+   ethernet chip, eeprom, flash and info spaces are ignored. */
+static int run_packet(const rtapi_u8 *pkt, int len, rtapi_u8 *reply)
+{
+    int pos = 0, rlen = 0;
+    long long now = now_ns();
+
+    put16(SPACE_TIMER, 0, now / 1000);	/* uSTimeStampReg */
+    watchdog(now);
+
+    while (pos + LBP16_CMD_SIZE <= len) {
+	unsigned int cmd = pkt[pos] | (pkt[pos + 1] << 8);
+	int sp = (cmd >> 10) & 7;
+	int size = 1 << ((cmd >> 8) & 3);
+	int count = cmd & LBP16_MAX_PACKET_DATA_SIZE;
+	int writable = sp == SPACE_HM2 || sp == SPACE_TIMER
+	    || sp == SPACE_STATUS;
+	unsigned int addr;
+	int i;
+
+	pos += LBP16_CMD_SIZE;
+	if (cmd & LBP16_ADDR) {
+	    if (pos + LBP16_ADDR_SIZE > len)
+		goto bad;
+	    space_addr[sp] = pkt[pos] | (pkt[pos + 1] << 8);
+	    pos += LBP16_ADDR_SIZE;
+	}
+	addr = space_addr[sp];
+
+	if (cmd & LBP16_WRITE) {
+	    if (pos + count * size > len)
+		goto bad;
+	    for (i = 0; i < count * size; i++) {
+		if (writable)
+		    space[sp][(addr + i % size) & 0xffff] = pkt[pos + i];
+		if (sp == SPACE_HM2)
+		    watchdog_write((addr + i % size) & 0xffff, pkt[pos + i],
+			now);
+		if (i % size == size - 1 && (cmd & LBP16_ADDR_AUTO_INC))
+		    addr += size;
+	    }
+	    pos += count * size;
+	} else {
+	    if (rlen + count * size > MAX_PACKET)
+		goto bad;
+	    for (i = 0; i < count * size; i++) {
+		/* the memory area info records are not emulated */
+		reply[rlen + i] = (cmd & LBP16_INFO_ACC) ? 0
+		    : space[sp][(addr + i % size) & 0xffff];
+		if (i % size == size - 1 && (cmd & LBP16_ADDR_AUTO_INC))
+		    addr += size;
+	    }
+	    rlen += count * size;
+	}
+	space_addr[sp] = addr & 0xffff;
+    }
+    if (pos == len)
+	return rlen;
+  bad:
+    parse_errors++;
+    count16(SPACE_STATUS, STATUS_PARSE_ERRORS);
+    return rlen;
+}
+
+static void answer(int sock, struct pending *p)
+{
+    static uint32_t last_write_count;
+    rtapi_u8 reply[MAX_PACKET];
+    int rlen = run_packet(p->data, p->len, reply);
+    uint32_t write_count = get32(SPACE_TIMER, TIMER_WRITE_COUNT);
+
+    if (write_count != last_write_count) {
+	last_write_count = write_count;
+	cycles++;
+    }
+    if (rlen == 0 || p->drop_reply)
+	return;
+    if (sendto(sock, reply, rlen, 0, (struct sockaddr *) &p->from,
+	    sizeof(p->from)) < 0) {
+	perror("sendto");
+	return;
+    }
+    tx_packets++;
+    count16(SPACE_STATUS, STATUS_TX_PACKETS);
+    count16(SPACE_STATUS, STATUS_TX_UDP);
+}
+
+static void receive(int sock)
+{
+    static long long last_due;
+
+    while (1) {
+	struct pending *p = &pending[pending_head];
+	socklen_t fromlen = sizeof(p->from);
+	int next = (pending_head + 1) % MAX_PENDING;
+	long long due;
+	int len = recvfrom(sock, p->data, sizeof(p->data), MSG_DONTWAIT,
+	    (struct sockaddr *) &p->from, &fromlen);
+
+	if (len < 0)
+	    return;
+	rx_packets++;
+	count16(SPACE_STATUS, STATUS_RX_PACKETS);
+	count16(SPACE_STATUS, STATUS_RX_UDP);
+
+	p->drop_reply = 0;
+	if (loss > 0 && random_fraction() < loss) {
+	    /* half of the losses are of the request, the rest of the
+	       reply, which leaves any writes in the request done */
+	    dropped++;
+	    if (random_fraction() < 0.5)
+		continue;
+	    p->drop_reply = 1;
+	}
+	if (next == pending_tail) {
+	    overflows++;
+	    continue;
+	}
+	due = now_ns() + latency;
+	if (jitter)
+	    due += jitter * random_fraction();
+	if (due < last_due)
+	    due = last_due;
+	last_due = due;
+	p->due = due;
+	p->len = len;
+	pending_head = next;
+    }
+}
+
+static void print_stats(double seconds)
+{
+    fprintf(stderr, "%.1fs: %lu requests, %lu replies, %lu lost, "
+	"%lu servo cycles (%.2f requests/cycle)",
+	seconds, rx_packets, tx_packets, dropped, cycles,
+	cycles ? (double) rx_packets / cycles : 0.0);
+    if (overflows)
+	fprintf(stderr, ", %lu overflows", overflows);
+    if (parse_errors)
+	fprintf(stderr, ", %lu parse errors", parse_errors);
+    fprintf(stderr, "\n");
+}
+
+static int serve(int sock, double stats_interval)
+{
+    long long start = now_ns();
+    long long next_stats = start + stats_interval * 1e9;
+
+    while (!stop) {
+	struct pollfd pfd = { sock, POLLIN, 0 };
+	struct timespec ts, *tsp = NULL;
+	long long now = now_ns(), wait = -1;
+
+	if (pending_tail != pending_head)
+	    wait = pending[pending_tail].due - now;
+	if (stats_interval > 0 && (wait < 0 || next_stats - now < wait))
+	    wait = next_stats - now;
+	if (wait >= 0) {
+	    if (wait < SPIN_NS)
+		wait = 0;
+	    ns_to_timespec(wait, &ts);
+	    tsp = &ts;
+	}
+	if (ppoll(&pfd, 1, tsp, NULL) < 0 && errno != EINTR) {
+	    perror("ppoll");
+	    return 1;
+	}
+	if (pfd.revents & POLLIN)
+	    receive(sock);
+
+	now = now_ns();
+	while (pending_tail != pending_head
+	    && pending[pending_tail].due <= now) {
+	    answer(sock, &pending[pending_tail]);
+	    pending_tail = (pending_tail + 1) % MAX_PENDING;
+	}
+	if (stats_interval > 0 && now >= next_stats) {
+	    print_stats((now - start) * 1e-9);
+	    next_stats += stats_interval * 1e9;
+	}
+    }
+    print_stats((now_ns() - start) * 1e-9);
+    return 0;
+}
+
+/***********************************************************************
+*                         BENCHMARK CLIENT                             *
+************************************************************************/
+
+/* Append LBP16 commands to 'pkt' at 'pos' for 'bytes' of consecutive
+   HostMot2 registers, as many commands as the 127 word limit needs. */
+static int put_hm2_cmds(rtapi_u8 *pkt, int pos, int write,
+    unsigned int addr, const rtapi_u8 *data, int bytes)
+{
+    while (bytes > 0) {
+	int words = bytes / 4, cmd;
+	if (words > LBP16_MAX_PACKET_DATA_SIZE)
+	    words = LBP16_MAX_PACKET_DATA_SIZE;
+	cmd = write ? CMD_WRITE_HOSTMOT2_ADDR32_INCR(words)
+	    : CMD_READ_HOSTMOT2_ADDR32_INCR(words);
+	LBP16_INIT_PACKET4(*(lbp16_cmd_addr *) (pkt + pos), cmd, addr);
+	pos += sizeof(lbp16_cmd_addr);
+	if (write) {
+	    memcpy(pkt + pos, data, words * 4);
+	    pos += words * 4;
+	    data += words * 4;
+	}
+	addr += words * 4;
+	bytes -= words * 4;
+    }
+    return pos;
+}
+
+static int compare_ll(const void *a, const void *b)
+{
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile(long long *v, long n, double p)
+{
+    long i = (long) (p * (n - 1) + 0.5);
+    return v[i] * 1e-3;
+}
+
+/* the packet hm2_eth sends for a cycle's reads: the TRAM reads, then
+   the receive counter and the read number handshake in the timer space.
+   'pos' bytes of writes already in 'pkt' go out in front of them. */
+static int send_reads(int sock, rtapi_u8 *pkt, int pos, int read_bytes,
+    unsigned int hm2addr, uint32_t read_cnt)
+{
+    pos = put_hm2_cmds(pkt, pos, 0, hm2addr, NULL, read_bytes);
+
+    LBP16_INIT_PACKET4(*(lbp16_cmd_addr *) (pkt + pos),
+	CMD_READ_COMM_CTRL_ADDR16(1), STATUS_RX_PACKETS);
+    pos += sizeof(lbp16_cmd_addr);
+    LBP16_INIT_PACKET4(*(lbp16_cmd_addr *) (pkt + pos),
+	CMD_WRITE_TIMER_ADDR16_INCR(2), 0x10);
+    pos += sizeof(lbp16_cmd_addr);
+    memcpy(pkt + pos, &read_cnt, 4);
+    pos += 4;
+    LBP16_INIT_PACKET4(*(lbp16_cmd_addr *) (pkt + pos),
+	CMD_READ_TIMER_ADDR16_INCR(4), 0x10);
+    pos += sizeof(lbp16_cmd_addr);
+    if (pos > MAX_PACKET) {
+	fprintf(stderr, "packet of %d bytes is too large\n", pos);
+	return -1;
+    }
+    if (send(sock, pkt, pos, 0) < 0) {
+	perror("send");
+	return -1;
+    }
+    return 0;
+}
+
+/* Receive a packet without waiting, or with -U, waiting as hm2_eth's
+   busy_poll does, and note how long after the kernel got it. */
+static int recv_stamped(int sock, rtapi_u8 *reply)
+{
+    char control[CMSG_SPACE(sizeof(struct timespec))];
+    struct iovec iov = { reply, MAX_PACKET };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1,
+	.msg_control = control, .msg_controllen = sizeof(control) };
+    struct cmsghdr *cmsg;
+    struct timespec stamp, now;
+    long long delay;
+    int len;
+
+    len = recvmsg(sock, &msg, busy_poll ? 0 : MSG_DONTWAIT);
+    if (len < 0)
+	return len;
+    clock_gettime(CLOCK_REALTIME, &now);
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	if (cmsg->cmsg_level == SOL_SOCKET
+	    && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+	    memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+	    delay = (now.tv_sec - stamp.tv_sec) * 1000000000LL
+		+ now.tv_nsec - stamp.tv_nsec;
+	    rx_delay_sum += delay;
+	    if (delay > rx_delay_max)
+		rx_delay_max = delay;
+	    rx_delay_count++;
+	}
+    return len;
+}
+
+/* Wait until 'deadline' for the reply to read number 'read_cnt',
+   skipping late replies to earlier ones.  Returns 1 if it came. */
+static int wait_reply(int sock, rtapi_u8 *reply, int expect,
+    uint32_t read_cnt, long long deadline, long *received, long *stale)
+{
+    long long t = now_ns();
+
+    do {
+	/* sleep rather than spin, so that an emulator on the same
+	   cpu gets to answer, unless busy polling */
+	struct pollfd pfd = { sock, POLLIN, 0 };
+	struct timespec ts;
+	uint32_t confirm;
+	int len;
+
+	if (deadline > t && !busy_poll) {
+	    ns_to_timespec(deadline - t, &ts);
+	    ppoll(&pfd, 1, &ts, NULL);
+	}
+	len = recv_stamped(sock, reply);
+	t = now_ns();
+	if (len < 0)
+	    continue;
+	(*received)++;
+	if (len == expect) {
+	    memcpy(&confirm, reply + expect - 8, 4);
+	    if (confirm == read_cnt)
+		return 1;
+	}
+	(*stale)++;
+    } while (t < deadline);
+    return 0;
+}
+
+/* Do what hm2_eth does in each servo cycle: one packet with the reads
+   whose reply is waited for, then one packet with the writes and the
+   write number.  With 'pipelined', the next cycle's reads are sent
+   right after the writes, as with hm2_eth's read-pipeline, and the
+   read only waits (sending the request again) if the reply is not
+   there yet, and with 'combined' as well, the writes and the next
+   cycle's reads go out in one packet.  The writes put back the register values just read, so
+   they are harmless on a real board as long as the registers read
+   back what was written. */
+static int benchmark(int sock, long long period, long ncycles,
+    int read_bytes, int write_bytes, unsigned int hm2addr,
+    long long timeout, int pipelined, int combined)
+{
+    rtapi_u8 pkt[2 * MAX_PACKET], reply[MAX_PACKET];
+    long long *wait = malloc(ncycles * sizeof(*wait));
+    long long start, next, sent = 0, sum = 0;
+    long long stale_sum = 0, stale_max = 0, send_sum = 0;
+    long n, k, nwait = 0, lost = 0, stale = 0, received = 0;
+    long packets = 0, fallbacks = 0;
+    long board_packets = 0, board_cycles = 0;
+    int have_board_count = 0, requested = 0;
+    unsigned int last_board_count = 0;
+    uint32_t read_cnt = 0, write_cnt = 0;
+    int expect = read_bytes + 2 + 8;
+
+    if (!wait) {
+	fprintf(stderr, "out of memory\n");
+	return 1;
+    }
+
+    start = next = now_ns();
+    for (k = 0; k < ncycles && !stop; k++) {
+	long long t0 = now_ns(), t1;
+	int pos, ok = 0;
+
+	next += period;
+
+	/* the reads */
+	if (requested) {
+	    ok = wait_reply(sock, reply, expect, read_cnt, t0,
+		&received, &stale);
+	    if (!ok)
+		fallbacks++;
+	}
+	if (!ok) {
+	    read_cnt++;
+	    if (send_reads(sock, pkt, 0, read_bytes, hm2addr, read_cnt) < 0)
+		break;
+	    packets++;
+	    sent = now_ns();
+	    ok = wait_reply(sock, reply, expect, read_cnt, sent + timeout,
+		&received, &stale);
+	}
+	requested = 0;
+	t1 = now_ns();
+
+	if (ok) {
+	    unsigned int board_count = reply[read_bytes]
+		| (reply[read_bytes + 1] << 8);
+	    wait[nwait++] = t1 - t0;
+	    sum += t1 - t0;
+	    stale_sum += t1 - sent;
+	    if (t1 - sent > stale_max)
+		stale_max = t1 - sent;
+	    if (have_board_count) {
+		board_packets += (board_count - last_board_count) & 0xffff;
+		board_cycles++;
+	    }
+	    last_board_count = board_count;
+	    have_board_count = 1;
+	} else {
+	    lost++;
+	    have_board_count = 0;
+	}
+
+	/* the writes, which are not answered */
+	t1 = now_ns();
+	write_cnt++;
+	pos = 0;
+	if (ok)
+	    pos = put_hm2_cmds(pkt, 0, 1, hm2addr, reply, write_bytes);
+	LBP16_INIT_PACKET4(*(lbp16_cmd_addr *) (pkt + pos),
+	    CMD_WRITE_TIMER_ADDR16_INCR(2), TIMER_WRITE_COUNT);
+	pos += sizeof(lbp16_cmd_addr);
+	memcpy(pkt + pos, &write_cnt, 4);
+	pos += 4;
+	if (!combined) {
+	    if (send(sock, pkt, pos, 0) < 0) {
+		perror("send");
+		break;
+	    }
+	    packets++;
+	    pos = 0;
+	}
+
+	if (pipelined) {
+	    read_cnt++;
+	    if (send_reads(sock, pkt, pos, read_bytes, hm2addr, read_cnt) < 0)
+		break;
+	    packets++;
+	    sent = now_ns();
+	    requested = 1;
+	}
+	send_sum += now_ns() - t1;
+
+	if (next > now_ns()) {
+	    struct timespec ts;
+	    ns_to_timespec(next, &ts);
+	    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	} else {
+	    next = now_ns();	/* overran, do not try to catch up */
+	}
+    }
+    n = k;
+
+    printf("%ld cycles in %.3f s, period %.1f us, %d bytes read and "
+	"%d written per cycle%s\n", n, (now_ns() - start) * 1e-9,
+	period * 1e-3, read_bytes, write_bytes,
+	combined ? ", pipelined and combined" :
+	pipelined ? ", pipelined" : "");
+    if (nwait) {
+	qsort(wait, nwait, sizeof(*wait), compare_ll);
+	printf("%s: min %.1f us, mean %.1f us, 50%% %.1f us, "
+	    "99%% %.1f us, 99.9%% %.1f us, max %.1f us\n",
+	    pipelined ? "read wait" : "round trip",
+	    wait[0] * 1e-3, sum * 1e-3 / nwait, percentile(wait, nwait, .5),
+	    percentile(wait, nwait, .99), percentile(wait, nwait, .999),
+	    wait[nwait - 1] * 1e-3);
+	if (pipelined)
+	    printf("staleness: mean %.1f us, max %.1f us, "
+		"fallbacks %ld\n", stale_sum * 1e-3 / nwait,
+		stale_max * 1e-3, fallbacks);
+    }
+    if (n)
+	printf("sending writes%s: mean %.1f us\n",
+	    pipelined ? " and next reads" : "", send_sum * 1e-3 / n);
+    if (rx_delay_count)
+	printf("receive delay%s: mean %.1f us, max %.1f us\n",
+	    busy_poll ? " (busy polling)" : "",
+	    rx_delay_sum * 1e-3 / rx_delay_count, rx_delay_max * 1e-3);
+    printf("lost replies %ld, stale replies %ld\n", lost, stale);
+    if (n)
+	printf("packets per cycle: sent %.2f, received %.2f, "
+	    "seen by board %.2f\n", (double) packets / n,
+	    (double) received / n,
+	    board_cycles ? (double) board_packets / board_cycles : 0.0);
+    free(wait);
+    return 0;
+}
+
+/***********************************************************************
+*                            MAIN PROGRAM                              *
+************************************************************************/
+
+int main(int argc, char **argv)
+{
+    const char *addr = "127.0.0.1", *board = "7I92", *image = NULL;
+    const struct board *b = NULL;
+    int bench = 0, pipelined = 0, combined = 0, read_bytes = 256, write_bytes = 128;
+    long long period = 1000000, timeout = -1;
+    long ncycles = 10000;
+    unsigned int hm2addr = 0x400;
+    double stats_interval = 0;
+    struct sockaddr_in sa;
+    int sock, i;
+
+    while (1) {
+	int c = getopt(argc, argv, "ha:b:L:J:l:s:i:S:BPCp:n:r:w:A:t:U:");
+	if (c == -1)
+	    break;
+	switch (c) {
+	case 'a':
+	    addr = optarg;
+	    break;
+	case 'b':
+	    board = optarg;
+	    break;
+	case 'L':
+	    latency = atof(optarg) * 1000;
+	    break;
+	case 'J':
+	    jitter = atof(optarg) * 1000;
+	    break;
+	case 'l':
+	    loss = atof(optarg) / 100;
+	    break;
+	case 's':
+	    rng_state = strtoull(optarg, NULL, 0) | 1;
+	    break;
+	case 'i':
+	    image = optarg;
+	    break;
+	case 'S':
+	    stats_interval = atof(optarg);
+	    break;
+	case 'B':
+	    bench = 1;
+	    break;
+	case 'P':
+	    pipelined = 1;
+	    break;
+	case 'C':
+	    pipelined = combined = 1;
+	    break;
+	case 'p':
+	    period = atof(optarg) * 1000;
+	    break;
+	case 'n':
+	    ncycles = atol(optarg);
+	    break;
+	case 'r':
+	    read_bytes = atoi(optarg) & ~3;
+	    break;
+	case 'w':
+	    write_bytes = atoi(optarg) & ~3;
+	    break;
+	case 'A':
+	    hm2addr = strtoul(optarg, NULL, 0) & ~3;
+	    break;
+	case 't':
+	    timeout = atof(optarg) * 1000;
+	    break;
+	case 'U':
+	    busy_poll = atoi(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    return 0;
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    if (optind != argc) {
+	usage();
+	return 1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(LBP16_UDP_PORT);
+    if (!inet_aton(addr, &sa.sin_addr)) {
+	fprintf(stderr, "%s: not an IPv4 address\n", addr);
+	return 1;
+    }
+
+    signal(SIGINT, quit);
+    signal(SIGTERM, quit);
+    /* both modes want short waits to be short, and to not be paged */
+    prctl(PR_SET_TIMERSLACK, 1);
+    mlockall(MCL_CURRENT | MCL_FUTURE);
+
+    sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+	perror("socket");
+	return 1;
+    }
+
+    if (bench) {
+	if (read_bytes < 0 || read_bytes > 1024 || write_bytes < 0
+	    || write_bytes > read_bytes || period <= 0 || ncycles <= 0) {
+	    fprintf(stderr, "hm2_eth_emu: -r must be at most 1024 bytes, "
+		"-w at most -r, and -p and -n positive\n");
+	    return 1;
+	}
+	if (timeout < 0)
+	    timeout = period;
+	if (connect(sock, (struct sockaddr *) &sa, sizeof(sa)) < 0) {
+	    perror("connect");
+	    return 1;
+	}
+	i = 1;
+	setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &i, sizeof(i));
+	if (busy_poll > 0) {
+	    /* the same short blocking receive as hm2_eth */
+	    struct timeval tv = { 0, 10 };
+	    if (setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &busy_poll,
+		    sizeof(busy_poll)) < 0) {
+		perror("SO_BUSY_POLL");
+		return 1;
+	    }
+	    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	}
+	return benchmark(sock, period, ncycles, read_bytes, write_bytes,
+	    hm2addr, timeout, pipelined, combined);
+    }
+
+    for (i = 0; i < sizeof(boards) / sizeof(boards[0]); i++)
+	if (strcasecmp(board, boards[i].name) == 0)
+	    b = &boards[i];
+    if (!b) {
+	fprintf(stderr, "hm2_eth_emu: unknown board '%s', one of:", board);
+	for (i = 0; i < sizeof(boards) / sizeof(boards[0]); i++)
+	    fprintf(stderr, " %s", boards[i].name);
+	fprintf(stderr, "\n");
+	return 1;
+    }
+    init_board(b, sa.sin_addr);
+    if (image && load_image(image) < 0)
+	return 1;
+
+    if (bind(sock, (struct sockaddr *) &sa, sizeof(sa)) < 0) {
+	fprintf(stderr, "hm2_eth_emu: bind %s:%d: %s\n", addr,
+	    LBP16_UDP_PORT, strerror(errno));
+	return 1;
+    }
+    fprintf(stderr, "hm2_eth_emu: %s listening on %s:%d\n", b->name,
+	addr, LBP16_UDP_PORT);
+    return serve(sock, stats_interval);
+}
@@ -283,15 +283,6 @@ void start_capture(void)
 		chan->data_len = 0;
 		break;
 	    }
-	    /* point at pin data */
-	    if (pin->signal == 0) {
-		/* pin is unlinked, get data from dummysig */
-		ctrl_shm->data_offset[n] = SHMOFF(&(pin->dummysig));
-	    } else {
-		/* pin is linked to a signal */
-		sig = SHMPTR(pin->signal);
-		ctrl_shm->data_offset[n] = sig->data_ptr;
-	    }
 	} else if ( chan->data_source_type == 1 ) {
 	    /* channel source is a signal, point at it */
 	    sig = SHMPTR(chan->data_source);
@@ -302,7 +293,6 @@ void start_capture(void)
 		chan->data_len = 0;
 		break;
 	    }
-	    ctrl_shm->data_offset[n] = sig->data_ptr;
 	} else if ( chan->data_source_type == 2 ) {
 	    /* channel source is a parameter, point at it */
 	    param = SHMPTR(chan->data_source);
@@ -313,11 +303,14 @@ void start_capture(void)
 		chan->data_len = 0;
 		break;
 	    }
-	    ctrl_shm->data_offset[n] = param->data_ptr;
 	} else {
 	    /* channel source is invalid */
 	    chan->data_len = 0;
 	}
+	/* the realtime code finds the data from the source, as signal
+	   data may move while it samples */
+	ctrl_shm->data_source_type[n] = chan->data_source_type;
+	ctrl_shm->data_source[n] = chan->data_source;
 	/* set data type */
 	ctrl_shm->data_type[n] = chan->data_type;
 	/* set data length - zero means don't sample */
@@ -328,6 +321,7 @@ void start_capture(void)
 	}
     }
     ctrl_shm->pre_trig = (ctrl_shm->rec_len-2) * ctrl_usr->trig.position;
+    ctrl_shm->stream = 0;
     ctrl_shm->state = INIT;
 }
 
@@ -103,8 +103,10 @@ static gint horiz_motion(GtkWidget *widget, GdkEventMotion *event);
 
 void init_horiz(void)
 {
-    /* stop sampling */
+    /* stop sampling, including a stream a killed halscope-record left */
     ctrl_shm->state = IDLE;
+    ctrl_shm->stream = 0;
+    ctrl_shm->stream_pid = 0;
     /* init non-zero members of the horizontal structure */
     /* set up the window */
     init_horiz_window();
@@ -286,11 +288,12 @@ void refresh_state_info(void)
 	"TRIGGER?",
 	"TRIGGERED",
 	"DONE",
-	"RESET"
+	"RESET",
+	"STREAM"
     };
 
     horiz = &(ctrl_usr->horiz);
-    if (ctrl_shm->state > RESET) {
+    if (ctrl_shm->state > STREAM) {
 	ctrl_shm->state = IDLE;
     }
     gtk_label_set_text_if(horiz->state_label, state_names[ctrl_shm->state]);
@@ -0,0 +1,649 @@
+/** This file, 'scope_record.c', is 'halscope-record', a command line
+    companion to halscope.  It uses the realtime part of the scope
+    (scope_rt) in its continuous STREAM mode, where the sample buffer
+    is a ring that this program empties while the scope keeps running,
+    and writes every sample to a file.
+
+    Invoking:
+
+    halscope-record -t thread [-m mult] [-s num_samples]
+                    [-T chan [-l level] [-f] [-b seconds] [-a seconds]]
+                    [-d seconds] [-o file] item...
+
+    Each 'item' is the name of a pin, signal or parameter to record, up
+    to 16 of them.
+
+    Without '-T', samples are written until the program is stopped
+    (or for '-d' seconds).  With '-T', the program waits for the
+    trigger channel to cross 'level' (rising, or falling with '-f'),
+    then writes the '-b' seconds before and the '-a' seconds after the
+    trigger, and exits.  Both windows may be minutes long; the
+    pre-trigger window is kept in memory.
+
+    If the output file name ends in '.gz' it is compressed with gzip.
+    The file format is read by the Python module 'halscope_record'.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111 USA
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>		/* getopt() */
+#include <stdint.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "../hal_priv.h"	/* HAL private API decls */
+#include "rtapi_atomic.h"
+#include "scope_shm.h"		/* scope shared memory layout */
+
+/***********************************************************************
+*                         LOCAL VARIABLES                              *
+************************************************************************/
+
+static int comp_id = -1;	/* -1 means hal_init() not called yet */
+static int shm_id = -1;
+static scope_shm_control_t *ctrl_shm;
+static scope_data_t *buffer;	/* the ring, right after ctrl_shm */
+static int linked;		/* scope.sample was added to a thread */
+
+static int nchan;
+static char *chan_name[16];
+static hal_type_t chan_type[16];
+static int rec_size;		/* bytes per sample in the file */
+
+static sig_atomic_t stop;
+static FILE *out;
+static unsigned int gaps_seen;	/* gaps of the stream already counted */
+
+/* the pre-trigger window: 'pre_len' samples as written to the file,
+   each with the number of samples lost just before it */
+static unsigned char *pre_data;
+static unsigned int *pre_lost;
+static long pre_len, pre_count, pre_next;
+
+/***********************************************************************
+*                         LOCAL FUNCTIONS                              *
+************************************************************************/
+
+static void quit(int sig)
+{
+    stop = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"Usage: halscope-record -t thread [-m mult] [-s num_samples]\n"
+	"           [-T chan [-l level] [-f] [-b seconds] [-a seconds]]\n"
+	"           [-d seconds] [-o file] item...\n");
+}
+
+static const char *type_name(hal_type_t type)
+{
+    switch (type) {
+    case HAL_BIT:
+	return "bit";
+    case HAL_FLOAT:
+	return "float";
+    case HAL_S32:
+	return "s32";
+    case HAL_U32:
+	return "u32";
+    default:
+	return "?";
+    }
+}
+
+static int type_size(hal_type_t type)
+{
+    switch (type) {
+    case HAL_BIT:
+	return 1;
+    case HAL_FLOAT:
+	return 8;
+    default:
+	return 4;
+    }
+}
+
+/* point channel 'n' at the pin, signal or parameter 'name', as
+   halscope's start_capture() does */
+static int setup_channel(int n, char *name)
+{
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    hal_param_t *param;
+    int source, source_type;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    if ((pin = halpr_find_pin_by_name(name)) != 0) {
+	chan_type[n] = pin->type;
+	source = SHMOFF(pin);
+	source_type = 0;
+    } else if ((sig = halpr_find_sig_by_name(name)) != 0) {
+	chan_type[n] = sig->type;
+	source = SHMOFF(sig);
+	source_type = 1;
+    } else if ((param = halpr_find_param_by_name(name)) != 0) {
+	chan_type[n] = param->type;
+	source = SHMOFF(param);
+	source_type = 2;
+    } else {
+	rtapi_mutex_give(&(hal_data->mutex));
+	fprintf(stderr, "ERROR: no pin, signal or parameter '%s'\n", name);
+	return -1;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    chan_name[n] = name;
+    ctrl_shm->data_source[n] = source;
+    ctrl_shm->data_source_type[n] = source_type;
+    ctrl_shm->data_type[n] = chan_type[n];
+    switch (chan_type[n]) {
+    case HAL_BIT:
+	ctrl_shm->data_len[n] = sizeof(hal_bit_t);
+	break;
+    case HAL_FLOAT:
+	ctrl_shm->data_len[n] = sizeof(hal_float_t);
+	break;
+    default:
+	ctrl_shm->data_len[n] = sizeof(hal_s32_t);
+	break;
+    }
+    return 0;
+}
+
+/* convert one sample from the ring to file layout */
+static void pack_sample(unsigned char *dest, scope_data_t *src)
+{
+    int n;
+
+    for (n = 0; n < nchan; n++) {
+	switch (chan_type[n]) {
+	case HAL_BIT:
+	    *dest = src[n].d_u8 != 0;
+	    break;
+	case HAL_FLOAT:
+	    memcpy(dest, &(src[n].d_real), 8);
+	    break;
+	case HAL_S32:
+	    memcpy(dest, &(src[n].d_s32), 4);
+	    break;
+	default:
+	    memcpy(dest, &(src[n].d_u32), 4);
+	    break;
+	}
+	dest += type_size(chan_type[n]);
+    }
+}
+
+/* the trigger test of scope_rt's check_trigger(), on a packed sample */
+static int trigger_state(unsigned char *rec, int chan, double level)
+{
+    int n;
+    double f;
+    int32_t s;
+    uint32_t u;
+
+    for (n = 0; n < chan; n++) {
+	rec += type_size(chan_type[n]);
+    }
+    switch (chan_type[chan]) {
+    case HAL_BIT:
+	return *rec != 0;
+    case HAL_FLOAT:
+	memcpy(&f, rec, 8);
+	return f > level;
+    case HAL_S32:
+	memcpy(&s, rec, 4);
+	return s > level;
+    default:
+	memcpy(&u, rec, 4);
+	return u > level;
+    }
+}
+
+static void write_header(long period, long trigger)
+{
+    int n;
+
+    fprintf(out, "halscope-record 1\n");
+    fprintf(out, "thread %s\n", ctrl_shm->thread_name);
+    fprintf(out, "period %ld\n", period);
+    fprintf(out, "trigger %ld\n", trigger);
+    for (n = 0; n < nchan; n++) {
+	fprintf(out, "channel %s %s\n", type_name(chan_type[n]), chan_name[n]);
+    }
+    fprintf(out, "data\n");
+}
+
+/* samples follow in blocks, each starting with two 32 bit words: the
+   number of samples in the block, and the number of samples that were
+   lost between the previous block and this one */
+static void write_block(unsigned char *data, uint32_t count, uint32_t lost)
+{
+    uint32_t hdr[2];
+
+    if (count == 0 && lost == 0) {
+	return;
+    }
+    hdr[0] = count;
+    hdr[1] = lost;
+    fwrite(hdr, sizeof(hdr), 1, out);
+    fwrite(data, rec_size, count, out);
+}
+
+/* the number of samples scope_rt dropped just before sample 'index' of
+   the stream, which the caller is about to read */
+static unsigned int lost_before(unsigned int index)
+{
+    unsigned int gaps, n, lost = 0;
+
+    gaps = atomic_load_explicit(&ctrl_shm->gaps, memory_order_acquire);
+    if (gaps - gaps_seen > SCOPE_STREAM_GAPS) {
+	/* can't happen, see SCOPE_STREAM_GAPS */
+	gaps_seen = gaps - SCOPE_STREAM_GAPS;
+    }
+    while (gaps_seen != gaps) {
+	n = gaps_seen % SCOPE_STREAM_GAPS;
+	if (ctrl_shm->gap_head[n] != index) {
+	    break;
+	}
+	/* sample 'index' exists, so this gap has ended */
+	lost += ctrl_shm->gap_lost[n];
+	gaps_seen++;
+    }
+    return lost;
+}
+
+static void pre_store(unsigned char *rec, unsigned int lost)
+{
+    memcpy(pre_data + pre_next * rec_size, rec, rec_size);
+    pre_lost[pre_next] = lost;
+    if (++pre_next == pre_len) {
+	pre_next = 0;
+    }
+    if (pre_count < pre_len) {
+	pre_count++;
+    }
+}
+
+/* sample periods from the oldest sample in the pre-trigger window to
+   the newest (the trigger), counting the samples lost in between */
+static long pre_span(void)
+{
+    long n, first, span;
+
+    first = (pre_next - pre_count + pre_len) % pre_len;
+    span = pre_count - 1;
+    for (n = 1; n < pre_count; n++) {
+	span += pre_lost[(first + n) % pre_len];
+    }
+    return span;
+}
+
+/* write the pre-trigger window, oldest first, split where samples
+   were lost */
+static void pre_flush(void)
+{
+    long n, first, i, len;
+
+    first = (pre_next - pre_count + pre_len) % pre_len;
+    n = 0;
+    while (n < pre_count) {
+	i = (first + n) % pre_len;
+	/* extend the block up to the next gap or the end of the ring */
+	len = 1;
+	while (n + len < pre_count && i + len < pre_len
+	    && pre_lost[i + len] == 0) {
+	    len++;
+	}
+	write_block(pre_data + i * rec_size, len, pre_lost[i]);
+	n += len;
+    }
+}
+
+/* a recorder that was killed leaves the scope streaming into its thread;
+   returns nonzero if that is what is using the scope, after stopping it */
+static int take_over_stale(void)
+{
+    if (ctrl_shm->stream_pid == 0 || kill(ctrl_shm->stream_pid, 0) == 0
+	|| errno != ESRCH) {
+	return 0;
+    }
+    ctrl_shm->state = RESET;
+    ctrl_shm->stream = 0;
+    ctrl_shm->stream_pid = 0;
+    if (ctrl_shm->thread_name[0] != '\0') {
+	hal_del_funct_from_thread("scope.sample", ctrl_shm->thread_name);
+	ctrl_shm->thread_name[0] = '\0';
+    }
+    /* let scope_rt go through RESET, if its thread runs */
+    usleep(100000);
+    ctrl_shm->state = IDLE;
+    return 1;
+}
+
+static void cleanup(void)
+{
+    if (ctrl_shm) {
+	ctrl_shm->state = RESET;
+	ctrl_shm->stream = 0;
+	ctrl_shm->stream_pid = 0;
+	if (linked) {
+	    hal_del_funct_from_thread("scope.sample", ctrl_shm->thread_name);
+	    ctrl_shm->thread_name[0] = '\0';
+	    /* scope.sample no longer runs to go through RESET */
+	    ctrl_shm->state = IDLE;
+	}
+    }
+    if (shm_id >= 0) {
+	rtapi_shmem_delete(shm_id, comp_id);
+    }
+    if (comp_id >= 0) {
+	hal_exit(comp_id);
+    }
+}
+
+/***********************************************************************
+*                            MAIN PROGRAM                              *
+************************************************************************/
+
+int main(int argc, char **argv)
+{
+    char *thread_name = 0, *ofilename = 0;
+    int mult = 1, num_samples = SCOPE_NUM_SAMPLES_DEFAULT;
+    int trig_chan = 0, falling = 0;
+    double level = 0.0, before = 0.0, after = 0.0, duration = 0.0;
+    int n, exitval = 1;
+    char comp_name[HAL_NAME_LEN + 1];
+    hal_thread_t *thread;
+    void *shm_base;
+    long period, post_len = -1, skip, block_len;
+    unsigned long shm_size;
+    unsigned int head, tail, lost_seen = 0, lost, gap = 0;
+    int pos;
+    int prev_state = -1, triggered = 0, compress = 0, done;
+    unsigned char *block, *rec;
+    size_t len;
+
+    while (1) {
+	int c = getopt(argc, argv, "ht:m:s:T:l:fb:a:d:o:");
+	if (c == -1) break;
+	switch (c) {
+	case 't':
+	    thread_name = optarg;
+	    break;
+	case 'm':
+	    mult = atoi(optarg);
+	    break;
+	case 's':
+	    num_samples = atoi(optarg);
+	    break;
+	case 'T':
+	    trig_chan = atoi(optarg);
+	    break;
+	case 'l':
+	    level = atof(optarg);
+	    break;
+	case 'f':
+	    falling = 1;
+	    break;
+	case 'b':
+	    before = atof(optarg);
+	    break;
+	case 'a':
+	    after = atof(optarg);
+	    break;
+	case 'd':
+	    duration = atof(optarg);
+	    break;
+	case 'o':
+	    ofilename = optarg;
+	    break;
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    nchan = argc - optind;
+    if (!thread_name || nchan < 1 || nchan > 16 || mult < 1
+	|| trig_chan < 0 || trig_chan > nchan) {
+	usage();
+	return 1;
+    }
+
+    signal(SIGINT, quit);
+    signal(SIGTERM, quit);
+    signal(SIGPIPE, quit);
+
+    /* connect to the HAL and to scope_rt, loading it if needed; the
+       name is unique, a killed recorder leaves its component behind */
+    snprintf(comp_name, sizeof(comp_name), "halscope-record%d", getpid());
+    comp_id = hal_init(comp_name);
+    if (comp_id < 0) {
+	fprintf(stderr, "ERROR: hal_init() failed: %d\n", comp_id);
+	return 1;
+    }
+    if (!halpr_find_funct_by_name("scope.sample")) {
+	char buf[1000];
+	snprintf(buf, sizeof(buf),
+	    EMC2_BIN_DIR "/halcmd loadrt scope_rt num_samples=%d",
+	    num_samples);
+	if (system(buf) != 0) {
+	    fprintf(stderr, "ERROR: loadrt scope_rt failed\n");
+	    goto out;
+	}
+    }
+    shm_id = rtapi_shmem_new(SCOPE_SHM_KEY, comp_id, sizeof(scope_shm_control_t));
+    if (shm_id < 0 || rtapi_shmem_getptr(shm_id, &shm_base) < 0) {
+	fprintf(stderr, "ERROR: failed to map scope shared memory\n");
+	goto out;
+    }
+    hal_ready(comp_id);
+    /* now that we know its real size, map the whole area */
+    shm_size = ((scope_shm_control_t *) shm_base)->shm_size;
+    rtapi_shmem_delete(shm_id, comp_id);
+    shm_id = rtapi_shmem_new(SCOPE_SHM_KEY, comp_id, shm_size);
+    if (shm_id < 0 || rtapi_shmem_getptr(shm_id, &shm_base) < 0) {
+	fprintf(stderr, "ERROR: failed to map scope shared memory\n");
+	goto out;
+    }
+    ctrl_shm = shm_base;
+    skip = (sizeof(scope_shm_control_t) + 3) & ~3;
+    buffer = (scope_data_t *) (((char *) shm_base) + skip);
+    if ((ctrl_shm->thread_name[0] != '\0' || ctrl_shm->state != IDLE)
+	&& !take_over_stale()) {
+	fprintf(stderr, "ERROR: the scope is in use (is halscope running?)\n");
+	ctrl_shm = 0;
+	goto out;
+    }
+
+    /* set up the channels and the ring */
+    for (n = 0; n < 16; n++) {
+	ctrl_shm->data_len[n] = 0;
+    }
+    rec_size = 0;
+    for (n = 0; n < nchan; n++) {
+	if (setup_channel(n, argv[optind + n]) < 0) {
+	    goto out;
+	}
+	rec_size += type_size(chan_type[n]);
+    }
+    ctrl_shm->sample_len = nchan;
+    ctrl_shm->rec_len = ctrl_shm->buf_len / nchan;
+    ctrl_shm->mult = mult;
+    ctrl_shm->trig_chan = 0;
+    ctrl_shm->auto_trig = 0;
+
+    rtapi_mutex_get(&(hal_data->mutex));
+    thread = halpr_find_thread_by_name(thread_name);
+    period = thread ? thread->period * mult : 0;
+    rtapi_mutex_give(&(hal_data->mutex));
+    if (!thread) {
+	fprintf(stderr, "ERROR: no thread '%s'\n", thread_name);
+	goto out;
+    }
+
+    if (trig_chan) {
+	pre_len = before * 1e9 / period + 1;
+	post_len = after * 1e9 / period;
+	pre_data = malloc(pre_len * rec_size);
+	pre_lost = malloc(pre_len * sizeof(*pre_lost));
+	if (!pre_data || !pre_lost) {
+	    fprintf(stderr, "ERROR: no memory for %ld pre-trigger samples\n",
+		pre_len);
+	    goto out;
+	}
+    } else if (duration > 0) {
+	post_len = duration * 1e9 / period;
+    }
+    block = malloc(ctrl_shm->rec_len * rec_size);
+    if (!block) {
+	fprintf(stderr, "ERROR: out of memory\n");
+	goto out;
+    }
+
+    /* open the output; the name reaches the shell through the
+       environment so that it needs no quoting */
+    if (!ofilename || strcmp(ofilename, "-") == 0) {
+	out = stdout;
+    } else if ((len = strlen(ofilename)) > 3
+	&& strcmp(ofilename + len - 3, ".gz") == 0) {
+	compress = 1;
+	setenv("HALSCOPE_RECORD_FILE", ofilename, 1);
+	out = popen("gzip -c > \"$HALSCOPE_RECORD_FILE\"", "w");
+    } else {
+	out = fopen(ofilename, "w");
+    }
+    if (!out) {
+	perror(ofilename);
+	goto out;
+    }
+    /* start streaming */
+    if (hal_add_funct_to_thread("scope.sample", thread_name, -1) < 0) {
+	fprintf(stderr, "ERROR: cannot add scope.sample to '%s'\n", thread_name);
+	goto out;
+    }
+    linked = 1;
+    strncpy(ctrl_shm->thread_name, thread_name, HAL_NAME_LEN);
+    ctrl_shm->thread_name[HAL_NAME_LEN] = '\0';
+    if (!trig_chan) {
+	write_header(period, -1);
+    }
+    ctrl_shm->tail = 0;
+    ctrl_shm->stream = 1;
+    ctrl_shm->stream_pid = getpid();
+    ctrl_shm->state = INIT;
+    tail = 0;
+    gaps_seen = 0;
+    /* scope_rt wraps its write position after rec_len samples, which
+       'tail % rec_len' would not follow when the counters overflow */
+    pos = 0;
+
+    /* with a trigger, post_len only counts once it has happened, and 0
+       means to stop at the trigger sample */
+    done = !trig_chan && post_len == 0;
+    while (!stop && !done) {
+	usleep(10000);
+	if (ctrl_shm->state != STREAM) {
+	    if (ctrl_shm->state != INIT && ctrl_shm->state != IDLE) {
+		fprintf(stderr, "ERROR: scope stopped streaming\n");
+		goto out;
+	    }
+	    continue;
+	}
+	head = atomic_load_explicit(&ctrl_shm->head, memory_order_acquire);
+	lost = ctrl_shm->lost - lost_seen;
+	if (lost) {
+	    lost_seen += lost;
+	    fprintf(stderr, "halscope-record: %u samples lost\n", lost);
+	}
+	block_len = 0;
+	while (tail != head && !done) {
+	    /* a gap ends the block, the samples after it start a new one */
+	    lost = lost_before(tail);
+	    if (lost && (!trig_chan || triggered)) {
+		write_block(block, block_len, gap);
+		block_len = 0;
+		gap = 0;
+	    }
+	    gap += lost;
+	    rec = block + block_len * rec_size;
+	    pack_sample(rec, buffer + pos * nchan);
+	    if (++pos == ctrl_shm->rec_len) {
+		pos = 0;
+	    }
+	    tail++;
+	    if (!trig_chan || triggered) {
+		block_len++;
+		if (post_len > 0 && --post_len == 0) {
+		    done = 1;
+		}
+		continue;
+	    }
+	    /* waiting for the trigger, keep the pre-trigger window; the
+	       trigger sample is the last one in it */
+	    n = trigger_state(rec, trig_chan - 1, level);
+	    pre_store(rec, gap);
+	    gap = 0;
+	    if (prev_state >= 0 && n != prev_state && n == !falling) {
+		triggered = 1;
+		write_header(period, pre_span());
+		pre_flush();
+		done = post_len == 0;
+	    }
+	    prev_state = n;
+	}
+	atomic_store_explicit(&ctrl_shm->tail, tail, memory_order_release);
+	if (!trig_chan || triggered) {
+	    write_block(block, block_len, gap);
+	    gap = 0;
+	}
+    }
+    if (trig_chan && !triggered) {
+	fprintf(stderr, "halscope-record: stopped before the trigger\n");
+    } else {
+	exitval = 0;
+    }
+
+out:
+    if (out) {
+	if (out == stdout) {
+	    fflush(out);
+	} else if (compress) {
+	    pclose(out);
+	} else {
+	    fclose(out);
+	}
+    }
+    cleanup();
+    return exitval;
+}
@@ -38,6 +38,7 @@
 #include "../hal_priv.h"	/* HAL private API decls */
 #include "scope_rt.h"		/* scope related declarations */
 #include "rtapi_string.h"
+#include "rtapi_atomic.h"
 
 /* module information */
 MODULE_AUTHOR("John Kasunich");
@@ -71,6 +72,7 @@ static void init_rt_control_struct(void *shmem);
 static void init_shm_control_struct(void);
 
 static void sample(void *arg, long period);
+static void locate_channels(void);
 static void capture_sample(void);
 static int check_trigger(void);
 
@@ -164,6 +166,11 @@ static void sample(void *arg, long period)
     }
     /* reset counter */
     ctrl_rt->mult_cntr = 0;
+    if (ctrl_shm->state != IDLE
+	&& ctrl_rt->sig_generation != hal_data->sig_generation) {
+	/* signal data was moved since the channels were located */
+	locate_channels();
+    }
     /* run the sampling state machine */
     switch (ctrl_shm->state) {
     case IDLE:
@@ -178,12 +185,19 @@ static void sample(void *arg, long period)
 	ctrl_rt->auto_timer = 0;
 	/* get info about channels */
 	for (n = 0; n < 16; n++) {
-	    ctrl_rt->data_addr[n] = SHMPTR(ctrl_shm->data_offset[n]);
 	    ctrl_rt->data_type[n] = ctrl_shm->data_type[n];
 	    ctrl_rt->data_len[n] = ctrl_shm->data_len[n];
 	}
+	locate_channels();
 	/* set next state */
-	ctrl_shm->state = PRE_TRIG;
+	if (ctrl_shm->stream) {
+	    ctrl_shm->head = 0;
+	    ctrl_shm->lost = 0;
+	    ctrl_shm->gaps = 0;
+	    ctrl_shm->state = STREAM;
+	} else {
+	    ctrl_shm->state = PRE_TRIG;
+	}
 	break;
     case PRE_TRIG:
 	/* acquire a sample */
@@ -232,6 +246,30 @@ static void sample(void *arg, long period)
     case DONE:
 	/* do nothing while GUI displays waveform */
 	break;
+    case STREAM:
+	/* the buffer is a ring of rec_len samples, and the reader
+	   frees them by advancing 'tail' */
+	if (ctrl_shm->head - atomic_load_explicit(&ctrl_shm->tail,
+		memory_order_acquire) >= (unsigned int) ctrl_shm->rec_len) {
+	    /* reader is behind, drop this sample, and note that the
+	       samples are missing between head - 1 and head */
+	    n = (ctrl_shm->gaps - 1) % SCOPE_STREAM_GAPS;
+	    if (ctrl_shm->gaps == 0 || ctrl_shm->gap_head[n] != ctrl_shm->head) {
+		n = ctrl_shm->gaps % SCOPE_STREAM_GAPS;
+		ctrl_shm->gap_head[n] = ctrl_shm->head;
+		ctrl_shm->gap_lost[n] = 0;
+		atomic_store_explicit(&ctrl_shm->gaps, ctrl_shm->gaps + 1,
+		    memory_order_release);
+	    }
+	    ctrl_shm->gap_lost[n]++;
+	    ctrl_shm->lost++;
+	    break;
+	}
+	capture_sample();
+	/* publish the sample */
+	atomic_store_explicit(&ctrl_shm->head, ctrl_shm->head + 1,
+	    memory_order_release);
+	break;
     default:
 	/* shouldn't get here - if we do, set a legal state */
 	ctrl_shm->state = IDLE;
@@ -240,6 +278,47 @@ static void sample(void *arg, long period)
     /* done */
 }
 
+/* points each channel at the current location of its data, which
+   moves when halpr_compact_signals() lays the signals out again */
+static void locate_channels(void)
+{
+    hal_pin_t *pin;
+    hal_sig_t *sig;
+    hal_param_t *param;
+    int n;
+
+    ctrl_rt->sig_generation = hal_data->sig_generation;
+    for (n = 0; n < 16; n++) {
+	if (ctrl_rt->data_len[n] == 0) {
+	    continue;
+	}
+	switch (ctrl_shm->data_source_type[n]) {
+	case 0:
+	    pin = SHMPTR(ctrl_shm->data_source[n]);
+	    if (pin->signal == 0) {
+		/* pin is unlinked, get data from dummysig */
+		ctrl_rt->data_addr[n] = &(pin->dummysig);
+	    } else {
+		sig = SHMPTR(pin->signal);
+		ctrl_rt->data_addr[n] = SHMPTR(sig->data_ptr);
+	    }
+	    break;
+	case 1:
+	    sig = SHMPTR(ctrl_shm->data_source[n]);
+	    ctrl_rt->data_addr[n] = SHMPTR(sig->data_ptr);
+	    break;
+	case 2:
+	    param = SHMPTR(ctrl_shm->data_source[n]);
+	    ctrl_rt->data_addr[n] = SHMPTR(param->data_ptr);
+	    break;
+	default:
+	    /* no source, don't sample */
+	    ctrl_rt->data_len[n] = 0;
+	    break;
+	}
+    }
+}
+
 static void capture_sample(void)
 {
     scope_data_t *dest;
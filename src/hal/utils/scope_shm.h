@@ -43,6 +43,10 @@
 
 #define SCOPE_SHM_KEY  0x130CF406
 #define SCOPE_NUM_SAMPLES_DEFAULT 16000
+/* gaps in the stream the reader has not passed yet: a gap only starts
+   when the ring is full, and a new one only after the reader frees some
+   of it, so a reader that takes all samples each time has at most two */
+#define SCOPE_STREAM_GAPS 8
 
 typedef enum {
     IDLE = 0,			/* waiting for run command */
@@ -51,7 +55,8 @@ typedef enum {
     TRIG_WAIT,			/* waiting for trigger */
     POST_TRIG,			/* acquiring post-trigger data */
     DONE,			/* data acquisition complete */
-    RESET			/* data acquisition interrupted */
+    RESET,			/* data acquisition interrupted */
+    STREAM			/* continuous acquisition into a ring */
 } scope_state_t;
 
 /* this struct holds a single value - one sample of one channel */
@@ -88,9 +93,19 @@ typedef struct {
     int curr;			/* R next sample to be acquired */
     int samples;		/* R number of valid samples */
     scope_state_t state;	/* RU current state */
-    int data_offset[16];	/* U data addr in shmem for each channel */
+    int data_source[16];	/* U pin, signal or param of each channel */
+    int data_source_type[16];	/* U 0 = pin, 1 = signal, 2 = param */
     hal_type_t data_type[16];	/* U data type for each channel */
     char data_len[16];		/* U data size, 0 if not to be acquired */
+    int stream;			/* U non-zero: INIT starts STREAM, not a shot */
+    volatile unsigned int head;	/* R samples written since INIT (stream) */
+    volatile unsigned int tail;	/* U samples the reader is done with */
+    unsigned int lost;		/* R samples dropped because ring was full */
+    volatile unsigned int gaps;	/* R gaps since INIT, see gap_head */
+    unsigned int gap_head[SCOPE_STREAM_GAPS];	/* R 'head' when gap
+				   'gaps % SCOPE_STREAM_GAPS' started */
+    unsigned int gap_lost[SCOPE_STREAM_GAPS];	/* R samples it dropped */
+    int stream_pid;		/* U process reading the stream */
 } scope_shm_control_t;
 
 #endif /* HALSC_SHM_H */
@@ -28,6 +28,7 @@
 #include <stdarg.h>
 #endif
 #include "posemath.h"
+#include "posemath_inline.h"
 
 #include "rtapi_math.h"
 #include <float.h>
@@ -787,7 +788,7 @@ int pmCartCartCompare(PmCartesian const * const v1, PmCartesian const * const v2
 
 int pmCartCartDot(PmCartesian const * const v1, PmCartesian const * const v2, double *d)
 {
-    *d = v1->x * v2->x + v1->y * v2->y + v1->z * v2->z;
+    *d = pmCartCartDotV(*v1, *v2);
 
     return pmErrno = 0;
 }
@@ -795,9 +796,7 @@ int pmCartCartDot(PmCartesian const * const v1, PmCartesian const * const v2, do
 int pmCartCartMult(PmCartesian const * const v1, PmCartesian const * const v2,
         PmCartesian * const out)
 {
-    out->x = v1->x * v2->x;
-    out->y = v1->y * v2->y;
-    out->z = v1->z * v2->z;
+    *out = pmCartCartMultV(*v1, *v2);
 
     return pmErrno = 0;
 }
@@ -818,16 +817,14 @@ int pmCartCartCross(PmCartesian const * const v1, PmCartesian const * const v2,
     if (vout == v1 || vout == v2) {
         return pmErrno = PM_IMPL_ERR;
     }
-    vout->x = v1->y * v2->z - v1->z * v2->y;
-    vout->y = v1->z * v2->x - v1->x * v2->z;
-    vout->z = v1->x * v2->y - v1->y * v2->x;
+    *vout = pmCartCartCrossV(*v1, *v2);
 
     return pmErrno = 0;
 }
 
 int pmCartMag(PmCartesian const * const v, double *d)
 {
-    *d = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
+    *d = pmCartMagV(*v);
 
     return pmErrno = 0;
 }
@@ -835,7 +832,7 @@ int pmCartMag(PmCartesian const * const v, double *d)
 /** Find square of magnitude of a vector (useful for some calculations to save a sqrt).*/
 int pmCartMagSq(PmCartesian const * const v, double *d)
 {
-    *d = pmSq(v->x) + pmSq(v->y) + pmSq(v->z);
+    *d = pmCartMagSqV(*v);
 
     return pmErrno = 0;
 }
@@ -843,7 +840,7 @@ int pmCartMagSq(PmCartesian const * const v, double *d)
 int pmCartCartDisp(PmCartesian const * const v1, PmCartesian const * const v2,
         double *d)
 {
-    *d = pmSqrt(pmSq(v2->x - v1->x) + pmSq(v2->y - v1->y) + pmSq(v2->z - v1->z));
+    *d = pmCartCartDispV(*v1, *v2);
 
     return pmErrno = 0;
 }
@@ -851,9 +848,7 @@ int pmCartCartDisp(PmCartesian const * const v1, PmCartesian const * const v2,
 int pmCartCartAdd(PmCartesian const * const v1, PmCartesian const * const v2,
         PmCartesian * const vout)
 {
-    vout->x = v1->x + v2->x;
-    vout->y = v1->y + v2->y;
-    vout->z = v1->z + v2->z;
+    *vout = pmCartCartAddV(*v1, *v2);
 
     return pmErrno = 0;
 }
@@ -861,19 +856,16 @@ int pmCartCartAdd(PmCartesian const * const v1, PmCartesian const * const v2,
 int pmCartCartSub(PmCartesian const * const v1, PmCartesian const * const v2,
         PmCartesian * const vout)
 {
-    vout->x = v1->x - v2->x;
-    vout->y = v1->y - v2->y;
-    vout->z = v1->z - v2->z;
+    *vout = pmCartCartSubV(*v1, *v2);
 
     return pmErrno = 0;
 }
 
 int pmCartScalMult(PmCartesian const * const v1, double d, PmCartesian * const vout)
 {
-    if (v1 != vout) {
-        *vout = *v1;
-    }
-    return pmCartScalMultEq(vout, d);
+    *vout = pmCartScalMultV(*v1, d);
+
+    return pmErrno = 0;
 }
 
 int pmCartScalDiv(PmCartesian const * const v1, double d, PmCartesian * const vout)
@@ -895,9 +887,7 @@ int pmCartNeg(PmCartesian const * const v1, PmCartesian * const vout)
 
 int pmCartNegEq(PmCartesian * const v1)
 {
-    v1->x = -v1->x;
-    v1->y = -v1->y;
-    v1->z = -v1->z;
+    *v1 = pmCartNegV(*v1);
 
     return pmErrno = 0;
 }
@@ -954,28 +944,21 @@ int pmCartAbs(PmCartesian const * const v, PmCartesian * const vout)
 
 int pmCartCartAddEq(PmCartesian * const v, PmCartesian const * const v_add)
 {
-    v->x += v_add->x;
-    v->y += v_add->y;
-    v->z += v_add->z;
+    *v = pmCartCartAddV(*v, *v_add);
 
     return pmErrno = 0;
 }
 
 int pmCartCartSubEq(PmCartesian * const v, PmCartesian const * const v_sub)
 {
-    v->x -= v_sub->x;
-    v->y -= v_sub->y;
-    v->z -= v_sub->z;
+    *v = pmCartCartSubV(*v, *v_sub);
 
     return pmErrno = 0;
 }
 
 int pmCartScalMultEq(PmCartesian * const v, double d)
 {
-
-    v->x *= d;
-    v->y *= d;
-    v->z *= d;
+    *v = pmCartScalMultV(*v, d);
 
     return pmErrno = 0;
 }
@@ -1247,9 +1230,7 @@ int pmMatInv(PmRotationMatrix const * const m, PmRotationMatrix * const mout)
 
 int pmMatCartMult(PmRotationMatrix const * const m, PmCartesian const * const v, PmCartesian * const vout)
 {
-    vout->x = m->x.x * v->x + m->y.x * v->y + m->z.x * v->z;
-    vout->y = m->x.y * v->x + m->y.y * v->y + m->z.y * v->z;
-    vout->z = m->x.z * v->x + m->y.z * v->y + m->z.z * v->z;
+    *vout = pmMatCartMultV(*m, *v);
 
     return pmErrno = 0;
 }
@@ -1257,17 +1238,7 @@ int pmMatCartMult(PmRotationMatrix const * const m, PmCartesian const * const v,
 int pmMatMatMult(PmRotationMatrix const * const m1, PmRotationMatrix const * const m2,
     PmRotationMatrix * const mout)
 {
-    mout->x.x = m1->x.x * m2->x.x + m1->y.x * m2->x.y + m1->z.x * m2->x.z;
-    mout->x.y = m1->x.y * m2->x.x + m1->y.y * m2->x.y + m1->z.y * m2->x.z;
-    mout->x.z = m1->x.z * m2->x.x + m1->y.z * m2->x.y + m1->z.z * m2->x.z;
-
-    mout->y.x = m1->x.x * m2->y.x + m1->y.x * m2->y.y + m1->z.x * m2->y.z;
-    mout->y.y = m1->x.y * m2->y.x + m1->y.y * m2->y.y + m1->z.y * m2->y.z;
-    mout->y.z = m1->x.z * m2->y.x + m1->y.z * m2->y.y + m1->z.z * m2->y.z;
-
-    mout->z.x = m1->x.x * m2->z.x + m1->y.x * m2->z.y + m1->z.x * m2->z.z;
-    mout->z.y = m1->x.y * m2->z.x + m1->y.y * m2->z.y + m1->z.y * m2->z.z;
-    mout->z.z = m1->x.z * m2->z.x + m1->y.z * m2->z.y + m1->z.z * m2->z.z;
+    *mout = pmMatMatMultV(*m1, *m2);
 
     return pmErrno = 0;
 }
@@ -1409,18 +1380,7 @@ int pmQuatQuatMult(PmQuaternion const * const q1, PmQuaternion const * const q2,
 	return pmErrno = PM_ERR;
     }
 
-    qout->s = q1->s * q2->s - q1->x * q2->x - q1->y * q2->y - q1->z * q2->z;
-
-    if (qout->s >= 0.0) {
-	qout->x = q1->s * q2->x + q1->x * q2->s + q1->y * q2->z - q1->z * q2->y;
-	qout->y = q1->s * q2->y - q1->x * q2->z + q1->y * q2->s + q1->z * q2->x;
-	qout->z = q1->s * q2->z + q1->x * q2->y - q1->y * q2->x + q1->z * q2->s;
-    } else {
-	qout->s *= -1;
-	qout->x = -q1->s * q2->x - q1->x * q2->s - q1->y * q2->z + q1->z * q2->y;
-	qout->y = -q1->s * q2->y + q1->x * q2->z - q1->y * q2->s - q1->z * q2->x;
-	qout->z = -q1->s * q2->z - q1->x * q2->y + q1->y * q2->x - q1->z * q2->s;
-    }
+    *qout = pmQuatQuatMultV(*q1, *q2);
 
 #ifdef PM_DEBUG
     if (!pmQuatIsNorm(q1) || !pmQuatIsNorm(q2)) {
@@ -1436,15 +1396,7 @@ int pmQuatQuatMult(PmQuaternion const * const q1, PmQuaternion const * const q2,
 
 int pmQuatCartMult(PmQuaternion const * const q1, PmCartesian const * const v2, PmCartesian * const vout)
 {
-    PmCartesian c;
-
-    c.x = q1->y * v2->z - q1->z * v2->y;
-    c.y = q1->z * v2->x - q1->x * v2->z;
-    c.z = q1->x * v2->y - q1->y * v2->x;
-
-    vout->x = v2->x + 2.0 * (q1->s * c.x + q1->y * c.z - q1->z * c.y);
-    vout->y = v2->y + 2.0 * (q1->s * c.y + q1->z * c.x - q1->x * c.z);
-    vout->z = v2->z + 2.0 * (q1->s * c.z + q1->x * c.y - q1->y * c.x);
+    *vout = pmQuatCartMultV(*q1, *v2);
 
 #ifdef PM_DEBUG
     if (!pmQuatIsNorm(q1)) {
@@ -1676,17 +1628,14 @@ int pmCartLineInit(PmCartLine * const line, PmCartesian const * const start, PmC
 
 int pmCartLinePoint(PmCartLine const * const line, double len, PmCartesian * const point)
 {
-    int r1 = 0, r2 = 0;
-
     if (line->tmag_zero) {
         *point = line->end;
     } else {
         /* return start + len * uVec */
-        r1 = pmCartScalMult(&line->uVec, len, point);
-        r2 = pmCartCartAdd(&line->start, point, point);
+        *point = pmCartCartScaleAddV(line->start, len, line->uVec);
     }
 
-    return pmErrno = (r1 || r2) ? PM_NORM_ERR : 0;
+    return pmErrno = 0;
 }
 
 
@@ -1865,7 +1814,7 @@ int pmCircleInit(PmCircle * const circle,
   */
 int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * const point)
 {
-    PmCartesian par, perp;
+    PmCartesian radius, p;
     double scale;
 
 #ifdef PM_DEBUG
@@ -1878,33 +1827,29 @@ int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * con
     }
 #endif
 
-    /* compute components rel to center */
-    pmCartScalMult(&circle->rTan, cos(angle), &par);
-    pmCartScalMult(&circle->rPerp, sin(angle), &perp);
-
-    /* add to get radius vector rel to center */
-    pmCartCartAdd(&par, &perp, point);
+    /* compute components rel to center, and add to get radius vector */
+    radius = pmCartCartAddV(pmCartScalMultV(circle->rTan, cos(angle)),
+            pmCartScalMultV(circle->rPerp, sin(angle)));
 
     /* get scale for spiral, helix interpolation */
     if (circle->angle == 0.0) {
 #ifdef PM_PRINT_ERROR
 	pmPrintError("error: pmCirclePoint angle is zero\n");
 #endif
+	*point = radius;
 	return pmErrno = PM_DIV_ERR;
     }
     scale = angle / circle->angle;
 
     /* add scaled vector in radial dir for spiral */
-    pmCartUnit(point, &par);
-    pmCartScalMult(&par, scale * circle->spiral, &par);
-    pmCartCartAdd(point, &par, point);
+    p = pmCartCartAddV(radius,
+            pmCartScalMultV(pmCartUnitV(radius), scale * circle->spiral));
 
     /* add scaled vector in helix dir */
-    pmCartScalMult(&circle->rHelix, scale, &perp);
-    pmCartCartAdd(point, &perp, point);
+    p = pmCartCartAddV(p, pmCartScalMultV(circle->rHelix, scale));
 
     /* add to center vector for final result */
-    pmCartCartAdd(&circle->center, point, point);
+    *point = pmCartCartAddV(circle->center, p);
 
     return pmErrno = 0;
 }
@@ -0,0 +1,170 @@
+/********************************************************************
+* Description: posemath_inline.h
+*    Header-inline versions of the core PmCartesian, PmQuaternion and
+*    PmRotationMatrix operations.
+*
+*   The functions in posemath.h are out-of-line, pass every argument
+*   by pointer, and store a status in the global pmErrno on every call,
+*   which keeps the compiler from combining or vectorizing successive
+*   operations. The functions here take and return their operands by
+*   value, never touch pmErrno, and have no data-dependent error
+*   branches, so hot paths (trajectory planner, blend math, kinematics)
+*   can be inlined and optimized as plain arithmetic.
+*
+*   Naming follows posemath.h with a trailing V ("by value"), e.g.
+*   pmCartCartAddV is the inline equivalent of pmCartCartAdd. The
+*   posemath.h functions are implemented as wrappers around these, so
+*   both give bit-identical results.
+*
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+********************************************************************/
+#ifndef POSEMATH_INLINE_H
+#define POSEMATH_INLINE_H
+
+#include "posemath.h"
+#include "rtapi_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* PmCartesian functions */
+
+static inline PmCartesian pmCartCartAddV(PmCartesian const v1, PmCartesian const v2)
+{
+    PmCartesian out = {v1.x + v2.x, v1.y + v2.y, v1.z + v2.z};
+    return out;
+}
+
+static inline PmCartesian pmCartCartSubV(PmCartesian const v1, PmCartesian const v2)
+{
+    PmCartesian out = {v1.x - v2.x, v1.y - v2.y, v1.z - v2.z};
+    return out;
+}
+
+static inline PmCartesian pmCartCartMultV(PmCartesian const v1, PmCartesian const v2)
+{
+    PmCartesian out = {v1.x * v2.x, v1.y * v2.y, v1.z * v2.z};
+    return out;
+}
+
+static inline PmCartesian pmCartScalMultV(PmCartesian const v, double d)
+{
+    PmCartesian out = {v.x * d, v.y * d, v.z * d};
+    return out;
+}
+
+/** Unchecked division, the caller must ensure d != 0. */
+static inline PmCartesian pmCartScalDivV(PmCartesian const v, double d)
+{
+    PmCartesian out = {v.x / d, v.y / d, v.z / d};
+    return out;
+}
+
+static inline PmCartesian pmCartNegV(PmCartesian const v)
+{
+    PmCartesian out = {-v.x, -v.y, -v.z};
+    return out;
+}
+
+static inline double pmCartCartDotV(PmCartesian const v1, PmCartesian const v2)
+{
+    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+
+static inline PmCartesian pmCartCartCrossV(PmCartesian const v1, PmCartesian const v2)
+{
+    PmCartesian out = {
+        v1.y * v2.z - v1.z * v2.y,
+        v1.z * v2.x - v1.x * v2.z,
+        v1.x * v2.y - v1.y * v2.x};
+    return out;
+}
+
+static inline double pmCartMagSqV(PmCartesian const v)
+{
+    return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+static inline double pmCartMagV(PmCartesian const v)
+{
+    return sqrt(pmCartMagSqV(v));
+}
+
+static inline double pmCartCartDispV(PmCartesian const v1, PmCartesian const v2)
+{
+    return pmCartMagV(pmCartCartSubV(v2, v1));
+}
+
+/** Unit vector of v, or the zero vector if v has zero length. */
+static inline PmCartesian pmCartUnitV(PmCartesian const v)
+{
+    double size = pmCartMagV(v);
+    return pmCartScalDivV(v, size > 0.0 ? size : 1.0);
+}
+
+/** Returns v1 + d * v2, the common "point along a direction" operation. */
+static inline PmCartesian pmCartCartScaleAddV(PmCartesian const v1, double d,
+        PmCartesian const v2)
+{
+    PmCartesian out = {v1.x + d * v2.x, v1.y + d * v2.y, v1.z + d * v2.z};
+    return out;
+}
+
+/* PmRotationMatrix functions */
+
+static inline PmCartesian pmMatCartMultV(PmRotationMatrix const m, PmCartesian const v)
+{
+    PmCartesian out = {
+        m.x.x * v.x + m.y.x * v.y + m.z.x * v.z,
+        m.x.y * v.x + m.y.y * v.y + m.z.y * v.z,
+        m.x.z * v.x + m.y.z * v.y + m.z.z * v.z};
+    return out;
+}
+
+static inline PmRotationMatrix pmMatMatMultV(PmRotationMatrix const m1,
+        PmRotationMatrix const m2)
+{
+    PmRotationMatrix out;
+    out.x = pmMatCartMultV(m1, m2.x);
+    out.y = pmMatCartMultV(m1, m2.y);
+    out.z = pmMatCartMultV(m1, m2.z);
+    return out;
+}
+
+/* PmQuaternion functions */
+
+static inline PmCartesian pmQuatCartMultV(PmQuaternion const q, PmCartesian const v)
+{
+    PmCartesian c = {
+        q.y * v.z - q.z * v.y,
+        q.z * v.x - q.x * v.z,
+        q.x * v.y - q.y * v.x};
+    PmCartesian out = {
+        v.x + 2.0 * (q.s * c.x + q.y * c.z - q.z * c.y),
+        v.y + 2.0 * (q.s * c.y + q.z * c.x - q.x * c.z),
+        v.z + 2.0 * (q.s * c.z + q.x * c.y - q.y * c.x)};
+    return out;
+}
+
+/** Quaternion product, normalized so that the scalar part is non-negative. */
+static inline PmQuaternion pmQuatQuatMultV(PmQuaternion const q1, PmQuaternion const q2)
+{
+    PmQuaternion out;
+    double s = q1.s * q2.s - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+    double sign = s >= 0.0 ? 1.0 : -1.0;
+
+    out.s = sign * s;
+    out.x = sign * (q1.s * q2.x + q1.x * q2.s + q1.y * q2.z - q1.z * q2.y);
+    out.y = sign * (q1.s * q2.y - q1.x * q2.z + q1.y * q2.s + q1.z * q2.x);
+    out.z = sign * (q1.s * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.s);
+    return out;
+}
+
+#ifdef __cplusplus
+}				/* matches extern "C" for C++ */
+#endif
+#endif				/* #ifndef POSEMATH_INLINE_H */
@@ -930,6 +930,18 @@ int rtapi_task_self(void)
     return -EINVAL;
 }
 
+int rtapi_task_set_cpu(int task_id, int cpu_id)
+{
+    /* not supported, tasks run where rt_task_init() puts them */
+    return -ENOSYS;
+}
+
+int rtapi_task_follow(int task_id, int leader_id)
+{
+    /* not supported, and not needed without rtapi_task_set_cpu() */
+    return -ENOSYS;
+}
+
 /***********************************************************************
 *                  SHARED MEMORY RELATED FUNCTIONS                     *
 ************************************************************************/
@@ -1717,6 +1729,8 @@ EXPORT_SYMBOL(rtapi_wait);
 EXPORT_SYMBOL(rtapi_task_resume);
 EXPORT_SYMBOL(rtapi_task_pause);
 EXPORT_SYMBOL(rtapi_task_self);
+EXPORT_SYMBOL(rtapi_task_set_cpu);
+EXPORT_SYMBOL(rtapi_task_follow);
 EXPORT_SYMBOL(rtapi_shmem_new);
 EXPORT_SYMBOL(rtapi_shmem_delete);
 EXPORT_SYMBOL(rtapi_shmem_getptr);
@@ -419,6 +419,25 @@ RTAPI_BEGIN_DECLS
 */
     extern int rtapi_task_self(void);
 
+/** 'rtapi_task_set_cpu()' asks for task 'task_id' to run only on
+    processor 'cpu_id', instead of wherever the RTOS puts its tasks.
+    The task must not have been started yet.  Returns 0 on success,
+    -EINVAL for a bad task or processor, or -ENOSYS if the RTOS does
+    not support it.  Call only from within init/cleanup code, not from
+    realtime tasks.
+*/
+    extern int rtapi_task_set_cpu(int task_id, int cpu_id);
+
+/** 'rtapi_task_follow()' asks for task 'task_id' to wake up at the
+    same times as the periodic task 'leader_id', instead of at times of
+    its own that start when it is started.  'task_id' must not have been
+    started yet, and must then be started with the same period as
+    'leader_id'.  Returns 0 on success, -EINVAL for a bad task, or
+    -ENOSYS if the RTOS does not support it.  Call only from within
+    init/cleanup code, not from realtime tasks.
+*/
+    extern int rtapi_task_follow(int task_id, int leader_id);
+
 #endif /* RTAPI */
 
 /***********************************************************************
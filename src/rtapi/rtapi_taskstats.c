@@ -0,0 +1,148 @@
+/*    This is a component of LinuxCNC
+ *
+ *    rtapi_taskstats: print the wakeup statistics that rtapi_app keeps
+ *    for its realtime tasks, see rtapi_taskstats.h
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "rtapi_taskstats.h"
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"Usage: rtapi_taskstats [-H] [-w seconds]\n"
+	"       rtapi_taskstats -r\n");
+}
+
+/* the upper bound of bucket 'n', in microseconds */
+static double bucket_us(int n)
+{
+    return (2ULL << n) * 1e-3;
+}
+
+static void print_summary(const char *what, const unsigned *count,
+    long long max)
+{
+    int p50 = rtapi_taskstats_percentile(count, .5);
+    int p99 = rtapi_taskstats_percentile(count, .99);
+    int p999 = rtapi_taskstats_percentile(count, .999);
+
+    if (p50 < 0)
+	return;
+    printf("    %-9s 50%% < %.1f us, 99%% < %.1f us, 99.9%% < %.1f us, "
+	"max %.1f us\n", what, bucket_us(p50), bucket_us(p99),
+	bucket_us(p999), max * 1e-3);
+}
+
+static void print_buckets(const char *what, const unsigned *count)
+{
+    int n;
+
+    printf("    %s:\n", what);
+    for (n = 0; n < RTAPI_TASKSTATS_BUCKETS; n++)
+	if (count[n])
+	    printf("      < %10.1f us %10u\n", bucket_us(n), count[n]);
+}
+
+static void print_stats(const rtapi_taskstats_t *ts, int histograms)
+{
+    int i, any = 0;
+
+    for (i = 0; i < RTAPI_TASKSTATS_TASKS; i++) {
+	/* a copy, so that the lines printed agree with each other */
+	rtapi_task_stats_t s = ts->task[i];
+
+	if (!s.active)
+	    continue;
+	any = 1;
+	printf("task %d, period %ld ns: %llu wakeups, %llu overruns\n",
+	    s.id, s.period, s.wakeups, s.overruns);
+	print_summary("late", s.late, s.late_max);
+	print_summary("run time", s.exec, s.exec_max);
+	if (histograms) {
+	    print_buckets("wakeup late", s.late);
+	    print_buckets("run time", s.exec);
+	}
+    }
+    if (!any)
+	printf("no realtime tasks\n");
+}
+
+int main(int argc, char **argv)
+{
+    int histograms = 0, reset = 0, id, i, c;
+    double interval = 0;
+    rtapi_taskstats_t *ts;
+
+    while ((c = getopt(argc, argv, "hHrw:")) != -1) {
+	switch (c) {
+	case 'H':
+	    histograms = 1;
+	    break;
+	case 'r':
+	    reset = 1;
+	    break;
+	case 'w':
+	    interval = atof(optarg);
+	    break;
+	case 'h':
+	    usage();
+	    return 0;
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    if (optind != argc) {
+	usage();
+	return 1;
+    }
+
+    id = shmget(RTAPI_TASKSTATS_KEY, 0, 0);
+    if (id < 0) {
+	fprintf(stderr, "rtapi_taskstats: no realtime tasks are running\n");
+	return 1;
+    }
+    ts = shmat(id, NULL, reset ? 0 : SHM_RDONLY);
+    if (ts == (void *) -1) {
+	perror("rtapi_taskstats: shmat");
+	return 1;
+    }
+
+    if (reset) {
+	for (i = 0; i < RTAPI_TASKSTATS_TASKS; i++)
+	    if (ts->task[i].active)
+		__sync_fetch_and_add(&ts->task[i].reset, 1);
+	return 0;
+    }
+
+    while (1) {
+	print_stats(ts, histograms);
+	if (interval <= 0)
+	    break;
+	fflush(stdout);
+	usleep(interval * 1e6);
+	printf("\n");
+    }
+    return 0;
+}
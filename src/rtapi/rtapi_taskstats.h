@@ -0,0 +1,88 @@
+/*    This is a component of LinuxCNC
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef RTAPI_TASKSTATS_H
+#define RTAPI_TASKSTATS_H
+
+/** Wakeup statistics of the uspace realtime tasks.
+
+    rtapi_app keeps them in a SysV shared memory segment with key
+    RTAPI_TASKSTATS_KEY while any task is running, one slot per task ID.
+    Each slot is only written by its own task, in rtapi_wait(): how late
+    the task woke up after the start of its period, how long it ran
+    before calling rtapi_wait() again, and the number of overruns, calls
+    that came after the next period had already started.
+
+    Times are in nanoseconds, in log2 sized buckets: bucket 0 counts 0
+    or 1 ns, bucket 'n' counts 2^n up to 2^(n+1)-1 ns.  Readers may see
+    one wakeup half counted.  To clear a slot, a reader increments
+    'reset'; the task clears the slot at its next wakeup.
+*/
+
+#define RTAPI_TASKSTATS_KEY 0x48525453	/* key of the statistics segment */
+#define RTAPI_TASKSTATS_TASKS 64	/* slots, at least MAX_TASKS */
+#define RTAPI_TASKSTATS_BUCKETS 32
+
+typedef struct {
+    int active;			/* a running task fills this slot */
+    int id;			/* its task ID */
+    long period;		/* its period, in ns */
+    unsigned reset;		/* incremented by readers to clear the slot */
+    unsigned reset_done;	/* value of 'reset' at the last clear */
+    unsigned long long wakeups;
+    unsigned long long overruns;
+    long long late_max;		/* ns */
+    long long exec_max;		/* ns */
+    unsigned late[RTAPI_TASKSTATS_BUCKETS];
+    unsigned exec[RTAPI_TASKSTATS_BUCKETS];
+} rtapi_task_stats_t;
+
+typedef struct {
+    rtapi_task_stats_t task[RTAPI_TASKSTATS_TASKS];
+} rtapi_taskstats_t;
+
+static inline int rtapi_taskstats_bucket(long long ns)
+{
+    unsigned long long v = ns > 0 ? ns : 0;
+    int n = 0;
+
+    if (v >> 32) return RTAPI_TASKSTATS_BUCKETS - 1;
+    /* floor(log2(v)), in five steps */
+    if (v >> 16) { v >>= 16; n += 16; }
+    if (v >> 8) { v >>= 8; n += 8; }
+    if (v >> 4) { v >>= 4; n += 4; }
+    if (v >> 2) { v >>= 2; n += 2; }
+    if (v >> 1) { n += 1; }
+    return n;
+}
+
+/* the bucket that holds the given fraction of the counts, or -1 */
+static inline int rtapi_taskstats_percentile(const unsigned *count, double p)
+{
+    unsigned long long total = 0, sum = 0;
+    int n;
+
+    for (n = 0; n < RTAPI_TASKSTATS_BUCKETS; n++)
+	total += count[n];
+    if (total == 0) return -1;
+    for (n = 0; n < RTAPI_TASKSTATS_BUCKETS; n++) {
+	sum += count[n];
+	if (sum >= p * total) return n;
+    }
+    return RTAPI_TASKSTATS_BUCKETS - 1;
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include <sys/fsuid.h>
 #include <unistd.h>
 #include <pthread.h>
+#include "rtapi_taskstats.h"
 
 inline void rtapi_timespec_add(timespec &result, const timespec &ta, const timespec &tb) {
     result.tv_sec = ta.tv_sec + tb.tv_sec;
@@ -54,11 +55,17 @@ struct rtapi_task {
   int uses_fp;
   size_t stacksize;
   int prio;
+  int cpu;			/* processor to run on, or -1 for the default */
   long period;
   struct timespec nextstart;
+  struct timespec start;		/* first wakeup, once 'started' is set */
+  int started;
+  int leader;			/* task to wake up with, or -1 */
   unsigned ratio;
   void *arg;
   void (*taskcode) (void*);	/* pointer to task function */
+  rtapi_task_stats_t *stats;	/* wakeup statistics, or NULL */
+  struct timespec woke;		/* when the task last woke up */
 };
 
 struct RtapiApp
@@ -77,11 +84,17 @@ struct RtapiApp
     static int allocate_task_id();
     static struct rtapi_task *get_task(int task_id);
     void unexpected_realtime_delay(rtapi_task *task, int nperiod=1);
+    static void task_stats_start(rtapi_task *task);
+    static void task_stats_stop(rtapi_task *task);
+    static void task_stats_ran(rtapi_task *task, const struct timespec &now);
+    static void task_stats_woke(rtapi_task *task, const struct timespec &now);
     virtual int task_delete(int id) = 0;
     virtual int task_start(int task_id, unsigned long period_nsec) = 0;
     virtual int task_pause(int task_id) = 0;
     virtual int task_resume(int task_id) = 0;
     virtual int task_self() = 0;
+    virtual int task_set_cpu(int task_id, int cpu);
+    virtual int task_follow(int task_id, int leader_id);
     virtual void wait() = 0;
     virtual unsigned char do_inb(unsigned int port) = 0;
     virtual void do_outb(unsigned char value, unsigned int port) = 0;
@@ -28,6 +28,9 @@ static int msg_level = RTAPI_MSG_ERR;	/* message printing level */
 
 #include <sys/ipc.h>		/* IPC_* */
 #include <sys/shm.h>		/* shmget() */
+#include <sys/syscall.h>	/* SYS_mbind */
+#include <linux/mempolicy.h>	/* MPOL_PREFERRED */
+#include <stdlib.h>		/* getenv() */
 /* These structs hold data associated with objects like tasks, etc. */
 /* Task handles are pointers to these structs.                      */
 
@@ -48,6 +51,84 @@ typedef struct {
 
 static rtapi_shmem_handle shmem_array[MAX_SHM] = {{0},};
 
+/* huge page size in bytes, or 0 if the kernel has none */
+static unsigned long rtapi_hugepage_size(void)
+{
+  unsigned long kb = 0;
+  char line[80];
+  FILE *f = fopen("/proc/meminfo", "r");
+  if(!f) return 0;
+  while(fgets(line, sizeof(line), f))
+    if(sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) break;
+  fclose(f);
+  return kb * 1024;
+}
+
+/* NUMA node of the CPU the realtime tasks run on by default (the last
+   one), or -1 if the machine has a single node */
+static int rtapi_shmem_node(void)
+{
+  char path[80];
+  int cpu = sysconf(_SC_NPROCESSORS_ONLN) - 1, node;
+
+  if(access("/sys/devices/system/node/node1", F_OK) != 0) return -1;
+  for(node = 0; node < 64; node++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+    if(access(path, F_OK) == 0) return node;
+  }
+  return -1;
+}
+
+#ifdef RTAPI
+/* whether the mapping at 'addr' is backed by huge pages.  shmctl's
+   IPC_STAT cannot tell: the kernel keeps only the permission bits of
+   the shmget() flags in shm_perm.mode, never SHM_HUGETLB */
+static int rtapi_mapping_is_huge(void *addr)
+{
+  char line[256];
+  unsigned long start, end, kb;
+  int found = 0, huge = 0;
+  FILE *f = fopen("/proc/self/smaps", "r");
+
+  if(!f) return 0;
+  while(fgets(line, sizeof(line), f)) {
+    if(sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      found = start == (unsigned long) addr;
+    } else if(found && sscanf(line, "KernelPageSize: %lu kB", &kb) == 1) {
+      huge = kb * 1024 > (unsigned long) sysconf(_SC_PAGESIZE);
+      break;
+    }
+  }
+  fclose(f);
+  return huge;
+}
+#endif
+
+/* create a segment backed by huge pages, if RTAPI_HUGEPAGES is set (from
+   [HAL]HUGEPAGES), otherwise or if that fails return -1 so the caller
+   falls back to normal pages.  An existing segment is left alone.
+   Rounds *size up to whole huge pages. */
+static int rtapi_shmem_new_huge(int key, unsigned long int *size)
+{
+  const char *env = getenv("RTAPI_HUGEPAGES");
+  unsigned long hugesize;
+  int id;
+
+  if(!env || !atoi(env)) return -1;
+  hugesize = rtapi_hugepage_size();
+  if(!hugesize) {
+    rtapi_print_msg(RTAPI_MSG_ERR, "RTAPI_HUGEPAGES: kernel has no huge pages\n");
+    return -1;
+  }
+  *size = (*size + hugesize - 1) / hugesize * hugesize;
+  id = shmget((key_t) key, *size, IPC_CREAT | IPC_EXCL | SHM_HUGETLB | 0600);
+  if(id == -1 && errno != EEXIST)
+    rtapi_print_msg(RTAPI_MSG_ERR,
+        "shared memory 0x%08x: no huge pages (%s), using normal pages; "
+        "reserve them with /proc/sys/vm/nr_hugepages\n", key, strerror(errno));
+  return id;
+}
+
 int rtapi_shmem_new(int key, int module_id, unsigned long int size)
 {
   rtapi_shmem_handle *shmem;
@@ -68,7 +149,12 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
   shmem = &shmem_array[i];
 
   /* now get shared memory block from OS */
-  shmem->id = shmget((key_t) key, (int) size, IPC_CREAT | 0600);
+  unsigned long int maplen = size;
+  shmem->id = rtapi_shmem_new_huge(key, &maplen);
+  if (shmem->id == -1) {
+    maplen = size;
+    shmem->id = shmget((key_t) key, (int) size, IPC_CREAT | 0600);
+  }
   if (shmem->id == -1) {
     rtapi_print_msg(RTAPI_MSG_ERR, "rtapi_shmem_new failed due to shmget(key=0x%08x): %s\n", key, strerror(errno));
     return -errno;
@@ -77,34 +163,50 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
   struct shmid_ds stat;
   int res = shmctl(shmem->id, IPC_STAT, &stat);
   if(res < 0) perror("shmctl IPC_STAT");
+  /* nobody had it mapped, so its pages have not been placed yet */
+  int unmapped = res == 0 && stat.shm_nattch == 0;
 
   /* ensure the segment is owned by user, not root */
-  if(geteuid() == 0 && getuid() != 0) {
+  if(res == 0 && geteuid() == 0 && getuid() != 0) {
     stat.shm_perm.uid = getuid();
     res = shmctl(shmem->id, IPC_SET, &stat);
     if(res < 0) perror("shmctl IPC_SET");
   }
 
+  /* and map it into process space */
+  shmem->mem = shmat(shmem->id, 0, 0);
+  if ((ssize_t) (shmem->mem) == -1) {
+    rtapi_print_msg(RTAPI_MSG_ERR, "rtapi_shmem_new failed due to shmat()\n");
+    return -errno;
+  }
+
 #ifdef RTAPI
   if(rtapi_is_realtime())
   {
+    /* huge pages are never swapped, and the flag is not set for them,
+       whoever created the segment */
+    int huge = rtapi_mapping_is_huge(shmem->mem);
+
     /* ensure the segment is locked */
     res = shmctl(shmem->id, SHM_LOCK, NULL);
     if(res < 0) perror("shmctl IPC_LOCK");
 
     res = shmctl(shmem->id, IPC_STAT, &stat);
     if(res < 0) perror("shmctl IPC_STAT");
-    if((stat.shm_perm.mode & SHM_LOCKED) != SHM_LOCKED)
+    else if(!huge && (stat.shm_perm.mode & SHM_LOCKED) != SHM_LOCKED)
       rtapi_print_msg(RTAPI_MSG_ERR,
           "shared memory segment not locked as requested\n");
   }
 #endif
 
-  /* and map it into process space */
-  shmem->mem = shmat(shmem->id, 0, 0);
-  if ((ssize_t) (shmem->mem) == -1) {
-    rtapi_print_msg(RTAPI_MSG_ERR, "rtapi_shmem_new failed due to shmat()\n");
-    return -errno;
+  /* with several NUMA nodes, the pages of a new segment come from the
+     memory next to the realtime CPU, whichever CPU faults them in */
+  int node = rtapi_shmem_node();
+  if(node >= 0 && unmapped) {
+    unsigned long nodemask = 1UL << node;
+    if(syscall(SYS_mbind, shmem->mem, maplen, MPOL_PREFERRED, &nodemask,
+          sizeof(nodemask) * 8, 0) < 0)
+      perror("mbind");
   }
 
   long pagesize = sysconf(_SC_PAGESIZE);
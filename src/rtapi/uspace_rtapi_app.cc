@@ -377,6 +377,31 @@ static int handle_command(vector<string> args) {
     }
 }
 
+// A "batch" request carries several commands, each as a count of
+// strings followed by the strings, e.g. from halcmd loading a config
+// file.  They are run in order until one fails, and the reply lists
+// the status of each command that was run.
+static vector<int> handle_batch(const vector<string> &args) {
+    vector<int> results;
+    size_t i = 1;
+    while(i < args.size()) {
+        size_t n = strtoul(args[i].c_str(), NULL, 10);
+        i++;
+        if(n == 0 || n > args.size() - i) {
+            rtapi_print_msg(RTAPI_MSG_ERR,
+                "rtapi_app: malformed batch request\n");
+            results.push_back(-EINVAL);
+            break;
+        }
+        vector<string> command(args.begin() + i, args.begin() + i + n);
+        i += n;
+        int result = handle_command(command);
+        results.push_back(result);
+        if(result != 0 || force_exit) break;
+    }
+    return results;
+}
+
 static int slave(int fd, vector<string> args) {
     try {
         write_strings(fd, args);
@@ -401,9 +426,9 @@ static int callback(int fd)
             "rtapi_app: failed to accept connection from slave: %s\n", strerror(errno));
         return -1;
     } else {
-        int result;
+        vector<string> args;
         try {
-            result = handle_command(read_strings(fd1));
+            args = read_strings(fd1);
         } catch (ReadError &e) {
             rtapi_print_msg(RTAPI_MSG_ERR,
                 "rtapi_app: failed to read from slave: %s\n", strerror(errno));
@@ -411,7 +436,14 @@ static int callback(int fd)
             return -1;
         }
         string buf;
-        write_number(buf, result);
+        if(args.size() && args[0] == "batch") {
+            vector<int> results = handle_batch(args);
+            write_number(buf, results.size());
+            for(unsigned int i=0; i<results.size(); i++)
+                write_number(buf, results[i]);
+        } else {
+            write_number(buf, handle_command(args));
+        }
         if(write(fd1, buf.data(), buf.size()) != (ssize_t)buf.size()) {
             rtapi_print_msg(RTAPI_MSG_ERR,
                 "rtapi_app: failed to write to slave: %s\n", strerror(errno));
@@ -429,7 +461,13 @@ static int master(int fd, vector<string> args) {
         perror("pthread_create (queue function)");
         return -1;
     }
-    do_load_cmd("hal_lib", vector<string>()); instance_count = 0;
+    // like the arguments of a load command, the first is the module name
+    vector<string> hal_lib_args(1, "hal_lib");
+    if(getenv("HAL_SIZE"))
+        hal_lib_args.push_back(string("hal_size=") + getenv("HAL_SIZE"));
+    if(getenv("HAL_PARALLEL_CPUS"))
+        hal_lib_args.push_back(string("parallel_cpus=") + getenv("HAL_PARALLEL_CPUS"));
+    do_load_cmd("hal_lib", hal_lib_args); instance_count = 0;
     App(); // force rtapi_app to be created
     int result=0;
     if(args.size()) {
@@ -561,9 +599,9 @@ struct rtapi_module {
 #define MODULE_OFFSET 32768
 
 rtapi_task::rtapi_task()
-    : magic{}, id{}, owner{}, stacksize{}, prio{},
-      period{}, nextstart{},
-      ratio{}, arg{}, taskcode{}
+    : magic{}, id{}, owner{}, stacksize{}, prio{}, cpu(-1),
+      period{}, nextstart{}, start{}, started{}, leader(-1),
+      ratio{}, arg{}, taskcode{}, stats{}, woke{}
 {}
 
 namespace
@@ -588,6 +626,8 @@ struct Posix : RtapiApp
     int task_pause(int task_id);
     int task_resume(int task_id);
     int task_self();
+    int task_set_cpu(int task_id, int cpu);
+    int task_follow(int task_id, int leader_id);
     void wait();
     struct rtapi_task *do_task_new() {
         return new PosixTask;
@@ -596,6 +636,7 @@ struct Posix : RtapiApp
     void do_outb(unsigned char value, unsigned int port);
     int run_threads(int fd, int (*callback)(int fd));
     static void *wrapper(void *arg);
+    bool takes_thread_lock(rtapi_task *task);
     bool do_thread_lock;
     pthread_mutex_t thread_lock;
 
@@ -854,6 +895,8 @@ int RtapiApp::task_new(void (*taskcode) (void*), void *arg,
   task->stacksize = stacksize;
   task->taskcode = taskcode;
   task->prio = prio;
+  task->cpu = -1;
+  task->leader = -1;
   task->magic = TASK_MAGIC;
   task_array[n] = task;
 
@@ -872,6 +915,14 @@ rtapi_task *RtapiApp::get_task(int task_id) {
     return task;
 }
 
+int RtapiApp::task_set_cpu(int task_id, int cpu) {
+    return -ENOSYS;
+}
+
+int RtapiApp::task_follow(int task_id, int leader_id) {
+    return -ENOSYS;
+}
+
 void RtapiApp::unexpected_realtime_delay(rtapi_task *task, int nperiod) {
     static int printed = 0;
     if(!printed)
@@ -885,6 +936,80 @@ void RtapiApp::unexpected_realtime_delay(rtapi_task *task, int nperiod) {
     }
 }
 
+static_assert(MAX_TASKS <= RTAPI_TASKSTATS_TASKS, "too few task statistics slots");
+
+static int taskstats_id = -1;
+static int taskstats_users;
+static rtapi_taskstats_t *taskstats;
+
+static long long timespec_diff(const struct timespec &a, const struct timespec &b) {
+    return (a.tv_sec - b.tv_sec) * 1000000000LL + (a.tv_nsec - b.tv_nsec);
+}
+
+// The statistics segment exists while any task is running.  Tasks are
+// started and deleted by the master, not by the realtime threads.
+void RtapiApp::task_stats_start(rtapi_task *task) {
+    if(!taskstats) {
+        taskstats_id = rtapi_shmem_new(RTAPI_TASKSTATS_KEY, 0, sizeof(rtapi_taskstats_t));
+        if(taskstats_id < 0) return;
+        void *mem;
+        if(rtapi_shmem_getptr(taskstats_id, &mem) < 0) {
+            rtapi_shmem_delete(taskstats_id, 0);
+            return;
+        }
+        taskstats = reinterpret_cast<rtapi_taskstats_t*>(mem);
+        memset(taskstats, 0, sizeof(*taskstats));
+    }
+    rtapi_task_stats_t *stats = &taskstats->task[task->id];
+    memset(stats, 0, sizeof(*stats));
+    stats->id = task->id;
+    stats->period = task->period;
+    stats->active = 1;
+    task->stats = stats;
+    task->woke = {};
+    taskstats_users++;
+}
+
+void RtapiApp::task_stats_stop(rtapi_task *task) {
+    if(!task->stats) return;
+    task->stats->active = 0;
+    task->stats = nullptr;
+    if(--taskstats_users == 0) {
+        rtapi_shmem_delete(taskstats_id, 0);
+        taskstats = nullptr;
+        taskstats_id = -1;
+    }
+}
+
+// called by wait() before it sleeps: the time since the task woke up
+void RtapiApp::task_stats_ran(rtapi_task *task, const struct timespec &now) {
+    rtapi_task_stats_t *stats = task->stats;
+    if(stats->reset != stats->reset_done) {
+        unsigned reset = stats->reset;
+        stats->wakeups = stats->overruns = 0;
+        stats->late_max = stats->exec_max = 0;
+        memset(stats->late, 0, sizeof(stats->late));
+        memset(stats->exec, 0, sizeof(stats->exec));
+        stats->reset_done = reset;
+        task->woke = {};
+    }
+    if(task->woke.tv_sec == 0 && task->woke.tv_nsec == 0) return;
+    long long exec = timespec_diff(now, task->woke);
+    stats->exec[rtapi_taskstats_bucket(exec)]++;
+    if(exec > stats->exec_max) stats->exec_max = exec;
+    if(rtapi_timespec_less(task->nextstart, now)) stats->overruns++;
+}
+
+// called by wait() once the task is to run again: how late that is
+void RtapiApp::task_stats_woke(rtapi_task *task, const struct timespec &now) {
+    rtapi_task_stats_t *stats = task->stats;
+    long long late = timespec_diff(now, task->nextstart);
+    stats->late[rtapi_taskstats_bucket(late)]++;
+    if(late > stats->late_max) stats->late_max = late;
+    stats->wakeups++;
+    task->woke = now;
+}
+
 int Posix::task_delete(int id)
 {
   auto task = ::rtapi_get_task<PosixTask>(id);
@@ -892,6 +1017,7 @@ int Posix::task_delete(int id)
 
   pthread_cancel(task->thr);
   pthread_join(task->thr, 0);
+  task_stats_stop(task);
   task->magic = 0;
   task_array[id] = 0;
   delete task;
@@ -914,7 +1040,10 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
   cpu_set_t cpuset;
   CPU_ZERO(&cpuset);
   int nprocs = sysconf( _SC_NPROCESSORS_ONLN );
-  CPU_SET(nprocs-1, &cpuset); // assumes processor numbers are contiguous
+  if(task->cpu >= 0)
+      CPU_SET(task->cpu, &cpuset);
+  else
+      CPU_SET(nprocs-1, &cpuset); // assumes processor numbers are contiguous
 
   pthread_attr_t attr;
   if(pthread_attr_init(&attr) < 0)
@@ -930,8 +1059,11 @@ int Posix::task_start(int task_id, unsigned long int period_nsec)
   if(nprocs > 1)
       if(pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset) < 0)
           return -errno;
-  if(pthread_create(&task->thr, &attr, &wrapper, reinterpret_cast<void*>(task)) < 0)
+  task_stats_start(task);
+  if(pthread_create(&task->thr, &attr, &wrapper, reinterpret_cast<void*>(task)) < 0) {
+      task_stats_stop(task);
       return -errno;
+  }
 
   return 0;
 }
@@ -953,16 +1085,37 @@ void *Posix::wrapper(void *arg)
   task->period = task->ratio * period;
   rtapi_print_msg(RTAPI_MSG_INFO, "task %p period = %lu ratio=%u\n",
 	  task, task->period, task->ratio);
+  if(task->stats) task->stats->period = task->period;
 
   pthread_setspecific(key, arg);
 
   Posix &papp = reinterpret_cast<Posix&>(App());
-  if(papp.do_thread_lock)
+  if(papp.takes_thread_lock(task))
       pthread_mutex_lock(&papp.thread_lock);
 
   struct timespec now;
   clock_gettime(RTAPI_CLOCK, &now);
-  rtapi_timespec_advance(task->nextstart, now, task->period);
+  if(task->leader >= 0) {
+      // wake up with the leader: at its first wakeup plus whole periods
+      rtapi_task *leader;
+      while((leader = RtapiApp::get_task(task->leader))
+              && !__atomic_load_n(&leader->started, __ATOMIC_ACQUIRE)) {
+          struct timespec ts = {0, 100000};
+          nanosleep(&ts, nullptr);
+          clock_gettime(RTAPI_CLOCK, &now);
+      }
+      if(leader) {
+          task->nextstart = leader->start;
+          while(!rtapi_timespec_less(now, task->nextstart))
+              rtapi_timespec_advance(task->nextstart, task->nextstart, task->period);
+      } else {
+          rtapi_timespec_advance(task->nextstart, now, task->period);
+      }
+  } else {
+      rtapi_timespec_advance(task->nextstart, now, task->period);
+  }
+  task->start = task->nextstart;
+  __atomic_store_n(&task->started, 1, __ATOMIC_RELEASE);
 
   /* call the task function with the task argument */
   (task->taskcode) (task->arg);
@@ -979,6 +1132,29 @@ int Posix::task_resume(int) {
     return -ENOSYS;
 }
 
+// A task pinned to a processor of its own only runs HAL functions when
+// the thread it helps tells it to, while that thread holds the lock.
+bool Posix::takes_thread_lock(rtapi_task *task) {
+    return do_thread_lock && task->cpu < 0;
+}
+
+int Posix::task_set_cpu(int task_id, int cpu) {
+  auto task = ::rtapi_get_task<PosixTask>(task_id);
+  if(!task) return -EINVAL;
+  int nprocs = sysconf( _SC_NPROCESSORS_ONLN );
+  if(cpu < 0 || cpu >= nprocs || cpu >= CPU_SETSIZE) return -EINVAL;
+  task->cpu = cpu;
+  return 0;
+}
+
+int Posix::task_follow(int task_id, int leader_id) {
+  auto task = ::rtapi_get_task<PosixTask>(task_id);
+  if(!task || !RtapiApp::get_task(leader_id) || task_id == leader_id)
+      return -EINVAL;
+  task->leader = leader_id;
+  return 0;
+}
+
 int Posix::task_self() {
     struct rtapi_task *task = reinterpret_cast<rtapi_task*>(pthread_getspecific(key));
     if(!task) return -EINVAL;
@@ -986,13 +1162,16 @@ int Posix::task_self() {
 }
 
 void Posix::wait() {
-    if(do_thread_lock)
+    struct rtapi_task *task = reinterpret_cast<rtapi_task*>(pthread_getspecific(key));
+    bool lock = takes_thread_lock(task);
+    if(lock)
         pthread_mutex_unlock(&thread_lock);
     pthread_testcancel();
-    struct rtapi_task *task = reinterpret_cast<rtapi_task*>(pthread_getspecific(key));
     rtapi_timespec_advance(task->nextstart, task->nextstart, task->period);
     struct timespec now;
     clock_gettime(RTAPI_CLOCK, &now);
+    if(task->stats)
+        task_stats_ran(task, now);
     if(rtapi_timespec_less(task->nextstart, now))
     {
         if(policy == SCHED_FIFO)
@@ -1002,8 +1181,12 @@ void Posix::wait() {
     {
         int res = rtapi_clock_nanosleep(RTAPI_CLOCK, TIMER_ABSTIME, &task->nextstart, nullptr, &now);
         if(res < 0) perror("clock_nanosleep");
+        if(task->stats)
+            clock_gettime(RTAPI_CLOCK, &now);
     }
-    if(do_thread_lock)
+    if(task->stats)
+        task_stats_woke(task, now);
+    if(lock)
         pthread_mutex_lock(&thread_lock);
 }
 
@@ -1093,6 +1276,16 @@ int rtapi_task_self()
     return App().task_self();
 }
 
+int rtapi_task_set_cpu(int task_id, int cpu_id)
+{
+    return App().task_set_cpu(task_id, cpu_id);
+}
+
+int rtapi_task_follow(int task_id, int leader_id)
+{
+    return App().task_follow(task_id, leader_id);
+}
+
 void rtapi_wait(void)
 {
     App().wait();
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Time sin, cos and tan of the blend intersection angle computed with
+# trig functions and in closed form.
+# Run from a run-in-place tree:  sh blend-trig.sh [pairs]
+set -e
+SRC=../../src
+T=$(mktemp -d)
+trap 'rm -rf $T' EXIT
+gcc -O2 -DULAPI -I$SRC -I$SRC/rtapi -I$SRC/hal -I$SRC/libnml/posemath \
+    -I$SRC/emc/tp -I$SRC/emc/nml_intf -I$SRC/emc/motion -I$SRC/emc/kinematics \
+    ../trajectory-planner/blend-trig/test.c $SRC/emc/tp/blendmath.c \
+    $SRC/emc/tp/spherical_arc.c $SRC/libnml/posemath/_posemath.c -lm -o $T/test
+$T/test bench ${1:-10000000}
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Time a scan of each of the classicladder example projects, with the
+# rungs and expressions interpreted and compiled, see
+# ../classicladder-compiled/test.c.
+# Run from a run-in-place tree:  sh classicladder.sh [scans]
+set -e
+CL=../../src/hal/classicladder
+FLAGS="-O2 -fcommon -DSEQUENTIAL_SUPPORT -DDYNAMIC_PLCSIZE -DOLD_TIMERS_MONOS_SUPPORT -DMODBUS_IO_MASTER -I../../src/rtapi -I../../src/hal -I$CL"
+T=$(mktemp -d)
+trap 'rm -rf $T' EXIT
+gcc $FLAGS -DRTAPI -DHAL_SUPPORT -c $CL/arrays.c -o $T/arrays.o
+gcc $FLAGS -w ../classicladder-compiled/test.c $CL/arithm_eval.c $CL/calc.c \
+    $CL/calc_sequential.c $CL/files.c $CL/files_project.c \
+    $CL/files_sequential.c $CL/manager.c $CL/symbols.c $CL/vars_access.c \
+    $T/arrays.o -lm -o $T/test
+$T/test bench ${1:-20000} $CL/projects_examples/*.clp
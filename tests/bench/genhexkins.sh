@@ -0,0 +1,15 @@
+#!/bin/sh
+# Time the genhexkins forward kinematics along the trajectory of
+# ../genhexkins/test.c, with one caller and with two (feedback and
+# command, as in motion).
+# Run from a run-in-place tree:  sh genhexkins.sh [samples]
+set -e
+SRC=../../src
+T=$(mktemp -d)
+trap 'rm -rf $T' EXIT
+gcc -O2 -DRTAPI -DSIM -D_GNU_SOURCE -I$SRC -I$SRC/rtapi -I$SRC/hal \
+    -I$SRC/libnml/posemath -I$SRC/emc/nml_intf -I$SRC/emc/kinematics \
+    ../genhexkins/test.c $SRC/libnml/posemath/_posemath.c -lm -o $T/test
+for CALLERS in 1 2; do
+    $T/test ${1:-20000} $CALLERS
+done
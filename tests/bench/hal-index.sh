@@ -0,0 +1,8 @@
+#!/bin/sh
+# Time pin and signal creation and name lookups with a large number of
+# pins.  Run from a run-in-place tree:  sh hal-index.sh [npins]
+# HAL_SIZE makes the HAL memory big enough for 50000 pins.
+export HAL_SIZE=${HAL_SIZE:-67108864}
+realtime start
+python ../hal-index/pins.py ${1:-50000}
+realtime stop
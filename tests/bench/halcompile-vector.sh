@@ -0,0 +1,26 @@
+#!/bin/sh
+# Compare lowpass with one function per instance against the same
+# component built with 'option vector yes', for several instance counts.
+# Run from a run-in-place tree:  sh halcompile-vector.sh [count...]
+set -e
+T=$(mktemp -d)
+# halcompile --install puts lowpassv in the tree's rtlib, take it out again
+trap 'rm -rf $T; rm -f $EMC2_HOME/rtlib/lowpassv.so $EMC2_HOME/rtlib/lowpassv.ko' EXIT
+sed 's/^component lowpass/component lowpassv/; s/^function _;/function _;\noption vector yes;/' \
+    ../../src/hal/components/lowpass.comp > $T/lowpassv.comp
+(cd $T && halcompile --install lowpassv.comp > /dev/null)
+
+for N in ${*:-1 4 16 64}; do
+    halrun > $T/out <<EOT
+loadrt lowpass count=$N
+loadrt lowpassv count=$N
+loadrt threads name1=a period1=1000000 name2=b period2=1000000
+$(i=0; while [ $i -lt $N ]; do echo "addf lowpass.$i a"; i=$((i+1)); done)
+addf lowpassv b
+start
+loadusr -w sleep 2
+getp a.tmax
+getp b.tmax
+EOT
+    echo "count=$N per-instance $(sed -n 1p $T/out) vector $(sed -n 2p $T/out) (max cycles)"
+done
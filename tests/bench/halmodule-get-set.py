@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+# Compare ways of reading and writing many pins from Python.
+# Run with realtime started:  python halmodule-get-set.py [npins] [loops]
+import hal
+import array
+import sys
+import time
+
+npins = int(sys.argv[1]) if len(sys.argv) > 1 else 200
+loops = int(sys.argv[2]) if len(sys.argv) > 2 else 1000
+
+h = hal.component("halbench")
+names = ["p%d" % i for i in range(npins)]
+pins = [h.newpin(n, hal.HAL_FLOAT, hal.HAL_IO) for n in names]
+h.ready()
+
+def bench(label, fn):
+    t0 = time.time()
+    for i in xrange(loops):
+        fn()
+    t = time.time() - t0
+    print "%-28s %8.2f us/pin" % (label, t * 1e6 / loops / npins)
+
+buf = array.array('d', [0] * npins)
+
+def subscript_get():
+    for n in names: h[n]
+def subscript_set():
+    for n in names: h[n] = 1.0
+def item_get():
+    for p in pins: p.get()
+def item_set():
+    for p in pins: p.set(1.0)
+def many_get_names():
+    h.get_many(names)
+def many_get_items():
+    h.get_many(pins)
+def many_get_buffer():
+    h.get_many(pins, buf)
+def many_set_buffer():
+    h.set_many(pins, buf)
+
+try:
+    bench("h[name] read", subscript_get)
+    bench("h[name] = v", subscript_set)
+    bench("pin.get()", item_get)
+    bench("pin.set(v)", item_set)
+    bench("get_many(names)", many_get_names)
+    bench("get_many(pins)", many_get_items)
+    bench("get_many(pins, buffer)", many_get_buffer)
+    bench("set_many(pins, buffer)", many_set_buffer)
+finally:
+    h.exit()
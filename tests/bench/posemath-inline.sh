@@ -0,0 +1,11 @@
+#!/bin/sh
+# Time the blendFindPoints3 style operations through the out-of-line
+# posemath functions and through posemath_inline.h.
+# Run from a run-in-place tree:  sh posemath-inline.sh [iterations]
+set -e
+SRC=../../src
+T=$(mktemp -d)
+trap 'rm -rf $T' EXIT
+gcc -O2 -DULAPI -I$SRC -I$SRC/rtapi -I$SRC/libnml/posemath \
+    ../posemath-inline/test.c $SRC/libnml/posemath/_posemath.c -lm -o $T/test
+$T/test bench ${1:-100000000}
@@ -0,0 +1,177 @@
+/* Runs classicladder projects outside of HAL, once through the rungs
+   and expressions compiled by PrepareRungs() and once interpreted (with
+   the Compiled flags cleared), with the same inputs, and compares the
+   state after every scan: bit, word and float variables (which hold the
+   sequential steps too), old timers, monostables, counters, IEC timers
+   and the dynamic states of every rung element.
+
+   usage: test check N project.clp...    first difference in N scans
+          test bench N project.clp...    ns per scan of each way
+
+   The classicladder sources are built without GTK_INTERFACE and
+   HAL_SUPPORT, with arrays.c built as for the realtime module; the few
+   things they need from the rest are stubbed here. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "classicladder.h"
+#include "global.h"
+#include "calc.h"
+#include "files_project.h"
+#include "vars_access.h"
+
+int ClassicLadder_AllocAll(void);
+void ClassicLadder_InitAllDatas(void);
+
+/* protocol_modbus_master.c, emc_mods.c and vars_names.c are not built */
+StrModbusMasterReq ModbusMasterReq[NBR_MODBUS_MASTER_REQ];
+char ModbusSerialPortNameUsed[30];
+int ModbusSerialSpeed, ModbusSerialDataBits, ModbusSerialStopBits;
+int ModbusSerialParity, ModbusSerialUseRtsToSend;
+int ModbusTimeInterFrame, ModbusTimeOutReceipt, ModbusTimeAfterTransmit;
+int ModbusEleOffset, ModbusDebugLevel;
+int MapCoilRead, MapCoilWrite, MapInputs, MapHolding;
+int MapRegisterRead, MapRegisterWrite;
+int modmaster;
+void PrepareModbusMaster(void) { }
+void SymbolsAutoAssign(void) { }
+void UpdateSizesOfConvVarNameTable(void) { }
+
+/* rtapi, as used by arrays.c: one block of memory */
+void rtapi_print(const char *fmt, ...) { }
+void rtapi_print_msg(int level, const char *fmt, ...) { }
+static void *shmem;
+int rtapi_shmem_new(int key, int module_id, unsigned long int size) {
+    if (!shmem) shmem = calloc(1, size);
+    return shmem ? 1 : -1;
+}
+int rtapi_shmem_getptr(int shmem_id, void **ptr) { *ptr = shmem; return 0; }
+int rtapi_shmem_delete(int shmem_id, int module_id) { return 0; }
+
+enum { BITS, WORDS, FLOATS, TIMERS, MONOSTABLES, COUNTERS, TIMERS_IEC, RUNGS, N_PARTS };
+static const char *part_names[N_PARTS] = {
+    "bit variables", "word variables", "float variables", "timers",
+    "monostables", "counters", "IEC timers", "rung elements"
+};
+typedef unsigned long long hash_t;
+
+static hash_t hash(hash_t h, const void *p, size_t n) {
+    const unsigned char *c = p;
+    while (n--) h = (h ^ *c++) * 1099511628211ULL;
+    return h;
+}
+
+static void snapshot(hash_t *h) {
+    int i, x, y;
+    for (i = 0; i < N_PARTS; i++) h[i] = 1469598103934665603ULL;
+    h[BITS] = hash(h[BITS], VarArray, SIZE_VAR_ARRAY * sizeof(*VarArray));
+    h[WORDS] = hash(h[WORDS], VarWordArray, SIZE_VAR_WORD_ARRAY * sizeof(*VarWordArray));
+    h[FLOATS] = hash(h[FLOATS], VarFloatArray, SIZE_VAR_FLOAT_ARRAY * sizeof(*VarFloatArray));
+    h[TIMERS] = hash(h[TIMERS], TimerArray, NBR_TIMERS * sizeof(*TimerArray));
+    h[MONOSTABLES] = hash(h[MONOSTABLES], MonostableArray, NBR_MONOSTABLES * sizeof(*MonostableArray));
+    h[COUNTERS] = hash(h[COUNTERS], CounterArray, NBR_COUNTERS * sizeof(*CounterArray));
+    h[TIMERS_IEC] = hash(h[TIMERS_IEC], NewTimerArray, NBR_TIMERS_IEC * sizeof(*NewTimerArray));
+    for (i = 0; i < NBR_RUNGS; i++) {
+        for (x = 0; x < RUNG_WIDTH; x++) {
+            for (y = 0; y < RUNG_HEIGHT; y++) {
+                StrElement *e = &RungArray[i].Element[x][y];
+                char d[4] = { e->DynamicInput, e->DynamicState, e->DynamicOutput, e->DynamicVarBak };
+                h[RUNGS] = hash(h[RUNGS], d, sizeof(d));
+            }
+        }
+    }
+}
+
+static unsigned rnd;
+static unsigned next(void) {
+    rnd = rnd * 1103515245 + 12345;
+    return rnd >> 16;
+}
+
+/* loads 'project', then runs 'scans' scans with inputs that change
+   the same way each time; with 'states' set, stores the state after
+   each scan there, and returns the ns per scan */
+static double run(char *project, int compiled, int scans, hash_t (*states)[N_PARTS]) {
+    struct timespec t0, t1;
+    double ns = 0;
+    int s, i;
+
+    ClassicLadder_InitAllDatas();
+    if (!LoadProjectFiles(project)) {
+        printf("%s: cannot load\n", project);
+        exit(1);
+    }
+    if (!compiled) {
+        for (i = 0; i < NBR_RUNGS; i++) RungArray[i].Compiled = 0;
+        for (i = 0; i < NBR_ARITHM_EXPR; i++) ArithmExpr[i].Compiled = 0;
+    }
+    InfosGene->GeneralParams.PeriodicRefreshMilliSecs = 10;
+    rnd = 1;
+    for (s = 0; s < scans; s++) {
+        for (i = 0; i < NBR_PHYS_INPUTS; i++)
+            if ((next() & 7) == 0)
+                WriteVar(VAR_PHYS_INPUT, i, !ReadVar(VAR_PHYS_INPUT, i));
+        for (i = 0; i < NBR_PHYS_WORDS_INPUTS; i++)
+            WriteVar(VAR_PHYS_WORD_INPUT, i, next() % 20);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        ClassicLadder_RefreshAllSections();
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        ns += (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+        if (states) snapshot(states[s]);
+    }
+    return ns / scans;
+}
+
+static int compiled_rungs(void) {
+    int i, n = 0;
+    for (i = 0; i < NBR_RUNGS; i++) n += RungArray[i].Compiled != 0;
+    return n;
+}
+
+static int compiled_exprs(void) {
+    int i, n = 0;
+    for (i = 0; i < NBR_ARITHM_EXPR; i++) n += ArithmExpr[i].Compiled != 0;
+    return n;
+}
+
+int main(int argc, char **argv) {
+    int bench, scans, k, s, p;
+    hash_t (*interpreted)[N_PARTS], (*compiled)[N_PARTS];
+
+    if (argc < 4 || (strcmp(argv[1], "check") && strcmp(argv[1], "bench"))) {
+        fprintf(stderr, "usage: test check|bench N project.clp...\n");
+        return 2;
+    }
+    bench = strcmp(argv[1], "bench") == 0;
+    scans = atoi(argv[2]);
+    interpreted = calloc(scans, sizeof(*interpreted));
+    compiled = calloc(scans, sizeof(*compiled));
+
+    ClassicLadder_AllocAll();
+    for (k = 3; k < argc; k++) {
+        char *name = strrchr(argv[k], '/') ? strrchr(argv[k], '/') + 1 : argv[k];
+        if (bench) {
+            double t0 = run(argv[k], 0, scans, NULL);
+            double t1 = run(argv[k], 1, scans, NULL);
+            printf("%-32s interpreted %7.0f ns  compiled %7.0f ns\n", name, t0, t1);
+            continue;
+        }
+        run(argv[k], 0, scans, interpreted);
+        run(argv[k], 1, scans, compiled);
+        printf("%s: %d rungs and %d expressions compiled, ", name,
+            compiled_rungs(), compiled_exprs());
+        for (s = 0; s < scans; s++) {
+            for (p = 0; p < N_PARTS; p++)
+                if (interpreted[s][p] != compiled[s][p]) break;
+            if (p < N_PARTS) break;
+        }
+        if (s < scans) {
+            printf("%s differ after scan %d\n", part_names[p], s + 1);
+            return 1;
+        }
+        printf("same after each of %d scans\n", scans);
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/sh
+# classicladder outside of HAL, see test.c; the flags that change the
+# layout of its structs are the same for every file, and -fcommon
+# because several of its files define the same globals
+CL=../../src/hal/classicladder
+FLAGS="-O2 -fcommon -DSEQUENTIAL_SUPPORT -DDYNAMIC_PLCSIZE -DOLD_TIMERS_MONOS_SUPPORT -DMODBUS_IO_MASTER -I../../src/rtapi -I../../src/hal -I$CL"
+gcc $FLAGS -DRTAPI -DHAL_SUPPORT -c $CL/arrays.c -o arrays.o &&
+gcc $FLAGS -w test.c $CL/arithm_eval.c $CL/calc.c $CL/calc_sequential.c \
+    $CL/files.c $CL/files_project.c $CL/files_sequential.c $CL/manager.c \
+    $CL/symbols.c $CL/vars_access.c arrays.o -lm -o test || exit 1
+./test check 2000 $CL/projects_examples/*.clp; exitval=$?
+rm -f test arrays.o
+exit $exitval
@@ -0,0 +1,133 @@
+/* Runs genhexkins outside of HAL: round trips (inverse, then forward
+   from the previous solution) along a synthetic trajectory of the default
+   platform, as motion does every servo cycle.
+
+   usage: test samples callers [budget-ns]
+
+   With 2 callers, the forward kinematics are called alternately for the
+   trajectory and for the same trajectory 50ms later, like the feedback
+   and commanded positions in motion.  Prints the worst error and the
+   number of failed calls, and the time per round trip on stderr. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "genhexkins.c"
+
+int hal_init(const char *name) { return 1; }
+int hal_ready(int comp_id) { return 0; }
+int hal_exit(int comp_id) { return 0; }
+void *hal_malloc(long int size) { return calloc(1, size); }
+int hal_param_float_newf(hal_param_dir_t dir, hal_float_t *data_addr,
+    int comp_id, const char *fmt, ...) { return 0; }
+int hal_param_u32_newf(hal_param_dir_t dir, hal_u32_t *data_addr,
+    int comp_id, const char *fmt, ...) { return 0; }
+int hal_pin_float_newf(hal_pin_dir_t dir, hal_float_t **data_ptr_addr,
+    int comp_id, const char *fmt, ...)
+{
+    *data_ptr_addr = calloc(1, sizeof(**data_ptr_addr));
+    return 0;
+}
+int hal_pin_u32_newf(hal_pin_dir_t dir, hal_u32_t **data_ptr_addr,
+    int comp_id, const char *fmt, ...)
+{
+    *data_ptr_addr = calloc(1, sizeof(**data_ptr_addr));
+    return 0;
+}
+long long int rtapi_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+static void trajectory(int k, double lag, EmcPose *p)
+{
+    double t = k * 0.001 - lag;
+    p->tran.x = 3 * sin(t);
+    p->tran.y = 3 * cos(1.3 * t);
+    p->tran.z = 20 + sin(0.7 * t);
+    p->a = 5 * sin(0.9 * t);
+    p->b = 4 * cos(1.1 * t);
+    p->c = 10 * sin(0.5 * t);
+    p->u = p->v = p->w = 0;
+}
+
+static double pose_error(const EmcPose *p, const EmcPose *q)
+{
+    double e = fabs(p->tran.x - q->tran.x);
+    e = fmax(e, fabs(p->tran.y - q->tran.y));
+    e = fmax(e, fabs(p->tran.z - q->tran.z));
+    e = fmax(e, fabs(p->a - q->a));
+    e = fmax(e, fabs(p->b - q->b));
+    e = fmax(e, fabs(p->c - q->c));
+    return e;
+}
+
+int main(int argc, char **argv)
+{
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    EmcPose want, pos[2], before;
+    double joints[9], max_error = 0;
+    int samples, callers, k, c, failures = 0, kept = 1;
+    unsigned overruns;
+    long long int start;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: test samples callers [budget-ns]\n");
+        return 1;
+    }
+    samples = atoi(argv[1]);
+    callers = atoi(argv[2]) == 2 ? 2 : 1;
+    if (rtapi_app_main() != 0) {
+        return 1;
+    }
+    if (argc > 3) {
+        haldata->time_budget = atoi(argv[3]);
+    }
+
+    for (c = 0; c < callers; c++) {
+        trajectory(0, c * 0.05, &pos[c]);
+    }
+    start = rtapi_get_time();
+    for (k = 1; k <= samples; k++) {
+        for (c = 0; c < callers; c++) {
+            trajectory(k, c * 0.05, &want);
+            kinematicsInverse(&want, joints, &iflags, &fflags);
+            before = pos[c];
+            overruns = *haldata->budget_overruns;
+            if (kinematicsForward(joints, &pos[c], &fflags, &iflags) != 0) {
+                failures++;
+            }
+            if (haldata->time_budget == 0) {
+                max_error = fmax(max_error, pose_error(&want, &pos[c]));
+            } else if (*haldata->budget_overruns != overruns &&
+                       pose_error(&before, &pos[c]) != 0) {
+                /* an abandoned solution must leave the pose alone */
+                kept = 0;
+            }
+        }
+    }
+    fprintf(stderr, "callers %d: %.2f us per round trip\n", callers,
+        (rtapi_get_time() - start) * 1e-3 / (samples * callers));
+
+    printf("callers %d: %d failures", callers, failures);
+    if (haldata->time_budget == 0) {
+        printf(", error %s\n", max_error < 1e-6 ? "ok" : "too large");
+    } else {
+        printf(", %s, poses %s\n",
+            *haldata->budget_overruns ? "overruns" : "no overruns",
+            kept ? "kept" : "changed");
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/sh
+SRC=../../src
+gcc -O2 -DRTAPI -DSIM -D_GNU_SOURCE -I$SRC -I$SRC/rtapi -I$SRC/hal \
+    -I$SRC/libnml/posemath -I$SRC/emc/nml_intf -I$SRC/emc/kinematics \
+    test.c $SRC/libnml/posemath/_posemath.c -lm -o test || exit 1
+./test 2000 1 2>/dev/null && ./test 2000 2 2>/dev/null &&
+# a budget of 1ns is always exceeded after the first iteration
+./test 200 2 1 2>/dev/null; exitval=$?
+rm -f test
+exit $exitval
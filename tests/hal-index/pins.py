@@ -0,0 +1,44 @@
+#!/usr/bin/env python
+# Time creating many pins, then signals linked to two pins each, which
+# looks up every name through the HAL name index.  With -q only the
+# counts are printed, for the test.
+# Run with realtime started:  python pins.py [-q] [npins]
+import hal
+import sys
+import time
+
+quiet = len(sys.argv) > 1 and sys.argv[1] == "-q"
+if quiet:
+    del sys.argv[1]
+npins = int(sys.argv[1]) if len(sys.argv) > 1 else 50000
+
+def report(label, t, count):
+    if quiet:
+        print "%s %d" % (label, count)
+    else:
+        print "%-16s %6d in %7.3f s" % (label, count, t)
+
+h = hal.component("idx")
+try:
+    t0 = time.time()
+    for i in xrange(npins):
+        h.newpin("p%d" % i, hal.HAL_FLOAT, hal.HAL_OUT if i % 2 == 0 else hal.HAL_IN)
+    h.ready()
+    report("pins", time.time() - t0, npins)
+
+    t0 = time.time()
+    for i in xrange(0, npins - 1, 2):
+        s = "idx-s%d" % i
+        hal.new_sig(s, hal.HAL_FLOAT)
+        hal.connect("idx.p%d" % i, s)
+        hal.connect("idx.p%d" % (i + 1), s)
+    report("signals+links", time.time() - t0, npins // 2)
+
+    t0 = time.time()
+    found = 0
+    for i in xrange(1, npins, 2):
+        if hal.pin_has_writer("idx.p%d" % i):
+            found += 1
+    report("lookups", time.time() - t0, found)
+finally:
+    h.exit()
@@ -0,0 +1,5 @@
+#!/bin/sh
+export HAL_SIZE=8388608
+realtime start
+python pins.py -q 5000
+realtime stop
@@ -0,0 +1,63 @@
+#!/bin/bash
+# the first loadrt starts rtapi_app, which keeps halcmd's stdout and
+# stderr, so its output goes to a file and not to runtests' pipe
+realtime start
+halcmd loadrt not count=1 > load.out 2>&1 || cat load.out
+rm -f load.out
+
+mem() {
+    halcmd status mem | sed -n "s/^  $1: *//p"
+}
+used() {
+    mem 'used\/total shared memory' | cut -d/ -f1
+}
+recycled() {
+    mem 'component memory' | sed 's/.* bytes, \(.*\) recycled in \(.*\) blocks/\1 \2/'
+}
+load_unload() {
+    halcmd loadrt and2 count=3
+    halcmd loadrt lowpass count=2
+    halcmd loadrt encoder num_chan=2
+    halcmd unloadrt lowpass
+    halcmd unloadrt encoder
+    halcmd unloadrt and2
+}
+
+# the pin, param and function structs made by the first load stay on
+# their free lists, everything else goes back
+load_unload
+base=$(used)
+for i in 1 2 3 4 5; do
+    load_unload
+    if [ "$(used)" != "$base" ]; then
+        echo "cycle $i: $(used) bytes used, $base before"
+    fi
+done
+echo "used memory back to where it was after 5 cycles"
+
+# memory of an unloaded component is reused, zeroed, by the next one:
+# 'or2' above it keeps it on the free lists instead of the free area
+halcmd loadrt constant count=4
+halcmd loadrt or2 count=1
+halcmd setp constant.0.value 1.5
+halcmd setp constant.3.value -2.5
+halcmd unloadrt constant
+set -- $(recycled)
+halcmd loadrt constant count=4
+set -- $1 $2 $(recycled)
+echo "recycled blocks reused: $([ $3 -lt $1 ] && echo yes || echo no)"
+echo "values after reload:" $(halcmd -s show param 'constant.*.value' | awk '{print $4}')
+halcmd unloadrt constant
+halcmd unloadrt or2
+
+# a recycled block larger than a request is split, the rest stays free
+halcmd loadrt encoder num_chan=8
+halcmd loadrt or2 count=1
+halcmd unloadrt encoder
+set -- $(recycled)
+halcmd loadrt constant count=1
+set -- $1 $2 $(recycled)
+# the block of the 8 encoders is much larger than what constant needs
+echo "split: $([ $3 -lt $1 ] && [ $((2 * $3)) -gt $1 ] && echo yes || echo "no, $1 then $3 bytes recycled")"
+echo "value after split:" $(halcmd -s show param 'constant.*.value' | awk '{print $4}')
+realtime stop
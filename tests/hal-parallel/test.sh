@@ -0,0 +1,4 @@
+#!/bin/sh
+# one helper on the first processor, the threads run on the last one
+export HAL_PARALLEL_CPUS=0
+halrun -f parallel.hal
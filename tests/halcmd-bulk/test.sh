@@ -0,0 +1,31 @@
+#!/bin/sh
+# rtapi_app starts with the first loadrt and keeps halcmd's stdout and
+# stderr, so loading goes to a file and not to a pipe that would never
+# close
+load() {
+    realtime start
+    halcmd -f load.hal > load.out 2>&1 || cat load.out
+    rm -f load.out
+}
+
+# a run with errors applies nothing and reports every error
+load
+halcmd save all > before
+halcmd -f bad.hal 2>&1
+echo "exit $?"
+halcmd save all > after
+if cmp -s before after; then echo "unchanged"; else diff before after; fi
+realtime stop
+
+# a clean run gives the same HAL as the same lines run one at a time
+load
+halcmd -f clean.hal
+halcmd save all > bulk
+realtime stop
+load
+halcmd -k -f clean.hal
+halcmd save all > single
+realtime stop
+if cmp -s bulk single; then echo "same as one at a time"; else diff bulk single; fi
+echo "$(grep -c . bulk) lines saved"
+rm -f before after bulk single
@@ -0,0 +1,15 @@
+#!/bin/sh
+set -e
+T=$(mktemp)
+trap 'rm -f $T' EXIT
+halcompile --install vector_test.comp > /dev/null
+halrun -f vector_test.hal > $T
+head -7 $T
+# the one function ran every instance once per period: 'calls' is the
+# 'runs' variable of each instance, equal for all and at least 1
+calls=$(tail -3 $T | sort -u)
+if [ "$(echo "$calls" | wc -l)" -eq 1 ] && [ "$calls" -gt 0 ]; then
+    echo "calls equal"
+else
+    echo "calls" $(tail -3 $T)
+fi
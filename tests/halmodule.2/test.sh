@@ -0,0 +1,54 @@
+#!/bin/sh
+realtime start
+python <<EOF
+import hal
+import array
+h = hal.component("x")
+try:
+    s = h.newpin("s", hal.HAL_S32, hal.HAL_OUT)
+    u = h.newpin("u", hal.HAL_U32, hal.HAL_OUT)
+    f = h.newpin("f", hal.HAL_FLOAT, hal.HAL_OUT)
+    b = h.newpin("b", hal.HAL_BIT, hal.HAL_OUT)
+    p = h.newparam("p", hal.HAL_FLOAT, hal.HAL_RW)
+    h.ready()
+
+    names = ["s", "u", "f", "b", "p"]
+    items = [s, u, f, b, p]
+
+    h.set_many(names, [-3, 7, 1.5, True, 2.25])
+    print h.get_many(names)
+
+    a = array.array('d', [0] * 5)
+    h.get_many(items, a)
+    print list(a)
+
+    h.set_many(items, array.array('d', [4, 5, 6.5, 0, -1]))
+    print h.get_many(items)
+    print h['s'], h.u, s.get()
+
+    def try_set(i, v):
+        try:
+            h.set_many(i, v)
+            print "set ok"
+        except OverflowError:
+            print "set overflow"
+        except ValueError:
+            print "set valueerror"
+        except AttributeError:
+            print "set notfound"
+
+    try_set(["s", "u"], [1, -1])
+    print h.get_many(["s", "u"])
+    try_set(["s", "u"], array.array('d', [1, 4294967296.]))
+    print h.get_many(["s", "u"])
+    try_set(["s"], [1, 2])
+    try_set(["s", "nope"], [1, 2])
+    print h.get_many(["s", "u"])
+except:
+    import traceback
+    print "Exception:", traceback.format_exc()
+    raise
+finally:
+    h.exit()
+EOF
+realtime stop
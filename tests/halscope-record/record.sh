@@ -0,0 +1,24 @@
+#!/bin/sh
+# on a rising edge of the square wave, with the default post-trigger
+# window of 0 the recording ends with the trigger sample
+halscope-record -t fast -T 2 -b 0.05 -o trigger.hsr sum2.0.out siggen.0.square || exit 1
+
+# stop the recorder for longer than the ring lasts, twice
+halscope-record -t fast -d 2 -o gaps.hsr sum2.0.out &
+pid=$!
+for i in 1 2; do
+    sleep 0.4
+    kill -STOP $pid
+    sleep 0.5
+    kill -CONT $pid
+done
+wait $pid || exit 1
+
+# a recorder that was killed leaves the scope streaming; the next one
+# takes over
+halscope-record -t fast -o killed.hsr sum2.0.out &
+pid=$!
+sleep 0.3
+kill -KILL $pid
+wait $pid
+halscope-record -t fast -d 0.1 -o after-kill.hsr sum2.0.out || exit 1
@@ -0,0 +1,7 @@
+#!/bin/sh
+# every reply is delayed by 300us
+hm2_eth_emu -a 127.0.0.1 -L 300 2>/dev/null &
+EMU=$!
+trap "kill $EMU" 0
+sleep 1
+halrun -f busy-poll.hal
@@ -0,0 +1,16 @@
+#!/bin/sh
+# the emulator prints the requests it got per servo cycle when it exits
+run() {
+    hm2_eth_emu -a 127.0.0.1 2>emulator.log &
+    EMU=$!
+    sleep 1
+    echo "combine-packets $1"
+    sed "s/@COMBINE@/$1/" combine.hal.in > combine.hal
+    halrun -f combine.hal
+    kill $EMU
+    wait $EMU
+    grep -o '[0-9.]* requests/cycle' emulator.log
+}
+run 0
+run 1
+rm -f combine.hal emulator.log
@@ -0,0 +1,6 @@
+#!/bin/sh
+hm2_eth_emu -a 127.0.0.42 2>/dev/null &
+EMU=$!
+trap "kill $EMU" 0
+sleep 1
+hm2_eth_emu -B -a 127.0.0.42 -n 500 -t 100000
@@ -0,0 +1,14 @@
+#!/bin/sh
+# the same configuration against a board that answers at once, and one
+# whose replies arrive after the next cycle has started
+run() {
+    hm2_eth_emu -a 127.0.0.1 "$@" 2>/dev/null &
+    EMU=$!
+    sleep 1
+    echo "emulator $*"
+    halrun -f pipeline.hal
+    kill $EMU
+    wait $EMU
+}
+run
+run -L 400
@@ -0,0 +1,6 @@
+#!/bin/sh
+hm2_eth_emu -a 127.0.0.1 2>/dev/null &
+EMU=$!
+trap "kill $EMU" 0
+sleep 1
+halrun -f tram.hal
@@ -0,0 +1,101 @@
+/* Compares the branch-free wrap-around arithmetic of hostmot2-wrap.h
+   with the code it replaced in encoder.c and stepgen.c. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "hostmot2-wrap.h"
+
+/* hm2_encoder_instance_update_rawcounts_and_handle_index() before */
+static rtapi_s32 old_count_diff(rtapi_u16 count, rtapi_u16 prev) {
+    rtapi_s32 reg_count_diff = (rtapi_s32)count - (rtapi_s32)prev;
+    if (reg_count_diff > 32768) reg_count_diff -= 65536;
+    if (reg_count_diff < -32768) reg_count_diff += 65536;
+    return reg_count_diff;
+}
+
+/* hm2_stepgen_process_tram_read() before */
+static rtapi_s64 old_acc_delta(rtapi_u32 acc, rtapi_u32 prev) {
+    rtapi_s64 acc_delta = (rtapi_s64)acc - (rtapi_s64)prev;
+    if (acc_delta > INT32_MAX) {
+        acc_delta -= UINT32_MAX;
+    } else if (acc_delta < INT32_MIN) {
+        acc_delta += UINT32_MAX;
+    }
+    return acc_delta;
+}
+
+static rtapi_u32 seed = 1;
+static rtapi_u32 next(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static const rtapi_u16 count_edges[] = {
+    0, 1, 2, 32766, 32767, 32768, 32769, 32770, 65533, 65534, 65535
+};
+static const rtapi_u32 acc_edges[] = {
+    0, 1, 2, 0x7ffffffe, 0x7fffffff, 0x80000000, 0x80000001, 0x80000002,
+    0xfffffffd, 0xfffffffe, 0xffffffff
+};
+#define N_COUNT_EDGES (sizeof(count_edges) / sizeof(count_edges[0]))
+#define N_ACC_EDGES (sizeof(acc_edges) / sizeof(acc_edges[0]))
+
+static int check_count(rtapi_u16 count, rtapi_u16 prev) {
+    if (hm2_encoder_count_diff(count, prev) != old_count_diff(count, prev)) {
+        printf("count %u prev %u: %d, was %d\n", count, prev,
+            hm2_encoder_count_diff(count, prev), old_count_diff(count, prev));
+        return 1;
+    }
+    return 0;
+}
+
+static int check_acc(rtapi_u32 acc, rtapi_u32 prev) {
+    if (hm2_stepgen_acc_delta(acc, prev) != old_acc_delta(acc, prev)) {
+        printf("acc %u prev %u: %d, was %lld\n", acc, prev,
+            hm2_stepgen_acc_delta(acc, prev), (long long)old_acc_delta(acc, prev));
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int errors = 0;
+    unsigned i, j;
+    long k;
+
+    /* every count against every edge, and the edges against each other */
+    for (i = 0; i < 65536; i++) {
+        for (j = 0; j < N_COUNT_EDGES; j++) {
+            errors += check_count(i, count_edges[j]);
+            errors += check_count(count_edges[j], i);
+        }
+    }
+    for (k = 0; k < 10000000; k++) {
+        errors += check_count(next(), next());
+    }
+
+    for (i = 0; i < N_ACC_EDGES; i++) {
+        for (j = 0; j < N_ACC_EDGES; j++) {
+            errors += check_acc(acc_edges[i], acc_edges[j]);
+            errors += check_acc(acc_edges[i] + next() % 16, acc_edges[j]);
+        }
+    }
+    for (k = 0; k < 10000000; k++) {
+        errors += check_acc(next(), next());
+    }
+
+    /* the cases named in the code */
+    printf("count diff +32768: %d\n", hm2_encoder_count_diff(32768, 0));
+    printf("count diff -32768: %d\n", hm2_encoder_count_diff(0, 32768));
+    printf("count diff 65535 to 0: %d\n", hm2_encoder_count_diff(0, 65535));
+    printf("count unchanged: %d\n", hm2_encoder_count_diff(1234, 1234));
+    printf("acc UINT32_MAX to 0: %d\n", hm2_stepgen_acc_delta(0, UINT32_MAX));
+    printf("acc 0 to UINT32_MAX: %d\n", hm2_stepgen_acc_delta(UINT32_MAX, 0));
+    printf("acc UINT32_MAX to 5: %d\n", hm2_stepgen_acc_delta(5, UINT32_MAX));
+    printf("acc INT32_MAX to INT32_MIN: %d\n", hm2_stepgen_acc_delta(0x80000000, 0x7fffffff));
+    printf("acc unchanged: %d\n", hm2_stepgen_acc_delta(0x12345678, 0x12345678));
+    printf("%d differences\n", errors);
+    return errors != 0;
+}
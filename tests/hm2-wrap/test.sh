@@ -0,0 +1,6 @@
+#!/bin/sh
+SRC=../../src
+gcc -O2 -Wall -I$SRC/rtapi -I$SRC/hal/drivers/mesa-hostmot2 test.c -o test || exit 1
+./test; exitval=$?
+rm -f test
+exit $exitval
@@ -0,0 +1,11 @@
+#!/bin/sh
+realtime start
+# the loadrt lines of a file go to rtapi_app as one batch; the one that
+# fails must be reported against its own line and stop the file there.
+# rtapi_app starts with the first loadrt and keeps halcmd's stdout and
+# stderr, so they go to a file and not to a pipe that would never close
+halcmd -f loadrt.hal > halcmd.out 2>&1
+grep '^loadrt.hal:' halcmd.out
+rm -f halcmd.out
+echo "components:" $(halcmd list comp | tr ' ' '\n' | grep -v '^halcmd' | sort)
+realtime stop
@@ -0,0 +1,130 @@
+/* Compares the out-of-line posemath functions with the by-value inline
+   versions in posemath_inline.h on the operations blendFindPoints3 does
+   for each blend: points along the two tangents, the unit normal, the
+   arc center and a rotated point.
+
+   usage: test check      results of both must be bit-identical
+          test bench N    ns per iteration of each, N iterations */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "posemath.h"
+#include "posemath_inline.h"
+
+typedef struct {
+    PmCartesian start, end, center, rotated;
+} points_t;
+
+static void points_api(PmCartesian const *p, PmCartesian const *u1,
+    PmCartesian const *u2, double d, double h, PmRotationMatrix const *m,
+    points_t *out)
+{
+    PmCartesian t, normal;
+
+    pmCartScalMult(u1, d, &t);
+    pmCartCartSub(p, &t, &out->start);
+    pmCartScalMult(u2, d, &t);
+    pmCartCartAdd(p, &t, &out->end);
+    pmCartCartSub(u2, u1, &t);
+    pmCartUnit(&t, &normal);
+    pmCartScalMult(&normal, h, &t);
+    pmCartCartAdd(p, &t, &out->center);
+    pmCartCartCross(u1, u2, &t);
+    pmMatCartMult(m, &t, &out->rotated);
+}
+
+static void points_inline(PmCartesian const *p, PmCartesian const *u1,
+    PmCartesian const *u2, double d, double h, PmRotationMatrix const *m,
+    points_t *out)
+{
+    PmCartesian normal = pmCartUnitV(pmCartCartSubV(*u2, *u1));
+
+    out->start = pmCartCartSubV(*p, pmCartScalMultV(*u1, d));
+    out->end = pmCartCartAddV(*p, pmCartScalMultV(*u2, d));
+    out->center = pmCartCartAddV(*p, pmCartScalMultV(normal, h));
+    out->rotated = pmMatCartMultV(*m, pmCartCartCrossV(*u1, *u2));
+}
+
+#define INPUTS 1024
+
+static PmCartesian p[INPUTS], u1[INPUTS], u2[INPUTS];
+static PmRotationMatrix m;
+
+static double random_double(void)
+{
+    return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+static PmCartesian random_cart(int unit)
+{
+    PmCartesian v = { random_double(), random_double(), random_double() };
+    return unit ? pmCartUnitV(v) : pmCartScalMultV(v, 100);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef void (*points_fn)(PmCartesian const *, PmCartesian const *,
+    PmCartesian const *, double, double, PmRotationMatrix const *,
+    points_t *);
+
+static double bench(points_fn fn, long n)
+{
+    points_t out;
+    double sum = 0, start = now();
+    long i;
+
+    for (i = 0; i < n; i++) {
+        int k = i % INPUTS;
+        fn(&p[k], &u1[k], &u2[k], 1.5, 0.5, &m, &out);
+        sum += out.start.x + out.end.y + out.center.z + out.rotated.x;
+    }
+    /* keep the results alive */
+    if (sum == 12345.678) {
+        printf("%g\n", sum);
+    }
+    return (now() - start) * 1e9 / n;
+}
+
+int main(int argc, char **argv)
+{
+    PmRpy rpy = { 0.1, 0.2, 0.3 };
+    int i;
+
+    srand(1);
+    for (i = 0; i < INPUTS; i++) {
+        p[i] = random_cart(0);
+        u1[i] = random_cart(1);
+        u2[i] = random_cart(1);
+    }
+    pmRpyMatConvert(&rpy, &m);
+
+    if (argc == 2 && !strcmp(argv[1], "check")) {
+        int differ = 0;
+        for (i = 0; i < INPUTS; i++) {
+            points_t a, b;
+            points_api(&p[i], &u1[i], &u2[i], 1.5, 0.5, &m, &a);
+            points_inline(&p[i], &u1[i], &u2[i], 1.5, 0.5, &m, &b);
+            if (memcmp(&a, &b, sizeof(a))) {
+                differ++;
+            }
+        }
+        printf("%d of %d differ\n", differ, INPUTS);
+        return 0;
+    }
+    if (argc == 3 && !strcmp(argv[1], "bench")) {
+        long n = atol(argv[2]);
+        printf("out-of-line %.1f ns/iter\n", bench(points_api, n));
+        printf("inline      %.1f ns/iter\n", bench(points_inline, n));
+        return 0;
+    }
+    fprintf(stderr, "usage: test check | test bench N\n");
+    return 1;
+}
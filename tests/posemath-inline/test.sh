@@ -0,0 +1,7 @@
+#!/bin/sh
+SRC=../../src
+gcc -O2 -DULAPI -I$SRC -I$SRC/rtapi -I$SRC/libnml/posemath \
+    test.c $SRC/libnml/posemath/_posemath.c -lm -o test || exit 1
+./test check; exitval=$?
+rm -f test
+exit $exitval
@@ -0,0 +1,26 @@
+#!/bin/sh
+awk 'BEGIN { for (i = 0; i < 1000; i++)
+    printf "%f %d %d %d\n", i * 0.25 - 100, i - 500, i * 7919, i % 3 == 0 }' \
+    > input.txt
+
+# text in, binary out
+halsampler -b -n 1000 data.bin &
+sleep 0.5
+halstreamer < input.txt || exit 1
+wait $! || exit 1
+
+# binary in, text out
+halsampler -n 1000 > output.txt &
+sleep 0.5
+halstreamer -b data.bin || exit 1
+wait $! || exit 1
+
+# the sample counter carries on from the first reader, so the second
+# one starts with a single "overrun"
+sed -i -e '1{/^overrun$/d}' -e 's/ $//' output.txt
+if cmp -s output.txt input.txt; then
+    echo "round trip ok"
+else
+    echo "round trip differs"
+    diff input.txt output.txt | head
+fi
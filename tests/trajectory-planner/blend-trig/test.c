@@ -0,0 +1,118 @@
+/* Compares the closed-form sin/cos of the blend intersection angle
+   (findIntersectionAngleSinCos) with sin/cos of the angle from
+   findIntersectionAngle, over random pairs of unit vectors.
+
+   usage: test check N    worst relative difference over N pairs
+          test bench N    ns per pair of each way, N pairs */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+
+#include "rtapi.h"
+#include "posemath.h"
+#include "blendmath.h"
+
+/* blendmath.c refers to these, the functions used here do not call them */
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...) { }
+int pmCircleTangentVector() { abort(); }
+int tcCanConsume() { abort(); }
+int tcFindBlendTolerance() { abort(); }
+int tcGetEndTangentUnitVector() { abort(); }
+int tcGetIntersectionPoint() { abort(); }
+int tcGetStartTangentUnitVector() { abort(); }
+
+#define INPUTS 4096
+
+static PmCartesian u1[INPUTS], u2[INPUTS];
+
+static PmCartesian random_unit(void)
+{
+    PmCartesian v;
+    v.x = 2.0 * rand() / RAND_MAX - 1.0;
+    v.y = 2.0 * rand() / RAND_MAX - 1.0;
+    v.z = 2.0 * rand() / RAND_MAX - 1.0;
+    pmCartUnitEq(&v);
+    return v;
+}
+
+static void fill(int seed)
+{
+    int i;
+    srand(seed);
+    for (i = 0; i < INPUTS; i++) {
+        u1[i] = random_unit();
+        u2[i] = random_unit();
+    }
+}
+
+static double relative(double a, double b)
+{
+    double m = fmax(fabs(a), fabs(b));
+    return m == 0 ? 0 : fabs(a - b) / m;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    long n, i;
+    double theta, s, c, worst = 0, sum = 0, start, t_trig, t_closed;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: test check|bench N\n");
+        return 1;
+    }
+    n = atol(argv[2]);
+
+    if (!strcmp(argv[1], "check")) {
+        for (i = 0; i < n; i++) {
+            int k = i % INPUTS;
+            if (k == 0) {
+                fill(i / INPUTS + 1);
+            }
+            findIntersectionAngle(&u1[k], &u2[k], &theta);
+            findIntersectionAngleSinCos(&u1[k], &u2[k], &s, &c);
+            /* away from theta = 0 and pi/2, where one of them vanishes
+               and a relative difference means nothing */
+            if (s > 1e-6 && c > 1e-6) {
+                worst = fmax(worst, relative(sin(theta), s));
+                worst = fmax(worst, relative(cos(theta), c));
+            }
+        }
+        printf("%s\n", worst < 1e-12 ? "closed form matches" : "closed form differs");
+        fprintf(stderr, "worst relative difference %g\n", worst);
+        return 0;
+    }
+
+    fill(1);
+    start = now();
+    for (i = 0; i < n; i++) {
+        int k = i % INPUTS;
+        findIntersectionAngle(&u1[k], &u2[k], &theta);
+        sum += sin(theta) + cos(theta) + tan(theta);
+    }
+    t_trig = now() - start;
+    start = now();
+    for (i = 0; i < n; i++) {
+        int k = i % INPUTS;
+        findIntersectionAngleSinCos(&u1[k], &u2[k], &s, &c);
+        sum += s + c + s / c;
+    }
+    t_closed = now() - start;
+    printf("acos, sin, cos, tan %.1f ns/pair\n", t_trig * 1e9 / n);
+    printf("closed form         %.1f ns/pair\n", t_closed * 1e9 / n);
+    /* keep the results alive */
+    if (sum == 12345.678) {
+        printf("%g\n", sum);
+    }
+    return 0;
+}
@@ -0,0 +1,9 @@
+#!/bin/sh
+SRC=../../../src
+gcc -O2 -DULAPI -I$SRC -I$SRC/rtapi -I$SRC/hal -I$SRC/libnml/posemath \
+    -I$SRC/emc/tp -I$SRC/emc/nml_intf -I$SRC/emc/motion -I$SRC/emc/kinematics \
+    test.c $SRC/emc/tp/blendmath.c $SRC/emc/tp/spherical_arc.c \
+    $SRC/libnml/posemath/_posemath.c -lm -o test || exit 1
+./test check 1000000; exitval=$?
+rm -f test
+exit $exitval
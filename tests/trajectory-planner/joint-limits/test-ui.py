@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+
+import linuxcnc
+import linuxcnc_util
+
+import time
+import sys
+import os
+import math
+
+
+# unbuffer stdout
+sys.stdout = os.fdopen(sys.stdout.fileno(), 'w', 0)
+
+
+c = linuxcnc.command()
+e = linuxcnc.error_channel()
+s = linuxcnc.stat()
+
+l = linuxcnc_util.LinuxCNC(command=c, status=s, error=e)
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_MANUAL)
+c.home(-1)
+l.wait_for_home(joints=[1,1,1,0,0,0,0,0,0])
+
+c.mode(linuxcnc.MODE_MDI)
+c.mdi('g21 g90 g0 x-10 y1')
+c.wait_complete()
+l.wait_for_axis_to_stop_at('x', -10)
+l.wait_for_axis_to_stop_at('y', 1)
+
+
+#
+# The limit tpClampVelocityByJointLimits() should find: the line is
+# sampled at 8 points (TP_JOINT_VEL_SAMPLES) and joint 2, the angle in
+# degrees, turns fastest between the two samples next to the origin.
+#
+
+start, end, y = -10.0, 10.0, 1.0
+samples = 8
+joint2_max_vel = 360.0
+
+ds = (end - start) / samples
+expected = 50.0
+for k in range(samples):
+    x0 = start + ds * k
+    x1 = x0 + ds
+    dq = abs(math.degrees(math.atan2(y, x1) - math.atan2(y, x0)))
+    expected = min(expected, joint2_max_vel * ds / dq)
+print "expected maxvel: %.3f mm/s" % expected
+
+
+c.mdi('g1 x10 f3000')
+
+peak = 0.0
+timeout = time.time() + 10.0
+while time.time() < timeout:
+    s.poll()
+    peak = max(peak, s.current_vel)
+    if s.interp_state == linuxcnc.INTERP_IDLE and abs(s.position[0] - end) < 0.0001:
+        break
+    time.sleep(0.001)
+else:
+    print "move did not finish"
+    sys.exit(1)
+
+print "peak velocity: %.3f mm/s" % peak
+
+if peak > expected * 1.001:
+    print "faster than the joint limits allow"
+    sys.exit(1)
+if peak < expected * 0.95:
+    print "slower than the joint limits need"
+    sys.exit(1)
+
+sys.exit(0)
@@ -0,0 +1,5 @@
+#!/bin/bash
+
+rm -f sim.var
+linuxcnc -r rosekins.ini
+exit $?